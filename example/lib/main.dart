@@ -48,7 +48,7 @@ class _ExampleBrowser extends State<ExampleBrowser> {
     //    additionalArguments: '--show-fps-counter');
 
     try {
-      await _controller.initialize();
+      await _controller.initialize(initialUrl: 'https://flutter.dev');
       _subscriptions.add(_controller.url.listen((url) {
         _textController.text = url;
       }));
@@ -61,7 +61,6 @@ class _ExampleBrowser extends State<ExampleBrowser> {
 
       await _controller.setBackgroundColor(Colors.transparent);
       await _controller.setPopupWindowPolicy(WebviewPopupWindowPolicy.deny);
-      await _controller.loadUrl('https://flutter.dev');
 
       if (!mounted) return;
       setState(() {});
@@ -41,3 +41,72 @@ const Map<String, SystemMouseCursor> _cursors = {
 
 SystemMouseCursor getCursorByName(String name) =>
     _cursors[name] ?? SystemMouseCursors.basic;
+
+// Names of the custom cursors already created in the engine.
+final Set<String> _customCursors = <String>{};
+
+/// Returns a cursor showing the image of a custom (CSS) cursor, creating it
+/// in the engine first if necessary.
+///
+/// [args] holds the cursor's name, its RGBA pixels, their dimensions and the
+/// hotspot as sent by the native side. Falls back to
+/// [SystemMouseCursors.basic] if the engine doesn't support custom cursors.
+Future<MouseCursor> getCustomCursor(Map<dynamic, dynamic> args) async {
+  final String name = args['name'];
+  if (!_customCursors.contains(name)) {
+    try {
+      await SystemChannels.mouseCursor
+          .invokeMethod<void>('createCustomCursor/windows', <String, dynamic>{
+        'name': name,
+        'buffer': args['buffer'],
+        'width': args['width'],
+        'height': args['height'],
+        'hotX': args['hotX'],
+        'hotY': args['hotY'],
+      });
+    } on MissingPluginException {
+      return SystemMouseCursors.basic;
+    } on PlatformException {
+      return SystemMouseCursors.basic;
+    }
+    _customCursors.add(name);
+  }
+  return _CustomMouseCursor(name);
+}
+
+class _CustomMouseCursor extends MouseCursor {
+  const _CustomMouseCursor(this.name);
+
+  final String name;
+
+  @override
+  MouseCursorSession createSession(int device) =>
+      _CustomMouseCursorSession(this, device);
+
+  @override
+  String get debugDescription => 'CustomMouseCursor($name)';
+
+  @override
+  bool operator ==(Object other) =>
+      other is _CustomMouseCursor && other.name == name;
+
+  @override
+  int get hashCode => name.hashCode;
+}
+
+class _CustomMouseCursorSession extends MouseCursorSession {
+  _CustomMouseCursorSession(_CustomMouseCursor cursor, int device)
+      : super(cursor, device);
+
+  @override
+  _CustomMouseCursor get cursor => super.cursor as _CustomMouseCursor;
+
+  @override
+  Future<void> activate() {
+    return SystemChannels.mouseCursor.invokeMethod<void>(
+        'setCustomCursor/windows', <String, dynamic>{'name': cursor.name});
+  }
+
+  @override
+  void dispose() {}
+}
@@ -35,7 +35,77 @@ enum WebviewPermissionDecision { none, allow, deny }
 /// [allow] allows popups and will create new windows.
 /// [deny] suppresses popups.
 /// [sameWindow] displays popup contents in the current WebView.
-enum WebviewPopupWindowPolicy { allow, deny, sameWindow }
+/// [newInstance] opens popups in a new webview rendered by Flutter (see
+/// `WebviewController.popupOpened`). Spare instances are created ahead of
+/// time, so popups open without delay.
+enum WebviewPopupWindowPolicy { allow, deny, sameWindow, newInstance }
+
+/// How frames are captured from the webview.
+///
+/// [continuous] captures a frame whenever the contents change.
+/// [onDemand] only captures a frame when requested using
+/// `WebviewController.requestFrame`, or once navigation or input has
+/// settled. Capturing is paused in between.
+enum WebviewRenderMode { continuous, onDemand }
+
+/// The state of recovering from a closed capture, after which frames stop
+/// arriving.
+///
+/// [lost] is reported once the capture has been closed.
+/// [recovered] is reported once capturing has resumed.
+/// [failed] is reported once all attempts to resume capturing have failed,
+/// leaving the texture frozen until the webview is recreated.
+enum WebviewCaptureRecoveryState { lost, recovered, failed }
+
+/// Why a renderer needed to be restarted.
+///
+/// [exited] means the renderer process crashed or was killed.
+/// [unresponsive] means WebView2 found the renderer to be unresponsive.
+/// [heartbeatTimeout] means the watchdog's heartbeat went unanswered (see
+/// `WebviewController.setRendererWatchdog`).
+/// [browserExited] means the browser process exited. The webview can't be
+/// recovered and needs to be recreated.
+enum WebviewRendererFailureKind {
+  exited,
+  unresponsive,
+  heartbeatTimeout,
+  browserExited
+}
+
+/// The progress of restarting a renderer.
+enum WebviewRendererFailureState { recovering, recovered, failed }
+
+/// The SameSite attribute of a cookie.
+enum WebviewCookieSameSite { none, lax, strict }
+
+/// Kinds of browsing data.
+///
+/// [allDomStorage] includes all of [fileSystems], [indexedDb],
+/// [localStorage], [webSql], [cacheStorage] and [serviceWorkers].
+/// [allSite] additionally includes [cookies]. [allProfile] includes all
+/// kinds.
+///
+/// For more detailed information, please refer to
+/// [Microsofts](https://learn.microsoft.com/en-us/microsoft-edge/webview2/reference/win32/icorewebview2profile2#clearbrowsingdata)
+/// documentation.
+enum WebviewBrowsingDataKind {
+  fileSystems,
+  indexedDb,
+  localStorage,
+  webSql,
+  cacheStorage,
+  allDomStorage,
+  cookies,
+  allSite,
+  diskCache,
+  downloadHistory,
+  generalAutofill,
+  passwordAutosave,
+  browsingHistory,
+  settings,
+  allProfile,
+  serviceWorkers
+}
 
 /// The kind of cross origin resource access for virtual hosts
 ///
@@ -49,6 +119,16 @@ enum WebviewPopupWindowPolicy { allow, deny, sameWindow }
 // Order must match WebviewHostResourceAccessKind (see webview.h)
 enum WebviewHostResourceAccessKind { deny, allow, denyCors }
 
+/// Predefined browser arguments for [WebviewController.initializeEnvironment].
+///
+/// [lowMemory] limits renderer processes and the disk cache and disables the
+/// back/forward cache.
+/// [balanced] uses a moderately sized disk cache.
+/// [maxThroughput] enables GPU rasterization, uses a large disk cache and
+/// keeps background and occluded webviews from being throttled.
+// Order must match util::PerformanceProfile (see util/browser_arguments.h)
+enum WebviewPerformanceProfile { lowMemory, balanced, maxThroughput }
+
 enum WebErrorStatus {
   WebErrorStatusUnknown,
   WebErrorStatusCertificateCommonNameIsIncorrect,
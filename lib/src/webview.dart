@@ -1,5 +1,6 @@
 import 'dart:async';
 import 'dart:convert';
+import 'dart:typed_data';
 import 'dart:ui';
 
 import 'package:flutter/gestures.dart';
@@ -10,6 +11,31 @@ import 'package:flutter/widgets.dart';
 import 'enums.dart';
 import 'cursor.dart';
 
+class WebviewPopup {
+  /// The controller of the webview the popup has been opened in. It has to
+  /// be initialized before use.
+  final WebviewController controller;
+  final String url;
+  const WebviewPopup(this.controller, this.url);
+}
+
+class WebviewCaptureRecovery {
+  final WebviewCaptureRecoveryState state;
+
+  /// The number of failed attempts preceding this state.
+  final int attempt;
+  const WebviewCaptureRecovery(this.state, this.attempt);
+}
+
+class WebviewRendererFailure {
+  final WebviewRendererFailureKind kind;
+  final WebviewRendererFailureState state;
+
+  /// The number of the recovery attempt, starting at 1.
+  final int attempt;
+  const WebviewRendererFailure(this.kind, this.state, this.attempt);
+}
+
 class HistoryChanged {
   final bool canGoBack;
   final bool canGoForward;
@@ -31,12 +57,144 @@ class WebviewDownloadEvent {
   );
 }
 
+/// A browser cookie.
+class WebviewCookie {
+  final String name;
+  final String value;
+  final String domain;
+  final String path;
+
+  /// The expiry date, or `null` for session cookies.
+  final DateTime? expires;
+  final bool isHttpOnly;
+  final bool isSecure;
+  final WebviewCookieSameSite sameSite;
+
+  const WebviewCookie({
+    required this.name,
+    required this.value,
+    required this.domain,
+    this.path = '/',
+    this.expires,
+    this.isHttpOnly = false,
+    this.isSecure = false,
+    this.sameSite = WebviewCookieSameSite.lax,
+  });
+
+  bool get isSession => expires == null;
+
+  static const int _httpOnlyFlag = 1 << 0;
+  static const int _secureFlag = 1 << 1;
+  static const int _sessionFlag = 1 << 2;
+
+  // Cookies are sent as lists to keep bulk transfers compact:
+  // [name, value, domain, path, expires, flags, sameSite]
+  factory WebviewCookie._fromList(List<dynamic> list) {
+    final int flags = list[5];
+    return WebviewCookie(
+      name: list[0],
+      value: list[1],
+      domain: list[2],
+      path: list[3],
+      expires: flags & _sessionFlag != 0
+          ? null
+          : DateTime.fromMillisecondsSinceEpoch(
+              ((list[4] as double) * 1000).round(),
+              isUtc: true),
+      isHttpOnly: flags & _httpOnlyFlag != 0,
+      isSecure: flags & _secureFlag != 0,
+      sameSite: WebviewCookieSameSite.values[list[6]],
+    );
+  }
+
+  List<dynamic> _toList() => [
+        name,
+        value,
+        domain,
+        path,
+        expires == null ? -1.0 : expires!.millisecondsSinceEpoch / 1000.0,
+        (isHttpOnly ? _httpOnlyFlag : 0) |
+            (isSecure ? _secureFlag : 0) |
+            (isSession ? _sessionFlag : 0),
+        sameSite.index,
+      ];
+}
+
+/// Statistics of a kind of task run on the platform thread, see
+/// [WebviewController.getTaskStats].
+class WebviewTaskStats {
+  final int count;
+
+  /// The number of runs exceeding the budget.
+  final int longCount;
+  final Duration total;
+  final Duration max;
+
+  /// The number of runs per duration bucket. Bucket `i` counts the runs
+  /// shorter than `bucketBounds[i]`, the last one all remaining runs.
+  final List<int> histogram;
+
+  const WebviewTaskStats(
+      this.count, this.longCount, this.total, this.max, this.histogram);
+
+  Duration get average => count == 0
+      ? Duration.zero
+      : Duration(microseconds: total.inMicroseconds ~/ count);
+}
+
+/// A task that exceeded the budget of the platform thread.
+class WebviewLongTask {
+  final String name;
+  final Duration duration;
+
+  /// The time elapsed since the task has completed. Not set for tasks
+  /// reported through [WebviewController.configureTaskMonitor].
+  final Duration? age;
+  const WebviewLongTask(this.name, this.duration, [this.age]);
+}
+
+class WebviewTaskReport {
+  final Duration budget;
+  final List<Duration> bucketBounds;
+
+  /// Statistics per task name, e.g. `webview.loadUrl` or
+  /// `event.navigationCompleted`.
+  final Map<String, WebviewTaskStats> tasks;
+
+  /// The most recent long tasks, oldest first.
+  final List<WebviewLongTask> longTasks;
+  const WebviewTaskReport(
+      this.budget, this.bucketBounds, this.tasks, this.longTasks);
+}
+
+/// The outcome of [WebviewController.replayChannelLog].
+class WebviewReplayReport {
+  final int records;
+
+  /// The number of method calls passed to the plugin and its instances.
+  final int dispatched;
+
+  /// Events, calls with dropped payloads and calls addressing instances
+  /// that don't exist in the replay.
+  final int skipped;
+
+  /// How far dispatching fell behind the pace of the recording.
+  final Duration maxLag;
+  const WebviewReplayReport(
+      this.records, this.dispatched, this.skipped, this.maxLag);
+}
+
 typedef PermissionRequestedDelegate
     = FutureOr<WebviewPermissionDecision> Function(
         String url, WebviewPermissionKind permissionKind, bool isUserInitiated);
 
 typedef ScriptID = String;
 
+/// Handles a call of a host function from a script. The result is passed
+/// back to the script and must consist of [bool], [int], [double],
+/// [String], [List] or [null] values.
+typedef HostFunction = FutureOr<dynamic> Function(List<dynamic> args);
+
 /// Attempts to translate a button constant such as [kPrimaryMouseButton]
 /// to a [PointerButton]
 PointerButton getButton(int value) {
@@ -82,20 +240,41 @@ class WebviewController extends ValueNotifier<WebviewValue> {
   /// using  an optional [browserExePath], an optional [userDataPath]
   /// and optional Chromium command line arguments [additionalArguments].
   ///
-  /// The environment is shared between all WebviewController instances and
-  /// can be initialized only once. Initialization must take place before any
-  /// WebviewController is created/initialized.
+  /// [graphicsContextShards] sets the number of Direct3D devices used for
+  /// capturing and copying frames. Instances are distributed across them by
+  /// load, which lets many webviews render in parallel on GPUs with multiple
+  /// engines. Defaults to a single device.
+  ///
+  /// The default environment is shared between all WebviewController
+  /// instances and can be initialized only once. Initialization must take
+  /// place before any WebviewController is created/initialized.
+  ///
+  /// A [performanceProfile] provides a base set of browser arguments.
+  /// [additionalArguments] are applied on top of it, overriding switches set
+  /// by both while uniting their `--enable-features` and `--disable-features`
+  /// lists. This requires them to consist of switches only; without a
+  /// profile, they are passed to the browser unchanged.
+  ///
+  /// Passing a [name] creates an additional environment, which controllers
+  /// select with their `environment` parameter. Each environment runs its
+  /// own browser processes; prefer profiles to isolate storage within one.
   ///
   /// Throws [PlatformException] if the environment was initialized before.
   static Future<void> initializeEnvironment(
-      {String? userDataPath,
+      {String? name,
+      String? userDataPath,
       String? browserExePath,
-      String? additionalArguments}) async {
+      String? additionalArguments,
+      WebviewPerformanceProfile? performanceProfile,
+      int? graphicsContextShards}) async {
     return _pluginChannel
         .invokeMethod('initializeEnvironment', <String, dynamic>{
+      'name': name,
       'userDataPath': userDataPath,
       'browserExePath': browserExePath,
-      'additionalArguments': additionalArguments
+      'additionalArguments': additionalArguments,
+      'performanceProfile': performanceProfile?.index,
+      'graphicsContextShards': graphicsContextShards
     });
   }
 
@@ -106,13 +285,161 @@ class WebviewController extends ValueNotifier<WebviewValue> {
     return _pluginChannel.invokeMethod<String>('getWebViewVersion');
   }
 
+  /// Adds a script that runs on every document of all webviews, including
+  /// ones created later, like [addScriptToExecuteOnDocumentCreated] does for
+  /// a single one. Global scripts aren't part of session snapshots.
+  ///
+  /// Returns an id which can be used for [removeGlobalScript].
+  static Future<int> addGlobalScript(String script) async {
+    final id =
+        await _pluginChannel.invokeMethod<int>('addGlobalScript', script);
+    return id!;
+  }
+
+  /// Removes a script added with [addGlobalScript] from all webviews.
+  static Future<void> removeGlobalScript(int id) async {
+    return _pluginChannel.invokeMethod('removeGlobalScript', id);
+  }
+
+  /// Captures the state of the given [controllers] (environment, profile,
+  /// URL, zoom factor, scroll position, session history, document scripts
+  /// and virtual host mappings) in a compact binary format that can be
+  /// persisted and passed to [restoreSession] after a restart.
+  ///
+  /// Instances with a higher value in [priorities] (e.g. the visible ones)
+  /// are restored first. Unlisted controllers get a priority of 0.
+  static Future<Uint8List> snapshotSession(List<WebviewController> controllers,
+      {Map<WebviewController, int> priorities = const {}}) async {
+    final instances = <List<int>>[];
+    for (final controller in controllers) {
+      await controller.ready;
+      instances.add([controller._textureId, priorities[controller] ?? 0]);
+    }
+    final snapshot = await _pluginChannel.invokeMethod<Uint8List>(
+        'snapshotSession', instances);
+    return snapshot!;
+  }
+
+  /// Recreates the instances of a snapshot taken by [snapshotSession].
+  ///
+  /// Up to [maxParallel] webviews are created concurrently, in priority
+  /// order. The returned controllers are in snapshot order and have to be
+  /// initialized before use; instances that could not be created are [null].
+  /// Named environments have to be set up with [initializeEnvironment]
+  /// beforehand, otherwise their instances aren't restored.
+  /// WebView2 cannot seed the back/forward list, so each instance only loads
+  /// its current history entry.
+  static Future<List<WebviewController?>> restoreSession(Uint8List snapshot,
+      {int maxParallel = 4}) async {
+    final textureIds = await _pluginChannel
+        .invokeListMethod<int?>('restoreSession', [snapshot, maxParallel]);
+    return textureIds!
+        .map((textureId) =>
+            textureId != null ? WebviewController._attached(textureId) : null)
+        .toList();
+  }
+
+  /// Returns how long the plugin has been blocking the platform thread,
+  /// broken down by method call and WebView2 event, along with the most
+  /// recent tasks exceeding the budget.
+  static Future<WebviewTaskReport> getTaskStats() async {
+    final report = (await _pluginChannel.invokeMapMethod<String, dynamic>(
+        'getTaskStats'))!;
+    final tasks = <String, WebviewTaskStats>{};
+    (report['tasks'] as Map).forEach((name, stats) {
+      tasks[name as String] = WebviewTaskStats(
+        stats['count'],
+        stats['longCount'],
+        Duration(microseconds: stats['totalUs']),
+        Duration(microseconds: stats['maxUs']),
+        List<int>.from(stats['histogram']),
+      );
+    });
+    return WebviewTaskReport(
+      Duration(microseconds: report['budgetUs']),
+      (report['bucketBoundsMs'] as List)
+          .map((bound) => Duration(milliseconds: bound))
+          .toList(),
+      tasks,
+      (report['longTasks'] as List)
+          .map((task) => WebviewLongTask(
+              task['name'],
+              Duration(microseconds: task['durationUs']),
+              Duration(microseconds: task['ageUs'])))
+          .toList(),
+    );
+  }
+
+  /// Sets the [budget] of tasks on the platform thread (8ms by default,
+  /// half a frame at 60Hz). If [onSlowCall] is set, it is invoked for
+  /// every task exceeding the budget.
+  static Future<void> configureTaskMonitor(
+      {Duration? budget, void Function(WebviewLongTask task)? onSlowCall}) {
+    _pluginChannel.setMethodCallHandler(onSlowCall == null
+        ? null
+        : (call) async {
+            if (call.method == 'slowCall') {
+              final Map<dynamic, dynamic> args = call.arguments;
+              onSlowCall(WebviewLongTask(
+                  args['name'], Duration(microseconds: args['durationUs'])));
+            }
+          });
+    return _pluginChannel.invokeMethod(
+        'configureTaskMonitor', [budget?.inMicroseconds, onSlowCall != null]);
+  }
+
+  /// Clears the statistics returned by [getTaskStats].
+  static Future<void> resetTaskStats() {
+    return _pluginChannel.invokeMethod('resetTaskStats');
+  }
+
+  /// Writes all method calls and events of the plugin and its instances to
+  /// a compact binary log at [path], replacing an ongoing recording.
+  ///
+  /// With [redact], the contents of strings (except map keys) and byte
+  /// buffers are masked while their lengths are kept.
+  static Future<void> startChannelRecording(String path,
+      {bool redact = false}) {
+    return _pluginChannel.invokeMethod('startChannelRecording', [path, redact]);
+  }
+
+  /// Stops recording and returns the number of recorded messages, or
+  /// [null] if there was no recording.
+  static Future<int?> stopChannelRecording() {
+    return _pluginChannel.invokeMethod<int>('stopChannelRecording');
+  }
+
+  /// Replays the method calls of a log written during
+  /// [startChannelRecording] against new instances, at [speed] times the
+  /// original pace (0 replays without delays).
+  ///
+  /// Calls addressing a recorded instance go to the instance created by the
+  /// same call during the replay. The instances created by the replay
+  /// aren't attached to controllers and stay alive unless the log disposes
+  /// of them. The time spent on the
+  /// platform thread is reported by [getTaskStats].
+  static Future<WebviewReplayReport> replayChannelLog(String path,
+      {double speed = 1.0}) async {
+    final report = (await _pluginChannel.invokeMapMethod<String, dynamic>(
+        'replayChannelLog', [path, speed]))!;
+    return WebviewReplayReport(
+      report['records'],
+      report['dispatched'],
+      report['skipped'],
+      Duration(microseconds: report['maxLagUs']),
+    );
+  }
+
   late Completer<void> _creatingCompleter;
   int _textureId = 0;
+  // Set for controllers of instances created natively.
+  int? _attachedTextureId;
   bool _isDisposed = false;
 
   Future<void> get ready => _creatingCompleter.future;
 
   PermissionRequestedDelegate? _permissionRequested;
+  Duration? _rememberPermissionDecisions;
 
   late MethodChannel _methodChannel;
   late EventChannel _eventChannel;
@@ -162,11 +489,21 @@ class WebviewController extends ValueNotifier<WebviewValue> {
   /// A stream reflecting the current document title.
   Stream<String> get title => _titleStreamController.stream;
 
-  final StreamController<SystemMouseCursor> _cursorStreamController =
-      StreamController<SystemMouseCursor>.broadcast();
+  final StreamController<MouseCursor> _cursorStreamController =
+      StreamController<MouseCursor>.broadcast();
 
   /// A stream reflecting the current cursor style.
-  Stream<SystemMouseCursor> get _cursor => _cursorStreamController.stream;
+  Stream<MouseCursor> get _cursor => _cursorStreamController.stream;
+
+  // Discards custom cursors which finish loading after a newer cursor change.
+  int _cursorChangeCount = 0;
+
+  int _nextClearBrowsingDataRequestId = 0;
+  int _nextRequestBodyId = 0;
+  final Map<int, void Function(int completed, int total)>
+      _clearBrowsingDataProgressCallbacks = {};
+  final Map<String, HostFunction> _hostFunctions = {};
+  final Map<String, int> _sharedBufferSizes = {};
 
   final StreamController<dynamic> _webMessageStreamController =
       StreamController<dynamic>();
@@ -181,19 +518,78 @@ class WebviewController extends ValueNotifier<WebviewValue> {
   Stream<bool> get containsFullScreenElementChanged =>
       _containsFullScreenElementChangedStreamController.stream;
 
-  WebviewController() : super(WebviewValue.uninitialized());
+  final StreamController<WebviewPopup> _popupOpenedStreamController =
+      StreamController<WebviewPopup>.broadcast();
+
+  /// A stream of popups opened with [WebviewPopupWindowPolicy.newInstance].
+  Stream<WebviewPopup> get popupOpened => _popupOpenedStreamController.stream;
+
+  final StreamController<WebviewCaptureRecovery>
+      _captureRecoveryStreamController =
+      StreamController<WebviewCaptureRecovery>.broadcast();
+
+  /// A stream reporting the automatic recovery from closed captures.
+  Stream<WebviewCaptureRecovery> get captureRecovery =>
+      _captureRecoveryStreamController.stream;
+
+  final StreamController<WebviewRendererFailure>
+      _rendererFailureStreamController =
+      StreamController<WebviewRendererFailure>.broadcast();
+
+  /// A stream reporting crashed or hung renderers and their automatic
+  /// restart. The current document is reloaded and scrolled back to where it
+  /// was.
+  Stream<WebviewRendererFailure> get rendererFailure =>
+      _rendererFailureStreamController.stream;
+
+  /// The name of the environment passed to [initializeEnvironment], or
+  /// [null] for the default one.
+  final String? environment;
+
+  /// The browser profile the webview uses. Profiles keep cookies, caches and
+  /// storage separate while sharing the environment's browser process. On
+  /// runtimes without profile support, each profile falls back to an
+  /// environment of its own. Must consist of letters, digits and
+  /// `#@$()+-_~.'` or spaces, and be at most 64 characters long.
+  final String? profile;
+
+  /// Whether the webview runs in InPrivate mode, not persisting any data.
+  final bool inPrivate;
+
+  WebviewController({this.environment, this.profile, this.inPrivate = false})
+      : super(WebviewValue.uninitialized());
+
+  WebviewController._attached(int textureId)
+      : _attachedTextureId = textureId,
+        environment = null,
+        profile = null,
+        inPrivate = false,
+        super(WebviewValue.uninitialized());
 
   /// Initializes the underlying platform view.
-  Future<void> initialize() async {
+  ///
+  /// If given, navigation to [initialUrl] starts while the webview is being
+  /// set up. Events emitted before the controller listens aren't lost.
+  /// [initialUrl] is ignored for restored controllers and popups.
+  Future<void> initialize({String? initialUrl}) async {
     if (_isDisposed) {
       return Future<void>.value();
     }
     _creatingCompleter = Completer<void>();
     try {
-      final reply =
-          await _pluginChannel.invokeMapMethod<String, dynamic>('initialize');
-
-      _textureId = reply!['textureId'];
+      final attachedTextureId = _attachedTextureId;
+      if (attachedTextureId != null) {
+        _textureId = attachedTextureId;
+      } else {
+        final reply = await _pluginChannel
+            .invokeMapMethod<String, dynamic>('initialize', <String, dynamic>{
+          'environment': environment,
+          'profile': profile,
+          'inPrivate': inPrivate,
+          'initialUrl': initialUrl,
+        });
+        _textureId = reply!['textureId'];
+      }
       _methodChannel = MethodChannel('$_pluginChannelPrefix/$_textureId');
       _eventChannel = EventChannel('$_pluginChannelPrefix/$_textureId/events');
       _eventStreamSubscription =
@@ -229,12 +625,27 @@ class WebviewController extends ValueNotifier<WebviewValue> {
           case 'securityStateChanged':
             _securityStateChangedStreamController.add(map['value']);
             break;
+          case 'clearBrowsingDataProgress':
+            final List<dynamic> progress = map['value'];
+            _clearBrowsingDataProgressCallbacks[progress[0]]
+                ?.call(progress[1], progress[2]);
+            break;
           case 'titleChanged':
             _titleStreamController.add(map['value']);
             break;
           case 'cursorChanged':
+            _cursorChangeCount++;
             _cursorStreamController.add(getCursorByName(map['value']));
             break;
+          case 'customCursorChanged':
+            final cursorChangeCount = ++_cursorChangeCount;
+            getCustomCursor(map['value']).then((cursor) {
+              if (cursorChangeCount == _cursorChangeCount &&
+                  !_cursorStreamController.isClosed) {
+                _cursorStreamController.add(cursor);
+              }
+            });
+            break;
           case 'webMessageReceived':
             try {
               final message = json.decode(map['value']);
@@ -246,6 +657,25 @@ class WebviewController extends ValueNotifier<WebviewValue> {
           case 'containsFullScreenElementChanged':
             _containsFullScreenElementChangedStreamController.add(map['value']);
             break;
+          case 'popupOpened':
+            _popupOpenedStreamController.add(WebviewPopup(
+                WebviewController._attached(map['value']['textureId']),
+                map['value']['url']));
+            break;
+          case 'captureRecovery':
+            _captureRecoveryStreamController.add(WebviewCaptureRecovery(
+                WebviewCaptureRecoveryState.values[map['value']['state']],
+                map['value']['attempt']));
+            break;
+          case 'rendererFailure':
+            _rendererFailureStreamController.add(WebviewRendererFailure(
+                WebviewRendererFailureKind.values[map['value']['kind']],
+                WebviewRendererFailureState.values[map['value']['state']],
+                map['value']['attempt']));
+            break;
+          case 'hostCalls':
+            _onHostCalls(map['value']);
+            break;
         }
       });
 
@@ -267,7 +697,7 @@ class WebviewController extends ValueNotifier<WebviewValue> {
     return _creatingCompleter.future;
   }
 
-  Future<bool?> _onPermissionRequested(Map<dynamic, dynamic> args) async {
+  Future<dynamic> _onPermissionRequested(Map<dynamic, dynamic> args) async {
     if (_permissionRequested == null) {
       return null;
     }
@@ -281,11 +711,12 @@ class WebviewController extends ValueNotifier<WebviewValue> {
       final decision =
           await _permissionRequested!(url, permissionKind, isUserInitiated);
 
+      final remember = _rememberPermissionDecisions;
       switch (decision) {
         case WebviewPermissionDecision.allow:
-          return true;
+          return remember != null ? [true, remember.inMilliseconds] : true;
         case WebviewPermissionDecision.deny:
-          return false;
+          return remember != null ? [false, remember.inMilliseconds] : false;
         default:
           return null;
       }
@@ -315,6 +746,13 @@ class WebviewController extends ValueNotifier<WebviewValue> {
   }
 
   /// Loads a document from the given string.
+  ///
+  /// Documents larger than 512 KiB are served from memory behind a random
+  /// URL on the `webview-content.invalid` host instead of being loaded
+  /// inline, which lifts WebView2's 2 MB limit for inline content. The last
+  /// few of them (up to 64 MiB) stay available for reloads and back/forward
+  /// navigations. Like inline content, they aren't part of session
+  /// snapshots.
   Future<void> loadStringContent(String content) async {
     if (_isDisposed) {
       return;
@@ -323,6 +761,45 @@ class WebviewController extends ValueNotifier<WebviewValue> {
     return _methodChannel.invokeMethod('loadStringContent', content);
   }
 
+  /// Navigates to [url] using the given HTTP [method] and [headers].
+  ///
+  /// The request body is either passed as [body] or streamed from
+  /// [bodyStream]. A streamed body is handed over chunk by chunk while the
+  /// webview sends the request, pausing the stream while the native buffer
+  /// is full, so it never has to be held in memory as a whole.
+  Future<void> navigateWithRequest(String url,
+      {String method = 'GET',
+      Map<String, String> headers = const {},
+      Uint8List? body,
+      Stream<List<int>>? bodyStream}) async {
+    if (_isDisposed) {
+      return;
+    }
+    assert(value.isInitialized);
+    assert(body == null || bodyStream == null);
+
+    if (bodyStream == null) {
+      return _methodChannel.invokeMethod(
+          'navigateWithRequest', [method, url, headers, body, null]);
+    }
+
+    final bodyId = _nextRequestBodyId++;
+    await _methodChannel.invokeMethod(
+        'navigateWithRequest', [method, url, headers, null, bodyId]);
+    var cancel = true;
+    try {
+      await for (final chunk in bodyStream) {
+        await _methodChannel.invokeMethod('appendRequestBody',
+            [bodyId, chunk is Uint8List ? chunk : Uint8List.fromList(chunk)]);
+      }
+      cancel = false;
+    } finally {
+      if (!_isDisposed) {
+        await _methodChannel.invokeMethod('closeRequestBody', [bodyId, cancel]);
+      }
+    }
+  }
+
   /// Reloads the current document.
   Future<void> reload() async {
     if (_isDisposed) {
@@ -411,6 +888,142 @@ class WebviewController extends ValueNotifier<WebviewValue> {
     return _methodChannel.invokeMethod('postWebMessage', message);
   }
 
+  /// Exposes [handler] to scripts as `window.flutterHost.<name>()`, which
+  /// returns a Promise.
+  ///
+  /// Calls are passed without JSON encoding and are delivered in batches.
+  /// The handler replaces any function or value registered under [name].
+  Future<void> addHostFunction(String name, HostFunction handler) async {
+    if (_isDisposed) {
+      return;
+    }
+    assert(value.isInitialized);
+    _hostFunctions[name] = handler;
+    return _methodChannel.invokeMethod('addHostFunction', name);
+  }
+
+  /// Removes a host function or value added with [addHostFunction] or
+  /// [setHostValue].
+  Future<void> removeHostFunction(String name) async {
+    if (_isDisposed) {
+      return;
+    }
+    assert(value.isInitialized);
+    _hostFunctions.remove(name);
+    return _methodChannel.invokeMethod('removeHostFunction', name);
+  }
+
+  /// Exposes [value] to scripts through a host function returning it.
+  ///
+  /// Unlike functions added with [addHostFunction], it can also be read
+  /// synchronously with `chrome.webview.hostObjects.sync.flutter.<name>()`,
+  /// as it is answered natively.
+  Future<void> setHostValue(String name, dynamic value) async {
+    if (_isDisposed) {
+      return;
+    }
+    assert(this.value.isInitialized);
+    _hostFunctions.remove(name);
+    return _methodChannel.invokeMethod('setHostValue', [name, value]);
+  }
+
+  Future<void> _onHostCalls(List<dynamic> calls) async {
+    final results = await Future.wait(calls.map((dynamic call) async {
+      final int callId = call[0];
+      final handler = _hostFunctions[call[1]];
+      if (handler == null) {
+        return [callId, false, 'Unknown host function ${call[1]}'];
+      }
+      try {
+        return [callId, true, await handler(call[2])];
+      } catch (e) {
+        return [callId, false, e.toString()];
+      }
+    }));
+    if (!_isDisposed) {
+      await _methodChannel.invokeMethod('completeHostCalls', results);
+    }
+  }
+
+  /// Copies [data] into the shared buffer [name], which is allocated on
+  /// first use. Writing a buffer again reuses its memory if it is large
+  /// enough, and released buffers are recycled.
+  Future<void> writeSharedBuffer(String name, Uint8List data) async {
+    if (_isDisposed) {
+      return;
+    }
+    assert(value.isInitialized);
+    await _methodChannel.invokeMethod('writeSharedBuffer', [name, data]);
+    _sharedBufferSizes[name] = data.length;
+  }
+
+  /// Posts the shared buffer [name] to the current document without copying
+  /// it. Scripts receive it as follows:
+  ///
+  /// ```js
+  /// chrome.webview.addEventListener('sharedbufferreceived', (e) => {
+  ///   const {name, size, data} = e.additionalData;
+  ///   const bytes = new Uint8Array(e.getBuffer(), 0, size);
+  /// });
+  /// ```
+  ///
+  /// By default, the script gets read-only access and sees later writes to
+  /// the buffer. With [transfer], the buffer is handed over with read-write
+  /// access and [name] becomes free. [additionalData] must be encodable as
+  /// JSON. Scripts should call `chrome.webview.releaseBuffer` once they are
+  /// done with a buffer.
+  Future<void> postSharedBuffer(String name,
+      {bool transfer = false, dynamic additionalData}) async {
+    if (_isDisposed) {
+      return;
+    }
+    assert(value.isInitialized);
+    final json = jsonEncode({
+      'name': name,
+      'size': _sharedBufferSizes[name] ?? 0,
+      'data': additionalData,
+    });
+    await _methodChannel
+        .invokeMethod('postSharedBuffer', [name, transfer, json]);
+    if (transfer) {
+      _sharedBufferSizes.remove(name);
+    }
+  }
+
+  /// Releases the shared buffer [name] on the host side.
+  Future<void> releaseSharedBuffer(String name) async {
+    if (_isDisposed) {
+      return;
+    }
+    assert(value.isInitialized);
+    _sharedBufferSizes.remove(name);
+    return _methodChannel.invokeMethod('releaseSharedBuffer', name);
+  }
+
+  /// Answers permission requests of [kind] from the origin of [url] with
+  /// [decision] without asking [Webview.permissionRequested], for [ttl] or
+  /// until cleared. [WebviewPermissionDecision.none] removes the decision.
+  Future<void> setPermissionDecision(String url, WebviewPermissionKind kind,
+      WebviewPermissionDecision decision,
+      {Duration? ttl}) async {
+    if (_isDisposed) {
+      return;
+    }
+    assert(value.isInitialized);
+    return _methodChannel.invokeMethod('setPermissionDecision',
+        [url, kind.index, decision.index, ttl?.inMilliseconds]);
+  }
+
+  /// Clears the permission decisions for the origin of [url], or all of
+  /// them.
+  Future<void> clearPermissionDecisions({String? url}) async {
+    if (_isDisposed) {
+      return;
+    }
+    assert(value.isInitialized);
+    return _methodChannel.invokeMethod('clearPermissionDecisions', url);
+  }
+
   /// Sets the user agent value.
   Future<void> setUserAgent(String userAgent) async {
     if (_isDisposed) {
@@ -429,6 +1042,97 @@ class WebviewController extends ValueNotifier<WebviewValue> {
     return _methodChannel.invokeMethod('clearCookies');
   }
 
+  /// Returns the cookies matching all of the given criteria.
+  ///
+  /// [uri] limits the result to cookies which would be sent to it, [domain]
+  /// matches the domain as well as its subdomains.
+  Future<List<WebviewCookie>> getCookies(
+      {String? uri, String? name, String? domain, String? path}) async {
+    if (_isDisposed) {
+      return [];
+    }
+    assert(value.isInitialized);
+    final List<dynamic>? cookies = await _methodChannel
+        .invokeMethod<List<dynamic>>('getCookies', [uri, name, domain, path]);
+    return cookies
+            ?.map((cookie) => WebviewCookie._fromList(cookie))
+            .toList() ??
+        [];
+  }
+
+  /// Adds or updates the given [cookies] in a single call, e.g. to restore a
+  /// session before the first navigation.
+  ///
+  /// Returns the number of cookies set.
+  Future<int> setCookies(List<WebviewCookie> cookies) async {
+    if (_isDisposed) {
+      return 0;
+    }
+    assert(value.isInitialized);
+    final count = await _methodChannel.invokeMethod<int>(
+        'setCookies', cookies.map((cookie) => cookie._toList()).toList());
+    return count ?? 0;
+  }
+
+  /// Deletes the cookies matching all of the given criteria (see
+  /// [getCookies]). Deletes all cookies if none are given.
+  ///
+  /// Returns the number of cookies deleted.
+  Future<int> deleteCookies(
+      {String? uri, String? name, String? domain, String? path}) async {
+    if (_isDisposed) {
+      return 0;
+    }
+    assert(value.isInitialized);
+    final count = await _methodChannel
+        .invokeMethod<int>('deleteCookies', [uri, name, domain, path]);
+    return count ?? 0;
+  }
+
+  /// Clears the given [kinds] of browsing data in the background.
+  ///
+  /// If [origins] are given, only the data stored by these origins is
+  /// cleared, leaving everything else (e.g. the shared disk cache) intact.
+  /// Only site data kinds (everything up to [WebviewBrowsingDataKind.allSite]
+  /// and [WebviewBrowsingDataKind.serviceWorkers]) can be cleared per origin.
+  ///
+  /// Otherwise, the data of the entire profile is cleared, optionally
+  /// limited to data created within [timeRange].
+  ///
+  /// [onProgress] is called after each origin (or once for the entire
+  /// profile) has been processed.
+  Future<void> clearBrowsingData(Set<WebviewBrowsingDataKind> kinds,
+      {List<String>? origins,
+      DateTimeRange? timeRange,
+      void Function(int completed, int total)? onProgress}) async {
+    if (_isDisposed) {
+      return;
+    }
+    assert(value.isInitialized);
+    assert(origins == null || origins.isEmpty || timeRange == null,
+        'Time ranges are only supported when clearing the entire profile.');
+
+    final requestId = _nextClearBrowsingDataRequestId++;
+    if (onProgress != null) {
+      _clearBrowsingDataProgressCallbacks[requestId] = onProgress;
+    }
+    try {
+      await _methodChannel.invokeMethod('clearBrowsingData', [
+        kinds.fold<int>(0, (mask, kind) => mask | (1 << kind.index)),
+        origins ?? <String>[],
+        timeRange == null
+            ? null
+            : timeRange.start.millisecondsSinceEpoch / 1000.0,
+        timeRange == null
+            ? null
+            : timeRange.end.millisecondsSinceEpoch / 1000.0,
+        requestId,
+      ]);
+    } finally {
+      _clearBrowsingDataProgressCallbacks.remove(requestId);
+    }
+  }
+
   /// Clears browser cache.
   Future<void> clearCache() async {
     if (_isDisposed) {
@@ -544,6 +1248,111 @@ class WebviewController extends ValueNotifier<WebviewValue> {
     return _methodChannel.invokeMethod('setFpsLimit', maxFps);
   }
 
+  /// Restricts copying the webview's contents to the given [rect], which is
+  /// in logical pixels relative to the webview's top-left corner.
+  ///
+  /// Use this when the webview is partially scrolled out of view or clipped
+  /// so that only the visible part is copied for each frame. An empty [rect]
+  /// skips copying entirely, e.g. while the webview is fully covered.
+  /// Passing `null` restores copying the entire surface.
+  Future<void> setVisibleRect(Rect? rect) async {
+    if (_isDisposed) {
+      return;
+    }
+    assert(value.isInitialized);
+    return _methodChannel.invokeMethod('setVisibleRect',
+        rect == null ? null : [rect.left, rect.top, rect.width, rect.height]);
+  }
+
+  /// Sets how frames are captured from the webview.
+  ///
+  /// In [WebviewRenderMode.onDemand], a frame is captured when calling
+  /// [requestFrame], or once [settleDelay] has passed after the last
+  /// navigation or input event.
+  Future<void> setRenderMode(WebviewRenderMode mode,
+      {Duration? settleDelay}) async {
+    if (_isDisposed) {
+      return;
+    }
+    assert(value.isInitialized);
+    return _methodChannel.invokeMethod(
+        'setRenderMode', [mode.index, settleDelay?.inMilliseconds]);
+  }
+
+  /// Configures the watchdog restarting hung renderers, which is enabled by
+  /// default.
+  ///
+  /// A trivial script is run every [heartbeatInterval] (2 seconds by
+  /// default). If it doesn't complete within [heartbeatTimeout] (3 seconds
+  /// by default) while no frames arrive, the renderer is considered hung
+  /// and restarted (see [rendererFailure]). Crashed renderers are only
+  /// restarted while the watchdog is enabled. Restarts following each other
+  /// without the renderer recovering are delayed increasingly, and given up
+  /// after the third.
+  Future<void> setRendererWatchdog(
+      {bool enabled = true,
+      Duration? heartbeatInterval,
+      Duration? heartbeatTimeout}) async {
+    if (_isDisposed) {
+      return;
+    }
+    assert(value.isInitialized);
+    return _methodChannel.invokeMethod('setRendererWatchdog', [
+      enabled,
+      heartbeatInterval?.inMilliseconds,
+      heartbeatTimeout?.inMilliseconds
+    ]);
+  }
+
+  /// Captures a single frame in [WebviewRenderMode.onDemand].
+  ///
+  /// Completes once the frame has been delivered. Completes immediately in
+  /// [WebviewRenderMode.continuous].
+  Future<void> requestFrame() async {
+    if (_isDisposed) {
+      return;
+    }
+    assert(value.isInitialized);
+    return _methodChannel.invokeMethod('requestFrame');
+  }
+
+  /// Creates an additional texture fed by this webview's capture and returns
+  /// its texture id, which can be shown using a [Texture] widget.
+  ///
+  /// The texture shows the region [sourceRect] of the webview (in logical
+  /// pixels), or the entire webview if omitted, scaled to [size]. Views with
+  /// the same region and size share a single copy per frame.
+  ///
+  /// Texture views are disposed together with the webview, or earlier
+  /// using [disposeTextureView].
+  Future<int?> createTextureView({Rect? sourceRect, Size? size}) async {
+    if (_isDisposed) {
+      return null;
+    }
+    assert(value.isInitialized);
+    return _methodChannel.invokeMethod<int>('createTextureView', [
+      sourceRect == null
+          ? null
+          : [
+              sourceRect.left,
+              sourceRect.top,
+              sourceRect.width,
+              sourceRect.height
+            ],
+      size?.width,
+      size?.height
+    ]);
+  }
+
+  /// Disposes a texture created using [createTextureView].
+  Future<void> disposeTextureView(int textureId) async {
+    if (_isDisposed) {
+      return;
+    }
+    assert(value.isInitialized);
+    return _methodChannel.invokeMethod('disposeTextureView', textureId);
+  }
+
   /// Sends a Pointer (Touch) update
   Future<void> _setPointerUpdate(WebviewPointerEventKind kind, int pointer,
       Offset position, double size, double pressure) async {
@@ -598,6 +1407,12 @@ class WebviewController extends ValueNotifier<WebviewValue> {
 class Webview extends StatefulWidget {
   final WebviewController controller;
   final PermissionRequestedDelegate? permissionRequested;
+
+  /// If set, decisions of [permissionRequested] other than
+  /// [WebviewPermissionDecision.none] are remembered natively for this long,
+  /// per origin and permission kind. Repeated requests are then answered
+  /// without calling [permissionRequested].
+  final Duration? rememberPermissionDecisions;
   final double? width;
   final double? height;
 
@@ -617,6 +1432,7 @@ class Webview extends StatefulWidget {
       {this.width,
       this.height,
       this.permissionRequested,
+      this.rememberPermissionDecisions,
       this.scaleFactor,
       this.filterQuality = FilterQuality.none});
 
@@ -643,6 +1459,8 @@ class _WebviewState extends State<Webview> {
     // TODO: Refactor callback and event handling and
     // remove this line
     _controller._permissionRequested = widget.permissionRequested;
+    _controller._rememberPermissionDecisions =
+        widget.rememberPermissionDecisions;
 
     // Report initial surface size
     WidgetsBinding.instance.addPostFrameCallback((_) => _reportSurfaceSize());
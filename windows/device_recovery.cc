@@ -0,0 +1,64 @@
+#include "device_recovery.h"
+
+#include <algorithm>
+#include <iostream>
+
+DeviceRecovery::DeviceRecovery(DeviceFactory recreate_device,
+                               TaskPoster post_task, int max_attempts)
+    : recreate_device_(std::move(recreate_device)),
+      post_task_(std::move(post_task)),
+      // The first attempt isn't delayed.
+      backoff_(kRetryInitialDelay, kRetryMaxDelay, max_attempts - 1) {}
+
+void DeviceRecovery::AddClient(Client* client) {
+  const std::lock_guard<std::mutex> lock(mutex_);
+  clients_.push_back(client);
+}
+
+void DeviceRecovery::RemoveClient(Client* client) {
+  const std::lock_guard<std::mutex> lock(mutex_);
+  clients_.erase(std::remove(clients_.begin(), clients_.end(), client),
+                 clients_.end());
+}
+
+void DeviceRecovery::NotifyDeviceLost() {
+  bool expected = false;
+  if (!device_lost_.compare_exchange_strong(expected, true)) {
+    // A recovery is already pending.
+    return;
+  }
+  post_task_([this]() { Recover(); }, std::chrono::milliseconds::zero());
+}
+
+void DeviceRecovery::Recover() {
+  if (backoff_.attempt() == 0) {
+    for (auto client : GetClients()) {
+      client->OnDeviceLost();
+    }
+  }
+
+  if (!recreate_device_()) {
+    if (const auto delay = backoff_.Next()) {
+      post_task_([this]() { Recover(); }, *delay);
+    } else {
+      // Give up, but keep the device marked as lost so that subsequent
+      // notifications don't end up in a recovery loop.
+      given_up_ = true;
+      std::cerr << "Recreating the graphics device failed." << std::endl;
+    }
+    return;
+  }
+
+  backoff_.Reset();
+  recovery_count_++;
+  device_lost_ = false;
+
+  for (auto client : GetClients()) {
+    client->OnDeviceRestored();
+  }
+}
+
+std::vector<DeviceRecovery::Client*> DeviceRecovery::GetClients() {
+  const std::lock_guard<std::mutex> lock(mutex_);
+  return clients_;
+}
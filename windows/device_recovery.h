@@ -0,0 +1,75 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+#include "util/backoff.h"
+
+// Coordinates the recovery from a removed or reset graphics device (e.g.
+// after a driver update or a TDR).
+//
+// Losing the device may be reported from any thread. The recovery itself
+// (releasing all device resources, recreating the device and restoring the
+// resources) is always carried out on the thread |post_task| posts to.
+// Failing to recreate the device is retried with growing delays, since the
+// GPU may be unavailable for a while (e.g. during a driver update).
+class DeviceRecovery {
+ public:
+  class Client {
+   public:
+    virtual ~Client() = default;
+
+    // Called before the device gets recreated. Clients must release all
+    // resources belonging to the lost device.
+    virtual void OnDeviceLost() = 0;
+
+    // Called after the device has been recreated successfully.
+    virtual void OnDeviceRestored() = 0;
+  };
+
+  typedef std::function<bool()> DeviceFactory;
+  // Runs a task after |delay|, which is zero for the first attempt.
+  typedef std::function<void(std::function<void()> task,
+                             std::chrono::milliseconds delay)>
+      TaskPoster;
+
+  // Retries follow after 250ms, 500ms, ... up to 8s, adding up to about
+  // 24s before giving up.
+  static constexpr int kDefaultMaxAttempts = 8;
+  static constexpr std::chrono::milliseconds kRetryInitialDelay{250};
+  static constexpr std::chrono::milliseconds kRetryMaxDelay{8000};
+
+  DeviceRecovery(DeviceFactory recreate_device, TaskPoster post_task,
+                 int max_attempts = kDefaultMaxAttempts);
+
+  void AddClient(Client* client);
+  void RemoveClient(Client* client);
+
+  // Reports the device as lost and schedules a recovery unless one is
+  // already pending. Can be called from any thread.
+  void NotifyDeviceLost();
+
+  bool is_device_lost() const { return device_lost_; }
+  // Set once all attempts have failed. The device stays lost.
+  bool has_given_up() const { return given_up_; }
+  size_t recovery_count() const { return recovery_count_; }
+
+ private:
+  DeviceFactory recreate_device_;
+  TaskPoster post_task_;
+
+  std::mutex mutex_;
+  std::vector<Client*> clients_;
+  std::atomic<bool> device_lost_ = false;
+  std::atomic<size_t> recovery_count_ = 0;
+  // Only used on the recovery thread.
+  util::Backoff backoff_;
+  std::atomic<bool> given_up_ = false;
+
+  void Recover();
+  std::vector<Client*> GetClients();
+};
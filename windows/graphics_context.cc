@@ -1,22 +1,161 @@
 #include "graphics_context.h"
 
+#include <d3d11_4.h>
+
 #include "util/d3dutil.h"
 #include "util/direct3d11.interop.h"
 
-GraphicsContext::GraphicsContext(rx::RoHelper* rohelper) : rohelper_(rohelper) {
+GraphicsContext::GraphicsContext(rx::RoHelper* rohelper,
+                                 TaskRunner* task_runner)
+    : rohelper_(rohelper),
+      task_runner_(task_runner),
+      device_recovery_(
+          [this]() {
+            ReleaseDevice();
+            valid_ = CreateDevice();
+            return valid_;
+          },
+          [task_runner](std::function<void()> task,
+                        std::chrono::milliseconds delay) {
+            if (delay.count() > 0) {
+              task_runner->PostDelayedTask(std::move(task), delay);
+            } else {
+              task_runner->PostTask(std::move(task));
+            }
+          }) {
+  valid_ = CreateDevice();
+}
+
+GraphicsContext::~GraphicsContext() { ReleaseDevice(); }
+
+GraphicsContext::ScopedContextLock::ScopedContextLock(
+    const GraphicsContext* context)
+    : multithread_(context->multithread_.get()) {
+  if (multithread_) {
+    multithread_->Enter();
+  }
+}
+
+GraphicsContext::ScopedContextLock::~ScopedContextLock() {
+  if (multithread_) {
+    multithread_->Leave();
+  }
+}
+
+bool GraphicsContext::CreateDevice() {
   device_ = CreateD3DDevice();
   if (!device_) {
-    return;
+    return false;
   }
 
   device_->GetImmediateContext(device_context_.put());
+
+  // Windows.Graphics.Capture and our own copies use the immediate context
+  // from different threads.
+  multithread_ = device_context_.try_as<ID3D11Multithread>();
+  if (multithread_) {
+    multithread_->SetMultithreadProtected(TRUE);
+  }
+
   if (FAILED(util::CreateDirect3D11DeviceFromDXGIDevice(
           device_.try_as<IDXGIDevice>().get(),
           (IInspectable**)device_winrt_.put()))) {
+    return false;
+  }
+
+  WatchDeviceRemoved();
+  return true;
+}
+
+void GraphicsContext::ReleaseDevice() {
+  UnwatchDeviceRemoved();
+
+  device_winrt_ = nullptr;
+  multithread_ = nullptr;
+  if (device_context_) {
+    device_context_->ClearState();
+    device_context_->Flush();
+  }
+  device_context_ = nullptr;
+  device_ = nullptr;
+}
+
+bool GraphicsContext::CheckDeviceRemoved() {
+  if (device_recovery_.is_device_lost()) {
+    return true;
+  }
+
+  if (device_ && FAILED(device_->GetDeviceRemovedReason())) {
+    device_recovery_.NotifyDeviceLost();
+    return true;
+  }
+  return false;
+}
+
+void GraphicsContext::WatchDeviceRemoved() {
+  auto device4 = device_.try_as<ID3D11Device4>();
+  if (!device4) {
     return;
   }
 
-  valid_ = true;
+  device_removed_event_.reset(CreateEvent(nullptr, FALSE, FALSE, nullptr));
+  if (!device_removed_event_ ||
+      FAILED(device4->RegisterDeviceRemovedEvent(device_removed_event_.get(),
+                                                 &device_removed_cookie_))) {
+    device_removed_event_.reset();
+    return;
+  }
+
+  // The callback is invoked on a thread pool thread.
+  RegisterWaitForSingleObject(
+      &device_removed_wait_, device_removed_event_.get(),
+      [](PVOID context, BOOLEAN timed_out) {
+        auto self = static_cast<GraphicsContext*>(context);
+        self->device_recovery_.NotifyDeviceLost();
+      },
+      this, INFINITE, WT_EXECUTEONLYONCE);
+}
+
+void GraphicsContext::UnwatchDeviceRemoved() {
+  if (device_removed_wait_) {
+    // Blocks until a running callback has returned.
+    UnregisterWaitEx(device_removed_wait_, INVALID_HANDLE_VALUE);
+    device_removed_wait_ = nullptr;
+  }
+
+  if (device_removed_cookie_) {
+    auto device4 = device_.try_as<ID3D11Device4>();
+    if (device4) {
+      device4->UnregisterDeviceRemoved(device_removed_cookie_);
+    }
+    device_removed_cookie_ = 0;
+  }
+
+  device_removed_event_.reset();
+}
+
+winrt::com_ptr<ID3D11DeviceContext> GraphicsContext::CreateDeferredContext()
+    const {
+  winrt::com_ptr<ID3D11DeviceContext> deferred_context;
+  if (!device_ ||
+      FAILED(device_->CreateDeferredContext(0, deferred_context.put()))) {
+    return nullptr;
+  }
+  return deferred_context;
+}
+
+bool GraphicsContext::ExecuteDeferredCommands(
+    ID3D11DeviceContext* deferred_context) {
+  // Finishing the command list doesn't touch the immediate context.
+  winrt::com_ptr<ID3D11CommandList> command_list;
+  if (FAILED(deferred_context->FinishCommandList(FALSE, command_list.put()))) {
+    return false;
+  }
+
+  const ScopedContextLock context_lock(this);
+  device_context_->ExecuteCommandList(command_list.get(), FALSE);
+  device_context_->Flush();
+  return true;
 }
 
 winrt::com_ptr<ABI::Windows::UI::Composition::ICompositor>
@@ -1,18 +1,49 @@
 #pragma once
 
 #include <D3d11.h>
+#include <d3d11_4.h>
+#include <wil/resource.h>
 #include <windows.graphics.capture.h>
 #include <windows.ui.composition.h>
 #include <winrt/Windows.Foundation.h>
 
+#include "device_recovery.h"
+#include "task_runner.h"
 #include "util/rohelper.h"
 
 class GraphicsContext {
  public:
-  GraphicsContext(rx::RoHelper* rohelper);
+  // Grants the calling thread exclusive access to the immediate context for
+  // the lifetime of the object.
+  // The immediate context is shared between the platform thread (capturing)
+  // and the raster thread (copying), so every sequence of commands issued on
+  // it must hold this lock. Copies on the raster thread are recorded on
+  // deferred contexts instead, and only lock for submission (see
+  // ExecuteDeferredCommands).
+  class ScopedContextLock {
+   public:
+    explicit ScopedContextLock(const GraphicsContext* context);
+    ~ScopedContextLock();
+
+    ScopedContextLock(const ScopedContextLock&) = delete;
+    ScopedContextLock& operator=(const ScopedContextLock&) = delete;
+
+   private:
+    ID3D11Multithread* multithread_;
+  };
+
+  GraphicsContext(rx::RoHelper* rohelper, TaskRunner* task_runner);
+  ~GraphicsContext();
 
   inline bool IsValid() const { return valid_; }
 
+  DeviceRecovery* device_recovery() { return &device_recovery_; }
+  TaskRunner* task_runner() const { return task_runner_; }
+
+  // Reports the device as lost if it has been removed or reset.
+  // Returns true if the device is lost.
+  bool CheckDeviceRemoved();
+
   ABI::Windows::Graphics::DirectX::Direct3D11::IDirect3DDevice* device() const {
     return device_winrt_.get();
   }
@@ -21,6 +52,14 @@ class GraphicsContext {
     return device_context_.get();
   }
 
+  // Returns a context for recording commands without holding the
+  // ScopedContextLock, or nullptr. Deferred contexts aren't thread-safe.
+  winrt::com_ptr<ID3D11DeviceContext> CreateDeferredContext() const;
+
+  // Runs the commands recorded on |deferred_context| on the immediate
+  // context and flushes them.
+  bool ExecuteDeferredCommands(ID3D11DeviceContext* deferred_context);
+
   winrt::com_ptr<ABI::Windows::UI::Composition::ICompositor> CreateCompositor();
 
   winrt::com_ptr<ABI::Windows::Graphics::Capture::IGraphicsCaptureItem>
@@ -42,8 +81,20 @@ class GraphicsContext {
  private:
   bool valid_ = false;
   rx::RoHelper* rohelper_;
+  TaskRunner* task_runner_;
+  DeviceRecovery device_recovery_;
   winrt::com_ptr<ABI::Windows::Graphics::DirectX::Direct3D11::IDirect3DDevice>
       device_winrt_;
   winrt::com_ptr<ID3D11Device> device_{nullptr};
   winrt::com_ptr<ID3D11DeviceContext> device_context_{nullptr};
+  winrt::com_ptr<ID3D11Multithread> multithread_{nullptr};
+
+  wil::unique_handle device_removed_event_;
+  DWORD device_removed_cookie_ = 0;
+  HANDLE device_removed_wait_ = nullptr;
+
+  bool CreateDevice();
+  void ReleaseDevice();
+  void WatchDeviceRemoved();
+  void UnwatchDeviceRemoved();
 };
@@ -0,0 +1,226 @@
+#include "host_object.h"
+
+#include <wrl.h>
+
+#include <format>
+
+#include "util/string_converter.h"
+
+namespace {
+
+using namespace Microsoft::WRL;
+
+util::HostValue FromVariant(const VARIANT& variant) {
+  wil::unique_variant value;
+  if (FAILED(VariantCopyInd(&value, &variant))) {
+    return {};
+  }
+
+  switch (V_VT(&value)) {
+    case VT_BOOL:
+      return {V_BOOL(&value) != VARIANT_FALSE};
+    case VT_BSTR:
+      return {util::Utf8FromUtf16(
+          std::wstring_view(V_BSTR(&value), SysStringLen(V_BSTR(&value))))};
+    case VT_I1:
+    case VT_I2:
+    case VT_I4:
+    case VT_I8:
+    case VT_INT:
+    case VT_UI1:
+    case VT_UI2:
+    case VT_UI4:
+    case VT_UI8:
+    case VT_UINT:
+      if (SUCCEEDED(VariantChangeType(&value, &value, 0, VT_I8))) {
+        return {static_cast<int64_t>(V_I8(&value))};
+      }
+      break;
+    case VT_R4:
+    case VT_R8:
+      if (SUCCEEDED(VariantChangeType(&value, &value, 0, VT_R8))) {
+        return {V_R8(&value)};
+      }
+      break;
+  }
+  return {};
+}
+
+void ToVariant(const util::HostValue& value, VARIANT* out) {
+  VariantInit(out);
+  if (const auto flag = std::get_if<bool>(&value.value)) {
+    V_VT(out) = VT_BOOL;
+    V_BOOL(out) = *flag ? VARIANT_TRUE : VARIANT_FALSE;
+  } else if (const auto integer = std::get_if<int64_t>(&value.value)) {
+    // Scripts see all numbers as doubles anyway.
+    if (*integer >= INT32_MIN && *integer <= INT32_MAX) {
+      V_VT(out) = VT_I4;
+      V_I4(out) = static_cast<int32_t>(*integer);
+    } else {
+      V_VT(out) = VT_R8;
+      V_R8(out) = static_cast<double>(*integer);
+    }
+  } else if (const auto number = std::get_if<double>(&value.value)) {
+    V_VT(out) = VT_R8;
+    V_R8(out) = *number;
+  } else if (const auto string = std::get_if<std::string>(&value.value)) {
+    const auto wide = util::Utf16FromUtf8(*string);
+    V_VT(out) = VT_BSTR;
+    V_BSTR(out) =
+        SysAllocStringLen(wide.data(), static_cast<UINT>(wide.size()));
+  } else if (const auto list = std::get_if<util::HostValue::List>(
+                 &value.value)) {
+    // Safe arrays show up as arrays in scripts.
+    auto array = SafeArrayCreateVector(VT_VARIANT, 0,
+                                       static_cast<ULONG>(list->size()));
+    if (array) {
+      for (LONG i = 0; i < static_cast<LONG>(list->size()); i++) {
+        wil::unique_variant element;
+        ToVariant((*list)[i], &element);
+        SafeArrayPutElement(array, &i, &element);
+      }
+      V_VT(out) = VT_ARRAY | VT_VARIANT;
+      V_ARRAY(out) = array;
+    }
+  } else {
+    V_VT(out) = VT_NULL;
+  }
+}
+
+void InvokeCallback(IDispatch* callback, bool success,
+                    const util::HostValue& value) {
+  // Arguments are passed in reverse order.
+  VARIANT args[2];
+  ToVariant(value, &args[0]);
+  ToVariant(util::HostValue{success}, &args[1]);
+  DISPPARAMS params = {args, nullptr, 2, 0};
+  callback->Invoke(DISPID_VALUE, IID_NULL, LOCALE_USER_DEFAULT,
+                   DISPATCH_METHOD, &params, nullptr, nullptr, nullptr);
+  VariantClear(&args[0]);
+  VariantClear(&args[1]);
+}
+
+class HostObject : public RuntimeClass<RuntimeClassFlags<ClassicCom>,
+                                       IDispatch> {
+ public:
+  HostObject(std::shared_ptr<util::HostDispatcher> dispatcher,
+             DeferredHostCallCallback on_deferred_call)
+      : dispatcher_(std::move(dispatcher)),
+        on_deferred_call_(std::move(on_deferred_call)) {}
+
+  STDMETHODIMP GetTypeInfoCount(UINT* count) override {
+    *count = 0;
+    return S_OK;
+  }
+
+  STDMETHODIMP GetTypeInfo(UINT, LCID, ITypeInfo**) override {
+    return E_NOTIMPL;
+  }
+
+  STDMETHODIMP GetIDsOfNames(REFIID, LPOLESTR* names, UINT count, LCID,
+                             DISPID* ids) override {
+    if (count == 0) {
+      return E_INVALIDARG;
+    }
+    // Named arguments aren't supported.
+    for (UINT i = 1; i < count; i++) {
+      ids[i] = DISPID_UNKNOWN;
+    }
+
+    const auto id = dispatcher_->GetDispatchId(util::Utf8FromUtf16(names[0]));
+    ids[0] = id ? *id : DISPID_UNKNOWN;
+    return id && count == 1 ? S_OK : DISP_E_UNKNOWNNAME;
+  }
+
+  STDMETHODIMP Invoke(DISPID id, REFIID, LCID, WORD flags,
+                      DISPPARAMS* params, VARIANT* result, EXCEPINFO*,
+                      UINT*) override {
+    if (!(flags & (DISPATCH_METHOD | DISPATCH_PROPERTYGET))) {
+      return DISP_E_MEMBERNOTFOUND;
+    }
+    if (params->cNamedArgs > 0) {
+      return DISP_E_NONAMEDARGS;
+    }
+
+    // Arguments are passed in reverse order; a trailing function is the
+    // callback.
+    util::HostValue::List args;
+    wil::com_ptr<IDispatch> callback;
+    for (UINT i = params->cArgs; i-- > 0;) {
+      const auto& arg = params->rgvarg[i];
+      if (i == 0 && V_VT(&arg) == VT_DISPATCH && V_DISPATCH(&arg)) {
+        callback = V_DISPATCH(&arg);
+      } else {
+        args.push_back(FromVariant(arg));
+      }
+    }
+
+    util::HostValue value;
+    const auto invoke_result = dispatcher_->Invoke(
+        id, std::move(args), &value,
+        [callback](bool success, util::HostValue result) {
+          if (callback) {
+            InvokeCallback(callback.get(), success, result);
+          }
+        });
+
+    switch (invoke_result) {
+      case util::HostDispatcher::InvokeResult::kCompleted:
+        if (callback) {
+          InvokeCallback(callback.get(), true, value);
+        }
+        if (result) {
+          ToVariant(value, result);
+        }
+        return S_OK;
+      case util::HostDispatcher::InvokeResult::kDeferred:
+        if (on_deferred_call_) {
+          on_deferred_call_();
+        }
+        if (result) {
+          VariantInit(result);
+        }
+        return S_OK;
+      case util::HostDispatcher::InvokeResult::kUnknown:
+      default:
+        return DISP_E_MEMBERNOTFOUND;
+    }
+  }
+
+ private:
+  std::shared_ptr<util::HostDispatcher> dispatcher_;
+  DeferredHostCallCallback on_deferred_call_;
+};
+
+}  // namespace
+
+wil::com_ptr<IDispatch> CreateHostObject(
+    std::shared_ptr<util::HostDispatcher> dispatcher,
+    DeferredHostCallCallback on_deferred_call) {
+  wil::com_ptr<IDispatch> object;
+  object.attach(Make<HostObject>(std::move(dispatcher),
+                                 std::move(on_deferred_call))
+                    .Detach());
+  return object;
+}
+
+std::string GetHostObjectScript(const std::string& name) {
+  // "then" is excluded so that the proxy itself isn't mistaken for a
+  // Promise.
+  return std::format(
+      R"((() => {{
+  const host = chrome.webview.hostObjects.sync.{0};
+  window.{0}Host = new Proxy({{}}, {{
+    get: (_, name) => name === 'then' ? undefined : (...args) =>
+      new Promise((resolve, reject) => {{
+        try {{
+          host[name](...args, (ok, value) =>
+            ok ? resolve(value) : reject(new Error(value)));
+        }} catch (e) {{
+          reject(e);
+        }}
+      }})
+  }});
+}})();)",
+      name);
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <oaidl.h>
+#include <wil/com.h>
+
+#include <functional>
+#include <memory>
+#include <string>
+
+#include "util/host_dispatcher.h"
+
+// Called after a call to a deferred host function has been queued.
+typedef std::function<void()> DeferredHostCallCallback;
+
+// Creates an IDispatch exposing the functions registered with |dispatcher|
+// as methods, to be added with ICoreWebView2::AddHostObjectToScript.
+//
+// Native functions return their result to synchronous callers right away.
+// If the last argument is a function, it is also called with (success,
+// result), which is the only way to get the result of deferred functions.
+wil::com_ptr<IDispatch> CreateHostObject(
+    std::shared_ptr<util::HostDispatcher> dispatcher,
+    DeferredHostCallCallback on_deferred_call);
+
+// Returns a document script defining window.<name>Host, which wraps every
+// function of the host object |name| in a Promise.
+std::string GetHostObjectScript(const std::string& name);
@@ -0,0 +1,87 @@
+#include "task_runner.h"
+
+#include <wrl.h>
+
+#include <algorithm>
+
+TaskRunner::TaskRunner(
+    winrt::com_ptr<ABI::Windows::System::IDispatcherQueue> dispatcher_queue)
+    : dispatcher_queue_(std::move(dispatcher_queue)) {}
+
+TaskRunner::~TaskRunner() {
+  const std::lock_guard<std::mutex> lock(timers_mutex_);
+  for (const auto& timer : timers_) {
+    timer->Stop();
+  }
+}
+
+bool TaskRunner::PostTask(Task task) {
+  if (!dispatcher_queue_) {
+    return false;
+  }
+
+  boolean enqueued = false;
+  auto hr = dispatcher_queue_->TryEnqueue(
+      Microsoft::WRL::Callback<ABI::Windows::System::IDispatcherQueueHandler>(
+          [task = std::move(task)]() -> HRESULT {
+            task();
+            return S_OK;
+          })
+          .Get(),
+      &enqueued);
+  return SUCCEEDED(hr) && enqueued;
+}
+
+bool TaskRunner::PostDelayedTask(Task task, std::chrono::milliseconds delay) {
+  if (!dispatcher_queue_) {
+    return false;
+  }
+
+  winrt::com_ptr<ABI::Windows::System::IDispatcherQueueTimer> timer;
+  if (FAILED(dispatcher_queue_->CreateTimer(timer.put()))) {
+    return false;
+  }
+
+  // TimeSpan is measured in 100ns units.
+  ABI::Windows::Foundation::TimeSpan interval;
+  typedef std::chrono::duration<int64_t, std::ratio<1, 10'000'000>> Ticks;
+  interval.Duration = std::chrono::duration_cast<Ticks>(delay).count();
+  timer->put_Interval(interval);
+  timer->put_IsRepeating(false);
+
+  EventRegistrationToken token;
+  auto hr = timer->add_Tick(
+      Microsoft::WRL::Callback<ABI::Windows::Foundation::ITypedEventHandler<
+          ABI::Windows::System::DispatcherQueueTimer*, IInspectable*>>(
+          [this, task = std::move(task)](
+              ABI::Windows::System::IDispatcherQueueTimer* sender,
+              IInspectable* args) -> HRESULT {
+            // Keep the timer alive while its handler is running.
+            winrt::com_ptr<ABI::Windows::System::IDispatcherQueueTimer> self;
+            {
+              const std::lock_guard<std::mutex> lock(timers_mutex_);
+              const auto it = std::find_if(
+                  timers_.begin(), timers_.end(), [sender](const auto& timer) {
+                    return timer.get() == sender;
+                  });
+              if (it != timers_.end()) {
+                self = std::move(*it);
+                timers_.erase(it);
+              }
+            }
+            task();
+            return S_OK;
+          })
+          .Get(),
+      &token);
+  if (FAILED(hr)) {
+    return false;
+  }
+
+  const std::lock_guard<std::mutex> lock(timers_mutex_);
+  if (FAILED(timer->Start())) {
+    return false;
+  }
+  timers_.push_back(std::move(timer));
+  return true;
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <windows.system.h>
+#include <winrt/base.h>
+
+#include <chrono>
+#include <functional>
+#include <list>
+#include <mutex>
+
+// Posts tasks to the thread owning a DispatcherQueue, i.e. the platform
+// thread.
+class TaskRunner {
+ public:
+  typedef std::function<void()> Task;
+
+  explicit TaskRunner(
+      winrt::com_ptr<ABI::Windows::System::IDispatcherQueue> dispatcher_queue);
+  ~TaskRunner();
+
+  // Can be called from any thread.
+  bool PostTask(Task task);
+
+  // Runs |task| once |delay| has passed. Can be called from any thread.
+  bool PostDelayedTask(Task task, std::chrono::milliseconds delay);
+
+ private:
+  winrt::com_ptr<ABI::Windows::System::IDispatcherQueue> dispatcher_queue_;
+
+  // Pending timers need to be kept alive until they fire.
+  std::mutex timers_mutex_;
+  std::list<winrt::com_ptr<ABI::Windows::System::IDispatcherQueueTimer>>
+      timers_;
+};
@@ -0,0 +1,64 @@
+#include "util/adaptive_poller.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+
+namespace {
+
+using util::AdaptivePoller;
+using namespace std::chrono_literals;
+
+TEST(AdaptivePollerTest, BacksOffWhileUnchanged) {
+  AdaptivePoller poller(10ms, 100ms);
+  EXPECT_EQ(poller.interval(), 10ms);
+  EXPECT_EQ(poller.OnPoll(false, 0ms), 20ms);
+  EXPECT_EQ(poller.OnPoll(false, 0ms), 40ms);
+  EXPECT_EQ(poller.OnPoll(false, 0ms), 80ms);
+  EXPECT_EQ(poller.OnPoll(false, 0ms), 100ms);
+  EXPECT_EQ(poller.OnPoll(false, 0ms), 100ms);
+}
+
+TEST(AdaptivePollerTest, ResetsWhenChanged) {
+  AdaptivePoller poller(10ms, 100ms);
+  poller.OnPoll(false, 0ms);
+  poller.OnPoll(false, 0ms);
+  EXPECT_EQ(poller.OnPoll(true, 0ms), 10ms);
+  EXPECT_EQ(poller.interval(), 10ms);
+}
+
+TEST(AdaptivePollerTest, ResetsOnActivity) {
+  AdaptivePoller poller(10ms, 100ms);
+  poller.OnPoll(false, 0ms);
+  poller.OnPoll(false, 0ms);
+  poller.NotifyActivity();
+  EXPECT_EQ(poller.interval(), 10ms);
+  EXPECT_EQ(poller.OnPoll(false, 0ms), 20ms);
+}
+
+TEST(AdaptivePollerTest, SpacesPollsBySlowPolls) {
+  AdaptivePoller poller(10ms, 100ms);
+  EXPECT_EQ(poller.OnPoll(true, 25ms), 25ms);
+  EXPECT_EQ(poller.interval(), 10ms);
+  EXPECT_EQ(poller.OnPoll(true, 250ms), 250ms);
+}
+
+TEST(AdaptivePollerTest, ClampsMinInterval) {
+  AdaptivePoller clamped(200ms, 100ms);
+  EXPECT_EQ(clamped.min_interval(), 100ms);
+  EXPECT_EQ(clamped.OnPoll(true, 0ms), 100ms);
+
+  AdaptivePoller poller(10ms, 100ms);
+  poller.set_min_interval(50ms);
+  EXPECT_EQ(poller.interval(), 50ms);
+  EXPECT_EQ(poller.OnPoll(true, 0ms), 50ms);
+  poller.set_min_interval(1s);
+  EXPECT_EQ(poller.min_interval(), 100ms);
+
+  // Lowering the minimum keeps the current interval.
+  poller.set_min_interval(5ms);
+  EXPECT_EQ(poller.interval(), 100ms);
+  EXPECT_EQ(poller.OnPoll(true, 0ms), 5ms);
+}
+
+}  // namespace
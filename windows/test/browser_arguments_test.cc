@@ -0,0 +1,115 @@
+#include "util/browser_arguments.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+namespace {
+
+using util::BrowserArguments;
+using util::PerformanceProfile;
+typedef std::vector<std::string> Features;
+
+BrowserArguments Parse(std::string_view command_line) {
+  auto arguments = BrowserArguments::Parse(command_line);
+  EXPECT_TRUE(arguments) << command_line;
+  return arguments.value_or(BrowserArguments());
+}
+
+TEST(BrowserArgumentsTest, ParsesSwitches) {
+  const auto arguments =
+      Parse("--flag -short --name=value  --quoted=\"a b\"\t--empty=");
+  EXPECT_TRUE(arguments.HasSwitch("flag"));
+  EXPECT_FALSE(arguments.GetSwitchValue("flag"));
+  EXPECT_TRUE(arguments.HasSwitch("short"));
+  EXPECT_EQ(arguments.GetSwitchValue("name"), "value");
+  EXPECT_EQ(arguments.GetSwitchValue("quoted"), "a b");
+  EXPECT_EQ(arguments.GetSwitchValue("empty"), "");
+  EXPECT_FALSE(arguments.HasSwitch("missing"));
+}
+
+TEST(BrowserArgumentsTest, ParsesEmptyCommandLine) {
+  EXPECT_EQ(Parse("").ToString(), "");
+  EXPECT_EQ(Parse("  ").ToString(), "");
+}
+
+TEST(BrowserArgumentsTest, RejectsMalformedCommandLines) {
+  EXPECT_FALSE(BrowserArguments::Parse("--name=\"unbalanced"));
+  EXPECT_FALSE(BrowserArguments::Parse("positional"));
+  EXPECT_FALSE(BrowserArguments::Parse("--flag positional"));
+  EXPECT_FALSE(BrowserArguments::Parse("--=value"));
+}
+
+TEST(BrowserArgumentsTest, LaterSwitchesWin) {
+  const auto arguments = Parse("--a=1 --b --a=2");
+  EXPECT_EQ(arguments.GetSwitchValue("a"), "2");
+  // The first occurrence keeps its position.
+  EXPECT_EQ(arguments.ToString(), "--a=2 --b");
+}
+
+TEST(BrowserArgumentsTest, CollectsFeatureLists) {
+  const auto arguments = Parse(
+      "--enable-features=A,B --disable-features=C,,D --enable-features=C");
+  EXPECT_EQ(arguments.enabled_features(), (Features{"A", "B", "C"}));
+  EXPECT_EQ(arguments.disabled_features(), (Features{"D"}));
+  EXPECT_FALSE(arguments.HasSwitch("enable-features"));
+}
+
+TEST(BrowserArgumentsTest, SerializesSwitchesThenFeatures) {
+  const auto arguments =
+      Parse("--enable-features=A --x=\"a b\" --disable-features=B --y");
+  EXPECT_EQ(arguments.ToString(),
+            "--x=\"a b\" --y --enable-features=A --disable-features=B");
+  // Serializing round-trips.
+  EXPECT_EQ(Parse(arguments.ToString()).ToString(), arguments.ToString());
+}
+
+TEST(BrowserArgumentsTest, MergeOverridesSwitches) {
+  auto base = Parse("--a=1 --b=2 --c");
+  base.Merge(Parse("--b=3 --d"));
+  EXPECT_EQ(base.ToString(), "--a=1 --b=3 --c --d");
+}
+
+TEST(BrowserArgumentsTest, MergeUnitesFeatureLists) {
+  auto base = Parse("--enable-features=A,B --disable-features=C");
+  base.Merge(Parse("--enable-features=B,D --disable-features=E"));
+  EXPECT_EQ(base.enabled_features(), (Features{"A", "B", "D"}));
+  EXPECT_EQ(base.disabled_features(), (Features{"C", "E"}));
+}
+
+TEST(BrowserArgumentsTest, MergeOverridesDecideAboutConflictingFeatures) {
+  auto base = Parse("--enable-features=A,B --disable-features=C,D");
+  base.Merge(Parse("--enable-features=C --disable-features=A"));
+  EXPECT_EQ(base.enabled_features(), (Features{"B", "C"}));
+  EXPECT_EQ(base.disabled_features(), (Features{"D", "A"}));
+}
+
+TEST(BrowserArgumentsTest, UserArgumentsOverrideProfile) {
+  auto arguments = BrowserArguments::ForProfile(PerformanceProfile::kLowMemory);
+  EXPECT_EQ(arguments.GetSwitchValue("renderer-process-limit"), "2");
+  EXPECT_EQ(arguments.disabled_features(), (Features{"BackForwardCache"}));
+
+  arguments.Merge(Parse(
+      "--renderer-process-limit=4 --enable-features=BackForwardCache,X"));
+  EXPECT_EQ(arguments.GetSwitchValue("renderer-process-limit"), "4");
+  EXPECT_TRUE(arguments.HasSwitch("enable-low-end-device-mode"));
+  EXPECT_EQ(arguments.enabled_features(),
+            (Features{"BackForwardCache", "X"}));
+  EXPECT_TRUE(arguments.disabled_features().empty());
+}
+
+TEST(BrowserArgumentsTest, ProfilesDiffer) {
+  const auto low = BrowserArguments::ForProfile(PerformanceProfile::kLowMemory);
+  const auto balanced =
+      BrowserArguments::ForProfile(PerformanceProfile::kBalanced);
+  const auto max =
+      BrowserArguments::ForProfile(PerformanceProfile::kMaxThroughput);
+  EXPECT_NE(low.ToString(), balanced.ToString());
+  EXPECT_NE(balanced.ToString(), max.ToString());
+  EXPECT_TRUE(max.HasSwitch("disable-renderer-backgrounding"));
+  EXPECT_EQ(max.disabled_features(),
+            (Features{"CalculateNativeWinOcclusion"}));
+}
+
+}  // namespace
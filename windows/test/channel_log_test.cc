@@ -0,0 +1,315 @@
+#include "util/channel_log.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+using util::ChannelRecord;
+using util::ChannelRecorder;
+using Kind = ChannelRecord::Kind;
+using Payload = ChannelRecord::Payload;
+using namespace std::chrono_literals;
+
+// Builds messages in the format of flutter::StandardMessageCodec.
+class MessageBuilder {
+ public:
+  MessageBuilder& String(const std::string& value) {
+    bytes_.push_back(7);
+    bytes_.push_back(static_cast<uint8_t>(value.size()));
+    bytes_.insert(bytes_.end(), value.begin(), value.end());
+    return *this;
+  }
+
+  MessageBuilder& Int32(int32_t value) {
+    bytes_.push_back(3);
+    for (int i = 0; i < 4; i++) {
+      bytes_.push_back(static_cast<uint8_t>(value >> (i * 8)));
+    }
+    return *this;
+  }
+
+  MessageBuilder& Float64(uint8_t byte) {
+    bytes_.push_back(6);
+    while (bytes_.size() % 8 != 0) {
+      bytes_.push_back(0);
+    }
+    bytes_.insert(bytes_.end(), 8, byte);
+    return *this;
+  }
+
+  MessageBuilder& Bytes(const std::vector<uint8_t>& value) {
+    bytes_.push_back(8);
+    bytes_.push_back(static_cast<uint8_t>(value.size()));
+    bytes_.insert(bytes_.end(), value.begin(), value.end());
+    return *this;
+  }
+
+  MessageBuilder& List(uint8_t size) {
+    bytes_.push_back(12);
+    bytes_.push_back(size);
+    return *this;
+  }
+
+  MessageBuilder& Map(uint8_t size) {
+    bytes_.push_back(13);
+    bytes_.push_back(size);
+    return *this;
+  }
+
+  MessageBuilder& Raw(uint8_t byte) {
+    bytes_.push_back(byte);
+    return *this;
+  }
+
+  std::vector<uint8_t> Build() const { return bytes_; }
+
+ private:
+  std::vector<uint8_t> bytes_;
+};
+
+class ChannelLogTest : public testing::Test {
+ protected:
+  ChannelLogTest() : start_(ChannelRecorder::Clock::now()) {}
+
+  std::unique_ptr<ChannelRecorder> CreateRecorder(bool redact) {
+    auto out = std::make_unique<std::ostringstream>();
+    out_ = out.get();
+    return std::make_unique<ChannelRecorder>(std::move(out), redact, start_);
+  }
+
+  std::vector<uint8_t> Data() const {
+    const auto data = out_->str();
+    return std::vector<uint8_t>(data.begin(), data.end());
+  }
+
+  std::vector<ChannelRecord> Read() const {
+    const auto data = Data();
+    std::vector<ChannelRecord> records;
+    EXPECT_TRUE(util::ReadChannelLog(data.data(), data.size(), &records));
+    return records;
+  }
+
+  ChannelRecorder::Clock::time_point start_;
+  std::ostringstream* out_ = nullptr;
+};
+
+TEST_F(ChannelLogTest, RoundTripsRecords) {
+  const auto arguments =
+      MessageBuilder().Map(1).String("url").String("https://a.com").Build();
+  const auto result =
+      MessageBuilder().Map(1).String("textureId").Int32(7).Build();
+
+  auto recorder = CreateRecorder(false);
+  EXPECT_EQ(recorder->Record(Kind::kMethodCall, util::kPluginChannel,
+                             "initialize", arguments, start_ + 1ms),
+            0u);
+  recorder->RecordResult(0, "initialize", result, start_ + 3ms);
+  EXPECT_EQ(recorder->Record(Kind::kMethodCall, 7, "loadUrl", arguments,
+                             start_ + 3ms),
+            2u);
+  EXPECT_EQ(recorder->Record(Kind::kEvent, 7, "urlChanged", {},
+                             start_ + 10s),
+            3u);
+  EXPECT_EQ(recorder->record_count(), 4u);
+  EXPECT_TRUE(recorder->Flush());
+
+  const auto records = Read();
+  ASSERT_EQ(records.size(), 4u);
+
+  EXPECT_EQ(records[0].kind, Kind::kMethodCall);
+  EXPECT_EQ(records[0].time, 1ms);
+  EXPECT_EQ(records[0].texture_id, util::kPluginChannel);
+  EXPECT_EQ(records[0].name, "initialize");
+  EXPECT_EQ(records[0].payload, arguments);
+  EXPECT_EQ(records[0].payload_state, Payload::kComplete);
+  EXPECT_EQ(records[0].payload_size, arguments.size());
+
+  EXPECT_EQ(records[1].kind, Kind::kResult);
+  EXPECT_EQ(records[1].time, 3ms);
+  EXPECT_EQ(records[1].name, "initialize");
+  EXPECT_EQ(records[1].call, 0u);
+  EXPECT_EQ(records[1].payload, result);
+
+  EXPECT_EQ(records[2].texture_id, 7);
+  EXPECT_EQ(records[2].time, 3ms);
+  EXPECT_EQ(records[2].name, "loadUrl");
+
+  EXPECT_EQ(records[3].kind, Kind::kEvent);
+  EXPECT_EQ(records[3].time, 10s);
+  EXPECT_EQ(records[3].name, "urlChanged");
+  EXPECT_TRUE(records[3].payload.empty());
+}
+
+TEST_F(ChannelLogTest, StoresRecordsOutOfOrderWithoutDelay) {
+  auto recorder = CreateRecorder(false);
+  recorder->Record(Kind::kEvent, 1, "a", {}, start_ + 5ms);
+  recorder->Record(Kind::kEvent, 1, "b", {}, start_ + 2ms);
+  recorder->Record(Kind::kEvent, 1, "c", {}, start_ + 6ms);
+  recorder->Flush();
+
+  const auto records = Read();
+  ASSERT_EQ(records.size(), 3u);
+  EXPECT_EQ(records[0].time, 5ms);
+  EXPECT_EQ(records[1].time, 5ms);
+  EXPECT_EQ(records[2].time, 6ms);
+}
+
+TEST_F(ChannelLogTest, RedactsPayloads) {
+  const auto arguments = MessageBuilder()
+                             .Map(3)
+                             .String("url")
+                             .String("secret")
+                             .String("count")
+                             .Int32(42)
+                             .String("data")
+                             .Bytes({1, 2, 3})
+                             .Build();
+  auto recorder = CreateRecorder(true);
+  recorder->Record(Kind::kMethodCall, 1, "post", arguments, start_);
+  // Empty payloads stay complete.
+  recorder->Record(Kind::kMethodCall, 1, "reload", {}, start_);
+  recorder->Flush();
+
+  const auto records = Read();
+  ASSERT_EQ(records.size(), 2u);
+  EXPECT_EQ(records[0].payload_state, Payload::kRedacted);
+  EXPECT_EQ(records[0].payload_size, arguments.size());
+  EXPECT_EQ(records[0].payload, MessageBuilder()
+                                    .Map(3)
+                                    .String("url")
+                                    .String("******")
+                                    .String("count")
+                                    .Int32(42)
+                                    .String("data")
+                                    .Bytes({0, 0, 0})
+                                    .Build());
+  EXPECT_EQ(records[1].payload_state, Payload::kComplete);
+
+  // Nothing of the secret reaches the log.
+  const auto data = Data();
+  EXPECT_EQ(std::string(data.begin(), data.end()).find("secret"),
+            std::string::npos);
+}
+
+TEST_F(ChannelLogTest, DropsPayloadsThatCannotBeRedacted) {
+  // A custom type.
+  const auto arguments = MessageBuilder().List(1).Raw(128).Build();
+  auto recorder = CreateRecorder(true);
+  recorder->Record(Kind::kMethodCall, 1, "custom", arguments, start_);
+  recorder->Flush();
+
+  const auto records = Read();
+  ASSERT_EQ(records.size(), 1u);
+  EXPECT_EQ(records[0].payload_state, Payload::kDropped);
+  EXPECT_TRUE(records[0].payload.empty());
+  EXPECT_EQ(records[0].payload_size, arguments.size());
+}
+
+TEST_F(ChannelLogTest, RedactsNestedAndAlignedValues) {
+  auto message = MessageBuilder()
+                     .List(3)
+                     .Float64(0xAB)
+                     .List(1)
+                     .String("abc")
+                     .Map(1)
+                     .String("key")
+                     .Bytes({9})
+                     .Build();
+  ASSERT_TRUE(util::RedactStandardMessage(&message));
+  EXPECT_EQ(message, MessageBuilder()
+                         .List(3)
+                         .Float64(0xAB)
+                         .List(1)
+                         .String("***")
+                         .Map(1)
+                         .String("key")
+                         .Bytes({0})
+                         .Build());
+
+  auto truncated = MessageBuilder().String("abc").Build();
+  truncated.pop_back();
+  EXPECT_FALSE(util::RedactStandardMessage(&truncated));
+
+  auto trailing = MessageBuilder().Int32(1).Int32(2).Build();
+  EXPECT_FALSE(util::RedactStandardMessage(&trailing));
+}
+
+TEST_F(ChannelLogTest, ReadsTruncatedLogs) {
+  auto recorder = CreateRecorder(false);
+  for (int i = 0; i < 3; i++) {
+    recorder->Record(Kind::kMethodCall, i, "call" + std::to_string(i),
+                     MessageBuilder().Int32(i).Build(), start_ + i * 1ms);
+  }
+  recorder->Flush();
+  const auto data = Data();
+
+  size_t previous_count = 0;
+  for (size_t size = 5; size <= data.size(); size++) {
+    std::vector<ChannelRecord> records;
+    ASSERT_TRUE(util::ReadChannelLog(data.data(), size, &records)) << size;
+    EXPECT_GE(records.size(), previous_count);
+    for (size_t i = 0; i < records.size(); i++) {
+      EXPECT_EQ(records[i].name, "call" + std::to_string(i));
+    }
+    previous_count = records.size();
+  }
+  EXPECT_EQ(previous_count, 3u);
+}
+
+TEST_F(ChannelLogTest, RejectsMalformedLogs) {
+  auto recorder = CreateRecorder(false);
+  recorder->Record(Kind::kEvent, 1, "a", {}, start_);
+  recorder->Flush();
+  const auto data = Data();
+  std::vector<ChannelRecord> records;
+
+  EXPECT_FALSE(util::ReadChannelLog(data.data(), 4, &records));
+  auto bad_magic = data;
+  bad_magic[0] = 'X';
+  EXPECT_FALSE(
+      util::ReadChannelLog(bad_magic.data(), bad_magic.size(), &records));
+  auto bad_version = data;
+  bad_version[4] = 1;
+  EXPECT_FALSE(
+      util::ReadChannelLog(bad_version.data(), bad_version.size(), &records));
+  auto bad_kind = data;
+  bad_kind[5] = 3;
+  EXPECT_FALSE(util::ReadChannelLog(bad_kind.data(), bad_kind.size(),
+                                    &records));
+}
+
+TEST_F(ChannelLogTest, RejectsResultsWithoutCall) {
+  auto recorder = CreateRecorder(false);
+  recorder->Record(Kind::kEvent, 1, "event", {}, start_);
+  // Refers to an event.
+  recorder->RecordResult(0, "initialize", {}, start_);
+  recorder->Flush();
+  std::vector<ChannelRecord> records;
+  auto data = Data();
+  EXPECT_FALSE(util::ReadChannelLog(data.data(), data.size(), &records));
+
+  recorder = CreateRecorder(false);
+  // Refers to a later record.
+  recorder->RecordResult(1, "initialize", {}, start_);
+  recorder->Record(Kind::kMethodCall, -1, "initialize", {}, start_);
+  recorder->Flush();
+  data = Data();
+  EXPECT_FALSE(util::ReadChannelLog(data.data(), data.size(), &records));
+}
+
+TEST_F(ChannelLogTest, ReportsWriteFailures) {
+  auto recorder = CreateRecorder(false);
+  recorder->Record(Kind::kEvent, 1, "a", {}, start_);
+  EXPECT_TRUE(recorder->Flush());
+  out_->setstate(std::ios::badbit);
+  recorder->Record(Kind::kEvent, 1, "b", {}, start_);
+  EXPECT_FALSE(recorder->Flush());
+}
+
+}  // namespace
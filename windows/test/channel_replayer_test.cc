@@ -0,0 +1,196 @@
+#include "util/channel_replayer.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "util/channel_log.h"
+#include "util/task_monitor.h"
+
+namespace {
+
+using util::ChannelRecord;
+using util::ChannelRecorder;
+using util::ChannelReplayer;
+using Kind = ChannelRecord::Kind;
+using namespace std::chrono_literals;
+
+ChannelRecord MakeRecord(Kind kind, std::chrono::microseconds time,
+                         int64_t texture_id, std::string name) {
+  ChannelRecord record;
+  record.kind = kind;
+  record.time = time;
+  record.texture_id = texture_id;
+  record.name = std::move(name);
+  return record;
+}
+
+class ChannelReplayerTest : public testing::Test {
+ protected:
+  ChannelReplayerTest() : start_(ChannelReplayer::Clock::now()) {}
+
+  std::unique_ptr<ChannelReplayer> CreateReplayer(
+      std::vector<ChannelRecord> records, double speed) {
+    return std::make_unique<ChannelReplayer>(
+        std::move(records), speed,
+        [this](size_t index, const ChannelRecord& record) {
+          dispatched_.emplace_back(index, record.name);
+        });
+  }
+
+  std::vector<ChannelRecord> ThreeRecords() {
+    return {MakeRecord(Kind::kMethodCall, 0ms, 1, "a"),
+            MakeRecord(Kind::kMethodCall, 10ms, 1, "b"),
+            MakeRecord(Kind::kMethodCall, 30ms, 1, "c")};
+  }
+
+  ChannelReplayer::Clock::time_point start_;
+  std::vector<std::pair<size_t, std::string>> dispatched_;
+};
+
+TEST_F(ChannelReplayerTest, PacesRecords) {
+  auto replayer = CreateReplayer(ThreeRecords(), 1);
+  replayer->Start(start_);
+
+  EXPECT_EQ(replayer->Run(start_), start_ + 10ms);
+  EXPECT_EQ(dispatched_.size(), 1u);
+  EXPECT_EQ(replayer->Run(start_ + 9ms), start_ + 10ms);
+  EXPECT_EQ(dispatched_.size(), 1u);
+  EXPECT_EQ(replayer->Run(start_ + 10ms), start_ + 30ms);
+  EXPECT_EQ(replayer->Run(start_ + 30ms), std::nullopt);
+
+  EXPECT_TRUE(replayer->done());
+  EXPECT_EQ(replayer->dispatched(), 3u);
+  EXPECT_EQ(replayer->max_lag(), 0ms);
+  const std::vector<std::pair<size_t, std::string>> expected = {
+      {0, "a"}, {1, "b"}, {2, "c"}};
+  EXPECT_EQ(dispatched_, expected);
+}
+
+TEST_F(ChannelReplayerTest, MeasuresLag) {
+  auto replayer = CreateReplayer(ThreeRecords(), 1);
+  replayer->Start(start_);
+
+  EXPECT_EQ(replayer->Run(start_ + 2ms), start_ + 10ms);
+  EXPECT_EQ(replayer->max_lag(), 2ms);
+  // Both remaining records are overdue; the lag is that of the earlier.
+  EXPECT_EQ(replayer->Run(start_ + 35ms), std::nullopt);
+  EXPECT_EQ(replayer->max_lag(), 25ms);
+
+  // Restarting starts over.
+  replayer->Start(start_ + 1s);
+  EXPECT_EQ(replayer->dispatched(), 0u);
+  EXPECT_EQ(replayer->max_lag(), 0ms);
+  EXPECT_EQ(replayer->Run(start_ + 1s), start_ + 1s + 10ms);
+}
+
+TEST_F(ChannelReplayerTest, ScalesPace) {
+  auto replayer = CreateReplayer(ThreeRecords(), 4);
+  replayer->Start(start_);
+  EXPECT_EQ(replayer->Run(start_), start_ + 2500us);
+  EXPECT_EQ(replayer->Run(start_ + 2500us), start_ + 7500us);
+
+  auto slow = CreateReplayer(ThreeRecords(), 0.5);
+  slow->Start(start_);
+  EXPECT_EQ(slow->Run(start_), start_ + 20ms);
+}
+
+TEST_F(ChannelReplayerTest, DispatchesAllAtOnceWithoutPace) {
+  auto replayer = CreateReplayer(ThreeRecords(), 0);
+  replayer->Start(start_);
+  EXPECT_EQ(replayer->Run(start_), std::nullopt);
+  EXPECT_EQ(dispatched_.size(), 3u);
+  EXPECT_EQ(replayer->max_lag(), 0ms);
+}
+
+TEST_F(ChannelReplayerTest, NamesTasks) {
+  EXPECT_EQ(ChannelReplayer::TaskNameOf(MakeRecord(
+                Kind::kMethodCall, 0ms, util::kPluginChannel, "initialize")),
+            "plugin.initialize");
+  EXPECT_EQ(ChannelReplayer::TaskNameOf(
+                MakeRecord(Kind::kMethodCall, 0ms, 3, "loadUrl")),
+            "webview.loadUrl");
+  EXPECT_EQ(ChannelReplayer::TaskNameOf(
+                MakeRecord(Kind::kEvent, 0ms, 3, "urlChanged")),
+            "event.urlChanged");
+  EXPECT_EQ(ChannelReplayer::TaskNameOf(MakeRecord(
+                Kind::kResult, 0ms, util::kPluginChannel, "initialize")),
+            "result.initialize");
+}
+
+TEST_F(ChannelReplayerTest, TimesDispatches) {
+  util::TaskMonitor monitor;
+  auto replayer = CreateReplayer(ThreeRecords(), 0);
+  replayer->SetTaskMonitor(&monitor);
+  replayer->Start(start_);
+  replayer->Run(start_);
+
+  const auto& stats = monitor.stats();
+  ASSERT_EQ(stats.size(), 3u);
+  EXPECT_EQ(stats.at("webview.a").count, 1u);
+  EXPECT_EQ(stats.at("webview.c").count, 1u);
+}
+
+// Records traffic, reads the log back and replays it, like
+// startChannelRecording and replayChannelLog do.
+TEST_F(ChannelReplayerTest, ReplaysRecordedLog) {
+  // {"url": "secret"} and {"textureId": 7}.
+  const std::vector<uint8_t> arguments = {13, 1, 7, 3,   'u', 'r', 'l', 7,
+                                          6,  's', 'e', 'c', 'r', 'e', 't'};
+  const std::vector<uint8_t> result = {13,  1,   7,   9,   't', 'e', 'x', 't',
+                                       'u', 'r', 'e', 'I', 'd', 3,   7,   0,
+                                       0,   0};
+
+  auto out = std::make_unique<std::ostringstream>();
+  const auto out_pointer = out.get();
+  const auto recording_start = ChannelRecorder::Clock::now();
+  ChannelRecorder recorder(std::move(out), true, recording_start);
+  const auto call =
+      recorder.Record(Kind::kMethodCall, util::kPluginChannel, "initialize",
+                      arguments, recording_start + 5ms);
+  recorder.RecordResult(call, "initialize", result, recording_start + 20ms);
+  recorder.Record(Kind::kEvent, 7, "urlChanged", arguments,
+                  recording_start + 25ms);
+  recorder.Record(Kind::kMethodCall, 7, "loadUrl", arguments,
+                  recording_start + 40ms);
+  ASSERT_TRUE(recorder.Flush());
+
+  const auto data = out_pointer->str();
+  std::vector<ChannelRecord> records;
+  ASSERT_TRUE(util::ReadChannelLog(
+      reinterpret_cast<const uint8_t*>(data.data()), data.size(), &records));
+  ASSERT_EQ(records.size(), 4u);
+
+  std::vector<ChannelRecord> replayed;
+  ChannelReplayer replayer(
+      records, 2, [&](size_t index, const ChannelRecord& record) {
+        EXPECT_EQ(index, replayed.size());
+        replayed.push_back(record);
+      });
+  replayer.Start(start_);
+  EXPECT_EQ(replayer.Run(start_), start_ + 2500us);
+  EXPECT_EQ(replayer.Run(start_ + 2500us), start_ + 10ms);
+  EXPECT_EQ(replayer.Run(start_ + 11ms), start_ + 12500us);
+  EXPECT_EQ(replayer.Run(start_ + 30ms), std::nullopt);
+  EXPECT_EQ(replayer.max_lag(), 17500us);
+
+  ASSERT_EQ(replayed.size(), 4u);
+  EXPECT_EQ(replayed[1].kind, Kind::kResult);
+  EXPECT_EQ(replayed[1].call, call);
+  // Texture ids survive redaction, strings don't.
+  EXPECT_EQ(replayed[1].payload, result);
+  EXPECT_EQ(replayed[0].payload_state, ChannelRecord::Payload::kRedacted);
+  std::vector<uint8_t> redacted = arguments;
+  std::fill(redacted.begin() + 9, redacted.end(), '*');
+  EXPECT_EQ(replayed[0].payload, redacted);
+  EXPECT_EQ(replayed[3].payload, redacted);
+  EXPECT_EQ(replayed[3].texture_id, 7);
+}
+
+}  // namespace
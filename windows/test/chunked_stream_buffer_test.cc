@@ -0,0 +1,208 @@
+#include "util/chunked_stream_buffer.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using std::chrono::milliseconds;
+using util::ChunkedStreamBuffer;
+using Status = ChunkedStreamBuffer::Status;
+typedef std::vector<uint8_t> Bytes;
+
+constexpr milliseconds kNoWait(0);
+// Long enough for another thread to get going, short enough to fail fast.
+constexpr milliseconds kWait(5000);
+
+TEST(ChunkedStreamBufferTest, ReadsChunksInOrder) {
+  ChunkedStreamBuffer buffer;
+  EXPECT_TRUE(buffer.Append({1, 2, 3}));
+  EXPECT_TRUE(buffer.Append({}));
+  EXPECT_TRUE(buffer.Append({4, 5}));
+  EXPECT_EQ(buffer.buffered(), 5u);
+  EXPECT_EQ(buffer.total_size(), 5u);
+
+  // Reads span chunk boundaries and split chunks.
+  Bytes data(4);
+  size_t read = 0;
+  EXPECT_EQ(buffer.Read(data.data(), 4, &read, kNoWait), Status::kOk);
+  EXPECT_EQ(read, 4u);
+  EXPECT_EQ(data, (Bytes{1, 2, 3, 4}));
+  EXPECT_EQ(buffer.buffered(), 1u);
+
+  EXPECT_EQ(buffer.Read(data.data(), 1, &read, kNoWait), Status::kOk);
+  EXPECT_EQ(read, 1u);
+  EXPECT_EQ(data[0], 5);
+  EXPECT_EQ(buffer.total_size(), 5u);
+}
+
+TEST(ChunkedStreamBufferTest, EndOfStreamAfterRemainingData) {
+  ChunkedStreamBuffer buffer;
+  buffer.Append({1, 2});
+  buffer.Close();
+  EXPECT_TRUE(buffer.is_closed());
+  EXPECT_FALSE(buffer.Append({3}));
+
+  Bytes data(4);
+  size_t read = 0;
+  EXPECT_EQ(buffer.Read(data.data(), 4, &read, kNoWait),
+            Status::kEndOfStream);
+  EXPECT_EQ(read, 2u);
+  EXPECT_EQ(buffer.Read(data.data(), 4, &read, kNoWait),
+            Status::kEndOfStream);
+  EXPECT_EQ(read, 0u);
+}
+
+TEST(ChunkedStreamBufferTest, TimesOutWithPartialData) {
+  ChunkedStreamBuffer buffer;
+  buffer.Append({1});
+
+  Bytes data(2);
+  size_t read = 0;
+  EXPECT_EQ(buffer.Read(data.data(), 2, &read, milliseconds(1)),
+            Status::kTimedOut);
+  EXPECT_EQ(read, 1u);
+}
+
+TEST(ChunkedStreamBufferTest, ReadWaitsForData) {
+  ChunkedStreamBuffer buffer;
+  Bytes data(4);
+  size_t read = 0;
+  Status status = Status::kTimedOut;
+  std::thread reader(
+      [&]() { status = buffer.Read(data.data(), 4, &read, kWait); });
+
+  buffer.Append({1, 2});
+  buffer.Append({3, 4});
+  reader.join();
+  EXPECT_EQ(status, Status::kOk);
+  EXPECT_EQ(read, 4u);
+  EXPECT_EQ(data, (Bytes{1, 2, 3, 4}));
+}
+
+TEST(ChunkedStreamBufferTest, CloseWakesWaitingReader) {
+  ChunkedStreamBuffer buffer;
+  Bytes data(4);
+  size_t read = 0;
+  Status status = Status::kTimedOut;
+  std::thread reader(
+      [&]() { status = buffer.Read(data.data(), 4, &read, kWait); });
+
+  buffer.Append({1});
+  buffer.Close();
+  reader.join();
+  EXPECT_EQ(status, Status::kEndOfStream);
+  EXPECT_EQ(read, 1u);
+}
+
+TEST(ChunkedStreamBufferTest, CancelWakesWaitingReader) {
+  ChunkedStreamBuffer buffer;
+  Bytes data(4);
+  size_t read = 0;
+  Status status = Status::kTimedOut;
+  std::thread reader(
+      [&]() { status = buffer.Read(data.data(), 4, &read, kWait); });
+
+  buffer.Cancel();
+  reader.join();
+  EXPECT_EQ(status, Status::kCancelled);
+  EXPECT_EQ(read, 0u);
+}
+
+TEST(ChunkedStreamBufferTest, CancelDropsData) {
+  ChunkedStreamBuffer buffer;
+  buffer.Append({1, 2});
+  buffer.Cancel();
+  EXPECT_EQ(buffer.buffered(), 0u);
+  EXPECT_FALSE(buffer.Append({3}));
+
+  Bytes data(2);
+  size_t read = 0;
+  EXPECT_EQ(buffer.Read(data.data(), 2, &read, kNoWait), Status::kCancelled);
+  EXPECT_EQ(read, 0u);
+}
+
+TEST(ChunkedStreamBufferTest, WritableRightAwayBelowCapacity) {
+  ChunkedStreamBuffer buffer(4);
+  buffer.Append({1, 2, 3});
+  int calls = 0;
+  buffer.WhenWritable([&](bool cancelled) {
+    EXPECT_FALSE(cancelled);
+    calls++;
+  });
+  EXPECT_EQ(calls, 1);
+}
+
+TEST(ChunkedStreamBufferTest, WritableOnceDrainedBelowCapacity) {
+  ChunkedStreamBuffer buffer(4);
+  // Appending beyond the capacity is allowed.
+  EXPECT_TRUE(buffer.Append({1, 2, 3, 4, 5, 6}));
+  int calls = 0;
+  buffer.WhenWritable([&](bool cancelled) {
+    EXPECT_FALSE(cancelled);
+    calls++;
+  });
+  EXPECT_EQ(calls, 0);
+
+  Bytes data(2);
+  size_t read = 0;
+  buffer.Read(data.data(), 2, &read, kNoWait);
+  EXPECT_EQ(calls, 0);
+  buffer.Read(data.data(), 1, &read, kNoWait);
+  EXPECT_EQ(calls, 1);
+  buffer.Read(data.data(), 1, &read, kNoWait);
+  EXPECT_EQ(calls, 1);
+}
+
+TEST(ChunkedStreamBufferTest, CancelNotifiesWaitingWriters) {
+  ChunkedStreamBuffer buffer(1);
+  buffer.Append({1});
+  bool notified_cancelled = false;
+  buffer.WhenWritable([&](bool cancelled) { notified_cancelled = cancelled; });
+  buffer.Cancel();
+  EXPECT_TRUE(notified_cancelled);
+
+  // Later writers learn about it right away.
+  bool later_cancelled = false;
+  buffer.WhenWritable([&](bool cancelled) { later_cancelled = cancelled; });
+  EXPECT_TRUE(later_cancelled);
+}
+
+TEST(ChunkedStreamBufferTest, StreamsAcrossThreads) {
+  constexpr size_t kSize = 256 * 1024;
+  ChunkedStreamBuffer buffer(4096);
+
+  std::thread producer([&]() {
+    for (size_t offset = 0; offset < kSize; offset += 1000) {
+      Bytes chunk(std::min<size_t>(1000, kSize - offset));
+      for (size_t i = 0; i < chunk.size(); i++) {
+        chunk[i] = static_cast<uint8_t>(offset + i);
+      }
+      buffer.Append(std::move(chunk));
+    }
+    buffer.Close();
+  });
+
+  Bytes data(kSize + 1);
+  size_t total = 0;
+  Status status = Status::kOk;
+  while (status == Status::kOk) {
+    size_t read = 0;
+    status = buffer.Read(data.data() + total, 777, &read, kWait);
+    total += read;
+  }
+  producer.join();
+
+  EXPECT_EQ(status, Status::kEndOfStream);
+  ASSERT_EQ(total, kSize);
+  for (size_t i = 0; i < kSize; i++) {
+    ASSERT_EQ(data[i], static_cast<uint8_t>(i)) << i;
+  }
+}
+
+}  // namespace
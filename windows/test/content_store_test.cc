@@ -0,0 +1,114 @@
+#include "util/content_store.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+namespace {
+
+using util::ContentStore;
+
+std::string Document(size_t size, char fill = 'x') {
+  return std::string(size, fill);
+}
+
+TEST(ContentStoreTest, StoresOnlyLargeDocuments) {
+  EXPECT_FALSE(ContentStore::ShouldStore(0));
+  EXPECT_FALSE(ContentStore::ShouldStore(ContentStore::kInlineLimit));
+  EXPECT_TRUE(ContentStore::ShouldStore(ContentStore::kInlineLimit + 1));
+}
+
+TEST(ContentStoreTest, HandsOutUnguessableUrls) {
+  ContentStore store;
+  const auto a = store.Add("a");
+  const auto b = store.Add("b");
+  EXPECT_NE(a, b);
+  EXPECT_TRUE(ContentStore::IsStoreUrl(a));
+  EXPECT_EQ(a.rfind("https://webview-content.invalid/", 0), 0u);
+  // 128 bits in hex.
+  EXPECT_EQ(a.size(), std::string("https://webview-content.invalid/").size() +
+                          32);
+
+  // Another store doesn't know the URL.
+  ContentStore other;
+  EXPECT_FALSE(other.Get(a));
+}
+
+TEST(ContentStoreTest, RecognizesStoreUrls) {
+  EXPECT_FALSE(ContentStore::IsStoreUrl("https://webview-content.invalid/"));
+  EXPECT_FALSE(ContentStore::IsStoreUrl("https://example.com/"));
+  EXPECT_FALSE(ContentStore::IsStoreUrl("about:blank"));
+  EXPECT_TRUE(ContentStore::IsStoreUrl("https://webview-content.invalid/00"));
+}
+
+TEST(ContentStoreTest, ServesDocumentsRepeatedly) {
+  ContentStore store;
+  const auto url = store.Add("<p>hello</p>");
+
+  // The initial load, a reload and a back navigation.
+  for (int i = 0; i < 3; i++) {
+    const auto content = store.Get(url);
+    ASSERT_TRUE(content);
+    EXPECT_EQ(*content, "<p>hello</p>");
+  }
+  EXPECT_EQ(store.size(), 1u);
+  EXPECT_FALSE(store.Get(url + "0"));
+}
+
+TEST(ContentStoreTest, EvictsLeastRecentlyUsedByCount) {
+  ContentStore store;
+  const auto first = store.Add("first");
+  const auto second = store.Add("second");
+  for (size_t i = 2; i < ContentStore::kMaxEntries; i++) {
+    store.Add("filler");
+  }
+  EXPECT_EQ(store.size(), ContentStore::kMaxEntries);
+
+  // Using the first document makes the second one the oldest.
+  EXPECT_TRUE(store.Get(first));
+  store.Add("new");
+  EXPECT_EQ(store.size(), ContentStore::kMaxEntries);
+  EXPECT_TRUE(store.Get(first));
+  EXPECT_FALSE(store.Get(second));
+}
+
+TEST(ContentStoreTest, EvictsByTotalSize) {
+  ContentStore store;
+  const auto quarter = ContentStore::kMaxStoredBytes / 4;
+  const auto a = store.Add(Document(quarter));
+  const auto b = store.Add(Document(quarter));
+  const auto c = store.Add(Document(quarter));
+  EXPECT_EQ(store.stored_bytes(), 3 * quarter);
+
+  const auto d = store.Add(Document(quarter + 1));
+  EXPECT_EQ(store.size(), 3u);
+  EXPECT_EQ(store.stored_bytes(), 3 * quarter + 1);
+  EXPECT_FALSE(store.Get(a));
+  EXPECT_TRUE(store.Get(b));
+  EXPECT_TRUE(store.Get(c));
+  EXPECT_TRUE(store.Get(d));
+}
+
+TEST(ContentStoreTest, KeepsMostRecentOversizedDocument) {
+  ContentStore store;
+  const auto small = store.Add("small");
+  const auto huge = store.Add(Document(ContentStore::kMaxStoredBytes + 1));
+  EXPECT_EQ(store.size(), 1u);
+  EXPECT_FALSE(store.Get(small));
+  const auto content = store.Get(huge);
+  ASSERT_TRUE(content);
+  EXPECT_EQ(content->size(), ContentStore::kMaxStoredBytes + 1);
+}
+
+TEST(ContentStoreTest, EvictedContentOutlivesPendingResponses) {
+  ContentStore store;
+  const auto url = store.Add("served");
+  const auto content = store.Get(url);
+  for (size_t i = 0; i < ContentStore::kMaxEntries; i++) {
+    store.Add("filler");
+  }
+  EXPECT_FALSE(store.Get(url));
+  EXPECT_EQ(*content, "served");
+}
+
+}  // namespace
@@ -0,0 +1,159 @@
+// Measures how long copies on the raster thread wait for the immediate
+// context while the platform thread keeps issuing work on it, comparing
+// copies issued on the immediate context (holding the lock throughout) with
+// copies recorded on a deferred context and only locking for submission,
+// as TextureBridgeGpu does.
+//
+// Windows only, needs a hardware device:
+//   context_lock_benchmark [frames]
+#include <d3d11_4.h>
+#include <winrt/base.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#pragma comment(lib, "d3d11.lib")
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+constexpr UINT kWidth = 1920;
+constexpr UINT kHeight = 1080;
+constexpr int kDefaultFrames = 600;
+// The copies the platform thread issues per lock, standing in for capture
+// and scaling work.
+constexpr int kPlatformCopiesPerLock = 4;
+
+struct Device {
+  winrt::com_ptr<ID3D11Device> device;
+  winrt::com_ptr<ID3D11DeviceContext> context;
+  winrt::com_ptr<ID3D11Multithread> multithread;
+};
+
+bool CreateDevice(Device* device) {
+  if (FAILED(D3D11CreateDevice(nullptr, D3D_DRIVER_TYPE_HARDWARE, nullptr,
+                               D3D11_CREATE_DEVICE_BGRA_SUPPORT, nullptr, 0,
+                               D3D11_SDK_VERSION, device->device.put(),
+                               nullptr, device->context.put()))) {
+    return false;
+  }
+  device->multithread = device->context.try_as<ID3D11Multithread>();
+  if (!device->multithread) {
+    return false;
+  }
+  device->multithread->SetMultithreadProtected(TRUE);
+  return true;
+}
+
+winrt::com_ptr<ID3D11Texture2D> CreateTexture(ID3D11Device* device) {
+  D3D11_TEXTURE2D_DESC desc = {};
+  desc.Width = kWidth;
+  desc.Height = kHeight;
+  desc.MipLevels = 1;
+  desc.ArraySize = 1;
+  desc.Format = DXGI_FORMAT_B8G8R8A8_UNORM;
+  desc.SampleDesc.Count = 1;
+  desc.Usage = D3D11_USAGE_DEFAULT;
+  desc.BindFlags = D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE;
+  winrt::com_ptr<ID3D11Texture2D> texture;
+  device->CreateTexture2D(&desc, nullptr, texture.put());
+  return texture;
+}
+
+double ToMs(Clock::duration duration) {
+  return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+void PrintPercentiles(const char* label, std::vector<double> values) {
+  std::sort(values.begin(), values.end());
+  const auto at = [&](double p) {
+    return values[static_cast<size_t>(p * (values.size() - 1))];
+  };
+  std::printf("  %-10s p50 %7.3fms  p90 %7.3fms  p99 %7.3fms  max %7.3fms\n",
+              label, at(0.5), at(0.9), at(0.99), values.back());
+}
+
+bool Run(bool deferred, int frames) {
+  Device device;
+  if (!CreateDevice(&device)) {
+    std::fprintf(stderr, "Creating the device failed.\n");
+    return false;
+  }
+
+  const auto source = CreateTexture(device.device.get());
+  const auto target = CreateTexture(device.device.get());
+  const auto platform_source = CreateTexture(device.device.get());
+  const auto platform_target = CreateTexture(device.device.get());
+  winrt::com_ptr<ID3D11DeviceContext> deferred_context;
+  if (deferred && FAILED(device.device->CreateDeferredContext(
+                      0, deferred_context.put()))) {
+    std::fprintf(stderr, "Creating a deferred context failed.\n");
+    return false;
+  }
+
+  std::atomic<bool> stop = false;
+  std::thread platform_thread([&]() {
+    while (!stop) {
+      device.multithread->Enter();
+      for (int i = 0; i < kPlatformCopiesPerLock; i++) {
+        device.context->CopyResource(platform_target.get(),
+                                     platform_source.get());
+      }
+      device.context->Flush();
+      device.multithread->Leave();
+      std::this_thread::yield();
+    }
+  });
+
+  std::vector<double> waits, holds, totals;
+  for (int frame = 0; frame < frames; frame++) {
+    const auto start = Clock::now();
+    winrt::com_ptr<ID3D11CommandList> command_list;
+    if (deferred) {
+      deferred_context->CopyResource(target.get(), source.get());
+      deferred_context->FinishCommandList(FALSE, command_list.put());
+    }
+
+    const auto lock_requested = Clock::now();
+    device.multithread->Enter();
+    const auto locked = Clock::now();
+    if (deferred) {
+      device.context->ExecuteCommandList(command_list.get(), FALSE);
+    } else {
+      device.context->CopyResource(target.get(), source.get());
+    }
+    device.context->Flush();
+    device.multithread->Leave();
+    const auto end = Clock::now();
+
+    waits.push_back(ToMs(locked - lock_requested));
+    holds.push_back(ToMs(end - locked));
+    totals.push_back(ToMs(end - start));
+    // Roughly the pace of a 60Hz raster thread.
+    std::this_thread::sleep_until(start + std::chrono::milliseconds(16));
+  }
+
+  stop = true;
+  platform_thread.join();
+
+  std::printf("%s context (%d frames):\n", deferred ? "deferred" : "immediate",
+              frames);
+  PrintPercentiles("lock wait", waits);
+  PrintPercentiles("lock held", holds);
+  PrintPercentiles("total", totals);
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  const int frames = argc > 1 ? std::max(1, std::atoi(argv[1]))
+                              : kDefaultFrames;
+  return Run(false, frames) && Run(true, frames) ? 0 : 1;
+}
@@ -0,0 +1,168 @@
+#include "util/cursor_bitmap.h"
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace {
+
+using util::CursorBitmaps;
+using util::CursorImage;
+
+typedef std::array<uint8_t, 4> Rgba;
+
+// Creates bitmaps with cleared masks of |mask_rows| rows.
+CursorBitmaps CreateBitmaps(uint32_t width, uint32_t height,
+                            uint32_t mask_rows) {
+  CursorBitmaps bitmaps;
+  bitmaps.width = width;
+  bitmaps.height = height;
+  bitmaps.mask_stride = util::MaskStride(width);
+  bitmaps.mask.assign(bitmaps.mask_stride * mask_rows, 0);
+  return bitmaps;
+}
+
+void SetMaskBit(CursorBitmaps* bitmaps, uint32_t x, uint32_t y) {
+  bitmaps->mask[y * bitmaps->mask_stride + x / 8] |= 0x80 >> (x % 8);
+}
+
+void SetColor(CursorBitmaps* bitmaps, uint32_t x, uint32_t y, uint8_t b,
+              uint8_t g, uint8_t r, uint8_t a) {
+  const size_t i = (static_cast<size_t>(y) * bitmaps->width + x) * 4;
+  bitmaps->color[i] = b;
+  bitmaps->color[i + 1] = g;
+  bitmaps->color[i + 2] = r;
+  bitmaps->color[i + 3] = a;
+}
+
+Rgba PixelAt(const CursorImage& image, uint32_t x, uint32_t y) {
+  const size_t i = (static_cast<size_t>(y) * image.width + x) * 4;
+  return {image.rgba[i], image.rgba[i + 1], image.rgba[i + 2],
+          image.rgba[i + 3]};
+}
+
+TEST(CursorBitmapTest, MaskStrideIsPaddedTo32Bits) {
+  EXPECT_EQ(util::MaskStride(1), 4u);
+  EXPECT_EQ(util::MaskStride(32), 4u);
+  EXPECT_EQ(util::MaskStride(33), 8u);
+}
+
+TEST(CursorBitmapTest, ConvertsMonochromeCursor) {
+  // One pixel for each combination of the AND and XOR bits.
+  auto bitmaps = CreateBitmaps(4, 1, 2);
+  // x = 0: AND 0, XOR 0 -> black.
+  // x = 1: AND 0, XOR 1 -> white.
+  SetMaskBit(&bitmaps, 1, 1);
+  // x = 2: AND 1, XOR 0 -> transparent.
+  SetMaskBit(&bitmaps, 2, 0);
+  // x = 3: AND 1, XOR 1 -> inverted, drawn black.
+  SetMaskBit(&bitmaps, 3, 0);
+  SetMaskBit(&bitmaps, 3, 1);
+
+  CursorImage image;
+  ASSERT_TRUE(util::ConvertCursorBitmaps(bitmaps, &image));
+  EXPECT_EQ(image.width, 4u);
+  EXPECT_EQ(image.height, 1u);
+  ASSERT_EQ(image.rgba.size(), 16u);
+  EXPECT_EQ(PixelAt(image, 0, 0), (Rgba{0, 0, 0, 0xff}));
+  EXPECT_EQ(PixelAt(image, 1, 0), (Rgba{0xff, 0xff, 0xff, 0xff}));
+  EXPECT_EQ(PixelAt(image, 2, 0), (Rgba{0, 0, 0, 0}));
+  EXPECT_EQ(PixelAt(image, 3, 0), (Rgba{0, 0, 0, 0xff}));
+}
+
+TEST(CursorBitmapTest, ReadsMaskRowsWithPadding) {
+  // Rows are 4 bytes apart even though 9 pixels fit into 2 bytes.
+  auto bitmaps = CreateBitmaps(9, 2, 4);
+  SetMaskBit(&bitmaps, 8, 3);
+
+  CursorImage image;
+  ASSERT_TRUE(util::ConvertCursorBitmaps(bitmaps, &image));
+  EXPECT_EQ(PixelAt(image, 8, 1), (Rgba{0xff, 0xff, 0xff, 0xff}));
+  EXPECT_EQ(PixelAt(image, 8, 0), (Rgba{0, 0, 0, 0xff}));
+  EXPECT_EQ(PixelAt(image, 7, 1), (Rgba{0, 0, 0, 0xff}));
+}
+
+TEST(CursorBitmapTest, ConvertsColorCursorWithAlpha) {
+  auto bitmaps = CreateBitmaps(2, 1, 1);
+  bitmaps.color.resize(8);
+  SetColor(&bitmaps, 0, 0, 0x10, 0x20, 0x30, 0x80);
+  SetColor(&bitmaps, 1, 0, 0x40, 0x50, 0x60, 0x00);
+  // The mask is ignored if there's an alpha channel.
+  SetMaskBit(&bitmaps, 0, 0);
+
+  CursorImage image;
+  ASSERT_TRUE(util::ConvertCursorBitmaps(bitmaps, &image));
+  EXPECT_EQ(PixelAt(image, 0, 0), (Rgba{0x30, 0x20, 0x10, 0x80}));
+  EXPECT_EQ(PixelAt(image, 1, 0), (Rgba{0x60, 0x50, 0x40, 0x00}));
+}
+
+TEST(CursorBitmapTest, TakesColorCursorTransparencyFromMask) {
+  auto bitmaps = CreateBitmaps(2, 1, 1);
+  bitmaps.color.resize(8);
+  SetColor(&bitmaps, 0, 0, 0x10, 0x20, 0x30, 0);
+  SetColor(&bitmaps, 1, 0, 0x40, 0x50, 0x60, 0);
+  SetMaskBit(&bitmaps, 1, 0);
+
+  CursorImage image;
+  ASSERT_TRUE(util::ConvertCursorBitmaps(bitmaps, &image));
+  EXPECT_EQ(PixelAt(image, 0, 0), (Rgba{0x30, 0x20, 0x10, 0xff}));
+  EXPECT_EQ(PixelAt(image, 1, 0), (Rgba{0x60, 0x50, 0x40, 0x00}));
+}
+
+TEST(CursorBitmapTest, ColorCursorWithoutMaskIsOpaque) {
+  CursorBitmaps bitmaps;
+  bitmaps.width = 1;
+  bitmaps.height = 1;
+  bitmaps.color = {0x10, 0x20, 0x30, 0x00};
+
+  CursorImage image;
+  ASSERT_TRUE(util::ConvertCursorBitmaps(bitmaps, &image));
+  EXPECT_EQ(PixelAt(image, 0, 0), (Rgba{0x30, 0x20, 0x10, 0xff}));
+}
+
+TEST(CursorBitmapTest, CopiesHotspot) {
+  auto bitmaps = CreateBitmaps(32, 32, 64);
+  bitmaps.hotspot_x = 5;
+  bitmaps.hotspot_y = 31;
+
+  CursorImage image;
+  ASSERT_TRUE(util::ConvertCursorBitmaps(bitmaps, &image));
+  EXPECT_EQ(image.hotspot_x, 5u);
+  EXPECT_EQ(image.hotspot_y, 31u);
+}
+
+TEST(CursorBitmapTest, ClampsHotspotToImage) {
+  auto bitmaps = CreateBitmaps(16, 8, 16);
+  bitmaps.hotspot_x = 16;
+  bitmaps.hotspot_y = 100;
+
+  CursorImage image;
+  ASSERT_TRUE(util::ConvertCursorBitmaps(bitmaps, &image));
+  EXPECT_EQ(image.hotspot_x, 15u);
+  EXPECT_EQ(image.hotspot_y, 7u);
+}
+
+TEST(CursorBitmapTest, RejectsInconsistentBitmaps) {
+  CursorImage image;
+
+  CursorBitmaps empty;
+  EXPECT_FALSE(util::ConvertCursorBitmaps(empty, &image));
+
+  // Monochrome cursors need both masks.
+  auto monochrome = CreateBitmaps(8, 8, 8);
+  EXPECT_FALSE(util::ConvertCursorBitmaps(monochrome, &image));
+  monochrome.mask.clear();
+  EXPECT_FALSE(util::ConvertCursorBitmaps(monochrome, &image));
+
+  auto color = CreateBitmaps(8, 8, 8);
+  color.color.resize(8 * 8 * 4 - 1);
+  EXPECT_FALSE(util::ConvertCursorBitmaps(color, &image));
+
+  auto short_stride = CreateBitmaps(16, 1, 2);
+  short_stride.mask_stride = 1;
+  EXPECT_FALSE(util::ConvertCursorBitmaps(short_stride, &image));
+}
+
+}  // namespace
@@ -0,0 +1,168 @@
+#include "device_recovery.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <utility>
+#include <vector>
+
+namespace {
+
+using std::chrono::milliseconds;
+
+// Stands in for the GPU: recreating it fails until |available| is set.
+struct FakeDevice {
+  bool available = false;
+  int creations = 0;
+
+  bool Recreate() {
+    creations++;
+    return available;
+  }
+};
+
+// Collects posted tasks instead of running them.
+struct FakeTaskRunner {
+  struct Task {
+    std::function<void()> task;
+    milliseconds delay;
+  };
+  std::deque<Task> tasks;
+
+  void Post(std::function<void()> task, milliseconds delay) {
+    tasks.push_back({std::move(task), delay});
+  }
+
+  // Runs the oldest task and returns its delay.
+  milliseconds RunNext() {
+    auto task = std::move(tasks.front());
+    tasks.pop_front();
+    task.task();
+    return task.delay;
+  }
+};
+
+struct RecordingClient : DeviceRecovery::Client {
+  std::vector<const char*> calls;
+
+  void OnDeviceLost() override { calls.push_back("lost"); }
+  void OnDeviceRestored() override { calls.push_back("restored"); }
+};
+
+class DeviceRecoveryTest : public ::testing::Test {
+ protected:
+  FakeDevice device_;
+  FakeTaskRunner runner_;
+  RecordingClient client_;
+
+  DeviceRecovery CreateRecovery(int max_attempts) {
+    return DeviceRecovery(
+        [this]() { return device_.Recreate(); },
+        [this](std::function<void()> task, milliseconds delay) {
+          runner_.Post(std::move(task), delay);
+        },
+        max_attempts);
+  }
+};
+
+TEST_F(DeviceRecoveryTest, RecoversImmediatelyIfTheDeviceIsAvailable) {
+  auto recovery = CreateRecovery(3);
+  recovery.AddClient(&client_);
+  device_.available = true;
+
+  recovery.NotifyDeviceLost();
+  EXPECT_TRUE(recovery.is_device_lost());
+  ASSERT_EQ(runner_.tasks.size(), 1u);
+  EXPECT_EQ(runner_.RunNext(), milliseconds(0));
+
+  EXPECT_FALSE(recovery.is_device_lost());
+  EXPECT_EQ(recovery.recovery_count(), 1u);
+  EXPECT_EQ(client_.calls, (std::vector<const char*>{"lost", "restored"}));
+}
+
+TEST_F(DeviceRecoveryTest, CoalescesNotifications) {
+  auto recovery = CreateRecovery(3);
+  recovery.NotifyDeviceLost();
+  recovery.NotifyDeviceLost();
+  EXPECT_EQ(runner_.tasks.size(), 1u);
+}
+
+TEST_F(DeviceRecoveryTest, RetriesWithGrowingDelays) {
+  auto recovery = CreateRecovery(5);
+  recovery.AddClient(&client_);
+
+  recovery.NotifyDeviceLost();
+  EXPECT_EQ(runner_.RunNext(), milliseconds(0));
+  EXPECT_EQ(runner_.RunNext(), milliseconds(250));
+  EXPECT_EQ(runner_.RunNext(), milliseconds(500));
+  device_.available = true;
+  EXPECT_EQ(runner_.RunNext(), milliseconds(1000));
+
+  EXPECT_TRUE(runner_.tasks.empty());
+  EXPECT_EQ(device_.creations, 4);
+  EXPECT_FALSE(recovery.is_device_lost());
+  // Clients release their resources only once.
+  EXPECT_EQ(client_.calls, (std::vector<const char*>{"lost", "restored"}));
+}
+
+TEST_F(DeviceRecoveryTest, CapsTheDelay) {
+  auto recovery = CreateRecovery(10);
+  recovery.NotifyDeviceLost();
+  runner_.RunNext();
+
+  milliseconds delay{0};
+  while (runner_.tasks.size() == 1) {
+    delay = runner_.RunNext();
+    EXPECT_LE(delay, DeviceRecovery::kRetryMaxDelay);
+  }
+  EXPECT_EQ(delay, DeviceRecovery::kRetryMaxDelay);
+}
+
+TEST_F(DeviceRecoveryTest, GivesUpAfterTheAttemptLimit) {
+  auto recovery = CreateRecovery(3);
+  recovery.AddClient(&client_);
+
+  recovery.NotifyDeviceLost();
+  while (!runner_.tasks.empty()) {
+    runner_.RunNext();
+  }
+
+  EXPECT_EQ(device_.creations, 3);
+  EXPECT_TRUE(recovery.has_given_up());
+  EXPECT_TRUE(recovery.is_device_lost());
+  EXPECT_EQ(client_.calls, (std::vector<const char*>{"lost"}));
+
+  // Further notifications don't start over.
+  recovery.NotifyDeviceLost();
+  EXPECT_TRUE(runner_.tasks.empty());
+}
+
+TEST_F(DeviceRecoveryTest, StartsOverAfterRecovering) {
+  auto recovery = CreateRecovery(3);
+  recovery.NotifyDeviceLost();
+  runner_.RunNext();
+  device_.available = true;
+  runner_.RunNext();
+  ASSERT_FALSE(recovery.is_device_lost());
+
+  device_.available = false;
+  recovery.NotifyDeviceLost();
+  EXPECT_EQ(runner_.RunNext(), milliseconds(0));
+  // The first retry uses the initial delay again.
+  EXPECT_EQ(runner_.RunNext(), milliseconds(250));
+}
+
+TEST_F(DeviceRecoveryTest, RemovedClientsAreNotNotified) {
+  auto recovery = CreateRecovery(3);
+  recovery.AddClient(&client_);
+  recovery.RemoveClient(&client_);
+  device_.available = true;
+
+  recovery.NotifyDeviceLost();
+  runner_.RunNext();
+  EXPECT_TRUE(client_.calls.empty());
+}
+
+}  // namespace
@@ -0,0 +1,146 @@
+#include "util/frame_scheduler.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+
+namespace {
+
+using std::chrono::milliseconds;
+using util::FrameRateLimiter;
+using util::FrameScheduler;
+using Action = FrameScheduler::Action;
+
+class FrameSchedulerTest : public ::testing::Test {
+ protected:
+  FrameScheduler::Clock::time_point start_ = FrameScheduler::Clock::now();
+  FrameScheduler scheduler_{milliseconds(250)};
+
+  FrameScheduler::Clock::time_point At(int ms) {
+    return start_ + milliseconds(ms);
+  }
+};
+
+TEST_F(FrameSchedulerTest, RequestStartsAndDeliveryStopsCapture) {
+  EXPECT_FALSE(scheduler_.is_capturing());
+  EXPECT_EQ(scheduler_.RequestFrame(), Action::kStartCapture);
+  EXPECT_TRUE(scheduler_.is_capturing());
+  EXPECT_EQ(scheduler_.FrameDelivered(), Action::kStopCapture);
+  EXPECT_FALSE(scheduler_.is_capturing());
+}
+
+TEST_F(FrameSchedulerTest, CombinesRequestsUntilDelivery) {
+  EXPECT_EQ(scheduler_.RequestFrame(), Action::kStartCapture);
+  EXPECT_EQ(scheduler_.RequestFrame(), Action::kNone);
+  EXPECT_EQ(scheduler_.RequestFrame(), Action::kNone);
+
+  // A single frame satisfies all of them.
+  EXPECT_EQ(scheduler_.FrameDelivered(), Action::kStopCapture);
+  EXPECT_EQ(scheduler_.FrameDelivered(), Action::kNone);
+
+  EXPECT_EQ(scheduler_.RequestFrame(), Action::kStartCapture);
+}
+
+TEST_F(FrameSchedulerTest, CapturesOnceActivitySettled) {
+  EXPECT_FALSE(scheduler_.deadline());
+
+  scheduler_.NotifyActivity(At(0));
+  EXPECT_EQ(scheduler_.deadline(), At(250));
+  EXPECT_EQ(scheduler_.Tick(At(249)), Action::kNone);
+  EXPECT_FALSE(scheduler_.is_capturing());
+
+  EXPECT_EQ(scheduler_.Tick(At(250)), Action::kStartCapture);
+  EXPECT_FALSE(scheduler_.deadline());
+  EXPECT_EQ(scheduler_.Tick(At(500)), Action::kNone);
+}
+
+TEST_F(FrameSchedulerTest, ActivityPostponesSettleDeadline) {
+  scheduler_.NotifyActivity(At(0));
+  scheduler_.NotifyActivity(At(200));
+  EXPECT_EQ(scheduler_.deadline(), At(450));
+  EXPECT_EQ(scheduler_.Tick(At(250)), Action::kNone);
+  EXPECT_EQ(scheduler_.Tick(At(450)), Action::kStartCapture);
+}
+
+TEST_F(FrameSchedulerTest, SettledFrameCombinesWithPendingRequest) {
+  EXPECT_EQ(scheduler_.RequestFrame(), Action::kStartCapture);
+  scheduler_.NotifyActivity(At(0));
+  EXPECT_EQ(scheduler_.Tick(At(250)), Action::kNone);
+  EXPECT_EQ(scheduler_.FrameDelivered(), Action::kStopCapture);
+}
+
+TEST_F(FrameSchedulerTest, ChangingSettleDelayAppliesToNextActivity) {
+  scheduler_.NotifyActivity(At(0));
+  scheduler_.set_settle_delay(milliseconds(50));
+  EXPECT_EQ(scheduler_.deadline(), At(250));
+
+  scheduler_.NotifyActivity(At(10));
+  EXPECT_EQ(scheduler_.deadline(), At(60));
+}
+
+TEST_F(FrameSchedulerTest, ResetClearsState) {
+  scheduler_.RequestFrame();
+  scheduler_.NotifyActivity(At(0));
+  scheduler_.Reset();
+  EXPECT_FALSE(scheduler_.is_capturing());
+  EXPECT_FALSE(scheduler_.deadline());
+  EXPECT_EQ(scheduler_.FrameDelivered(), Action::kNone);
+}
+
+TEST(FrameRateLimiterTest, UnlimitedByDefault) {
+  FrameRateLimiter limiter;
+  const auto now = FrameRateLimiter::Clock::now();
+  EXPECT_FALSE(limiter.frame_interval());
+  EXPECT_FALSE(limiter.ShouldDropFrame(now));
+  EXPECT_FALSE(limiter.ShouldDropFrame(now));
+}
+
+TEST(FrameRateLimiterTest, DropsFramesArrivingTooEarly) {
+  FrameRateLimiter limiter;
+  limiter.SetMaxFps(10);
+  ASSERT_TRUE(limiter.frame_interval());
+  EXPECT_EQ(*limiter.frame_interval(), milliseconds(100));
+
+  const auto start = FrameRateLimiter::Clock::now();
+  EXPECT_FALSE(limiter.ShouldDropFrame(start));
+  EXPECT_TRUE(limiter.ShouldDropFrame(start + milliseconds(50)));
+  EXPECT_TRUE(limiter.ShouldDropFrame(start + milliseconds(99)));
+  EXPECT_FALSE(limiter.ShouldDropFrame(start + milliseconds(100)));
+
+  // Measured from the last accepted frame, not the last dropped one.
+  EXPECT_TRUE(limiter.ShouldDropFrame(start + milliseconds(150)));
+  EXPECT_FALSE(limiter.ShouldDropFrame(start + milliseconds(200)));
+}
+
+TEST(FrameRateLimiterTest, RoundsIntervalUp) {
+  FrameRateLimiter limiter;
+  limiter.SetMaxFps(60);
+  ASSERT_TRUE(limiter.frame_interval());
+  EXPECT_GE(*limiter.frame_interval() * 60, std::chrono::seconds(1));
+  EXPECT_LT(*limiter.frame_interval(), milliseconds(17));
+}
+
+TEST(FrameRateLimiterTest, RemovingLimitAcceptsAllFrames) {
+  FrameRateLimiter limiter;
+  limiter.SetMaxFps(10);
+  const auto start = FrameRateLimiter::Clock::now();
+  EXPECT_FALSE(limiter.ShouldDropFrame(start));
+
+  limiter.SetMaxFps(std::nullopt);
+  EXPECT_FALSE(limiter.frame_interval());
+  EXPECT_FALSE(limiter.ShouldDropFrame(start + milliseconds(1)));
+
+  // A new limit doesn't measure from frames accepted while unlimited.
+  limiter.SetMaxFps(10);
+  EXPECT_FALSE(limiter.ShouldDropFrame(start + milliseconds(2)));
+}
+
+TEST(FrameRateLimiterTest, NonPositiveLimitIsUnlimited) {
+  FrameRateLimiter limiter;
+  limiter.SetMaxFps(0);
+  EXPECT_FALSE(limiter.frame_interval());
+  limiter.SetMaxFps(-5);
+  EXPECT_FALSE(limiter.frame_interval());
+}
+
+}  // namespace
@@ -0,0 +1,273 @@
+#include "util/host_dispatcher.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <string>
+#include <variant>
+#include <vector>
+
+namespace {
+
+using util::HostDispatcher;
+using util::HostValue;
+using InvokeResult = HostDispatcher::InvokeResult;
+
+// Records how deferred calls are completed.
+struct CompletionLog {
+  struct Entry {
+    bool success;
+    HostValue result;
+  };
+  std::vector<Entry> entries;
+
+  HostDispatcher::Completion Callback() {
+    return [this](bool success, HostValue result) {
+      entries.push_back({success, std::move(result)});
+    };
+  }
+};
+
+int64_t IntOf(const HostValue& value) { return std::get<int64_t>(value.value); }
+
+TEST(HostDispatcherTest, CallsNativeHandlersSynchronously) {
+  HostDispatcher dispatcher;
+  dispatcher.RegisterNative("add", [](const HostValue::List& args) {
+    return HostValue{IntOf(args[0]) + IntOf(args[1])};
+  });
+
+  const auto id = dispatcher.GetDispatchId("add");
+  ASSERT_TRUE(id);
+  HostValue result;
+  const HostValue::List args = {HostValue{int64_t{2}}, HostValue{int64_t{3}}};
+  EXPECT_EQ(dispatcher.Invoke(*id, args, &result, nullptr),
+            InvokeResult::kCompleted);
+  EXPECT_EQ(IntOf(result), 5);
+  EXPECT_FALSE(dispatcher.has_pending_calls());
+  EXPECT_EQ(dispatcher.outstanding_calls(), 0u);
+}
+
+TEST(HostDispatcherTest, NativeHandlerWithoutFunctionReturnsNull) {
+  HostDispatcher dispatcher;
+  dispatcher.RegisterNative("noop", nullptr);
+  HostValue result{true};
+  EXPECT_EQ(dispatcher.Invoke(*dispatcher.GetDispatchId("noop"), {}, &result,
+                              nullptr),
+            InvokeResult::kCompleted);
+  EXPECT_TRUE(std::holds_alternative<std::monostate>(result.value));
+}
+
+TEST(HostDispatcherTest, BatchesDeferredCalls) {
+  HostDispatcher dispatcher;
+  dispatcher.RegisterDeferred("a");
+  dispatcher.RegisterDeferred("b");
+  const auto a = *dispatcher.GetDispatchId("a");
+  const auto b = *dispatcher.GetDispatchId("b");
+
+  CompletionLog log;
+  HostValue result;
+  EXPECT_EQ(dispatcher.Invoke(a, {HostValue{int64_t{1}}}, &result,
+                              log.Callback()),
+            InvokeResult::kDeferred);
+  EXPECT_EQ(dispatcher.Invoke(b, {}, &result, log.Callback()),
+            InvokeResult::kDeferred);
+  EXPECT_EQ(dispatcher.Invoke(a, {HostValue{int64_t{2}}}, &result,
+                              log.Callback()),
+            InvokeResult::kDeferred);
+  EXPECT_TRUE(dispatcher.has_pending_calls());
+
+  // All calls made so far are taken in one batch, in call order.
+  const auto calls = dispatcher.TakePendingCalls();
+  ASSERT_EQ(calls.size(), 3u);
+  EXPECT_EQ(calls[0].name, "a");
+  EXPECT_EQ(calls[1].name, "b");
+  EXPECT_EQ(calls[2].name, "a");
+  EXPECT_EQ(IntOf(calls[0].args[0]), 1);
+  EXPECT_EQ(IntOf(calls[2].args[0]), 2);
+  EXPECT_LT(calls[0].call_id, calls[1].call_id);
+  EXPECT_LT(calls[1].call_id, calls[2].call_id);
+
+  EXPECT_FALSE(dispatcher.has_pending_calls());
+  EXPECT_TRUE(dispatcher.TakePendingCalls().empty());
+  EXPECT_EQ(dispatcher.outstanding_calls(), 3u);
+  EXPECT_TRUE(log.entries.empty());
+}
+
+TEST(HostDispatcherTest, RoutesResultsToTheirCalls) {
+  HostDispatcher dispatcher;
+  dispatcher.RegisterDeferred("f");
+  const auto id = *dispatcher.GetDispatchId("f");
+
+  std::vector<std::string> completed;
+  HostValue result;
+  for (const auto name : {"first", "second"}) {
+    dispatcher.Invoke(id, {}, &result,
+                      [&completed, name](bool success, HostValue value) {
+                        EXPECT_TRUE(success);
+                        completed.push_back(name + std::string(":") +
+                                            std::get<std::string>(value.value));
+                      });
+  }
+  const auto calls = dispatcher.TakePendingCalls();
+  ASSERT_EQ(calls.size(), 2u);
+
+  // Completed out of order.
+  EXPECT_TRUE(
+      dispatcher.Complete(calls[1].call_id, true, HostValue{std::string("b")}));
+  EXPECT_TRUE(
+      dispatcher.Complete(calls[0].call_id, true, HostValue{std::string("a")}));
+  EXPECT_EQ(completed, (std::vector<std::string>{"second:b", "first:a"}));
+  EXPECT_EQ(dispatcher.outstanding_calls(), 0u);
+
+  // Each call completes once.
+  EXPECT_FALSE(dispatcher.Complete(calls[0].call_id, true, HostValue{}));
+  EXPECT_FALSE(dispatcher.Complete(12345, true, HostValue{}));
+}
+
+TEST(HostDispatcherTest, CompletesCallsBeforeTheyAreTaken) {
+  HostDispatcher dispatcher;
+  dispatcher.RegisterDeferred("f");
+  const auto id = *dispatcher.GetDispatchId("f");
+
+  CompletionLog log;
+  HostValue result;
+  dispatcher.Invoke(id, {}, &result, log.Callback());
+  dispatcher.Invoke(id, {}, &result, log.Callback());
+
+  // The first call id is 1.
+  EXPECT_TRUE(dispatcher.Complete(1, false, HostValue{std::string("error")}));
+  ASSERT_EQ(log.entries.size(), 1u);
+  EXPECT_FALSE(log.entries[0].success);
+
+  const auto calls = dispatcher.TakePendingCalls();
+  ASSERT_EQ(calls.size(), 1u);
+  EXPECT_EQ(calls[0].call_id, 2u);
+}
+
+TEST(HostDispatcherTest, CancelAllFailsOutstandingCalls) {
+  HostDispatcher dispatcher;
+  dispatcher.RegisterDeferred("f");
+  const auto id = *dispatcher.GetDispatchId("f");
+
+  CompletionLog log;
+  HostValue result;
+  dispatcher.Invoke(id, {}, &result, log.Callback());
+  dispatcher.Invoke(id, {}, &result, nullptr);
+  dispatcher.TakePendingCalls();
+  dispatcher.Invoke(id, {}, &result, log.Callback());
+
+  dispatcher.CancelAll();
+  EXPECT_FALSE(dispatcher.has_pending_calls());
+  EXPECT_EQ(dispatcher.outstanding_calls(), 0u);
+  ASSERT_EQ(log.entries.size(), 2u);
+  for (const auto& entry : log.entries) {
+    EXPECT_FALSE(entry.success);
+    EXPECT_EQ(std::get<std::string>(entry.result.value), "Cancelled");
+  }
+  EXPECT_FALSE(dispatcher.Complete(1, true, HostValue{}));
+}
+
+TEST(HostDispatcherTest, RejectsUnknownDispatchIds) {
+  HostDispatcher dispatcher;
+  dispatcher.RegisterNative("f", nullptr);
+  EXPECT_FALSE(dispatcher.GetDispatchId("g"));
+
+  HostValue result;
+  for (const HostDispatcher::DispatchId id : {0, -1, 2, INT32_MAX}) {
+    EXPECT_EQ(dispatcher.Invoke(id, {}, &result, nullptr),
+              InvokeResult::kUnknown)
+        << id;
+  }
+}
+
+TEST(HostDispatcherTest, KeepsDispatchIdsAcrossRegistrations) {
+  HostDispatcher dispatcher;
+  dispatcher.RegisterNative("a", nullptr);
+  dispatcher.RegisterDeferred("b");
+  const auto a = *dispatcher.GetDispatchId("a");
+  const auto b = *dispatcher.GetDispatchId("b");
+  EXPECT_GT(a, 0);
+  EXPECT_NE(a, b);
+
+  EXPECT_TRUE(dispatcher.Unregister("a"));
+  EXPECT_FALSE(dispatcher.Unregister("a"));
+  EXPECT_FALSE(dispatcher.GetDispatchId("a"));
+  HostValue result;
+  EXPECT_EQ(dispatcher.Invoke(a, {}, &result, nullptr),
+            InvokeResult::kUnknown);
+
+  // Scripts may still hold on to the old id.
+  dispatcher.RegisterDeferred("a");
+  EXPECT_EQ(dispatcher.GetDispatchId("a"), a);
+  EXPECT_EQ(dispatcher.Invoke(a, {}, &result, nullptr),
+            InvokeResult::kDeferred);
+}
+
+TEST(HostDispatcherTest, HandlerMayReplaceItself) {
+  HostDispatcher dispatcher;
+  dispatcher.RegisterNative("f", [&](const HostValue::List&) {
+    dispatcher.RegisterNative(
+        "f", [](const HostValue::List&) { return HostValue{int64_t{2}}; });
+    return HostValue{int64_t{1}};
+  });
+  const auto id = *dispatcher.GetDispatchId("f");
+
+  HostValue result;
+  dispatcher.Invoke(id, {}, &result, nullptr);
+  EXPECT_EQ(IntOf(result), 1);
+  dispatcher.Invoke(id, {}, &result, nullptr);
+  EXPECT_EQ(IntOf(result), 2);
+}
+
+TEST(HostDispatcherTest, PassesArgumentsOfAllTypes) {
+  HostDispatcher dispatcher;
+  HostValue::List received;
+  dispatcher.RegisterNative("f", [&](const HostValue::List& args) {
+    received = args;
+    return HostValue{};
+  });
+
+  HostValue::List args = {
+      HostValue{},
+      HostValue{true},
+      HostValue{int64_t{-7}},
+      HostValue{0.5},
+      HostValue{std::string("text")},
+      HostValue{HostValue::List{HostValue{int64_t{1}}, HostValue{}}},
+  };
+  HostValue result;
+  dispatcher.Invoke(*dispatcher.GetDispatchId("f"), args, &result, nullptr);
+
+  ASSERT_EQ(received.size(), args.size());
+  EXPECT_TRUE(std::holds_alternative<std::monostate>(received[0].value));
+  EXPECT_EQ(std::get<bool>(received[1].value), true);
+  EXPECT_EQ(IntOf(received[2]), -7);
+  EXPECT_EQ(std::get<double>(received[3].value), 0.5);
+  EXPECT_EQ(std::get<std::string>(received[4].value), "text");
+  const auto& list = std::get<HostValue::List>(received[5].value);
+  ASSERT_EQ(list.size(), 2u);
+  EXPECT_EQ(IntOf(list[0]), 1);
+  EXPECT_TRUE(std::holds_alternative<std::monostate>(list[1].value));
+}
+
+TEST(HostDispatcherTest, HandlersSeeArgumentTypesAsPassed) {
+  HostDispatcher dispatcher;
+  // A handler expecting an integer has to check the type itself.
+  dispatcher.RegisterNative("twice", [](const HostValue::List& args) {
+    if (args.size() != 1 || !std::holds_alternative<int64_t>(args[0].value)) {
+      return HostValue{std::string("Invalid argument")};
+    }
+    return HostValue{IntOf(args[0]) * 2};
+  });
+  const auto id = *dispatcher.GetDispatchId("twice");
+
+  HostValue result;
+  dispatcher.Invoke(id, {HostValue{std::string("2")}}, &result, nullptr);
+  EXPECT_EQ(std::get<std::string>(result.value), "Invalid argument");
+  dispatcher.Invoke(id, {HostValue{2.0}}, &result, nullptr);
+  EXPECT_EQ(std::get<std::string>(result.value), "Invalid argument");
+  dispatcher.Invoke(id, {HostValue{int64_t{2}}}, &result, nullptr);
+  EXPECT_EQ(IntOf(result), 4);
+}
+
+}  // namespace
@@ -0,0 +1,155 @@
+#include "util/permission_cache.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+
+namespace {
+
+using util::PermissionCache;
+using Decision = PermissionCache::Decision;
+using namespace std::chrono_literals;
+
+constexpr int32_t kCamera = 1;
+constexpr int32_t kMicrophone = 2;
+
+TEST(PermissionCacheTest, MatchesOriginAndKind) {
+  PermissionCache cache;
+  const auto now = PermissionCache::Clock::now();
+  cache.Set("https://a.com", kCamera, Decision::kAllow, std::nullopt, now);
+  cache.Set("https://a.com", kMicrophone, Decision::kDeny, std::nullopt, now);
+
+  EXPECT_EQ(cache.Lookup("https://a.com", kCamera, now), Decision::kAllow);
+  EXPECT_EQ(cache.Lookup("https://a.com", kMicrophone, now), Decision::kDeny);
+  EXPECT_FALSE(cache.Lookup("https://a.com:8443", kCamera, now));
+  EXPECT_FALSE(cache.Lookup("http://a.com", kCamera, now));
+  EXPECT_FALSE(cache.Lookup("https://b.com", kCamera, now));
+  EXPECT_FALSE(cache.Lookup("https://a.com", 3, now));
+}
+
+TEST(PermissionCacheTest, ReplacesDecisions) {
+  PermissionCache cache;
+  const auto now = PermissionCache::Clock::now();
+  cache.Set("https://a.com", kCamera, Decision::kAllow, 1s, now);
+  cache.Set("https://a.com", kCamera, Decision::kDeny, std::nullopt, now);
+  EXPECT_EQ(cache.size(), 1u);
+  EXPECT_EQ(cache.Lookup("https://a.com", kCamera, now + 1h),
+            Decision::kDeny);
+}
+
+TEST(PermissionCacheTest, ExpiresDecisions) {
+  PermissionCache cache;
+  const auto now = PermissionCache::Clock::now();
+  cache.Set("https://a.com", kCamera, Decision::kAllow, 10s, now);
+  cache.Set("https://a.com", kMicrophone, Decision::kAllow, std::nullopt,
+            now);
+
+  EXPECT_EQ(cache.Lookup("https://a.com", kCamera, now + 9s),
+            Decision::kAllow);
+  EXPECT_FALSE(cache.Lookup("https://a.com", kCamera, now + 10s));
+  EXPECT_EQ(cache.size(), 1u);
+  EXPECT_EQ(cache.Lookup("https://a.com", kMicrophone, now + 24h),
+            Decision::kAllow);
+}
+
+TEST(PermissionCacheTest, ParsesTtls) {
+  EXPECT_EQ(PermissionCache::ParseTtl(0), PermissionCache::Clock::duration());
+  EXPECT_EQ(PermissionCache::ParseTtl(1500), 1500ms);
+  // 30 days, which Dart sends as int64.
+  EXPECT_EQ(PermissionCache::ParseTtl(int64_t{30} * 24 * 3600 * 1000),
+            24h * 30);
+  EXPECT_EQ(PermissionCache::ParseTtl(INT64_MAX),
+            PermissionCache::Clock::duration::max());
+  EXPECT_FALSE(PermissionCache::ParseTtl(-1));
+}
+
+TEST(PermissionCacheTest, RemembersReplies) {
+  PermissionCache cache;
+  const auto now = PermissionCache::Clock::now();
+  const int64_t kThirtyDaysMs = int64_t{30} * 24 * 3600 * 1000;
+  ASSERT_GT(kThirtyDaysMs, INT32_MAX);
+
+  EXPECT_TRUE(cache.Remember("https://a.com", kCamera, true, kThirtyDaysMs,
+                             now));
+  EXPECT_EQ(cache.Lookup("https://a.com", kCamera, now + 24h * 29),
+            Decision::kAllow);
+  EXPECT_FALSE(cache.Lookup("https://a.com", kCamera, now + 24h * 30));
+
+  EXPECT_TRUE(cache.Remember("https://a.com", kMicrophone, false, 0, now));
+  EXPECT_FALSE(cache.Lookup("https://a.com", kMicrophone, now));
+
+  EXPECT_FALSE(cache.Remember("https://b.com", kCamera, true, -1, now));
+  EXPECT_FALSE(cache.Lookup("https://b.com", kCamera, now));
+}
+
+TEST(PermissionCacheTest, SaturatesLongTtls) {
+  constexpr auto kYear = 24h * 365;
+  PermissionCache cache;
+  const auto now = PermissionCache::Clock::now();
+  EXPECT_TRUE(cache.Remember("https://a.com", kCamera, true, INT64_MAX, now));
+  EXPECT_EQ(cache.Lookup("https://a.com", kCamera, now + 100 * kYear),
+            Decision::kAllow);
+}
+
+TEST(PermissionCacheTest, RemovesDecisions) {
+  PermissionCache cache;
+  const auto now = PermissionCache::Clock::now();
+  cache.Set("https://a.com", kCamera, Decision::kAllow, std::nullopt, now);
+  cache.Set("https://a.com", kMicrophone, Decision::kAllow, std::nullopt,
+            now);
+  cache.Set("https://b.com", kCamera, Decision::kAllow, std::nullopt, now);
+
+  EXPECT_TRUE(cache.Remove("https://a.com", kCamera));
+  EXPECT_FALSE(cache.Remove("https://a.com", kCamera));
+  EXPECT_EQ(cache.size(), 2u);
+
+  cache.RemoveOrigin("https://a.com");
+  EXPECT_FALSE(cache.Lookup("https://a.com", kMicrophone, now));
+  EXPECT_EQ(cache.Lookup("https://b.com", kCamera, now), Decision::kAllow);
+
+  cache.Clear();
+  EXPECT_EQ(cache.size(), 0u);
+}
+
+TEST(PermissionCacheTest, DropsExpiredEntriesWhenFull) {
+  PermissionCache cache(2);
+  const auto now = PermissionCache::Clock::now();
+  cache.Set("https://a.com", kCamera, Decision::kAllow, 1s, now);
+  cache.Set("https://b.com", kCamera, Decision::kAllow, 1h, now);
+  cache.Set("https://c.com", kCamera, Decision::kAllow, std::nullopt,
+            now + 2s);
+
+  EXPECT_EQ(cache.size(), 2u);
+  EXPECT_FALSE(cache.Lookup("https://a.com", kCamera, now));
+  EXPECT_TRUE(cache.Lookup("https://b.com", kCamera, now));
+  EXPECT_TRUE(cache.Lookup("https://c.com", kCamera, now));
+}
+
+TEST(PermissionCacheTest, DropsSoonestExpiringEntryWhenFull) {
+  PermissionCache cache(3);
+  const auto now = PermissionCache::Clock::now();
+  cache.Set("https://a.com", kCamera, Decision::kAllow, std::nullopt, now);
+  cache.Set("https://b.com", kCamera, Decision::kAllow, 2h, now);
+  cache.Set("https://c.com", kCamera, Decision::kAllow, 1h, now);
+  cache.Set("https://d.com", kCamera, Decision::kAllow, 3h, now);
+
+  EXPECT_EQ(cache.size(), 3u);
+  EXPECT_FALSE(cache.Lookup("https://c.com", kCamera, now));
+  EXPECT_TRUE(cache.Lookup("https://a.com", kCamera, now));
+  EXPECT_TRUE(cache.Lookup("https://b.com", kCamera, now));
+  EXPECT_TRUE(cache.Lookup("https://d.com", kCamera, now));
+
+  // Decisions without expiry go last.
+  PermissionCache permanent(1);
+  permanent.Set("https://a.com", kCamera, Decision::kAllow, std::nullopt,
+                now);
+  permanent.Set("https://b.com", kCamera, Decision::kDeny, std::nullopt,
+                now);
+  EXPECT_EQ(permanent.size(), 1u);
+  EXPECT_EQ(permanent.Lookup("https://b.com", kCamera, now),
+            Decision::kDeny);
+}
+
+}  // namespace
@@ -0,0 +1,188 @@
+#include "util/preview_frame_pipeline.h"
+
+#include <gtest/gtest.h>
+#include <png.h>
+
+#include <chrono>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "util/adaptive_poller.h"
+
+namespace {
+
+using util::AdaptivePoller;
+using util::PixelFrame;
+using util::PreviewFramePipeline;
+using Result = PreviewFramePipeline::Result;
+using namespace std::chrono_literals;
+
+std::vector<uint8_t> ReadFixture(const std::string& name) {
+  std::ifstream file(std::string(FIXTURES_DIR) + "/" + name,
+                     std::ios::binary);
+  EXPECT_TRUE(file) << name;
+  return std::vector<uint8_t>(std::istreambuf_iterator<char>(file), {});
+}
+
+// Decodes PNG images to RGBA, like WIC does in TextureBridgePreview.
+class PngDecoder {
+ public:
+  int decode_count() const { return decode_count_; }
+
+  PreviewFramePipeline::Decoder AsDecoder() {
+    return [this](const uint8_t* data, size_t size, PixelFrame* frame) {
+      decode_count_++;
+      png_image image = {};
+      image.version = PNG_IMAGE_VERSION;
+      if (!png_image_begin_read_from_memory(&image, data, size)) {
+        return false;
+      }
+      image.format = PNG_FORMAT_RGBA;
+      frame->width = image.width;
+      frame->height = image.height;
+      frame->pixels.resize(PNG_IMAGE_SIZE(image));
+      return png_image_finish_read(&image, nullptr, frame->pixels.data(), 0,
+                                   nullptr) != 0;
+    };
+  }
+
+ private:
+  int decode_count_ = 0;
+};
+
+std::vector<uint8_t> Repeat(std::vector<uint8_t> pixel, size_t count) {
+  std::vector<uint8_t> result;
+  for (size_t i = 0; i < count; i++) {
+    result.insert(result.end(), pixel.begin(), pixel.end());
+  }
+  return result;
+}
+
+class PreviewFramePipelineTest : public testing::Test {
+ protected:
+  PreviewFramePipelineTest()
+      : red_(ReadFixture("red_4x2.png")),
+        blue_(ReadFixture("blue_4x2.png")),
+        gradient_(ReadFixture("gradient_3x3_rgb.png")),
+        pipeline_(decoder_.AsDecoder()) {}
+
+  Result Process(const std::vector<uint8_t>& image) {
+    return pipeline_.Process(image.data(), image.size());
+  }
+
+  PngDecoder decoder_;
+  const std::vector<uint8_t> red_;
+  const std::vector<uint8_t> blue_;
+  const std::vector<uint8_t> gradient_;
+  PreviewFramePipeline pipeline_;
+};
+
+TEST_F(PreviewFramePipelineTest, DecodesFixtures) {
+  EXPECT_EQ(Process(red_), Result::kDecoded);
+  pipeline_.Commit();
+  EXPECT_EQ(pipeline_.front().width, 4u);
+  EXPECT_EQ(pipeline_.front().height, 2u);
+  EXPECT_EQ(pipeline_.front().pixels, Repeat({255, 0, 0, 255}, 8));
+
+  // RGB images get an opaque alpha channel.
+  EXPECT_EQ(Process(gradient_), Result::kDecoded);
+  pipeline_.Commit();
+  const auto& frame = pipeline_.front();
+  ASSERT_EQ(frame.pixels.size(), 3u * 3u * 4u);
+  const size_t bottom_right = (2 * 3 + 2) * 4;
+  EXPECT_EQ(frame.pixels[bottom_right], 200);
+  EXPECT_EQ(frame.pixels[bottom_right + 1], 200);
+  EXPECT_EQ(frame.pixels[bottom_right + 2], 50);
+  EXPECT_EQ(frame.pixels[bottom_right + 3], 255);
+}
+
+TEST_F(PreviewFramePipelineTest, SkipsUnchangedImages) {
+  EXPECT_EQ(Process(red_), Result::kDecoded);
+  EXPECT_EQ(Process(red_), Result::kUnchanged);
+  EXPECT_EQ(decoder_.decode_count(), 1);
+
+  EXPECT_EQ(Process(blue_), Result::kDecoded);
+  EXPECT_EQ(Process(red_), Result::kDecoded);
+  EXPECT_EQ(decoder_.decode_count(), 3);
+
+  pipeline_.Invalidate();
+  EXPECT_EQ(Process(red_), Result::kDecoded);
+  EXPECT_EQ(decoder_.decode_count(), 4);
+}
+
+TEST_F(PreviewFramePipelineTest, ShowsFramesOnlyOnceCommitted) {
+  EXPECT_TRUE(pipeline_.front().pixels.empty());
+  Process(red_);
+  EXPECT_TRUE(pipeline_.front().pixels.empty());
+  pipeline_.Commit();
+  EXPECT_EQ(pipeline_.front().pixels, Repeat({255, 0, 0, 255}, 8));
+
+  Process(blue_);
+  EXPECT_EQ(pipeline_.front().pixels, Repeat({255, 0, 0, 255}, 8));
+  pipeline_.Commit();
+  EXPECT_EQ(pipeline_.front().pixels, Repeat({0, 0, 255, 128}, 8));
+
+  // Nothing to commit.
+  pipeline_.Commit();
+  EXPECT_EQ(pipeline_.front().pixels, Repeat({0, 0, 255, 128}, 8));
+}
+
+TEST_F(PreviewFramePipelineTest, KeepsFrontFrameOnFailure) {
+  Process(red_);
+  pipeline_.Commit();
+
+  const std::vector<uint8_t> truncated(blue_.begin(), blue_.end() - 20);
+  EXPECT_EQ(Process(truncated), Result::kFailed);
+  pipeline_.Commit();
+  EXPECT_EQ(pipeline_.front().pixels, Repeat({255, 0, 0, 255}, 8));
+
+  // A decoded frame that wasn't committed is dropped by a failure, as the
+  // back buffer may have been overwritten.
+  Process(blue_);
+  EXPECT_EQ(Process(truncated), Result::kFailed);
+  pipeline_.Commit();
+  EXPECT_EQ(pipeline_.front().pixels, Repeat({255, 0, 0, 255}, 8));
+
+  // Failed images are retried.
+  EXPECT_EQ(Process(truncated), Result::kFailed);
+  EXPECT_EQ(decoder_.decode_count(), 5);
+}
+
+TEST_F(PreviewFramePipelineTest, RejectsFramesOfWrongSize) {
+  PreviewFramePipeline pipeline(
+      [](const uint8_t*, size_t, PixelFrame* frame) {
+        frame->width = 4;
+        frame->height = 2;
+        frame->pixels.resize(4 * 2 * 3);
+        return true;
+      });
+  EXPECT_EQ(pipeline.Process(red_.data(), red_.size()), Result::kFailed);
+}
+
+// Feeds a sequence of captured images through the pipeline and the poller,
+// like TextureBridgePreview does.
+TEST_F(PreviewFramePipelineTest, AdaptsPollIntervalToChanges) {
+  AdaptivePoller poller(10ms, 80ms);
+  const auto poll = [&](const std::vector<uint8_t>& image) {
+    return poller.OnPoll(Process(image) == Result::kDecoded, 1ms);
+  };
+
+  EXPECT_EQ(poll(red_), 10ms);
+  EXPECT_EQ(poll(red_), 20ms);
+  EXPECT_EQ(poll(red_), 40ms);
+  EXPECT_EQ(poll(red_), 80ms);
+  EXPECT_EQ(poll(red_), 80ms);
+  EXPECT_EQ(poll(blue_), 10ms);
+  EXPECT_EQ(poll(blue_), 20ms);
+  EXPECT_EQ(poll(gradient_), 10ms);
+  EXPECT_EQ(decoder_.decode_count(), 3);
+
+  // Failed captures back off like unchanged ones.
+  const std::vector<uint8_t> corrupt(red_.size(), 0);
+  EXPECT_EQ(poll(corrupt), 20ms);
+  EXPECT_EQ(poll(corrupt), 40ms);
+}
+
+}  // namespace
@@ -0,0 +1,102 @@
+#include "util/rect.h"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+namespace {
+
+using util::Rect;
+
+TEST(RectTest, SizeOfInvertedRectIsEmpty) {
+  const Rect rect{10, 10, 5, 20};
+  EXPECT_EQ(rect.width(), 0);
+  EXPECT_EQ(rect.height(), 10);
+  EXPECT_TRUE(rect.IsEmpty());
+}
+
+TEST(RectTest, Intersect) {
+  EXPECT_EQ(util::Intersect({0, 0, 10, 10}, {5, 2, 20, 8}),
+            (Rect{5, 2, 10, 8}));
+  EXPECT_EQ(util::Intersect({0, 0, 10, 10}, {2, 2, 4, 4}),
+            (Rect{2, 2, 4, 4}));
+}
+
+TEST(RectTest, IntersectWithoutOverlapIsEmpty) {
+  // Touching edges don't overlap as right and bottom are exclusive.
+  EXPECT_EQ(util::Intersect({0, 0, 10, 10}, {10, 0, 20, 10}), Rect{});
+  EXPECT_EQ(util::Intersect({0, 0, 10, 10}, {0, 10, 10, 20}), Rect{});
+  EXPECT_EQ(util::Intersect({0, 0, 10, 10}, {-20, -20, -5, -5}), Rect{});
+}
+
+TEST(RectTest, ScaleToPhysicalAtIntegerScale) {
+  EXPECT_EQ(util::ScaleToPhysical(10, 20, 30, 40, 1.0),
+            (Rect{10, 20, 40, 60}));
+  EXPECT_EQ(util::ScaleToPhysical(10, 20, 30, 40, 2.0),
+            (Rect{20, 40, 80, 120}));
+}
+
+TEST(RectTest, ScaleToPhysicalRoundsOutwards) {
+  // 1.25: 3 * 1.25 = 3.75 and (3 + 5) * 1.25 = 10.
+  EXPECT_EQ(util::ScaleToPhysical(3, 3, 5, 5, 1.25), (Rect{3, 3, 10, 10}));
+  // 1.5: 1.5 and (1 + 2) * 1.5 = 4.5.
+  EXPECT_EQ(util::ScaleToPhysical(1, 1, 2, 2, 1.5), (Rect{1, 1, 5, 5}));
+  // 1.75: 0.5 * 1.75 = 0.875 and 1.5 * 1.75 = 2.625.
+  EXPECT_EQ(util::ScaleToPhysical(0.5, 0.5, 1, 1, 1.75), (Rect{0, 0, 3, 3}));
+}
+
+TEST(RectTest, ScaleToPhysicalCoversFractionalPixels) {
+  // Every logical pixel touched must be covered, even if tiny.
+  const auto rect = util::ScaleToPhysical(10.1, 10.1, 0.1, 0.1, 1.5);
+  EXPECT_EQ(rect, (Rect{15, 15, 16, 16}));
+  EXPECT_FALSE(rect.IsEmpty());
+}
+
+TEST(RectTest, ScaleToPhysicalRoundsNegativeOriginDown) {
+  EXPECT_EQ(util::ScaleToPhysical(-1.5, -0.5, 3, 1, 1.25),
+            (Rect{-2, -1, 2, 1}));
+}
+
+TEST(RectTest, ScaleToPhysicalRejectsEmptyInput) {
+  EXPECT_EQ(util::ScaleToPhysical(1, 1, 0, 10, 1.5), Rect{});
+  EXPECT_EQ(util::ScaleToPhysical(1, 1, 10, -1, 1.5), Rect{});
+  EXPECT_EQ(util::ScaleToPhysical(1, 1, 10, 10, 0), Rect{});
+  EXPECT_EQ(util::ScaleToPhysical(1, 1, 10, 10, -1), Rect{});
+}
+
+TEST(RectTest, ScaleToPhysicalSaturates) {
+  constexpr auto kMax = std::numeric_limits<int32_t>::max();
+  constexpr auto kMin = std::numeric_limits<int32_t>::min();
+  EXPECT_EQ(util::ScaleToPhysical(-1e12, 0, 2e12, 1e12, 2.0),
+            (Rect{kMin, 0, kMax, kMax}));
+  EXPECT_EQ(util::ScaleToPhysical(std::nan(""), 0, 10, 10, 1.0).left, 0);
+}
+
+TEST(RectTest, ClipToSurface) {
+  EXPECT_EQ(util::ClipToSurface({-5, -5, 50, 50}, 40, 30),
+            (Rect{0, 0, 40, 30}));
+  EXPECT_EQ(util::ClipToSurface({5, 5, 10, 10}, 40, 30), (Rect{5, 5, 10, 10}));
+}
+
+TEST(RectTest, ClipToSurfaceOutsideIsEmpty) {
+  EXPECT_EQ(util::ClipToSurface({40, 0, 50, 10}, 40, 30), Rect{});
+  EXPECT_EQ(util::ClipToSurface({-10, -10, 0, 0}, 40, 30), Rect{});
+  EXPECT_EQ(util::ClipToSurface({0, 0, 10, 10}, 0, 0), Rect{});
+}
+
+TEST(RectTest, ClipToHugeSurface) {
+  constexpr auto kMax = std::numeric_limits<int32_t>::max();
+  EXPECT_EQ(util::ClipToSurface({0, 0, kMax, 10}, UINT32_MAX, UINT32_MAX),
+            (Rect{0, 0, kMax, 10}));
+}
+
+TEST(RectTest, ScaledRectClippedToSurface) {
+  // A 1.25x rect at the edge of a 100x100 surface.
+  const auto rect = util::ClipToSurface(
+      util::ScaleToPhysical(70.5, 70.5, 20, 20, 1.25), 100, 100);
+  EXPECT_EQ(rect, (Rect{88, 88, 100, 100}));
+}
+
+}  // namespace
@@ -0,0 +1,223 @@
+#include "util/renderer_watchdog.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+
+namespace {
+
+using util::RendererWatchdog;
+using Action = RendererWatchdog::Action;
+using State = RendererWatchdog::State;
+using namespace std::chrono_literals;
+
+// The watchdog is driven with explicit times, starting at an arbitrary one.
+class RendererWatchdogTest : public testing::Test {
+ protected:
+  RendererWatchdogTest() : now_(RendererWatchdog::Clock::time_point(1h)) {
+    options_.heartbeat_interval = 2s;
+    options_.heartbeat_timeout = 3s;
+    options_.unresponsive_timeout = 10s;
+    options_.recovery_timeout = 15s;
+    options_.recovery_delay = 1s;
+    options_.max_recovery_delay = 3s;
+    options_.max_recoveries = 3;
+    watchdog_.set_options(options_);
+  }
+
+  void Advance(RendererWatchdog::Clock::duration duration) {
+    now_ += duration;
+  }
+
+  // Advances to the deadline and ticks.
+  Action TickAtDeadline() {
+    const auto deadline = watchdog_.deadline();
+    EXPECT_TRUE(deadline);
+    if (deadline && *deadline > now_) {
+      now_ = *deadline;
+    }
+    return watchdog_.Tick(now_);
+  }
+
+  // Sends a heartbeat and lets it time out.
+  Action TimeOut() {
+    EXPECT_EQ(TickAtDeadline(), Action::kSendHeartbeat);
+    return TickAtDeadline();
+  }
+
+  RendererWatchdog::Options options_;
+  RendererWatchdog watchdog_;
+  RendererWatchdog::Clock::time_point now_;
+};
+
+TEST_F(RendererWatchdogTest, SendsHeartbeats) {
+  EXPECT_EQ(watchdog_.state(), State::kStopped);
+  EXPECT_FALSE(watchdog_.deadline());
+
+  watchdog_.Start(now_);
+  EXPECT_EQ(watchdog_.deadline(), now_ + 2s);
+  Advance(1s);
+  EXPECT_EQ(watchdog_.Tick(now_), Action::kNone);
+  Advance(1s);
+  EXPECT_EQ(watchdog_.Tick(now_), Action::kSendHeartbeat);
+  EXPECT_EQ(watchdog_.state(), State::kWaiting);
+  EXPECT_EQ(watchdog_.heartbeat_id(), 1u);
+
+  Advance(500ms);
+  watchdog_.OnHeartbeatCompleted(1, now_);
+  EXPECT_EQ(watchdog_.state(), State::kHealthy);
+  EXPECT_EQ(watchdog_.deadline(), now_ + 2s);
+  EXPECT_EQ(TickAtDeadline(), Action::kSendHeartbeat);
+  EXPECT_EQ(watchdog_.heartbeat_id(), 2u);
+}
+
+TEST_F(RendererWatchdogTest, RecoversAfterHeartbeatTimeout) {
+  watchdog_.Start(now_);
+  EXPECT_EQ(TickAtDeadline(), Action::kSendHeartbeat);
+  const auto sent = now_;
+  EXPECT_EQ(watchdog_.deadline(), sent + 3s);
+
+  // Outdated heartbeats are ignored.
+  watchdog_.OnHeartbeatCompleted(0, now_);
+  EXPECT_EQ(watchdog_.state(), State::kWaiting);
+
+  Advance(2s);
+  EXPECT_EQ(watchdog_.Tick(now_), Action::kNone);
+  Advance(1s);
+  EXPECT_EQ(watchdog_.Tick(now_), Action::kRecover);
+  EXPECT_EQ(watchdog_.state(), State::kRecovering);
+  EXPECT_EQ(watchdog_.recoveries(), 1);
+  EXPECT_EQ(watchdog_.deadline(), now_ + 15s);
+}
+
+TEST_F(RendererWatchdogTest, ExtendsTimeoutAfterFrame) {
+  watchdog_.Start(now_);
+  EXPECT_EQ(TickAtDeadline(), Action::kSendHeartbeat);
+  const auto sent = now_;
+
+  // Frames from before the heartbeat don't count.
+  watchdog_.OnFrame(sent - 1s);
+  EXPECT_EQ(watchdog_.deadline(), sent + 3s);
+
+  Advance(1s);
+  watchdog_.OnFrame(now_);
+  EXPECT_EQ(watchdog_.deadline(), sent + 10s);
+  Advance(5s);
+  EXPECT_EQ(watchdog_.Tick(now_), Action::kNone);
+  EXPECT_EQ(TickAtDeadline(), Action::kRecover);
+  EXPECT_EQ(now_, sent + 10s);
+}
+
+TEST_F(RendererWatchdogTest, RestartsHeartbeatOnNavigation) {
+  watchdog_.Start(now_);
+  EXPECT_EQ(TickAtDeadline(), Action::kSendHeartbeat);
+  Advance(2s);
+  watchdog_.OnNavigationStarted(now_);
+  EXPECT_EQ(watchdog_.state(), State::kHealthy);
+  EXPECT_EQ(watchdog_.deadline(), now_ + 2s);
+}
+
+TEST_F(RendererWatchdogTest, BacksOffBetweenRecoveries) {
+  watchdog_.Start(now_);
+  EXPECT_EQ(TimeOut(), Action::kRecover);
+  EXPECT_EQ(watchdog_.recoveries(), 1);
+
+  // Recovering timed out: the next attempt is delayed.
+  EXPECT_EQ(TickAtDeadline(), Action::kNone);
+  EXPECT_EQ(watchdog_.state(), State::kRecoveryScheduled);
+  EXPECT_EQ(watchdog_.deadline(), now_ + 1s);
+  Advance(500ms);
+  EXPECT_EQ(watchdog_.Tick(now_), Action::kNone);
+  Advance(500ms);
+  EXPECT_EQ(watchdog_.Tick(now_), Action::kRecover);
+  EXPECT_EQ(watchdog_.recoveries(), 2);
+
+  // The renderer comes back, but hangs again right away.
+  Advance(1s);
+  watchdog_.OnRecovered(now_);
+  EXPECT_EQ(watchdog_.state(), State::kHealthy);
+  EXPECT_EQ(TimeOut(), Action::kNone);
+  EXPECT_EQ(watchdog_.deadline(), now_ + 2s);
+  EXPECT_EQ(TickAtDeadline(), Action::kRecover);
+  EXPECT_EQ(watchdog_.recoveries(), 3);
+}
+
+TEST_F(RendererWatchdogTest, LimitsBackoffDelay) {
+  options_.max_recoveries = 10;
+  watchdog_.set_options(options_);
+  watchdog_.Start(now_);
+  EXPECT_EQ(TimeOut(), Action::kRecover);
+
+  for (const auto delay : {1s, 2s, 3s, 3s}) {
+    EXPECT_EQ(TickAtDeadline(), Action::kNone);
+    EXPECT_EQ(watchdog_.deadline(), now_ + delay);
+    EXPECT_EQ(TickAtDeadline(), Action::kRecover);
+  }
+  EXPECT_EQ(watchdog_.recoveries(), 5);
+}
+
+TEST_F(RendererWatchdogTest, GivesUpAfterMaxRecoveries) {
+  watchdog_.Start(now_);
+  EXPECT_EQ(TimeOut(), Action::kRecover);
+  for (int i = 0; i < 2; i++) {
+    EXPECT_EQ(TickAtDeadline(), Action::kNone);
+    EXPECT_EQ(TickAtDeadline(), Action::kRecover);
+  }
+  EXPECT_EQ(watchdog_.recoveries(), 3);
+
+  EXPECT_EQ(TickAtDeadline(), Action::kGiveUp);
+  EXPECT_EQ(watchdog_.state(), State::kFailed);
+  EXPECT_FALSE(watchdog_.deadline());
+  EXPECT_EQ(watchdog_.OnRendererFailed(now_), Action::kNone);
+
+  // Restarting the watchdog starts over.
+  watchdog_.Start(now_);
+  EXPECT_EQ(watchdog_.recoveries(), 0);
+  EXPECT_EQ(TimeOut(), Action::kRecover);
+}
+
+TEST_F(RendererWatchdogTest, ResetsRecoveriesAfterAnsweredHeartbeat) {
+  watchdog_.Start(now_);
+  EXPECT_EQ(TimeOut(), Action::kRecover);
+  EXPECT_EQ(TickAtDeadline(), Action::kNone);
+  EXPECT_EQ(TickAtDeadline(), Action::kRecover);
+  watchdog_.OnRecovered(now_);
+
+  EXPECT_EQ(TickAtDeadline(), Action::kSendHeartbeat);
+  watchdog_.OnHeartbeatCompleted(watchdog_.heartbeat_id(), now_);
+  EXPECT_EQ(watchdog_.recoveries(), 0);
+
+  // The next hang is recovered from right away again.
+  EXPECT_EQ(TimeOut(), Action::kRecover);
+  EXPECT_EQ(watchdog_.recoveries(), 1);
+}
+
+TEST_F(RendererWatchdogTest, RecoversFromCrashes) {
+  EXPECT_EQ(watchdog_.OnRendererFailed(now_), Action::kNone);
+
+  watchdog_.Start(now_);
+  EXPECT_EQ(watchdog_.OnRendererFailed(now_), Action::kRecover);
+  EXPECT_EQ(watchdog_.OnRendererFailed(now_), Action::kNone);
+  EXPECT_EQ(watchdog_.state(), State::kRecoveryScheduled);
+
+  // Further crashes don't postpone the scheduled recovery.
+  const auto deadline = watchdog_.deadline();
+  Advance(500ms);
+  EXPECT_EQ(watchdog_.OnRendererFailed(now_), Action::kNone);
+  EXPECT_EQ(watchdog_.deadline(), deadline);
+  EXPECT_EQ(TickAtDeadline(), Action::kRecover);
+  EXPECT_EQ(watchdog_.recoveries(), 2);
+}
+
+TEST_F(RendererWatchdogTest, StopsWatching) {
+  watchdog_.Start(now_);
+  EXPECT_EQ(TickAtDeadline(), Action::kSendHeartbeat);
+  watchdog_.Stop();
+  EXPECT_EQ(watchdog_.state(), State::kStopped);
+  EXPECT_FALSE(watchdog_.deadline());
+  Advance(1h);
+  EXPECT_EQ(watchdog_.Tick(now_), Action::kNone);
+  EXPECT_EQ(watchdog_.OnRendererFailed(now_), Action::kNone);
+}
+
+}  // namespace
@@ -0,0 +1,69 @@
+#include "util/restore_scheduler.h"
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+namespace {
+
+using util::RestoreScheduler;
+typedef std::vector<size_t> Indices;
+
+TEST(RestoreSchedulerTest, StartsByDescendingPriority) {
+  RestoreScheduler scheduler({1, 5, 3}, 3);
+  EXPECT_EQ(scheduler.Start(), (Indices{1, 2, 0}));
+  EXPECT_EQ(scheduler.in_flight(), 3u);
+}
+
+TEST(RestoreSchedulerTest, KeepsOrderOfEqualPriorities) {
+  RestoreScheduler scheduler({0, 2, 0, 2, 0}, 5);
+  EXPECT_EQ(scheduler.Start(), (Indices{1, 3, 0, 2, 4}));
+}
+
+TEST(RestoreSchedulerTest, LimitsInstancesInFlight) {
+  RestoreScheduler scheduler({0, 0, 0, 0, 9}, 2);
+  EXPECT_EQ(scheduler.Start(), (Indices{4, 0}));
+  EXPECT_EQ(scheduler.in_flight(), 2u);
+
+  EXPECT_EQ(scheduler.Complete(0), (Indices{1}));
+  EXPECT_EQ(scheduler.in_flight(), 2u);
+  EXPECT_EQ(scheduler.Complete(4), (Indices{2}));
+  EXPECT_EQ(scheduler.Complete(2), (Indices{3}));
+  EXPECT_FALSE(scheduler.done());
+
+  EXPECT_TRUE(scheduler.Complete(1).empty());
+  EXPECT_EQ(scheduler.in_flight(), 1u);
+  EXPECT_TRUE(scheduler.Complete(3).empty());
+  EXPECT_EQ(scheduler.in_flight(), 0u);
+  EXPECT_TRUE(scheduler.done());
+}
+
+TEST(RestoreSchedulerTest, RunsAtLeastOneInstance) {
+  RestoreScheduler scheduler({0, 0}, 0);
+  EXPECT_EQ(scheduler.Start(), (Indices{0}));
+  EXPECT_EQ(scheduler.Complete(0), (Indices{1}));
+}
+
+TEST(RestoreSchedulerTest, IgnoresUnexpectedCompletions) {
+  RestoreScheduler scheduler({0, 0, 0}, 1);
+  EXPECT_EQ(scheduler.Start(), (Indices{0}));
+
+  // Not started yet.
+  EXPECT_TRUE(scheduler.Complete(1).empty());
+  // Out of range.
+  EXPECT_TRUE(scheduler.Complete(7).empty());
+  EXPECT_EQ(scheduler.in_flight(), 1u);
+
+  EXPECT_EQ(scheduler.Complete(0), (Indices{1}));
+  // Already completed.
+  EXPECT_TRUE(scheduler.Complete(0).empty());
+  EXPECT_EQ(scheduler.in_flight(), 1u);
+}
+
+TEST(RestoreSchedulerTest, EmptyIsDone) {
+  RestoreScheduler scheduler({}, 4);
+  EXPECT_TRUE(scheduler.done());
+  EXPECT_TRUE(scheduler.Start().empty());
+}
+
+}  // namespace
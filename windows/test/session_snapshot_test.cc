@@ -0,0 +1,188 @@
+#include "util/session_snapshot.h"
+
+#include <gtest/gtest.h>
+
+#include "util/binary_stream.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace {
+
+using util::InstanceState;
+using util::SessionSnapshot;
+
+SessionSnapshot CreateSnapshot() {
+  InstanceState visible;
+  visible.priority = 10;
+  visible.environment = "shared";
+  visible.profile = "work";
+  visible.in_private = true;
+  visible.url = "https://example.com/b";
+  visible.zoom_factor = 1.25;
+  visible.scroll_x = 12.5;
+  visible.scroll_y = -3;
+  visible.history = {"https://example.com/a", "https://example.com/b"};
+  visible.history_index = 1;
+  visible.init_scripts = {"window.a = 1;", ""};
+  visible.host_mappings = {{"app.invalid", "C:\\app", 2}};
+
+  InstanceState hidden;
+  hidden.priority = -1;
+  hidden.url = "about:blank";
+
+  SessionSnapshot snapshot;
+  snapshot.instances = {visible, hidden};
+  return snapshot;
+}
+
+bool Deserialize(const std::vector<uint8_t>& data, SessionSnapshot* snapshot) {
+  return util::DeserializeSessionSnapshot(data.data(), data.size(), snapshot);
+}
+
+TEST(SessionSnapshotTest, RoundTrip) {
+  const auto snapshot = CreateSnapshot();
+  const auto data = util::SerializeSessionSnapshot(snapshot);
+
+  SessionSnapshot result;
+  ASSERT_TRUE(Deserialize(data, &result));
+  ASSERT_EQ(result.instances.size(), 2u);
+
+  const auto& visible = result.instances[0];
+  EXPECT_EQ(visible.priority, 10);
+  EXPECT_EQ(visible.environment, "shared");
+  EXPECT_EQ(visible.profile, "work");
+  EXPECT_TRUE(visible.in_private);
+  EXPECT_EQ(visible.url, "https://example.com/b");
+  EXPECT_EQ(visible.zoom_factor, 1.25);
+  EXPECT_EQ(visible.scroll_x, 12.5);
+  EXPECT_EQ(visible.scroll_y, -3);
+  EXPECT_EQ(visible.history, snapshot.instances[0].history);
+  EXPECT_EQ(visible.history_index, 1u);
+  EXPECT_EQ(visible.init_scripts, snapshot.instances[0].init_scripts);
+  ASSERT_EQ(visible.host_mappings.size(), 1u);
+  EXPECT_EQ(visible.host_mappings[0].host_name, "app.invalid");
+  EXPECT_EQ(visible.host_mappings[0].folder_path, "C:\\app");
+  EXPECT_EQ(visible.host_mappings[0].access_kind, 2);
+
+  const auto& hidden = result.instances[1];
+  EXPECT_EQ(hidden.priority, -1);
+  EXPECT_FALSE(hidden.environment);
+  EXPECT_FALSE(hidden.profile);
+  EXPECT_FALSE(hidden.in_private);
+  EXPECT_EQ(hidden.url, "about:blank");
+  EXPECT_EQ(hidden.zoom_factor, 1.0);
+  EXPECT_TRUE(hidden.history.empty());
+}
+
+TEST(SessionSnapshotTest, RoundTripEmpty) {
+  const auto data = util::SerializeSessionSnapshot({});
+  SessionSnapshot result = CreateSnapshot();
+  ASSERT_TRUE(Deserialize(data, &result));
+  EXPECT_TRUE(result.instances.empty());
+}
+
+TEST(SessionSnapshotTest, ReadsVersion1) {
+  util::BinaryWriter writer;
+  for (const auto byte : {'W', 'V', 'S', 'S'}) {
+    writer.WriteByte(static_cast<uint8_t>(byte));
+  }
+  writer.WriteByte(1);
+  writer.WriteVarint(1);
+  writer.WriteSigned(3);
+  writer.WriteString("https://example.com");
+  writer.WriteDouble(1.5);
+  writer.WriteDouble(0);
+  writer.WriteDouble(20);
+  writer.WriteVarint(1);
+  writer.WriteString("https://example.com");
+  writer.WriteVarint(0);
+  writer.WriteVarint(0);
+  writer.WriteVarint(0);
+
+  SessionSnapshot result;
+  ASSERT_TRUE(Deserialize(writer.Take(), &result));
+  ASSERT_EQ(result.instances.size(), 1u);
+  const auto& instance = result.instances[0];
+  EXPECT_EQ(instance.priority, 3);
+  EXPECT_EQ(instance.url, "https://example.com");
+  EXPECT_EQ(instance.zoom_factor, 1.5);
+  EXPECT_EQ(instance.scroll_y, 20);
+  // Version 1 instances belong to the default environment and profile.
+  EXPECT_FALSE(instance.environment);
+  EXPECT_FALSE(instance.profile);
+  EXPECT_FALSE(instance.in_private);
+}
+
+TEST(SessionSnapshotTest, RejectsTruncatedInput) {
+  const auto data = util::SerializeSessionSnapshot(CreateSnapshot());
+  for (size_t size = 0; size < data.size(); size++) {
+    SessionSnapshot result;
+    EXPECT_FALSE(util::DeserializeSessionSnapshot(data.data(), size, &result))
+        << "size " << size;
+  }
+}
+
+TEST(SessionSnapshotTest, RejectsTrailingData) {
+  auto data = util::SerializeSessionSnapshot(CreateSnapshot());
+  data.push_back(0);
+  SessionSnapshot result;
+  EXPECT_FALSE(Deserialize(data, &result));
+}
+
+TEST(SessionSnapshotTest, RejectsWrongMagicAndVersion) {
+  const auto data = util::SerializeSessionSnapshot(CreateSnapshot());
+  SessionSnapshot result;
+
+  auto magic = data;
+  magic[0] = 'X';
+  EXPECT_FALSE(Deserialize(magic, &result));
+
+  auto version = data;
+  version[4] = 0xff;
+  EXPECT_FALSE(Deserialize(version, &result));
+}
+
+TEST(SessionSnapshotTest, RejectsInvalidFlags) {
+  SessionSnapshot snapshot;
+  snapshot.instances.resize(1);
+  const auto data = util::SerializeSessionSnapshot(snapshot);
+  // The instance starts with its priority, followed by the presence flags
+  // of the environment and profile and the InPrivate flag.
+  constexpr size_t kFirstFlag = 4 + 1 + 1 + 1;
+  for (size_t i = kFirstFlag; i < kFirstFlag + 3; i++) {
+    auto corrupt = data;
+    corrupt[i] = 2;
+    SessionSnapshot result;
+    EXPECT_FALSE(Deserialize(corrupt, &result)) << "offset " << i;
+  }
+}
+
+TEST(SessionSnapshotTest, RejectsHistoryIndexOutOfRange) {
+  SessionSnapshot snapshot;
+  snapshot.instances.resize(1);
+  snapshot.instances[0].history = {"a", "b"};
+  snapshot.instances[0].history_index = 2;
+
+  SessionSnapshot result;
+  EXPECT_FALSE(Deserialize(util::SerializeSessionSnapshot(snapshot), &result));
+}
+
+TEST(SessionSnapshotTest, RejectsHugeCounts) {
+  // Magic, version and an instance count far beyond the input size.
+  const std::vector<uint8_t> data = {'W',  'V',  'S',  'S',  1,
+                                     0xff, 0xff, 0xff, 0xff, 0x0f};
+  SessionSnapshot result;
+  EXPECT_FALSE(Deserialize(data, &result));
+}
+
+TEST(SessionSnapshotTest, KeepsOutputOnFailure) {
+  const auto data = util::SerializeSessionSnapshot(CreateSnapshot());
+  SessionSnapshot result;
+  result.instances.resize(3);
+  EXPECT_FALSE(util::DeserializeSessionSnapshot(data.data(), data.size() - 1,
+                                                &result));
+  EXPECT_EQ(result.instances.size(), 3u);
+}
+
+}  // namespace
@@ -0,0 +1,177 @@
+#include "util/shard_balancer.h"
+
+#include <gtest/gtest.h>
+
+namespace {
+
+using util::ShardBalancer;
+
+TEST(ShardBalancerTest, PicksLeastLoadedShard) {
+  ShardBalancer balancer(3);
+  EXPECT_EQ(balancer.PickShard(), 0u);
+
+  balancer.Add(1, 0, 100);
+  EXPECT_EQ(balancer.PickShard(), 1u);
+  balancer.Add(2, 1, 50);
+  EXPECT_EQ(balancer.PickShard(), 2u);
+  balancer.Add(3, 2, 80);
+  EXPECT_EQ(balancer.PickShard(), 1u);
+
+  balancer.UpdateWeight(2, 200);
+  EXPECT_EQ(balancer.LoadOf(1), 200u);
+  EXPECT_EQ(balancer.PickShard(), 2u);
+
+  balancer.Remove(1);
+  EXPECT_EQ(balancer.LoadOf(0), 0u);
+  EXPECT_EQ(balancer.PickShard(), 0u);
+  EXPECT_FALSE(balancer.ShardOf(1));
+  EXPECT_EQ(balancer.ShardOf(3), 2u);
+}
+
+TEST(ShardBalancerTest, KeepsAtLeastOneShard) {
+  ShardBalancer balancer(0);
+  EXPECT_EQ(balancer.shard_count(), 1u);
+  EXPECT_TRUE(balancer.SetShardCount(0));
+  EXPECT_EQ(balancer.shard_count(), 1u);
+}
+
+TEST(ShardBalancerTest, ChangesShardCountOnlyWhileEmpty) {
+  ShardBalancer balancer;
+  balancer.Add(1, 0, 10);
+  EXPECT_FALSE(balancer.SetShardCount(4));
+  EXPECT_EQ(balancer.shard_count(), 1u);
+
+  balancer.Remove(1);
+  EXPECT_TRUE(balancer.SetShardCount(4));
+  EXPECT_EQ(balancer.shard_count(), 4u);
+}
+
+TEST(ShardBalancerTest, IgnoresUnknownShardsAndInstances) {
+  ShardBalancer balancer(2);
+  balancer.Add(1, 5, 10);
+  EXPECT_FALSE(balancer.ShardOf(1));
+
+  balancer.UpdateWeight(2, 10);
+  balancer.Remove(2);
+  EXPECT_FALSE(balancer.Reassign(2, 1));
+  EXPECT_EQ(balancer.LoadOf(0), 0u);
+  EXPECT_EQ(balancer.LoadOf(1), 0u);
+}
+
+TEST(ShardBalancerTest, SkipsDisabledShards) {
+  ShardBalancer balancer(3);
+  balancer.DisableShard(0);
+  EXPECT_FALSE(balancer.IsUsable(0));
+  EXPECT_EQ(balancer.PickShard(), 1u);
+
+  balancer.Add(1, 1, 10);
+  balancer.DisableShard(2);
+  EXPECT_EQ(balancer.PickShard(), 1u);
+
+  // Without a usable shard, everything goes to the first one.
+  balancer.DisableShard(1);
+  EXPECT_EQ(balancer.PickShard(), 0u);
+
+  balancer.Remove(1);
+  EXPECT_TRUE(balancer.SetShardCount(3));
+  EXPECT_TRUE(balancer.IsUsable(0));
+  EXPECT_TRUE(balancer.IsUsable(2));
+}
+
+TEST(ShardBalancerTest, ReassignKeepsWeight) {
+  ShardBalancer balancer(2);
+  balancer.Add(1, 1, 30);
+  EXPECT_TRUE(balancer.Reassign(1, 0));
+  EXPECT_EQ(balancer.ShardOf(1), 0u);
+  EXPECT_EQ(balancer.LoadOf(0), 30u);
+  EXPECT_EQ(balancer.LoadOf(1), 0u);
+}
+
+TEST(ShardBalancerTest, RebalanceMovesTowardsEvenSplit) {
+  ShardBalancer balancer(2);
+  balancer.Add(1, 0, 10);
+  balancer.Add(2, 0, 40);
+  balancer.Add(3, 0, 30);
+
+  // Moving 40 leaves 40 against 40.
+  const auto moves = balancer.Rebalance();
+  ASSERT_EQ(moves.size(), 1u);
+  EXPECT_EQ(moves[0].instance, 2);
+  EXPECT_EQ(moves[0].from, 0u);
+  EXPECT_EQ(moves[0].to, 1u);
+  EXPECT_EQ(balancer.LoadOf(0), 40u);
+  EXPECT_EQ(balancer.LoadOf(1), 40u);
+
+  EXPECT_TRUE(balancer.Rebalance(4).empty());
+}
+
+TEST(ShardBalancerTest, RebalanceLimitsMoves) {
+  ShardBalancer balancer(2);
+  for (int64_t instance = 1; instance <= 4; instance++) {
+    balancer.Add(instance, 0, 10);
+  }
+
+  EXPECT_EQ(balancer.Rebalance(1).size(), 1u);
+  EXPECT_EQ(balancer.LoadOf(0), 30u);
+  EXPECT_EQ(balancer.Rebalance(4).size(), 1u);
+  EXPECT_EQ(balancer.LoadOf(0), 20u);
+  EXPECT_EQ(balancer.LoadOf(1), 20u);
+}
+
+TEST(ShardBalancerTest, RebalanceOnlyMovesIfItHelps) {
+  ShardBalancer balancer(2);
+  // Moving the single instance would only swap the imbalance.
+  balancer.Add(1, 0, 50);
+  EXPECT_TRUE(balancer.Rebalance().empty());
+
+  // Breaks ties by the lowest instance id.
+  balancer.Remove(1);
+  balancer.Add(3, 0, 20);
+  balancer.Add(2, 0, 20);
+  const auto moves = balancer.Rebalance();
+  ASSERT_EQ(moves.size(), 1u);
+  EXPECT_EQ(moves[0].instance, 2);
+}
+
+TEST(ShardBalancerTest, RebalanceDoesNotTargetDisabledShards) {
+  ShardBalancer balancer(3);
+  balancer.Add(1, 0, 10);
+  balancer.Add(2, 0, 10);
+  balancer.DisableShard(1);
+
+  const auto moves = balancer.Rebalance(4);
+  ASSERT_EQ(moves.size(), 1u);
+  EXPECT_EQ(moves[0].to, 2u);
+
+  // Instances left on a disabled shard are moved off it.
+  EXPECT_TRUE(balancer.Reassign(1, 1));
+  EXPECT_TRUE(balancer.Reassign(2, 1));
+  const auto off = balancer.Rebalance(4);
+  ASSERT_EQ(off.size(), 1u);
+  EXPECT_EQ(off[0].from, 1u);
+  EXPECT_EQ(balancer.LoadOf(1), 10u);
+
+  // Nothing to move to without a usable shard.
+  balancer.Add(3, 1, 10);
+  balancer.Add(4, 1, 10);
+  balancer.DisableShard(0);
+  balancer.DisableShard(2);
+  EXPECT_TRUE(balancer.Rebalance(4).empty());
+}
+
+TEST(ShardBalancerTest, UndoingAFailedMove) {
+  ShardBalancer balancer(2);
+  balancer.Add(1, 0, 10);
+  balancer.Add(2, 0, 10);
+
+  const auto moves = balancer.Rebalance();
+  ASSERT_EQ(moves.size(), 1u);
+  balancer.DisableShard(moves[0].to);
+  EXPECT_TRUE(balancer.Reassign(moves[0].instance, moves[0].from));
+
+  EXPECT_EQ(balancer.LoadOf(0), 20u);
+  EXPECT_EQ(balancer.PickShard(), 0u);
+  EXPECT_TRUE(balancer.Rebalance().empty());
+}
+
+}  // namespace
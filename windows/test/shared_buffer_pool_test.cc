@@ -0,0 +1,176 @@
+#include "util/shared_buffer_pool.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <vector>
+
+namespace {
+
+using util::SharedBufferPool;
+typedef std::vector<SharedBufferPool::BufferId> Ids;
+
+constexpr size_t kPage = SharedBufferPool::kPageSize;
+
+TEST(SharedBufferPoolTest, RoundsCapacityToPages) {
+  EXPECT_EQ(SharedBufferPool::GetCapacity(0), kPage);
+  EXPECT_EQ(SharedBufferPool::GetCapacity(1), kPage);
+  EXPECT_EQ(SharedBufferPool::GetCapacity(kPage), kPage);
+  EXPECT_EQ(SharedBufferPool::GetCapacity(kPage + 1), 2 * kPage);
+}
+
+TEST(SharedBufferPoolTest, AllocatesNewBuffers) {
+  SharedBufferPool pool;
+  const auto a = pool.Acquire("a", 100);
+  EXPECT_TRUE(a.is_new);
+  EXPECT_EQ(a.capacity, kPage);
+  EXPECT_EQ(pool.SizeOf("a"), 100u);
+  EXPECT_EQ(pool.Find("a"), a.id);
+
+  const auto b = pool.Acquire("b", 100);
+  EXPECT_TRUE(b.is_new);
+  EXPECT_NE(a.id, b.id);
+  EXPECT_EQ(pool.bound_count(), 2u);
+  EXPECT_FALSE(pool.Find("c"));
+  EXPECT_EQ(pool.SizeOf("c"), 0u);
+}
+
+TEST(SharedBufferPoolTest, WritesBoundBufferInPlace) {
+  SharedBufferPool pool;
+  const auto first = pool.Acquire("a", 3 * kPage);
+  const auto second = pool.Acquire("a", kPage);
+  EXPECT_FALSE(second.is_new);
+  EXPECT_EQ(second.id, first.id);
+  EXPECT_EQ(second.capacity, 3 * kPage);
+  EXPECT_EQ(pool.SizeOf("a"), kPage);
+  EXPECT_TRUE(pool.TakeClosedBuffers().empty());
+}
+
+TEST(SharedBufferPoolTest, GrowingPoolsTheOldBuffer) {
+  SharedBufferPool pool;
+  const auto small = pool.Acquire("a", kPage);
+  const auto large = pool.Acquire("a", 2 * kPage);
+  EXPECT_TRUE(large.is_new);
+  EXPECT_NE(large.id, small.id);
+  EXPECT_EQ(pool.pooled_count(), 1u);
+  EXPECT_EQ(pool.pooled_bytes(), kPage);
+
+  // Another name picks the pooled buffer up.
+  const auto reused = pool.Acquire("b", 10);
+  EXPECT_FALSE(reused.is_new);
+  EXPECT_EQ(reused.id, small.id);
+  EXPECT_EQ(pool.pooled_count(), 0u);
+}
+
+TEST(SharedBufferPoolTest, ReusesSmallestFittingBuffer) {
+  SharedBufferPool pool;
+  const auto four = pool.Acquire("four", 4 * kPage);
+  const auto two = pool.Acquire("two", 2 * kPage);
+  const auto three = pool.Acquire("three", 3 * kPage);
+  pool.Release("four");
+  pool.Release("two");
+  pool.Release("three");
+  EXPECT_EQ(pool.pooled_bytes(), 9 * kPage);
+
+  EXPECT_EQ(pool.Acquire("x", 2 * kPage + 1).id, three.id);
+  EXPECT_EQ(pool.Acquire("y", 2 * kPage).id, two.id);
+  EXPECT_EQ(pool.Acquire("z", 2 * kPage).id, four.id);
+}
+
+TEST(SharedBufferPoolTest, DoesNotWasteMoreThanHalfABuffer) {
+  SharedBufferPool pool;
+  const auto large = pool.Acquire("a", 4 * kPage);
+  pool.Release("a");
+
+  // A quarter of the buffer would be used.
+  const auto small = pool.Acquire("b", kPage);
+  EXPECT_TRUE(small.is_new);
+  EXPECT_NE(small.id, large.id);
+
+  // Half of it is fine.
+  EXPECT_EQ(pool.Acquire("c", 2 * kPage).id, large.id);
+}
+
+TEST(SharedBufferPoolTest, NeverRecyclesPostedBuffers) {
+  SharedBufferPool pool;
+  const auto posted = pool.Acquire("a", 10);
+  EXPECT_TRUE(pool.MarkPosted("a"));
+  EXPECT_FALSE(pool.MarkPosted("b"));
+
+  EXPECT_TRUE(pool.Release("a"));
+  EXPECT_EQ(pool.pooled_count(), 0u);
+  EXPECT_EQ(pool.TakeClosedBuffers(), Ids{posted.id});
+
+  // Neither when it is replaced by a larger one.
+  const auto replaced = pool.Acquire("b", 10);
+  pool.MarkPosted("b");
+  pool.Acquire("b", 2 * kPage);
+  EXPECT_EQ(pool.pooled_count(), 0u);
+  EXPECT_EQ(pool.TakeClosedBuffers(), Ids{replaced.id});
+}
+
+TEST(SharedBufferPoolTest, TransferHandsBufferOverForClosing) {
+  SharedBufferPool pool;
+  const auto buffer = pool.Acquire("a", 10);
+  EXPECT_EQ(pool.Transfer("a"), buffer.id);
+  EXPECT_FALSE(pool.Find("a"));
+  EXPECT_EQ(pool.pooled_count(), 0u);
+  EXPECT_EQ(pool.TakeClosedBuffers(), Ids{buffer.id});
+  EXPECT_FALSE(pool.Transfer("a"));
+}
+
+TEST(SharedBufferPoolTest, LimitsPooledBytes) {
+  SharedBufferPool pool(3 * kPage);
+  const auto a = pool.Acquire("a", kPage);
+  const auto b = pool.Acquire("b", kPage);
+  const auto c = pool.Acquire("c", 2 * kPage);
+  pool.Release("a");
+  pool.Release("b");
+  EXPECT_TRUE(pool.TakeClosedBuffers().empty());
+
+  // The oldest pooled buffers are closed to make room.
+  pool.Release("c");
+  EXPECT_EQ(pool.pooled_bytes(), 3 * kPage);
+  EXPECT_EQ(pool.pooled_count(), 2u);
+  EXPECT_EQ(pool.TakeClosedBuffers(), Ids{a.id});
+  EXPECT_EQ(pool.Acquire("d", kPage).id, b.id);
+  EXPECT_EQ(pool.Acquire("e", 2 * kPage).id, c.id);
+}
+
+TEST(SharedBufferPoolTest, DoesNotPoolBuffersLargerThanTheLimit) {
+  SharedBufferPool pool(kPage);
+  const auto large = pool.Acquire("a", 2 * kPage);
+  pool.Release("a");
+  EXPECT_EQ(pool.pooled_count(), 0u);
+  EXPECT_EQ(pool.TakeClosedBuffers(), Ids{large.id});
+}
+
+TEST(SharedBufferPoolTest, ReleaseAllClosesEverything) {
+  SharedBufferPool pool;
+  const auto pooled = pool.Acquire("a", 10);
+  pool.Release("a");
+  const auto bound = pool.Acquire("b", 2 * kPage);
+
+  pool.ReleaseAll();
+  EXPECT_EQ(pool.bound_count(), 0u);
+  EXPECT_EQ(pool.pooled_count(), 0u);
+  EXPECT_EQ(pool.pooled_bytes(), 0u);
+  auto closed = pool.TakeClosedBuffers();
+  std::sort(closed.begin(), closed.end());
+  EXPECT_EQ(closed, (Ids{pooled.id, bound.id}));
+  EXPECT_FALSE(pool.Release("b"));
+}
+
+TEST(SharedBufferPoolTest, TakesClosedBuffersOnce) {
+  SharedBufferPool pool;
+  const auto a = pool.Acquire("a", 10);
+  pool.Transfer("a");
+  EXPECT_EQ(pool.TakeClosedBuffers(), Ids{a.id});
+  EXPECT_TRUE(pool.TakeClosedBuffers().empty());
+
+  const auto b = pool.Acquire("b", 10);
+  pool.Transfer("b");
+  EXPECT_EQ(pool.TakeClosedBuffers(), Ids{b.id});
+}
+
+}  // namespace
@@ -0,0 +1,152 @@
+#include "util/texture_view_graph.h"
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+namespace {
+
+using util::Rect;
+using util::TextureCopy;
+using util::TextureViewGraph;
+using util::TextureViewSpec;
+
+TextureViewSpec Region(Rect rect) {
+  TextureViewSpec spec;
+  spec.source_rect = rect;
+  return spec;
+}
+
+TEST(TextureViewGraphTest, AddsAndRemovesViews) {
+  TextureViewGraph graph;
+  EXPECT_TRUE(graph.empty());
+
+  const auto a = graph.AddView({});
+  const auto b = graph.AddView({});
+  EXPECT_NE(a, b);
+  EXPECT_EQ(graph.size(), 2u);
+  EXPECT_TRUE(graph.HasView(a));
+
+  EXPECT_TRUE(graph.RemoveView(a));
+  EXPECT_FALSE(graph.RemoveView(a));
+  EXPECT_FALSE(graph.HasView(a));
+  EXPECT_FALSE(graph.Resolve(a, 100, 100));
+  EXPECT_EQ(graph.size(), 1u);
+}
+
+TEST(TextureViewGraphTest, DoesNotReuseViewIds) {
+  TextureViewGraph graph;
+  const auto a = graph.AddView({});
+  graph.RemoveView(a);
+  EXPECT_NE(graph.AddView({}), a);
+}
+
+TEST(TextureViewGraphTest, DefaultViewCopiesEntireFrame) {
+  TextureViewGraph graph;
+  const auto view = graph.AddView({});
+
+  const auto copy = graph.Resolve(view, 640, 480);
+  ASSERT_TRUE(copy);
+  EXPECT_EQ(copy->source, (Rect{0, 0, 640, 480}));
+  EXPECT_EQ(copy->width, 640u);
+  EXPECT_EQ(copy->height, 480u);
+  EXPECT_FALSE(copy->needs_scaling());
+}
+
+TEST(TextureViewGraphTest, RegionIsClippedToFrame) {
+  TextureViewGraph graph;
+  const auto view = graph.AddView(Region({600, 400, 700, 500}));
+
+  const auto copy = graph.Resolve(view, 640, 480);
+  ASSERT_TRUE(copy);
+  EXPECT_EQ(copy->source, (Rect{600, 400, 640, 480}));
+  EXPECT_EQ(copy->width, 40u);
+  EXPECT_EQ(copy->height, 80u);
+}
+
+TEST(TextureViewGraphTest, RegionOutsideOfFrameIsSkipped) {
+  TextureViewGraph graph;
+  const auto view = graph.AddView(Region({700, 0, 800, 100}));
+  EXPECT_FALSE(graph.Resolve(view, 640, 480));
+  EXPECT_TRUE(graph.ResolveAll(640, 480).empty());
+
+  // It resolves once the frame grows.
+  EXPECT_TRUE(graph.Resolve(view, 1024, 768));
+}
+
+TEST(TextureViewGraphTest, ExplicitSizeScales) {
+  TextureViewGraph graph;
+  TextureViewSpec spec;
+  spec.width = 320;
+  const auto view = graph.AddView(spec);
+
+  const auto copy = graph.Resolve(view, 640, 480);
+  ASSERT_TRUE(copy);
+  EXPECT_EQ(copy->width, 320u);
+  EXPECT_EQ(copy->height, 480u);
+  EXPECT_TRUE(copy->needs_scaling());
+}
+
+TEST(TextureViewGraphTest, ZeroSizeIsSkipped) {
+  TextureViewGraph graph;
+  TextureViewSpec spec;
+  spec.height = 0;
+  const auto view = graph.AddView(spec);
+  EXPECT_FALSE(graph.Resolve(view, 640, 480));
+}
+
+TEST(TextureViewGraphTest, IdenticalViewsShareACopy) {
+  TextureViewGraph graph;
+  const auto full = graph.AddView({});
+  // An explicit full frame region resolves to the same copy.
+  const auto same = graph.AddView(Region({0, 0, 640, 480}));
+  // Clipping makes this one identical as well.
+  const auto clipped = graph.AddView(Region({-10, -10, 1000, 1000}));
+  const auto region = graph.AddView(Region({0, 0, 320, 240}));
+
+  const auto jobs = graph.ResolveAll(640, 480);
+  ASSERT_EQ(jobs.size(), 2u);
+
+  // Jobs are ordered by copy.
+  EXPECT_EQ(jobs[0].copy.source, (Rect{0, 0, 320, 240}));
+  EXPECT_EQ(jobs[0].views, std::vector<TextureViewGraph::ViewId>{region});
+  EXPECT_EQ(jobs[1].copy.source, (Rect{0, 0, 640, 480}));
+  EXPECT_EQ(jobs[1].views,
+            (std::vector<TextureViewGraph::ViewId>{full, same, clipped}));
+}
+
+TEST(TextureViewGraphTest, SameRegionAtDifferentSizesIsCopiedTwice) {
+  TextureViewGraph graph;
+  TextureViewSpec half;
+  half.width = 320;
+  half.height = 240;
+  graph.AddView({});
+  graph.AddView(half);
+  graph.AddView(half);
+
+  const auto jobs = graph.ResolveAll(640, 480);
+  ASSERT_EQ(jobs.size(), 2u);
+  EXPECT_EQ(jobs[0].copy.source, jobs[1].copy.source);
+  EXPECT_EQ(jobs[0].views.size() + jobs[1].views.size(), 3u);
+}
+
+TEST(TextureViewGraphTest, SharingDependsOnFrameSize) {
+  TextureViewGraph graph;
+  graph.AddView({});
+  graph.AddView(Region({0, 0, 640, 480}));
+
+  EXPECT_EQ(graph.ResolveAll(640, 480).size(), 1u);
+  // The explicit region no longer covers the whole frame.
+  EXPECT_EQ(graph.ResolveAll(800, 600).size(), 2u);
+}
+
+TEST(TextureViewGraphTest, CopyOrdering) {
+  const TextureCopy a{{0, 0, 10, 10}, 10, 10};
+  const TextureCopy b{{0, 0, 10, 10}, 5, 5};
+  EXPECT_TRUE(b < a);
+  EXPECT_FALSE(a < b);
+  EXPECT_FALSE(a == b);
+  EXPECT_TRUE(a == (TextureCopy{{0, 0, 10, 10}, 10, 10}));
+}
+
+}  // namespace
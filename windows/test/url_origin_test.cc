@@ -0,0 +1,62 @@
+#include "util/url_origin.h"
+
+#include <gtest/gtest.h>
+
+namespace {
+
+using util::NormalizeOrigin;
+
+TEST(UrlOriginTest, NormalizesOrigins) {
+  EXPECT_EQ(NormalizeOrigin("HTTPS://Example.COM/path?q#f"),
+            "https://example.com");
+  EXPECT_EQ(NormalizeOrigin("https://example.com"), "https://example.com");
+  EXPECT_EQ(NormalizeOrigin("https://sub.example-1.com?q"),
+            "https://sub.example-1.com");
+  EXPECT_EQ(NormalizeOrigin("custom+scheme.v1://host"),
+            "custom+scheme.v1://host");
+}
+
+TEST(UrlOriginTest, KeepsOnlyNonDefaultPorts) {
+  EXPECT_EQ(NormalizeOrigin("https://example.com:443/"),
+            "https://example.com");
+  EXPECT_EQ(NormalizeOrigin("http://example.com:80"), "http://example.com");
+  EXPECT_EQ(NormalizeOrigin("http://example.com:8080/"),
+            "http://example.com:8080");
+  EXPECT_EQ(NormalizeOrigin("http://example.com:443/"),
+            "http://example.com:443");
+  EXPECT_EQ(NormalizeOrigin("https://example.com:80/"),
+            "https://example.com:80");
+  EXPECT_EQ(NormalizeOrigin("https://example.com:/"), "https://example.com");
+}
+
+TEST(UrlOriginTest, HandlesIpv6Literals) {
+  EXPECT_EQ(NormalizeOrigin("http://[::1]:8080/"), "http://[::1]:8080");
+  EXPECT_EQ(NormalizeOrigin("http://[::1]/"), "http://[::1]");
+  EXPECT_EQ(NormalizeOrigin("https://[FE80::1]:443"), "https://[fe80::1]");
+  EXPECT_FALSE(NormalizeOrigin("http://[::1/"));
+  EXPECT_FALSE(NormalizeOrigin("http://[::1]x/"));
+}
+
+TEST(UrlOriginTest, RejectsUrlsWithoutHost) {
+  EXPECT_FALSE(NormalizeOrigin("about:blank"));
+  EXPECT_FALSE(NormalizeOrigin("example.com"));
+  EXPECT_FALSE(NormalizeOrigin("://example.com"));
+  EXPECT_FALSE(NormalizeOrigin("file:///C:/index.html"));
+  EXPECT_FALSE(NormalizeOrigin("https://:8080/"));
+}
+
+TEST(UrlOriginTest, RejectsUserInfo) {
+  EXPECT_FALSE(NormalizeOrigin("https://user:pw@example.com/"));
+  EXPECT_FALSE(NormalizeOrigin("https://user@example.com/"));
+}
+
+TEST(UrlOriginTest, RejectsCharactersUnsafeInJson) {
+  EXPECT_FALSE(NormalizeOrigin("1http://example.com"));
+  EXPECT_FALSE(NormalizeOrigin("ht^tp://example.com"));
+  EXPECT_FALSE(NormalizeOrigin("https://exa\"mple.com"));
+  EXPECT_FALSE(NormalizeOrigin("https://exa\\mple.com"));
+  EXPECT_FALSE(NormalizeOrigin("https://exa mple.com"));
+  EXPECT_FALSE(NormalizeOrigin("https://example.com:80a"));
+}
+
+}  // namespace
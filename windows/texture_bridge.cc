@@ -6,44 +6,190 @@
 #include <atomic>
 #include <cassert>
 #include <iostream>
+#include <utility>
 
 #include "util/direct3d11.interop.h"
 
 namespace {
 const int kNumBuffers = 1;
+
+// Recreating a closed capture item is retried after 100ms, 200ms, ... up to
+// 5s between attempts.
+constexpr auto kCaptureRecoveryInitialDelay = std::chrono::milliseconds(100);
+constexpr auto kCaptureRecoveryMaxDelay = std::chrono::milliseconds(5000);
+constexpr int kCaptureRecoveryMaxAttempts = 8;
 }  // namespace
 
 TextureBridge::TextureBridge(GraphicsContext* graphics_context,
                              ABI::Windows::UI::Composition::IVisual* visual)
-    : graphics_context_(graphics_context) {
+    : graphics_context_(graphics_context),
+      capture_backoff_(kCaptureRecoveryInitialDelay, kCaptureRecoveryMaxDelay,
+                       kCaptureRecoveryMaxAttempts) {
+  if (visual) {
+    visual_.copy_from(visual);
+    CreateCaptureItem();
+    assert(capture_item_);
+  }
+
+  graphics_context_->device_recovery()->AddClient(this);
+}
+
+TextureBridge::~TextureBridge() {
+  graphics_context_->device_recovery()->RemoveClient(this);
+
+  const std::scoped_lock lock(surface_mutex_, mutex_);
+  StopInternal();
+  ReleaseCaptureItem();
+}
+
+bool TextureBridge::CreateCaptureItem() {
+  ReleaseCaptureItem();
   capture_item_ =
-      graphics_context_->CreateGraphicsCaptureItemFromVisual(visual);
-  assert(capture_item_);
+      graphics_context_->CreateGraphicsCaptureItemFromVisual(visual_.get());
+  if (!capture_item_) {
+    return false;
+  }
 
+  // The event may be raised on any thread.
   capture_item_->add_Closed(
       Microsoft::WRL::Callback<ABI::Windows::Foundation::ITypedEventHandler<
           ABI::Windows::Graphics::Capture::GraphicsCaptureItem*,
           IInspectable*>>(
-          [](ABI::Windows::Graphics::Capture::IGraphicsCaptureItem* item,
-             IInspectable* args) -> HRESULT {
-            std::cerr << "Capture item was closed." << std::endl;
+          [this, task_runner = graphics_context_->task_runner(),
+           lifetime = std::weak_ptr<bool>(lifetime_),
+           generation = ++capture_item_generation_](
+              ABI::Windows::Graphics::Capture::IGraphicsCaptureItem* item,
+              IInspectable* args) -> HRESULT {
+            task_runner->PostTask([this, lifetime, generation]() {
+              if (!lifetime.expired()) {
+                OnCaptureItemClosed(generation);
+              }
+            });
             return S_OK;
           })
           .Get(),
       &on_closed_token_);
+  return true;
 }
 
-TextureBridge::~TextureBridge() {
-  const std::lock_guard<std::mutex> lock(mutex_);
-  StopInternal();
+void TextureBridge::ReleaseCaptureItem() {
   if (capture_item_) {
     capture_item_->remove_Closed(on_closed_token_);
+    capture_item_ = nullptr;
+  }
+}
+
+void TextureBridge::OnCaptureItemClosed(uint64_t generation) {
+  bool failed;
+  {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    if (generation != capture_item_generation_ || !capture_item_) {
+      return;
+    }
+
+    std::cerr << "Capture item was closed." << std::endl;
+    capture_lost_ = true;
+    StopCapture();
+    ReleaseFramePool();
+    ReleaseCaptureItem();
+    failed = !ScheduleCaptureRecovery();
+  }
+
+  if (capture_recovery_) {
+    capture_recovery_(CaptureRecoveryState::kLost, 0);
+    if (failed) {
+      capture_recovery_(CaptureRecoveryState::kFailed, 0);
+    }
+  }
+}
+
+bool TextureBridge::ScheduleCaptureRecovery() {
+  const auto delay = capture_backoff_.Next();
+  if (!delay) {
+    std::cerr << "Recreating the capture item failed." << std::endl;
+    return false;
+  }
+
+  return graphics_context_->task_runner()->PostDelayedTask(
+      [this, lifetime = std::weak_ptr<bool>(lifetime_)]() {
+        if (!lifetime.expired()) {
+          RecoverCapture();
+        }
+      },
+      *delay);
+}
+
+void TextureBridge::RecoverCapture() {
+  CaptureRecoveryState state;
+  int attempt;
+  std::vector<FrameRequestCallback> frame_request_callbacks;
+  {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    if (!capture_lost_) {
+      return;
+    }
+
+    attempt = capture_backoff_.attempt() - 1;
+    bool recovered = graphics_context_->IsValid() && CreateCaptureItem();
+    if (recovered && is_running_) {
+      if (render_mode_ == RenderMode::kOnDemand) {
+        // Deliver a fresh frame, then pause again.
+        frame_scheduler_.RequestFrame();
+      }
+      recovered = StartCapture();
+    }
+
+    if (recovered) {
+      capture_lost_ = false;
+      capture_backoff_.Reset();
+      state = CaptureRecoveryState::kRecovered;
+    } else {
+      StopCapture();
+      ReleaseFramePool();
+      ReleaseCaptureItem();
+      if (ScheduleCaptureRecovery()) {
+        return;
+      }
+      // Don't keep frame requests waiting for a capture that won't resume.
+      frame_scheduler_.Reset();
+      frame_request_callbacks = TakeFrameRequestCallbacks();
+      state = CaptureRecoveryState::kFailed;
+      attempt++;
+    }
+  }
+
+  for (const auto& callback : frame_request_callbacks) {
+    callback();
+  }
+  if (capture_recovery_) {
+    capture_recovery_(state, attempt);
   }
 }
 
 bool TextureBridge::Start() {
   const std::lock_guard<std::mutex> lock(mutex_);
-  if (is_running_ || !capture_item_) {
+  if (is_running_ || !graphics_context_->IsValid()) {
+    return false;
+  }
+
+  // While a closed capture item is being recovered, capturing resumes once
+  // it has been recreated.
+  if (!StartCapture() && !capture_lost_) {
+    return false;
+  }
+
+  is_running_ = true;
+  if (render_mode_ == RenderMode::kOnDemand) {
+    // Pause again once the initial frame has been delivered.
+    frame_scheduler_.RequestFrame();
+  }
+  return true;
+}
+
+bool TextureBridge::StartCapture() {
+  StopCapture();
+  ReleaseFramePool();
+  if (!capture_item_) {
     return false;
   }
 
@@ -55,7 +201,10 @@ bool TextureBridge::Start() {
       static_cast<ABI::Windows::Graphics::DirectX::DirectXPixelFormat>(
           kPixelFormat),
       kNumBuffers, size);
-  assert(frame_pool_);
+  if (!frame_pool_) {
+    std::cerr << "Creating frame pool failed." << std::endl;
+    return false;
+  }
 
   frame_pool_->add_FrameArrived(
       Microsoft::WRL::Callback<ABI::Windows::Foundation::ITypedEventHandler<
@@ -76,34 +225,91 @@ bool TextureBridge::Start() {
     return false;
   }
 
-  if (SUCCEEDED(capture_session_->StartCapture())) {
-    is_running_ = true;
-    return true;
+  return SUCCEEDED(capture_session_->StartCapture());
+}
+
+void TextureBridge::StopCapture() {
+  if (frame_pool_) {
+    frame_pool_->remove_FrameArrived(on_frame_arrived_token_);
   }
+  if (capture_session_) {
+    auto closable =
+        capture_session_.try_as<ABI::Windows::Foundation::IClosable>();
+    assert(closable);
+    closable->Close();
+    capture_session_ = nullptr;
+  }
+}
 
-  return false;
+void TextureBridge::ReleaseFramePool() {
+  if (frame_pool_) {
+    auto closable = frame_pool_.try_as<ABI::Windows::Foundation::IClosable>();
+    if (closable) {
+      closable->Close();
+    }
+    frame_pool_ = nullptr;
+  }
 }
 
 void TextureBridge::Stop() {
-  const std::lock_guard<std::mutex> lock(mutex_);
+  const std::scoped_lock lock(surface_mutex_, mutex_);
   StopInternal();
 }
 
 void TextureBridge::StopInternal() {
   if (is_running_) {
     is_running_ = false;
-    frame_pool_->remove_FrameArrived(on_frame_arrived_token_);
-    auto closable =
-        capture_session_.try_as<ABI::Windows::Foundation::IClosable>();
-    assert(closable);
-    closable->Close();
-    capture_session_ = nullptr;
+    StopCapture();
+    frame_scheduler_.Reset();
+    for (const auto& callback : TakeFrameRequestCallbacks()) {
+      callback();
+    }
+  }
+}
+
+void TextureBridge::SetGraphicsContext(GraphicsContext* graphics_context) {
+  bool was_running;
+  {
+    const std::scoped_lock lock(surface_mutex_, mutex_);
+    if (graphics_context == graphics_context_) {
+      return;
+    }
+
+    was_running = is_running_;
+    ReleaseDeviceResources();
+
+    graphics_context_->device_recovery()->RemoveClient(this);
+    graphics_context_ = graphics_context;
+    graphics_context_->device_recovery()->AddClient(this);
+  }
+
+  if (was_running) {
+    Start();
+  }
+}
+
+void TextureBridge::OnDeviceLost() {
+  const std::scoped_lock lock(surface_mutex_, mutex_);
+  resume_after_device_restored_ = is_running_;
+  ReleaseDeviceResources();
+}
+
+void TextureBridge::ReleaseDeviceResources() {
+  StopInternal();
+  ReleaseFramePool();
+  last_frame_ = nullptr;
+}
+
+void TextureBridge::OnDeviceRestored() {
+  if (resume_after_device_restored_) {
+    resume_after_device_restored_ = false;
+    Start();
   }
 }
 
 void TextureBridge::OnFrameArrived() {
   const std::lock_guard<std::mutex> lock(mutex_);
-  if (!is_running_) {
+  if (!is_running_ || !frame_pool_) {
     return;
   }
 
@@ -120,7 +326,9 @@ void TextureBridge::OnFrameArrived() {
     if (SUCCEEDED(frame->get_Surface(frame_surface.put()))) {
       last_frame_ =
           util::TryGetDXGIInterfaceFromObject<ID3D11Texture2D>(frame_surface);
-      has_frame = !ShouldDropFrame();
+      has_frame = render_mode_ == RenderMode::kOnDemand ||
+                  !frame_rate_limiter_.ShouldDropFrame(
+                      util::FrameRateLimiter::Clock::now());
     }
   }
 
@@ -135,42 +343,163 @@ void TextureBridge::OnFrameArrived() {
     needs_update_ = false;
   }
 
+  DeliverFrame(has_frame);
+}
+
+void TextureBridge::DeliverFrame(bool has_frame) {
+  std::vector<FrameRequestCallback> frame_request_callbacks;
+  if (has_frame && render_mode_ == RenderMode::kOnDemand &&
+      frame_scheduler_.FrameDelivered() ==
+          util::FrameScheduler::Action::kStopCapture) {
+    frame_request_callbacks = TakeFrameRequestCallbacks();
+
+    // The capture can't be closed from within its own event handler.
+    graphics_context_->task_runner()->PostTask(
+        [this, lifetime = std::weak_ptr<bool>(lifetime_)]() {
+          if (lifetime.expired()) {
+            return;
+          }
+          const std::lock_guard<std::mutex> lock(mutex_);
+          if (is_running_ && !frame_scheduler_.is_capturing()) {
+            StopCapture();
+            ReleaseFramePool();
+          }
+        });
+  }
+
   if (has_frame && frame_available_) {
     frame_available_();
   }
+
+  for (const auto& callback : frame_request_callbacks) {
+    callback();
+  }
 }
 
-bool TextureBridge::ShouldDropFrame() {
-  if (!frame_duration_.has_value()) {
-    return false;
+void TextureBridge::NotifySurfaceSizeChanged() {
+  const std::lock_guard<std::mutex> lock(mutex_);
+  needs_update_ = true;
+  ScheduleFrameAfterActivity();
+}
+
+void TextureBridge::SetRenderMode(
+    RenderMode mode, std::optional<std::chrono::milliseconds> settle_delay) {
+  std::vector<FrameRequestCallback> callbacks;
+  {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    if (settle_delay) {
+      frame_scheduler_.set_settle_delay(*settle_delay);
+    }
+    if (mode == render_mode_) {
+      return;
+    }
+
+    render_mode_ = mode;
+    frame_scheduler_.Reset();
+    if (is_running_) {
+      // Restarting the capture delivers a fresh frame, after which
+      // capturing is paused again in on-demand mode.
+      if (mode == RenderMode::kOnDemand) {
+        frame_scheduler_.RequestFrame();
+      }
+      StartCapture();
+    }
+    callbacks = TakeFrameRequestCallbacks();
   }
-  auto now = std::chrono::high_resolution_clock::now();
 
-  bool should_drop_frame = false;
-  if (last_frame_timestamp_.has_value()) {
-    auto diff = std::chrono::duration_cast<std::chrono::milliseconds>(
-        now - last_frame_timestamp_.value());
-    should_drop_frame = diff < frame_duration_.value();
+  for (const auto& callback : callbacks) {
+    callback();
   }
+}
 
-  if (!should_drop_frame) {
-    last_frame_timestamp_ = now;
+void TextureBridge::RequestFrame(FrameRequestCallback callback) {
+  {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    if (is_running_ && render_mode_ == RenderMode::kOnDemand) {
+      const auto action = frame_scheduler_.RequestFrame();
+      if (action == util::FrameScheduler::Action::kNone || StartCapture()) {
+        frame_request_callbacks_.push_back(std::move(callback));
+        return;
+      }
+      frame_scheduler_.Reset();
+    }
   }
-  return should_drop_frame;
+
+  callback();
 }
 
-void TextureBridge::NotifySurfaceSizeChanged() {
+void TextureBridge::NotifyActivity() {
   const std::lock_guard<std::mutex> lock(mutex_);
-  needs_update_ = true;
+  ScheduleFrameAfterActivity();
 }
 
-void TextureBridge::SetFpsLimit(std::optional<int> max_fps) {
+void TextureBridge::ScheduleFrameAfterActivity() {
+  if (is_running_ && render_mode_ == RenderMode::kOnDemand) {
+    frame_scheduler_.NotifyActivity(util::FrameScheduler::Clock::now());
+    ScheduleSettleTick();
+  }
+}
+
+void TextureBridge::ScheduleSettleTick() {
+  const auto deadline = frame_scheduler_.deadline();
+  if (settle_tick_pending_ || !deadline) {
+    return;
+  }
+
+  const auto delay = std::chrono::ceil<std::chrono::milliseconds>(
+      *deadline - util::FrameScheduler::Clock::now());
+  settle_tick_pending_ = graphics_context_->task_runner()->PostDelayedTask(
+      [this, lifetime = std::weak_ptr<bool>(lifetime_)]() {
+        if (!lifetime.expired()) {
+          OnSettleTick();
+        }
+      },
+      std::max(delay, std::chrono::milliseconds(0)));
+}
+
+void TextureBridge::OnSettleTick() {
   const std::lock_guard<std::mutex> lock(mutex_);
-  auto value = max_fps.value_or(0);
-  if (value != 0) {
-    frame_duration_ = FrameDuration(1000.0 / value);
-  } else {
-    frame_duration_.reset();
-    last_frame_timestamp_.reset();
+  settle_tick_pending_ = false;
+  if (!is_running_ || render_mode_ != RenderMode::kOnDemand) {
+    return;
+  }
+
+  const auto action =
+      frame_scheduler_.Tick(util::FrameScheduler::Clock::now());
+  if (action == util::FrameScheduler::Action::kStartCapture) {
+    if (!StartCapture()) {
+      frame_scheduler_.Reset();
+    }
+    return;
   }
+
+  // Further activity may have moved the deadline.
+  ScheduleSettleTick();
+}
+
+std::vector<TextureBridge::FrameRequestCallback>
+TextureBridge::TakeFrameRequestCallbacks() {
+  return std::exchange(frame_request_callbacks_, {});
+}
+
+void TextureBridge::SetVisibleRect(std::optional<util::Rect> rect) {
+  {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    if (visible_rect_ == rect) {
+      return;
+    }
+    visible_rect_ = rect;
+    visible_rect_changed_ = true;
+  }
+
+  // Previously hidden parts need to be copied even if the contents
+  // haven't changed.
+  if (frame_available_) {
+    frame_available_();
+  }
+}
+
+void TextureBridge::SetFpsLimit(std::optional<int> max_fps) {
+  const std::lock_guard<std::mutex> lock(mutex_);
+  frame_rate_limiter_.SetMaxFps(max_fps);
 }
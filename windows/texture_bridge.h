@@ -6,22 +6,52 @@
 #include <chrono>
 #include <cstdint>
 #include <functional>
+#include <memory>
 #include <mutex>
 #include <optional>
+#include <vector>
 
+#include "device_recovery.h"
 #include "graphics_context.h"
+#include "util/backoff.h"
+#include "util/frame_scheduler.h"
+#include "util/rect.h"
 
 typedef struct {
   size_t width;
   size_t height;
 } Size;
 
-class TextureBridge {
+class TextureBridge : public DeviceRecovery::Client {
  public:
   typedef std::function<void()> FrameAvailableCallback;
   typedef std::function<void(Size size)> SurfaceSizeChangedCallback;
-  typedef std::chrono::duration<double, std::milli> FrameDuration;
-
+  typedef std::function<void()> FrameRequestCallback;
+
+  enum class CaptureRecoveryState {
+    // The capture item has been closed and frames stopped arriving.
+    kLost,
+    // The capture item has been recreated and capturing resumed.
+    kRecovered,
+    // Recreating the capture item failed repeatedly. Frames stay frozen.
+    kFailed,
+  };
+  // |attempt| is the number of failed attempts preceding the state change.
+  typedef std::function<void(CaptureRecoveryState state, int attempt)>
+      CaptureRecoveryCallback;
+
+  enum class RenderMode {
+    // Frames are captured whenever the contents change.
+    kContinuous,
+    // Capturing is paused between frames. A frame is only captured when
+    // requested, or after activity (navigation, input, resizing) once the
+    // settle delay has passed.
+    kOnDemand,
+  };
+
+  // Frames are captured from |visual| using Windows.Graphics.Capture.
+  // Subclasses passing nullptr provide frames themselves by overriding
+  // StartCapture() and StopCapture().
   TextureBridge(GraphicsContext* graphics_context,
                 ABI::Windows::UI::Composition::IVisual* visual);
   virtual ~TextureBridge();
@@ -37,25 +67,79 @@ class TextureBridge {
     surface_size_changed_ = std::move(callback);
   }
 
+  // Called on the platform thread whenever a closed capture item is
+  // recovered from.
+  void SetOnCaptureRecovery(CaptureRecoveryCallback callback) {
+    capture_recovery_ = std::move(callback);
+  }
+
   void NotifySurfaceSizeChanged();
   void SetFpsLimit(std::optional<int> max_fps);
 
+  // Restricts copying to the given region of the surface (in physical
+  // pixels). Pixels outside of it keep their previous contents.
+  // Passing std::nullopt copies the entire surface again.
+  void SetVisibleRect(std::optional<util::Rect> rect);
+
+  void SetRenderMode(RenderMode mode,
+                     std::optional<std::chrono::milliseconds> settle_delay);
+
+  // Captures a single frame in on-demand mode. |callback| is called once the
+  // frame has been delivered, or right away if the frame can't be captured
+  // or capturing is continuous.
+  void RequestFrame(FrameRequestCallback callback);
+
+  // Notifies about activity likely changing the contents, which schedules a
+  // frame in on-demand mode.
+  void NotifyActivity();
+
+  // Moves the bridge to a different graphics context. All resources
+  // belonging to the current device are released and capturing is resumed
+  // on the new one.
+  void SetGraphicsContext(GraphicsContext* graphics_context);
+
+  // DeviceRecovery::Client
+  void OnDeviceLost() override;
+  void OnDeviceRestored() override;
+
  protected:
   bool is_running_ = false;
+  bool resume_after_device_restored_ = false;
+
+  GraphicsContext* graphics_context_;
 
-  const GraphicsContext* graphics_context_;
+  // Held while producing a surface on the raster thread. When acquiring both
+  // mutexes, use std::scoped_lock to avoid lock-order inversions.
+  std::mutex surface_mutex_;
   std::mutex mutex_;
-  std::optional<FrameDuration> frame_duration_ = std::nullopt;
+  util::FrameRateLimiter frame_rate_limiter_;
 
   FrameAvailableCallback frame_available_;
   SurfaceSizeChangedCallback surface_size_changed_;
+  CaptureRecoveryCallback capture_recovery_;
   std::atomic<bool> needs_update_ = false;
+  std::optional<util::Rect> visible_rect_;
+  bool visible_rect_changed_ = false;
   winrt::com_ptr<ID3D11Texture2D> last_frame_;
-  std::optional<std::chrono::high_resolution_clock::time_point>
-      last_frame_timestamp_;
 
+  RenderMode render_mode_ = RenderMode::kContinuous;
+  util::FrameScheduler frame_scheduler_;
+  bool settle_tick_pending_ = false;
+  std::vector<FrameRequestCallback> frame_request_callbacks_;
+  // Expires when the bridge is destroyed. Guards delayed tasks.
+  std::shared_ptr<bool> lifetime_ = std::make_shared<bool>(true);
+
+  // The visual capture items are created from. Kept for recreating the
+  // capture item once it has been closed (e.g. when the visual got detached
+  // or the compositor was reset).
+  winrt::com_ptr<ABI::Windows::UI::Composition::IVisual> visual_;
   winrt::com_ptr<ABI::Windows::Graphics::Capture::IGraphicsCaptureItem>
       capture_item_;
+  // Incremented with every capture item, so that notifications about
+  // previous ones are ignored.
+  uint64_t capture_item_generation_ = 0;
+  bool capture_lost_ = false;
+  util::Backoff capture_backoff_;
   winrt::com_ptr<ABI::Windows::Graphics::Capture::IDirect3D11CaptureFramePool>
       frame_pool_;
   winrt::com_ptr<ABI::Windows::Graphics::Capture::IGraphicsCaptureSession>
@@ -64,9 +148,29 @@ class TextureBridge {
   EventRegistrationToken on_closed_token_ = {};
   EventRegistrationToken on_frame_arrived_token_ = {};
 
+  // Called with both |surface_mutex_| and |mutex_| held.
   virtual void StopInternal();
+  void ReleaseDeviceResources();
+
+  // Called with |mutex_| held. Starting an active capture restarts it, which
+  // guarantees a new frame to be delivered.
+  virtual bool StartCapture();
+  virtual void StopCapture();
+  void ReleaseFramePool();
+  virtual void ScheduleFrameAfterActivity();
+  void ScheduleSettleTick();
+  void OnSettleTick();
+  std::vector<FrameRequestCallback> TakeFrameRequestCallbacks();
   void OnFrameArrived();
-  bool ShouldDropFrame();
+  // Called with |mutex_| held.
+  bool CreateCaptureItem();
+  void ReleaseCaptureItem();
+  bool ScheduleCaptureRecovery();
+  void OnCaptureItemClosed(uint64_t generation);
+  void RecoverCapture();
+  // Called with |mutex_| held after a frame has been received. Notifies
+  // about it and pauses capturing again in on-demand mode.
+  void DeliverFrame(bool has_frame);
 
   // corresponds to DXGI_FORMAT_B8G8R8A8_UNORM
   static constexpr auto kPixelFormat = ABI::Windows::Graphics::DirectX::
@@ -1,37 +1,152 @@
 #include "texture_bridge_gpu.h"
 
 #include <iostream>
+#include <utility>
 
 #include "util/direct3d11.interop.h"
 
 TextureBridgeGpu::TextureBridgeGpu(
     GraphicsContext* graphics_context,
     ABI::Windows::UI::Composition::IVisual* visual)
-    : TextureBridge(graphics_context, visual) {
-  surface_descriptor_.struct_size = sizeof(FlutterDesktopGpuSurfaceDescriptor);
-  surface_descriptor_.format =
-      kFlutterDesktopPixelFormatNone;  // no format required for DXGI surfaces
+    : TextureBridge(graphics_context, visual) {}
+
+bool TextureBridgeGpu::AcquireFrame(std::optional<util::Rect>* visible_rect,
+                                    bool* visible_rect_changed) {
+  const std::lock_guard<std::mutex> lock(mutex_);
+  if (!is_running_) {
+    return false;
+  }
+
+  if (last_frame_) {
+    // Frames which have already been taken don't need to be copied again.
+    source_frame_ = std::move(last_frame_);
+    frame_generation_++;
+  }
+
+  if (visible_rect) {
+    *visible_rect = visible_rect_;
+  }
+  if (visible_rect_changed) {
+    *visible_rect_changed = std::exchange(visible_rect_changed_, false);
+  }
+  return true;
 }
 
 void TextureBridgeGpu::ProcessFrame(
-    winrt::com_ptr<ID3D11Texture2D> src_texture) {
+    const std::optional<util::Rect>& visible_rect) {
+  if (graphics_context_->CheckDeviceRemoved()) {
+    return;
+  }
+
   D3D11_TEXTURE2D_DESC desc;
-  src_texture->GetDesc(&desc);
+  source_frame_->GetDesc(&desc);
 
   const auto width = desc.Width;
   const auto height = desc.Height;
 
-  EnsureSurface(width, height);
+  if (!EnsureSurface(&surface_, width, height)) {
+    return;
+  }
+  surface_.generation = frame_generation_;
+
+  util::Rect region{0, 0, static_cast<int32_t>(width),
+                    static_cast<int32_t>(height)};
+  if (visible_rect) {
+    region = util::ClipToSurface(*visible_rect, width, height);
+  }
 
-  auto device_context = graphics_context_->d3d_device_context();
+  if (region.IsEmpty()) {
+    // Entirely clipped or covered, nothing to copy.
+    return;
+  }
+
+  if (static_cast<UINT>(region.width()) == width &&
+      static_cast<UINT>(region.height()) == height) {
+    CopyFromSource(surface_.texture.get(), 0, 0, nullptr);
+  } else {
+    D3D11_BOX box;
+    box.left = static_cast<UINT>(region.left);
+    box.top = static_cast<UINT>(region.top);
+    box.front = 0;
+    box.right = static_cast<UINT>(region.right);
+    box.bottom = static_cast<UINT>(region.bottom);
+    box.back = 1;
+    CopyFromSource(surface_.texture.get(), box.left, box.top, &box);
+  }
+}
+
+bool TextureBridgeGpu::ProcessViewFrame(const util::TextureCopy& copy,
+                                        SharedSurface* surface) {
+  if (graphics_context_->CheckDeviceRemoved()) {
+    return false;
+  }
+
+  if (!EnsureSurface(surface, copy.width, copy.height)) {
+    return false;
+  }
+
+  bool copied = true;
+  if (copy.needs_scaling()) {
+    const GraphicsContext::ScopedContextLock context_lock(graphics_context_);
+    if (!scaler_) {
+      scaler_ = std::make_unique<TextureScaler>(graphics_context_);
+    }
+    copied = scaler_->Scale(source_frame_.get(), copy.source,
+                            surface->texture.get());
+    graphics_context_->d3d_device_context()->Flush();
+  } else {
+    D3D11_BOX box;
+    box.left = static_cast<UINT>(copy.source.left);
+    box.top = static_cast<UINT>(copy.source.top);
+    box.front = 0;
+    box.right = static_cast<UINT>(copy.source.right);
+    box.bottom = static_cast<UINT>(copy.source.bottom);
+    box.back = 1;
+    CopyFromSource(surface->texture.get(), 0, 0, &box);
+  }
+
+  if (copied) {
+    surface->generation = frame_generation_;
+  }
+  return copied;
+}
+
+void TextureBridgeGpu::CopyFromSource(ID3D11Texture2D* dst, UINT x, UINT y,
+                                      const D3D11_BOX* box) {
+  if (!deferred_context_ && !deferred_context_failed_) {
+    deferred_context_ = graphics_context_->CreateDeferredContext();
+    deferred_context_failed_ = !deferred_context_;
+  }
+
+  const auto record = [&](ID3D11DeviceContext* context) {
+    if (box) {
+      context->CopySubresourceRegion(dst, 0, x, y, 0, source_frame_.get(), 0,
+                                     box);
+    } else {
+      context->CopyResource(dst, source_frame_.get());
+    }
+  };
+
+  if (deferred_context_) {
+    record(deferred_context_.get());
+    if (graphics_context_->ExecuteDeferredCommands(deferred_context_.get())) {
+      return;
+    }
+    // Start over on the immediate context with a fresh deferred context
+    // next time.
+    deferred_context_ = nullptr;
+  }
 
-  device_context->CopyResource(surface_.get(), src_texture.get());
+  const GraphicsContext::ScopedContextLock context_lock(graphics_context_);
+  const auto device_context = graphics_context_->d3d_device_context();
+  record(device_context);
   device_context->Flush();
 }
 
-void TextureBridgeGpu::EnsureSurface(uint32_t width, uint32_t height) {
-  if (!surface_ || surface_size_.width != width ||
-      surface_size_.height != height) {
+bool TextureBridgeGpu::EnsureSurface(SharedSurface* surface, uint32_t width,
+                                     uint32_t height) {
+  if (!surface->texture || surface->size.width != width ||
+      surface->size.height != height) {
     D3D11_TEXTURE2D_DESC dstDesc = {};
     dstDesc.ArraySize = 1;
     dstDesc.MipLevels = 1;
@@ -45,55 +160,138 @@ void TextureBridgeGpu::EnsureSurface(uint32_t width, uint32_t height) {
     dstDesc.SampleDesc.Quality = 0;
     dstDesc.Usage = D3D11_USAGE_DEFAULT;
 
-    surface_ = nullptr;
+    *surface = {};
     if (!SUCCEEDED(graphics_context_->d3d_device()->CreateTexture2D(
-            &dstDesc, nullptr, surface_.put()))) {
+            &dstDesc, nullptr, surface->texture.put()))) {
       std::cerr << "Creating intermediate texture failed" << std::endl;
-      return;
+      graphics_context_->CheckDeviceRemoved();
+      return false;
     }
 
     HANDLE shared_handle;
-    surface_.try_as(dxgi_surface_);
-    assert(dxgi_surface_);
-    dxgi_surface_->GetSharedHandle(&shared_handle);
-
-    surface_descriptor_.handle = shared_handle;
-    surface_descriptor_.width = surface_descriptor_.visible_width = width;
-    surface_descriptor_.height = surface_descriptor_.visible_height = height;
-    surface_descriptor_.release_context = surface_.get();
-    surface_descriptor_.release_callback = [](void* release_context) {
+    auto dxgi_surface = surface->texture.as<IDXGIResource>();
+    dxgi_surface->GetSharedHandle(&shared_handle);
+
+    auto& descriptor = surface->descriptor;
+    descriptor.struct_size = sizeof(FlutterDesktopGpuSurfaceDescriptor);
+    descriptor.format =
+        kFlutterDesktopPixelFormatNone;  // no format required for DXGI surfaces
+    descriptor.handle = shared_handle;
+    descriptor.width = descriptor.visible_width = width;
+    descriptor.height = descriptor.visible_height = height;
+    descriptor.release_context = surface->texture.get();
+    descriptor.release_callback = [](void* release_context) {
       auto texture = reinterpret_cast<ID3D11Texture2D*>(release_context);
       texture->Release();
     };
 
-    surface_size_ = {width, height};
+    surface->size = {width, height};
+  }
+  return true;
+}
+
+const FlutterDesktopGpuSurfaceDescriptor* TextureBridgeGpu::AcquireDescriptor(
+    SharedSurface* surface) {
+  if (!surface->texture) {
+    return nullptr;
   }
+
+  // Gets released in the SurfaceDescriptor's release callback.
+  surface->texture->AddRef();
+
+  return &surface->descriptor;
 }
 
 const FlutterDesktopGpuSurfaceDescriptor*
 TextureBridgeGpu::GetSurfaceDescriptor(size_t width, size_t height) {
-  const std::lock_guard<std::mutex> lock(mutex_);
+  const std::lock_guard<std::mutex> surface_lock(surface_mutex_);
 
-  if (!is_running_) {
+  std::optional<util::Rect> visible_rect;
+  bool visible_rect_changed;
+  if (!AcquireFrame(&visible_rect, &visible_rect_changed)) {
     return nullptr;
   }
 
-  if (last_frame_) {
-    ProcessFrame(last_frame_);
+  if (source_frame_ &&
+      (surface_.generation != frame_generation_ || visible_rect_changed)) {
+    ProcessFrame(visible_rect);
   }
 
-  if (surface_) {
-    // Gets released in the SurfaceDescriptor's release callback.
-    surface_->AddRef();
+  return AcquireDescriptor(&surface_);
+}
+
+int64_t TextureBridgeGpu::AddView(const util::TextureViewSpec& spec) {
+  const std::lock_guard<std::mutex> surface_lock(surface_mutex_);
+  return view_graph_.AddView(spec);
+}
+
+void TextureBridgeGpu::RemoveView(int64_t view_id) {
+  const std::lock_guard<std::mutex> surface_lock(surface_mutex_);
+  if (view_graph_.RemoveView(view_id)) {
+    PruneViewSurfaces();
   }
+}
+
+const FlutterDesktopGpuSurfaceDescriptor*
+TextureBridgeGpu::GetViewSurfaceDescriptor(int64_t view_id) {
+  const std::lock_guard<std::mutex> surface_lock(surface_mutex_);
 
-  return &surface_descriptor_;
+  if (!AcquireFrame(nullptr, nullptr) || !source_frame_) {
+    return nullptr;
+  }
+
+  D3D11_TEXTURE2D_DESC desc;
+  source_frame_->GetDesc(&desc);
+  const auto copy = view_graph_.Resolve(view_id, desc.Width, desc.Height);
+  if (!copy) {
+    return nullptr;
+  }
+
+  // Surfaces outnumbering the views means that some of them belong to
+  // copies which no longer exist (e.g. after the frame size changed).
+  if (view_surfaces_.size() > view_graph_.size()) {
+    PruneViewSurfaces();
+  }
+
+  auto& surface = view_surfaces_[*copy];
+  if (surface.generation != frame_generation_) {
+    // The first view asking for a new frame updates the shared surface for
+    // all views resolving to the same copy.
+    ProcessViewFrame(*copy, &surface);
+  }
+
+  return AcquireDescriptor(&surface);
+}
+
+void TextureBridgeGpu::PruneViewSurfaces() {
+  if (!source_frame_) {
+    view_surfaces_.clear();
+    return;
+  }
+
+  D3D11_TEXTURE2D_DESC desc;
+  source_frame_->GetDesc(&desc);
+
+  std::map<util::TextureCopy, SharedSurface> surfaces;
+  for (const auto& job : view_graph_.ResolveAll(desc.Width, desc.Height)) {
+    auto it = view_surfaces_.find(job.copy);
+    if (it != view_surfaces_.end()) {
+      surfaces.insert(view_surfaces_.extract(it));
+    }
+  }
+  view_surfaces_ = std::move(surfaces);
 }
 
 void TextureBridgeGpu::StopInternal() {
   TextureBridge::StopInternal();
 
-  // For some reason, the destination surface needs to be recreated upon
-  // resuming. Force |EnsureSurface| to create a new one by resetting it here.
-  surface_ = nullptr;
+  // For some reason, the destination surfaces need to be recreated upon
+  // resuming. Force |EnsureSurface| to create new ones by resetting them here.
+  surface_ = {};
+  view_surfaces_.clear();
+  scaler_ = nullptr;
+  // Belongs to the device, which may be about to be replaced.
+  deferred_context_ = nullptr;
+  deferred_context_failed_ = false;
+  source_frame_ = nullptr;
 }
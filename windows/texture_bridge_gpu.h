@@ -2,7 +2,12 @@
 
 #include <flutter/texture_registrar.h>
 
+#include <map>
+#include <memory>
+
 #include "texture_bridge.h"
+#include "texture_scaler.h"
+#include "util/texture_view_graph.h"
 
 class TextureBridgeGpu : public TextureBridge {
  public:
@@ -12,15 +17,56 @@ class TextureBridgeGpu : public TextureBridge {
   const FlutterDesktopGpuSurfaceDescriptor* GetSurfaceDescriptor(size_t width,
                                                                  size_t height);
 
+  // Texture views are additional surfaces fed by the same capture, showing
+  // either the entire frame or a region of it, optionally scaled. Views
+  // resolving to the same region and size share a single copy.
+  int64_t AddView(const util::TextureViewSpec& spec);
+  void RemoveView(int64_t view_id);
+  const FlutterDesktopGpuSurfaceDescriptor* GetViewSurfaceDescriptor(
+      int64_t view_id);
+
  protected:
   void StopInternal() override;
 
  private:
-  FlutterDesktopGpuSurfaceDescriptor surface_descriptor_ = {};
-  Size surface_size_ = {0, 0};
-  winrt::com_ptr<ID3D11Texture2D> surface_{nullptr};
-  winrt::com_ptr<IDXGIResource> dxgi_surface_;
+  struct SharedSurface {
+    winrt::com_ptr<ID3D11Texture2D> texture{nullptr};
+    FlutterDesktopGpuSurfaceDescriptor descriptor = {};
+    Size size = {0, 0};
+    // The frame generation this surface was last updated with.
+    uint64_t generation = 0;
+  };
+
+  // All members below are guarded by |surface_mutex_|, which is kept
+  // separate from |mutex_| so that copying doesn't block frame delivery on
+  // the platform thread.
+  SharedSurface surface_;
+  // The most recently received frame. Kept for copying newly revealed
+  // regions when the visible rect changes, and for updating views.
+  winrt::com_ptr<ID3D11Texture2D> source_frame_{nullptr};
+  // Incremented whenever |source_frame_| changes.
+  uint64_t frame_generation_ = 0;
+
+  // Unscaled copies are recorded here, so that the immediate context, which
+  // the platform thread uses as well, is only locked for submitting them.
+  // Created on first use, as not all drivers might support it.
+  winrt::com_ptr<ID3D11DeviceContext> deferred_context_{nullptr};
+  bool deferred_context_failed_ = false;
+
+  util::TextureViewGraph view_graph_;
+  std::map<util::TextureCopy, SharedSurface> view_surfaces_;
+  std::unique_ptr<TextureScaler> scaler_;
 
-  void ProcessFrame(winrt::com_ptr<ID3D11Texture2D> src_texture);
-  void EnsureSurface(uint32_t width, uint32_t height);
+  bool AcquireFrame(std::optional<util::Rect>* visible_rect,
+                    bool* visible_rect_changed);
+  void ProcessFrame(const std::optional<util::Rect>& visible_rect);
+  bool ProcessViewFrame(const util::TextureCopy& copy, SharedSurface* surface);
+  bool EnsureSurface(SharedSurface* surface, uint32_t width, uint32_t height);
+  // Copies |box| of |source_frame_| (or all of it, if nullptr) to |x|, |y|
+  // of |dst|.
+  void CopyFromSource(ID3D11Texture2D* dst, UINT x, UINT y,
+                      const D3D11_BOX* box);
+  void PruneViewSurfaces();
+  const FlutterDesktopGpuSurfaceDescriptor* AcquireDescriptor(
+      SharedSurface* surface);
 };
@@ -0,0 +1,230 @@
+#include "texture_bridge_preview.h"
+
+#include <objbase.h>
+
+#include <iostream>
+
+#pragma comment(lib, "windowscodecs.lib")
+
+TextureBridgePreview::TextureBridgePreview(GraphicsContext* graphics_context,
+                                           Webview* webview)
+    : TextureBridge(graphics_context, nullptr),
+      webview_(webview),
+      pipeline_([this](const uint8_t* data, size_t size,
+                       util::PixelFrame* frame) {
+        return DecodeImage(data, size, frame);
+      }) {
+  if (FAILED(CoCreateInstance(CLSID_WICImagingFactory, nullptr,
+                              CLSCTX_INPROC_SERVER,
+                              IID_PPV_ARGS(wic_factory_.put())))) {
+    std::cerr << "Creating the WIC imaging factory failed." << std::endl;
+  }
+  if (FAILED(CreateStreamOnHGlobal(nullptr, TRUE, stream_.put()))) {
+    std::cerr << "Creating the preview stream failed." << std::endl;
+  }
+}
+
+TextureBridgePreview::~TextureBridgePreview() { Stop(); }
+
+bool TextureBridgePreview::StartCapture() {
+  StopCapture();
+  if (!wic_factory_ || !stream_ || !webview_->IsValid()) {
+    return false;
+  }
+
+  capturing_ = true;
+  // Like restarting a capture session, this guarantees a new frame even if
+  // the contents haven't changed.
+  pipeline_.Invalidate();
+  poller_.NotifyActivity();
+  SchedulePoll(Clock::duration::zero());
+  return true;
+}
+
+void TextureBridgePreview::StopCapture() {
+  capturing_ = false;
+  poll_pending_ = false;
+  generation_++;
+}
+
+void TextureBridgePreview::ScheduleFrameAfterActivity() {
+  TextureBridge::ScheduleFrameAfterActivity();
+  if (!capturing_) {
+    return;
+  }
+
+  poller_.NotifyActivity();
+  const auto delay = poller_.min_interval();
+  // Only ever move the next poll closer, so that continuous activity can't
+  // postpone it indefinitely.
+  if (poll_pending_ && next_poll_time_ > Clock::now() + delay) {
+    generation_++;
+    SchedulePoll(delay);
+  }
+}
+
+void TextureBridgePreview::SchedulePoll(Clock::duration delay) {
+  if (capture_in_flight_) {
+    // Scheduled once the capture has completed.
+    return;
+  }
+
+  next_poll_time_ = Clock::now() + delay;
+  poll_pending_ = graphics_context_->task_runner()->PostDelayedTask(
+      [this, lifetime = std::weak_ptr<bool>(lifetime_),
+       generation = generation_]() {
+        if (!lifetime.expired()) {
+          Poll(generation);
+        }
+      },
+      std::chrono::ceil<std::chrono::milliseconds>(delay));
+}
+
+void TextureBridgePreview::Poll(uint64_t generation) {
+  {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    if (generation != generation_ || !capturing_) {
+      return;
+    }
+    poll_pending_ = false;
+    capture_in_flight_ = true;
+  }
+
+  LARGE_INTEGER zero = {};
+  ULARGE_INTEGER empty = {};
+  stream_->Seek(zero, STREAM_SEEK_SET, nullptr);
+  stream_->SetSize(empty);
+
+  // The completion handler may run synchronously, so |mutex_| must not be
+  // held here.
+  webview_->CapturePreview(
+      stream_.get(), [this, lifetime = std::weak_ptr<bool>(lifetime_),
+                      generation, started = Clock::now()](bool success) {
+        if (!lifetime.expired()) {
+          OnPreviewCaptured(generation, success, started);
+        }
+      });
+}
+
+void TextureBridgePreview::OnPreviewCaptured(uint64_t generation,
+                                             bool success,
+                                             Clock::time_point started) {
+  {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    capture_in_flight_ = false;
+    if (generation != generation_ || !capturing_) {
+      // Capturing has been restarted in the meantime. The image may predate
+      // the restart, so take a new one.
+      if (capturing_) {
+        SchedulePoll(Clock::duration::zero());
+      }
+      return;
+    }
+  }
+
+  // Decoding only touches the back buffer and doesn't need to block either
+  // thread.
+  auto result = util::PreviewFramePipeline::Result::kFailed;
+  if (success && ReadStream()) {
+    result = pipeline_.Process(encoded_.data(), encoded_.size());
+  }
+
+  const std::scoped_lock lock(surface_mutex_, mutex_);
+  if (generation != generation_ || !capturing_) {
+    if (capturing_) {
+      SchedulePoll(Clock::duration::zero());
+    }
+    return;
+  }
+
+  if (result == util::PreviewFramePipeline::Result::kDecoded) {
+    pipeline_.Commit();
+  }
+
+  // In on-demand mode, an unchanged image still completes the frame.
+  DeliverFrame(result == util::PreviewFramePipeline::Result::kDecoded ||
+               (render_mode_ == RenderMode::kOnDemand &&
+                result == util::PreviewFramePipeline::Result::kUnchanged));
+
+  poller_.set_min_interval(frame_rate_limiter_.frame_interval().value_or(
+      util::AdaptivePoller::kDefaultMinInterval));
+  SchedulePoll(
+      poller_.OnPoll(result == util::PreviewFramePipeline::Result::kDecoded,
+                     Clock::now() - started));
+}
+
+bool TextureBridgePreview::ReadStream() {
+  LARGE_INTEGER zero = {};
+  ULARGE_INTEGER size;
+  if (FAILED(stream_->Seek(zero, STREAM_SEEK_END, &size)) ||
+      FAILED(stream_->Seek(zero, STREAM_SEEK_SET, nullptr))) {
+    return false;
+  }
+
+  encoded_.resize(static_cast<size_t>(size.QuadPart));
+  ULONG read = 0;
+  return SUCCEEDED(stream_->Read(encoded_.data(),
+                                 static_cast<ULONG>(encoded_.size()),
+                                 &read)) &&
+         read == encoded_.size();
+}
+
+bool TextureBridgePreview::DecodeImage(const uint8_t* data, size_t size,
+                                       util::PixelFrame* frame) {
+  winrt::com_ptr<IWICStream> stream;
+  if (FAILED(wic_factory_->CreateStream(stream.put())) ||
+      FAILED(stream->InitializeFromMemory(const_cast<BYTE*>(data),
+                                          static_cast<DWORD>(size)))) {
+    return false;
+  }
+
+  winrt::com_ptr<IWICBitmapDecoder> decoder;
+  winrt::com_ptr<IWICBitmapFrameDecode> source;
+  if (FAILED(wic_factory_->CreateDecoderFromStream(
+          stream.get(), nullptr, WICDecodeMetadataCacheOnDemand,
+          decoder.put())) ||
+      FAILED(decoder->GetFrame(0, source.put()))) {
+    return false;
+  }
+
+  // Flutter expects pixel buffers in RGBA.
+  winrt::com_ptr<IWICFormatConverter> converter;
+  if (FAILED(wic_factory_->CreateFormatConverter(converter.put())) ||
+      FAILED(converter->Initialize(source.get(), GUID_WICPixelFormat32bppRGBA,
+                                   WICBitmapDitherTypeNone, nullptr, 0.0,
+                                   WICBitmapPaletteTypeCustom))) {
+    return false;
+  }
+
+  UINT width, height;
+  if (FAILED(converter->GetSize(&width, &height))) {
+    return false;
+  }
+
+  const UINT stride = width * 4;
+  frame->width = width;
+  frame->height = height;
+  // Keeps the capacity of previous frames.
+  frame->pixels.resize(static_cast<size_t>(stride) * height);
+  return SUCCEEDED(converter->CopyPixels(
+      nullptr, stride, static_cast<UINT>(frame->pixels.size()),
+      frame->pixels.data()));
+}
+
+const FlutterDesktopPixelBuffer* TextureBridgePreview::CopyPixelBuffer(
+    size_t width, size_t height) {
+  {
+    const std::lock_guard<std::mutex> surface_lock(surface_mutex_);
+    const auto& frame = pipeline_.front();
+    if (frame.pixels.empty()) {
+      return nullptr;
+    }
+    // Keeps the capacity of previous frames.
+    pixels_.assign(frame.pixels.begin(), frame.pixels.end());
+    pixel_buffer_.width = frame.width;
+    pixel_buffer_.height = frame.height;
+  }
+
+  pixel_buffer_.buffer = pixels_.data();
+  return &pixel_buffer_;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <flutter/texture_registrar.h>
+#include <wincodec.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "texture_bridge.h"
+#include "util/adaptive_poller.h"
+#include "util/preview_frame_pipeline.h"
+#include "webview.h"
+
+// Provides frames on systems lacking Windows.Graphics.Capture by polling
+// preview images of the webview (ICoreWebView2::CapturePreview) and
+// decoding them on the CPU. Unchanged images are skipped, and polling slows
+// down while the contents stay the same.
+class TextureBridgePreview : public TextureBridge {
+ public:
+  TextureBridgePreview(GraphicsContext* graphics_context, Webview* webview);
+  ~TextureBridgePreview() override;
+
+  // Called on the raster thread. The returned buffer stays valid until the
+  // next call.
+  const FlutterDesktopPixelBuffer* CopyPixelBuffer(size_t width,
+                                                   size_t height);
+
+ protected:
+  bool StartCapture() override;
+  void StopCapture() override;
+  void ScheduleFrameAfterActivity() override;
+
+ private:
+  typedef util::AdaptivePoller::Clock Clock;
+
+  Webview* webview_;
+  winrt::com_ptr<IWICImagingFactory> wic_factory_;
+
+  // All members below are guarded by |mutex_|.
+  bool capturing_ = false;
+  // Incremented whenever capturing starts or stops, or the next poll gets
+  // rescheduled. Outdated polls and captures are ignored.
+  uint64_t generation_ = 0;
+  bool poll_pending_ = false;
+  Clock::time_point next_poll_time_;
+  bool capture_in_flight_ = false;
+  util::AdaptivePoller poller_;
+
+  // Only used on the platform thread. The image is written to |stream_|,
+  // which is reused between polls, as is |encoded_|.
+  winrt::com_ptr<IStream> stream_;
+  std::vector<uint8_t> encoded_;
+  // Committing the back buffer and reading the front one are guarded by
+  // |surface_mutex_|.
+  util::PreviewFramePipeline pipeline_;
+
+  // Only used on the raster thread. The front buffer is copied to |pixels_|,
+  // so that the lock isn't held while Flutter uploads it.
+  std::vector<uint8_t> pixels_;
+  FlutterDesktopPixelBuffer pixel_buffer_ = {};
+
+  void SchedulePoll(Clock::duration delay);
+  void Poll(uint64_t generation);
+  void OnPreviewCaptured(uint64_t generation, bool success,
+                         Clock::time_point started);
+  bool ReadStream();
+  bool DecodeImage(const uint8_t* data, size_t size, util::PixelFrame* frame);
+};
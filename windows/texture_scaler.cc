@@ -0,0 +1,102 @@
+#include "texture_scaler.h"
+
+#include <iostream>
+
+namespace {
+// Keep the number of cached processors bounded in case the output sizes keep
+// changing (e.g. while resizing).
+constexpr size_t kMaxCachedProcessors = 8;
+}  // namespace
+
+TextureScaler::TextureScaler(GraphicsContext* graphics_context)
+    : graphics_context_(graphics_context) {
+  graphics_context_->d3d_device()->QueryInterface(video_device_.put());
+  graphics_context_->d3d_device_context()->QueryInterface(
+      video_context_.put());
+}
+
+const TextureScaler::Processor* TextureScaler::GetProcessor(
+    const ProcessorKey& key) {
+  if (auto it = processors_.find(key); it != processors_.end()) {
+    return &it->second;
+  }
+
+  if (processors_.size() >= kMaxCachedProcessors) {
+    processors_.clear();
+  }
+
+  const auto [input_width, input_height, output_width, output_height] = key;
+
+  D3D11_VIDEO_PROCESSOR_CONTENT_DESC content_desc = {};
+  content_desc.InputFrameFormat = D3D11_VIDEO_FRAME_FORMAT_PROGRESSIVE;
+  content_desc.InputWidth = input_width;
+  content_desc.InputHeight = input_height;
+  content_desc.OutputWidth = output_width;
+  content_desc.OutputHeight = output_height;
+  content_desc.Usage = D3D11_VIDEO_USAGE_OPTIMAL_SPEED;
+
+  Processor processor;
+  if (FAILED(video_device_->CreateVideoProcessorEnumerator(
+          &content_desc, processor.enumerator.put())) ||
+      FAILED(video_device_->CreateVideoProcessor(
+          processor.enumerator.get(), 0, processor.processor.put()))) {
+    std::cerr << "Creating video processor failed." << std::endl;
+    return nullptr;
+  }
+
+  return &(processors_[key] = std::move(processor));
+}
+
+bool TextureScaler::Scale(ID3D11Texture2D* src, const util::Rect& src_rect,
+                          ID3D11Texture2D* dst) {
+  if (!video_device_ || !video_context_) {
+    return false;
+  }
+
+  D3D11_TEXTURE2D_DESC src_desc;
+  src->GetDesc(&src_desc);
+  D3D11_TEXTURE2D_DESC dst_desc;
+  dst->GetDesc(&dst_desc);
+
+  const auto processor = GetProcessor(
+      {src_desc.Width, src_desc.Height, dst_desc.Width, dst_desc.Height});
+  if (!processor) {
+    return false;
+  }
+
+  D3D11_VIDEO_PROCESSOR_INPUT_VIEW_DESC input_desc = {};
+  input_desc.ViewDimension = D3D11_VPIV_DIMENSION_TEXTURE2D;
+  winrt::com_ptr<ID3D11VideoProcessorInputView> input_view;
+  if (FAILED(video_device_->CreateVideoProcessorInputView(
+          src, processor->enumerator.get(), &input_desc, input_view.put()))) {
+    return false;
+  }
+
+  D3D11_VIDEO_PROCESSOR_OUTPUT_VIEW_DESC output_desc = {};
+  output_desc.ViewDimension = D3D11_VPOV_DIMENSION_TEXTURE2D;
+  winrt::com_ptr<ID3D11VideoProcessorOutputView> output_view;
+  if (FAILED(video_device_->CreateVideoProcessorOutputView(
+          dst, processor->enumerator.get(), &output_desc, output_view.put()))) {
+    return false;
+  }
+
+  const RECT source_rect{src_rect.left, src_rect.top, src_rect.right,
+                         src_rect.bottom};
+  const RECT target_rect{0, 0, static_cast<LONG>(dst_desc.Width),
+                         static_cast<LONG>(dst_desc.Height)};
+  auto video_processor = processor->processor.get();
+  video_context_->VideoProcessorSetStreamFrameFormat(
+      video_processor, 0, D3D11_VIDEO_FRAME_FORMAT_PROGRESSIVE);
+  video_context_->VideoProcessorSetStreamSourceRect(video_processor, 0, TRUE,
+                                                    &source_rect);
+  video_context_->VideoProcessorSetStreamDestRect(video_processor, 0, TRUE,
+                                                  &target_rect);
+  video_context_->VideoProcessorSetOutputTargetRect(video_processor, TRUE,
+                                                    &target_rect);
+
+  D3D11_VIDEO_PROCESSOR_STREAM stream = {};
+  stream.Enable = TRUE;
+  stream.pInputSurface = input_view.get();
+  return SUCCEEDED(video_context_->VideoProcessorBlt(
+      video_processor, output_view.get(), 0, 1, &stream));
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <d3d11.h>
+#include <winrt/base.h>
+
+#include <cstdint>
+#include <map>
+#include <tuple>
+
+#include "graphics_context.h"
+#include "util/rect.h"
+
+// Copies and scales regions of BGRA textures on the GPU using the D3D11
+// video processor. Video processing is only available on the immediate
+// context, so scaled copies can't be recorded on deferred contexts.
+class TextureScaler {
+ public:
+  explicit TextureScaler(GraphicsContext* graphics_context);
+
+  // Scales |src_rect| of |src| into the entire |dst|. |dst| must have been
+  // created with D3D11_BIND_RENDER_TARGET. Must be called while holding a
+  // GraphicsContext::ScopedContextLock.
+  bool Scale(ID3D11Texture2D* src, const util::Rect& src_rect,
+             ID3D11Texture2D* dst);
+
+ private:
+  struct Processor {
+    winrt::com_ptr<ID3D11VideoProcessorEnumerator> enumerator;
+    winrt::com_ptr<ID3D11VideoProcessor> processor;
+  };
+
+  // Input width, input height, output width, output height.
+  typedef std::tuple<UINT, UINT, UINT, UINT> ProcessorKey;
+
+  GraphicsContext* graphics_context_;
+  winrt::com_ptr<ID3D11VideoDevice> video_device_;
+  winrt::com_ptr<ID3D11VideoContext> video_context_;
+  std::map<ProcessorKey, Processor> processors_;
+
+  const Processor* GetProcessor(const ProcessorKey& key);
+};
@@ -0,0 +1,28 @@
+#include "adaptive_poller.h"
+
+#include <algorithm>
+
+namespace util {
+
+AdaptivePoller::AdaptivePoller(Clock::duration min_interval,
+                               Clock::duration max_interval)
+    : min_interval_(std::min(min_interval, max_interval)),
+      max_interval_(max_interval),
+      interval_(min_interval_) {}
+
+void AdaptivePoller::set_min_interval(Clock::duration min_interval) {
+  min_interval_ = std::min(min_interval, max_interval_);
+  interval_ = std::max(interval_, min_interval_);
+}
+
+AdaptivePoller::Clock::duration AdaptivePoller::OnPoll(
+    bool changed, Clock::duration elapsed) {
+  if (changed) {
+    interval_ = min_interval_;
+  } else {
+    interval_ = std::min(interval_ * 2, max_interval_);
+  }
+  return std::max(interval_, elapsed);
+}
+
+}  // namespace util
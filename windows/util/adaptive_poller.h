@@ -0,0 +1,45 @@
+#pragma once
+
+#include <chrono>
+
+namespace util {
+
+// Decides how often to poll for frames when the contents can't be observed
+// directly (see TextureBridgePreview).
+//
+// The interval doubles with every unchanged frame, up to a maximum, and
+// drops back to the minimum as soon as the contents change or activity
+// (input, navigation, resizing) is reported. Polls are also spaced by at
+// least the time the previous one took, keeping their share of time at or
+// below one half.
+class AdaptivePoller {
+ public:
+  typedef std::chrono::steady_clock Clock;
+
+  static constexpr Clock::duration kDefaultMinInterval =
+      std::chrono::milliseconds(33);
+  static constexpr Clock::duration kDefaultMaxInterval =
+      std::chrono::milliseconds(1000);
+
+  explicit AdaptivePoller(Clock::duration min_interval = kDefaultMinInterval,
+                          Clock::duration max_interval = kDefaultMaxInterval);
+
+  // The minimum is clamped to the maximum.
+  void set_min_interval(Clock::duration min_interval);
+  Clock::duration min_interval() const { return min_interval_; }
+  Clock::duration interval() const { return interval_; }
+
+  // Reports the outcome of a poll which took |elapsed|, and returns the
+  // delay until the next one.
+  Clock::duration OnPoll(bool changed, Clock::duration elapsed);
+
+  // Resets the interval to the minimum.
+  void NotifyActivity() { interval_ = min_interval_; }
+
+ private:
+  Clock::duration min_interval_;
+  Clock::duration max_interval_;
+  Clock::duration interval_;
+};
+
+}  // namespace util
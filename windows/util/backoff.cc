@@ -0,0 +1,25 @@
+#include "backoff.h"
+
+#include <algorithm>
+
+namespace util {
+
+Backoff::Backoff(Duration initial_delay, Duration max_delay, int max_attempts)
+    : initial_delay_(initial_delay),
+      max_delay_(std::max(max_delay, initial_delay)),
+      max_attempts_(max_attempts) {}
+
+std::optional<Backoff::Duration> Backoff::Next() {
+  if (exhausted()) {
+    return std::nullopt;
+  }
+
+  auto delay = initial_delay_;
+  for (int i = 0; i < attempt_ && delay < max_delay_; i++) {
+    delay *= 2;
+  }
+  attempt_++;
+  return std::min(delay, max_delay_);
+}
+
+}  // namespace util
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <chrono>
+#include <optional>
+
+namespace util {
+
+// Exponentially growing delays between a limited number of attempts.
+class Backoff {
+ public:
+  typedef std::chrono::milliseconds Duration;
+
+  Backoff(Duration initial_delay, Duration max_delay, int max_attempts);
+
+  // Returns the delay before the next attempt, or std::nullopt once all
+  // attempts have been used up. The first attempt happens after
+  // |initial_delay|, and each further one doubles it up to |max_delay|.
+  std::optional<Duration> Next();
+
+  // Starts over after an attempt has succeeded.
+  void Reset() { attempt_ = 0; }
+
+  // The number of attempts handed out since the last reset.
+  int attempt() const { return attempt_; }
+  bool exhausted() const { return attempt_ >= max_attempts_; }
+
+ private:
+  Duration initial_delay_;
+  Duration max_delay_;
+  int max_attempts_;
+  int attempt_ = 0;
+};
+
+}  // namespace util
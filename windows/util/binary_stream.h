@@ -0,0 +1,143 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace util {
+
+// Writes the primitives of the plugin's compact binary formats: varints,
+// zigzag-encoded signed values, little-endian doubles and length-prefixed
+// strings.
+class BinaryWriter {
+ public:
+  void WriteByte(uint8_t value) { buffer_.push_back(value); }
+
+  void WriteVarint(uint64_t value) {
+    while (value >= 0x80) {
+      buffer_.push_back(static_cast<uint8_t>(value | 0x80));
+      value >>= 7;
+    }
+    buffer_.push_back(static_cast<uint8_t>(value));
+  }
+
+  // Zigzag encoding keeps small negative values short.
+  void WriteSigned(int64_t value) {
+    WriteVarint((static_cast<uint64_t>(value) << 1) ^
+                static_cast<uint64_t>(value >> 63));
+  }
+
+  void WriteDouble(double value) {
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    for (int i = 0; i < 8; i++) {
+      buffer_.push_back(static_cast<uint8_t>(bits >> (i * 8)));
+    }
+  }
+
+  void WriteString(std::string_view value) {
+    WriteVarint(value.size());
+    buffer_.insert(buffer_.end(), value.begin(), value.end());
+  }
+
+  void WriteBytes(const uint8_t* data, size_t size) {
+    buffer_.insert(buffer_.end(), data, data + size);
+  }
+
+  const std::vector<uint8_t>& buffer() const { return buffer_; }
+  void Clear() { buffer_.clear(); }
+  std::vector<uint8_t> Take() { return std::move(buffer_); }
+
+ private:
+  std::vector<uint8_t> buffer_;
+};
+
+// Reads what BinaryWriter wrote. All methods return false on truncated or
+// malformed input.
+class BinaryReader {
+ public:
+  BinaryReader(const uint8_t* data, size_t size) : data_(data), size_(size) {}
+
+  bool ReadByte(uint8_t* value) {
+    if (pos_ >= size_) {
+      return false;
+    }
+    *value = data_[pos_++];
+    return true;
+  }
+
+  bool ReadVarint(uint64_t* value) {
+    *value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+      uint8_t byte;
+      if (!ReadByte(&byte)) {
+        return false;
+      }
+      *value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+      if (!(byte & 0x80)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // Every element takes at least one byte, which bounds the allocations
+  // made for corrupt input.
+  bool ReadCount(uint64_t* count) {
+    return ReadVarint(count) && *count <= size_ - pos_;
+  }
+
+  bool ReadSigned(int64_t* value) {
+    uint64_t encoded;
+    if (!ReadVarint(&encoded)) {
+      return false;
+    }
+    *value = static_cast<int64_t>(encoded >> 1) ^
+             -static_cast<int64_t>(encoded & 1);
+    return true;
+  }
+
+  bool ReadDouble(double* value) {
+    if (size_ - pos_ < 8) {
+      return false;
+    }
+    uint64_t bits = 0;
+    for (int i = 0; i < 8; i++) {
+      bits |= static_cast<uint64_t>(data_[pos_++]) << (i * 8);
+    }
+    std::memcpy(value, &bits, sizeof(bits));
+    return true;
+  }
+
+  bool ReadString(std::string* value) {
+    uint64_t length;
+    if (!ReadVarint(&length) || length > size_ - pos_) {
+      return false;
+    }
+    value->assign(reinterpret_cast<const char*>(data_ + pos_), length);
+    pos_ += length;
+    return true;
+  }
+
+  bool ReadBytes(size_t size, std::vector<uint8_t>* value) {
+    if (size > size_ - pos_) {
+      return false;
+    }
+    value->assign(data_ + pos_, data_ + pos_ + size);
+    pos_ += size;
+    return true;
+  }
+
+  bool at_end() const { return pos_ == size_; }
+
+ private:
+  const uint8_t* data_;
+  size_t size_;
+  size_t pos_ = 0;
+};
+
+}  // namespace util
@@ -0,0 +1,237 @@
+#include "browser_arguments.h"
+
+#include <algorithm>
+
+namespace util {
+
+namespace {
+
+constexpr std::string_view kEnableFeatures = "enable-features";
+constexpr std::string_view kDisableFeatures = "disable-features";
+
+bool IsWhitespace(char c) {
+  return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+std::optional<std::vector<std::string>> Tokenize(std::string_view input) {
+  std::vector<std::string> tokens;
+  std::string token;
+  bool in_token = false;
+  bool quoted = false;
+  for (const auto c : input) {
+    if (c == '"') {
+      quoted = !quoted;
+      in_token = true;
+    } else if (IsWhitespace(c) && !quoted) {
+      if (in_token) {
+        tokens.push_back(std::move(token));
+        token.clear();
+        in_token = false;
+      }
+    } else {
+      token.push_back(c);
+      in_token = true;
+    }
+  }
+  if (quoted) {
+    return std::nullopt;
+  }
+  if (in_token) {
+    tokens.push_back(std::move(token));
+  }
+  return tokens;
+}
+
+std::vector<std::string> SplitFeatures(std::string_view list) {
+  std::vector<std::string> features;
+  size_t start = 0;
+  while (start <= list.size()) {
+    const auto end = std::min(list.find(',', start), list.size());
+    if (end > start) {
+      features.emplace_back(list.substr(start, end - start));
+    }
+    start = end + 1;
+  }
+  return features;
+}
+
+std::string JoinFeatures(const std::vector<std::string>& features) {
+  std::string list;
+  for (const auto& feature : features) {
+    if (!list.empty()) {
+      list.push_back(',');
+    }
+    list += feature;
+  }
+  return list;
+}
+
+void AppendArgument(std::string* out, std::string_view name,
+                    const std::optional<std::string>& value) {
+  if (!out->empty()) {
+    out->push_back(' ');
+  }
+  *out += "--";
+  *out += name;
+  if (value) {
+    out->push_back('=');
+    const bool quote =
+        std::any_of(value->begin(), value->end(), IsWhitespace);
+    if (quote) {
+      out->push_back('"');
+    }
+    *out += *value;
+    if (quote) {
+      out->push_back('"');
+    }
+  }
+}
+
+}  // namespace
+
+// static
+std::optional<BrowserArguments> BrowserArguments::Parse(
+    std::string_view command_line) {
+  const auto tokens = Tokenize(command_line);
+  if (!tokens) {
+    return std::nullopt;
+  }
+
+  BrowserArguments arguments;
+  for (const auto& token : *tokens) {
+    std::string_view argument = token;
+    if (argument.substr(0, 2) == "--") {
+      argument.remove_prefix(2);
+    } else if (argument.substr(0, 1) == "-") {
+      argument.remove_prefix(1);
+    } else {
+      return std::nullopt;
+    }
+
+    const auto separator = argument.find('=');
+    const auto name = argument.substr(0, separator);
+    if (name.empty()) {
+      return std::nullopt;
+    }
+    std::optional<std::string> value;
+    if (separator != std::string_view::npos) {
+      value = std::string(argument.substr(separator + 1));
+    }
+    arguments.SetSwitch(name, std::move(value));
+  }
+  return arguments;
+}
+
+// static
+BrowserArguments BrowserArguments::ForProfile(PerformanceProfile profile) {
+  BrowserArguments arguments;
+  switch (profile) {
+    case PerformanceProfile::kLowMemory:
+      arguments.SetSwitch("renderer-process-limit", "2");
+      arguments.SetSwitch("disk-cache-size", "33554432");
+      arguments.SetSwitch("enable-low-end-device-mode");
+      arguments.DisableFeature("BackForwardCache");
+      break;
+    case PerformanceProfile::kBalanced:
+      arguments.SetSwitch("disk-cache-size", "104857600");
+      break;
+    case PerformanceProfile::kMaxThroughput:
+      arguments.SetSwitch("disk-cache-size", "536870912");
+      arguments.SetSwitch("enable-gpu-rasterization");
+      arguments.SetSwitch("enable-zero-copy");
+      // Offscreen webviews must not be throttled as if they were hidden.
+      arguments.SetSwitch("disable-background-timer-throttling");
+      arguments.SetSwitch("disable-renderer-backgrounding");
+      arguments.SetSwitch("disable-backgrounding-occluded-windows");
+      arguments.DisableFeature("CalculateNativeWinOcclusion");
+      break;
+  }
+  return arguments;
+}
+
+void BrowserArguments::Merge(const BrowserArguments& overrides) {
+  for (const auto& [name, value] : overrides.switches_) {
+    SetSwitch(name, value);
+  }
+  for (const auto& feature : overrides.enabled_features_) {
+    EnableFeature(feature);
+  }
+  for (const auto& feature : overrides.disabled_features_) {
+    DisableFeature(feature);
+  }
+}
+
+bool BrowserArguments::HasSwitch(std::string_view name) const {
+  return std::any_of(switches_.begin(), switches_.end(),
+                     [&](const auto& s) { return s.first == name; });
+}
+
+std::optional<std::string> BrowserArguments::GetSwitchValue(
+    std::string_view name) const {
+  for (const auto& [switch_name, value] : switches_) {
+    if (switch_name == name) {
+      return value;
+    }
+  }
+  return std::nullopt;
+}
+
+void BrowserArguments::SetSwitch(std::string_view name,
+                                 std::optional<std::string> value) {
+  if (name == kEnableFeatures || name == kDisableFeatures) {
+    for (const auto& feature : SplitFeatures(value.value_or(""))) {
+      if (name == kEnableFeatures) {
+        EnableFeature(feature);
+      } else {
+        DisableFeature(feature);
+      }
+    }
+    return;
+  }
+
+  const auto it =
+      std::find_if(switches_.begin(), switches_.end(),
+                   [&](const auto& s) { return s.first == name; });
+  if (it != switches_.end()) {
+    it->second = std::move(value);
+  } else {
+    switches_.emplace_back(std::string(name), std::move(value));
+  }
+}
+
+std::string BrowserArguments::ToString() const {
+  std::string result;
+  for (const auto& [name, value] : switches_) {
+    AppendArgument(&result, name, value);
+  }
+  if (!enabled_features_.empty()) {
+    AppendArgument(&result, kEnableFeatures, JoinFeatures(enabled_features_));
+  }
+  if (!disabled_features_.empty()) {
+    AppendArgument(&result, kDisableFeatures,
+                   JoinFeatures(disabled_features_));
+  }
+  return result;
+}
+
+void BrowserArguments::EnableFeature(const std::string& feature) {
+  disabled_features_.erase(std::remove(disabled_features_.begin(),
+                                       disabled_features_.end(), feature),
+                           disabled_features_.end());
+  if (std::find(enabled_features_.begin(), enabled_features_.end(),
+                feature) == enabled_features_.end()) {
+    enabled_features_.push_back(feature);
+  }
+}
+
+void BrowserArguments::DisableFeature(const std::string& feature) {
+  enabled_features_.erase(std::remove(enabled_features_.begin(),
+                                      enabled_features_.end(), feature),
+                          enabled_features_.end());
+  if (std::find(disabled_features_.begin(), disabled_features_.end(),
+                feature) == disabled_features_.end()) {
+    disabled_features_.push_back(feature);
+  }
+}
+
+}  // namespace util
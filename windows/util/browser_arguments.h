@@ -0,0 +1,57 @@
+#pragma once
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace util {
+
+// Predefined sets of browser arguments trading memory for throughput.
+enum class PerformanceProfile { kLowMemory, kBalanced, kMaxThroughput };
+
+// A parsed set of Chromium command line switches.
+class BrowserArguments {
+ public:
+  // Splits |command_line| at whitespace outside of double quotes. Returns
+  // std::nullopt for unbalanced quotes or arguments that aren't switches.
+  static std::optional<BrowserArguments> Parse(std::string_view command_line);
+
+  static BrowserArguments ForProfile(PerformanceProfile profile);
+
+  // Applies |overrides| on top of these arguments: switches present in both
+  // take the value from |overrides|. The feature lists (--enable-features
+  // and --disable-features) are united instead, with |overrides| deciding
+  // about features listed on both sides.
+  void Merge(const BrowserArguments& overrides);
+
+  bool HasSwitch(std::string_view name) const;
+  std::optional<std::string> GetSwitchValue(std::string_view name) const;
+  // Passing no value adds a plain flag.
+  void SetSwitch(std::string_view name,
+                 std::optional<std::string> value = std::nullopt);
+
+  const std::vector<std::string>& enabled_features() const {
+    return enabled_features_;
+  }
+  const std::vector<std::string>& disabled_features() const {
+    return disabled_features_;
+  }
+
+  // Serializes the arguments, quoting values containing whitespace.
+  std::string ToString() const;
+
+ private:
+  typedef std::pair<std::string, std::optional<std::string>> Switch;
+
+  // In insertion order, without the feature lists.
+  std::vector<Switch> switches_;
+  std::vector<std::string> enabled_features_;
+  std::vector<std::string> disabled_features_;
+
+  void EnableFeature(const std::string& feature);
+  void DisableFeature(const std::string& feature);
+};
+
+}  // namespace util
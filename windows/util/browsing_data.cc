@@ -0,0 +1,78 @@
+#include "browsing_data.h"
+
+#include <algorithm>
+
+#include "url_origin.h"
+
+namespace util {
+
+namespace {
+
+struct StorageType {
+  uint32_t kinds;
+  const char* name;
+};
+
+// Maps browsing data kinds to DevTools protocol storage types.
+constexpr StorageType kStorageTypes[] = {
+    {kBrowsingDataFileSystems | kBrowsingDataAllDomStorage, "file_systems"},
+    {kBrowsingDataIndexedDb | kBrowsingDataAllDomStorage, "indexeddb"},
+    {kBrowsingDataLocalStorage | kBrowsingDataAllDomStorage, "local_storage"},
+    {kBrowsingDataWebSql | kBrowsingDataAllDomStorage, "websql"},
+    {kBrowsingDataCacheStorage | kBrowsingDataAllDomStorage, "cache_storage"},
+    {kBrowsingDataServiceWorkers | kBrowsingDataAllDomStorage,
+     "service_workers"},
+    {kBrowsingDataCookies, "cookies"},
+};
+
+}  // namespace
+
+std::string GetOriginStorageTypes(uint32_t kinds) {
+  if (kinds & kBrowsingDataAllSite) {
+    return "all";
+  }
+
+  std::string types;
+  for (const auto& type : kStorageTypes) {
+    if (kinds & type.kinds) {
+      if (!types.empty()) {
+        types.push_back(',');
+      }
+      types.append(type.name);
+    }
+  }
+  return types;
+}
+
+std::optional<std::vector<ClearBrowsingDataStep>> PlanClearBrowsingData(
+    uint32_t kinds, const std::vector<std::string>& origins) {
+  if (kinds == 0 || (kinds & ~kBrowsingDataAllKinds)) {
+    return std::nullopt;
+  }
+
+  std::vector<ClearBrowsingDataStep> steps;
+  if (origins.empty()) {
+    steps.push_back({std::nullopt, kinds});
+    return steps;
+  }
+
+  if (kinds & ~kBrowsingDataOriginKinds) {
+    return std::nullopt;
+  }
+
+  for (const auto& url : origins) {
+    auto origin = NormalizeOrigin(url);
+    if (!origin) {
+      return std::nullopt;
+    }
+    const bool is_duplicate = std::any_of(
+        steps.begin(), steps.end(),
+        [&origin](const auto& step) { return step.origin == origin; });
+    if (!is_duplicate) {
+      steps.push_back({std::move(origin), kinds});
+    }
+  }
+  return steps;
+}
+
+}  // namespace util
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace util {
+
+// Kinds of browsing data. The values match COREWEBVIEW2_BROWSING_DATA_KINDS.
+enum BrowsingDataKind : uint32_t {
+  kBrowsingDataFileSystems = 1 << 0,
+  kBrowsingDataIndexedDb = 1 << 1,
+  kBrowsingDataLocalStorage = 1 << 2,
+  kBrowsingDataWebSql = 1 << 3,
+  kBrowsingDataCacheStorage = 1 << 4,
+  kBrowsingDataAllDomStorage = 1 << 5,
+  kBrowsingDataCookies = 1 << 6,
+  kBrowsingDataAllSite = 1 << 7,
+  kBrowsingDataDiskCache = 1 << 8,
+  kBrowsingDataDownloadHistory = 1 << 9,
+  kBrowsingDataGeneralAutofill = 1 << 10,
+  kBrowsingDataPasswordAutosave = 1 << 11,
+  kBrowsingDataBrowsingHistory = 1 << 12,
+  kBrowsingDataSettings = 1 << 13,
+  kBrowsingDataAllProfile = 1 << 14,
+  kBrowsingDataServiceWorkers = 1 << 15,
+};
+
+// The kinds which can be cleared for individual origins. All other kinds
+// (e.g. the disk cache) are shared across origins.
+constexpr uint32_t kBrowsingDataOriginKinds =
+    kBrowsingDataFileSystems | kBrowsingDataIndexedDb |
+    kBrowsingDataLocalStorage | kBrowsingDataWebSql |
+    kBrowsingDataCacheStorage | kBrowsingDataAllDomStorage |
+    kBrowsingDataCookies | kBrowsingDataAllSite | kBrowsingDataServiceWorkers;
+
+constexpr uint32_t kBrowsingDataAllKinds = (1 << 16) - 1;
+
+// A single step of clearing browsing data.
+struct ClearBrowsingDataStep {
+  // The origin to clear, or std::nullopt to clear the entire profile.
+  std::optional<std::string> origin;
+  uint32_t kinds = 0;
+};
+
+// Returns the storage types for the DevTools protocol's
+// Storage.clearDataForOrigin, e.g. "cookies,local_storage".
+std::string GetOriginStorageTypes(uint32_t kinds);
+
+// Splits a request into steps. Without origins, the whole profile is
+// cleared in a single step. Otherwise, there is one step per (distinct)
+// origin (see NormalizeOrigin). Returns std::nullopt if the request is
+// invalid, i.e. contains unknown kinds, kinds which can't be cleared per
+// origin, or malformed origins.
+std::optional<std::vector<ClearBrowsingDataStep>> PlanClearBrowsingData(
+    uint32_t kinds, const std::vector<std::string>& origins);
+
+}  // namespace util
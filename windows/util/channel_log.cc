@@ -0,0 +1,320 @@
+#include "channel_log.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace util {
+
+namespace {
+
+constexpr uint8_t kMagic[] = {'W', 'V', 'C', 'L'};
+// Version 2 added results.
+constexpr uint8_t kVersion = 2;
+
+// Records are written once this much has been buffered.
+constexpr size_t kFlushThreshold = 64 * 1024;
+
+// Bounds the recursion on corrupt messages.
+constexpr int kMaxNestingDepth = 64;
+
+// The type tags of flutter::StandardMessageCodec.
+enum class StandardType : uint8_t {
+  kNull = 0,
+  kTrue = 1,
+  kFalse = 2,
+  kInt32 = 3,
+  kInt64 = 4,
+  kLargeInt = 5,
+  kFloat64 = 6,
+  kString = 7,
+  kUInt8List = 8,
+  kInt32List = 9,
+  kInt64List = 10,
+  kFloat64List = 11,
+  kList = 12,
+  kMap = 13,
+  kFloat32List = 14,
+};
+
+class StandardMessageRedactor {
+ public:
+  explicit StandardMessageRedactor(std::vector<uint8_t>* message)
+      : data_(message->data()), size_(message->size()) {}
+
+  bool Redact() { return RedactValue(false, 0) && pos_ == size_; }
+
+ private:
+  uint8_t* data_;
+  size_t size_;
+  size_t pos_ = 0;
+
+  bool Skip(size_t count) {
+    if (count > size_ - pos_) {
+      return false;
+    }
+    pos_ += count;
+    return true;
+  }
+
+  // Elements of typed lists and doubles are aligned relative to the start
+  // of the message.
+  bool Align(size_t alignment) {
+    const size_t mod = pos_ % alignment;
+    return mod == 0 || Skip(alignment - mod);
+  }
+
+  bool ReadSize(size_t* size) {
+    if (pos_ >= size_) {
+      return false;
+    }
+    const uint8_t byte = data_[pos_++];
+    if (byte < 254) {
+      *size = byte;
+      return true;
+    }
+    // Larger sizes follow as uint16 or uint32.
+    const size_t length = byte == 254 ? 2 : 4;
+    if (length > size_ - pos_) {
+      return false;
+    }
+    *size = 0;
+    for (size_t i = 0; i < length; i++) {
+      *size |= static_cast<size_t>(data_[pos_++]) << (i * 8);
+    }
+    return true;
+  }
+
+  // Overwrites |count| bytes with |mask| unless |is_key| is set.
+  bool Mask(size_t count, uint8_t mask, bool is_key) {
+    if (count > size_ - pos_) {
+      return false;
+    }
+    if (!is_key) {
+      std::fill_n(data_ + pos_, count, mask);
+    }
+    pos_ += count;
+    return true;
+  }
+
+  bool RedactValue(bool is_key, int depth) {
+    if (pos_ >= size_ || depth > kMaxNestingDepth) {
+      return false;
+    }
+
+    size_t size;
+    switch (static_cast<StandardType>(data_[pos_++])) {
+      case StandardType::kNull:
+      case StandardType::kTrue:
+      case StandardType::kFalse:
+        return true;
+      case StandardType::kInt32:
+        return Skip(4);
+      case StandardType::kInt64:
+        return Skip(8);
+      case StandardType::kLargeInt:
+        return ReadSize(&size) && Skip(size);
+      case StandardType::kFloat64:
+        return Align(8) && Skip(8);
+      case StandardType::kString:
+        return ReadSize(&size) && Mask(size, '*', is_key);
+      case StandardType::kUInt8List:
+        return ReadSize(&size) && Mask(size, 0, is_key);
+      case StandardType::kInt32List:
+      case StandardType::kFloat32List:
+        return ReadSize(&size) && Align(4) && size <= size_ / 4 &&
+               Skip(size * 4);
+      case StandardType::kInt64List:
+      case StandardType::kFloat64List:
+        return ReadSize(&size) && Align(8) && size <= size_ / 8 &&
+               Skip(size * 8);
+      case StandardType::kList:
+        if (!ReadSize(&size)) {
+          return false;
+        }
+        for (size_t i = 0; i < size; i++) {
+          if (!RedactValue(false, depth + 1)) {
+            return false;
+          }
+        }
+        return true;
+      case StandardType::kMap:
+        if (!ReadSize(&size)) {
+          return false;
+        }
+        for (size_t i = 0; i < size; i++) {
+          if (!RedactValue(true, depth + 1) ||
+              !RedactValue(false, depth + 1)) {
+            return false;
+          }
+        }
+        return true;
+      default:
+        // Custom types can't be skipped.
+        return false;
+    }
+  }
+};
+
+}  // namespace
+
+ChannelRecorder::ChannelRecorder(std::unique_ptr<std::ostream> out,
+                                 bool redact, Clock::time_point start)
+    : out_(std::move(out)), redact_(redact), start_(start) {
+  for (const auto byte : kMagic) {
+    writer_.WriteByte(byte);
+  }
+  writer_.WriteByte(kVersion);
+}
+
+ChannelRecorder::~ChannelRecorder() { Flush(); }
+
+size_t ChannelRecorder::Record(ChannelRecord::Kind kind, int64_t texture_id,
+                               std::string_view name,
+                               std::vector<uint8_t> payload,
+                               Clock::time_point time) {
+  return Write(kind, texture_id, name, 0, std::move(payload), time);
+}
+
+void ChannelRecorder::RecordResult(size_t call, std::string_view name,
+                                   std::vector<uint8_t> payload,
+                                   Clock::time_point time) {
+  Write(ChannelRecord::Kind::kResult, kPluginChannel, name, call,
+        std::move(payload), time);
+}
+
+size_t ChannelRecorder::Write(ChannelRecord::Kind kind, int64_t texture_id,
+                              std::string_view name, size_t call,
+                              std::vector<uint8_t> payload,
+                              Clock::time_point time) {
+  auto payload_state = ChannelRecord::Payload::kComplete;
+  if (redact_ && !payload.empty()) {
+    payload_state = RedactStandardMessage(&payload)
+                        ? ChannelRecord::Payload::kRedacted
+                        : ChannelRecord::Payload::kDropped;
+  }
+
+  // Records are expected in order; anything else is stored without delay.
+  const auto offset =
+      std::chrono::duration_cast<std::chrono::microseconds>(time - start_);
+  const auto delta = std::max(offset - last_time_,
+                              std::chrono::microseconds::zero());
+  last_time_ += delta;
+
+  writer_.WriteByte(static_cast<uint8_t>(kind) |
+                    static_cast<uint8_t>(payload_state) << 4);
+  writer_.WriteVarint(static_cast<uint64_t>(delta.count()));
+  writer_.WriteSigned(texture_id);
+
+  // A reference equal to the number of known names introduces a new one.
+  const auto [it, inserted] = names_.try_emplace(std::string(name),
+                                                 names_.size());
+  writer_.WriteVarint(it->second);
+  if (inserted) {
+    writer_.WriteString(name);
+  }
+  if (kind == ChannelRecord::Kind::kResult) {
+    writer_.WriteVarint(call);
+  }
+
+  writer_.WriteVarint(payload.size());
+  if (payload_state != ChannelRecord::Payload::kDropped) {
+    writer_.WriteBytes(payload.data(), payload.size());
+  }
+
+  if (writer_.buffer().size() >= kFlushThreshold) {
+    Flush();
+  }
+  return record_count_++;
+}
+
+bool ChannelRecorder::Flush() {
+  if (!out_ || !*out_) {
+    return false;
+  }
+  const auto& buffer = writer_.buffer();
+  out_->write(reinterpret_cast<const char*>(buffer.data()), buffer.size());
+  out_->flush();
+  writer_.Clear();
+  return static_cast<bool>(*out_);
+}
+
+bool ReadChannelLog(const uint8_t* data, size_t size,
+                    std::vector<ChannelRecord>* records) {
+  BinaryReader reader(data, size);
+  for (const auto expected : kMagic) {
+    uint8_t byte;
+    if (!reader.ReadByte(&byte) || byte != expected) {
+      return false;
+    }
+  }
+  uint8_t version;
+  if (!reader.ReadByte(&version) || version != kVersion) {
+    return false;
+  }
+
+  std::vector<std::string> names;
+  std::vector<ChannelRecord> result;
+  auto time = std::chrono::microseconds::zero();
+  while (!reader.at_end()) {
+    ChannelRecord record;
+    uint8_t tag;
+    uint64_t delta, name_index, payload_size;
+    // Failing reads mean the log has been cut off.
+    if (!reader.ReadByte(&tag) || !reader.ReadVarint(&delta) ||
+        !reader.ReadSigned(&record.texture_id) ||
+        !reader.ReadVarint(&name_index)) {
+      break;
+    }
+
+    const uint8_t kind = tag & 0x0F;
+    const uint8_t payload_state = tag >> 4;
+    if (kind > static_cast<uint8_t>(ChannelRecord::Kind::kResult) ||
+        payload_state >
+            static_cast<uint8_t>(ChannelRecord::Payload::kDropped) ||
+        name_index > names.size()) {
+      return false;
+    }
+    record.kind = static_cast<ChannelRecord::Kind>(kind);
+    record.payload_state = static_cast<ChannelRecord::Payload>(payload_state);
+
+    if (name_index == names.size()) {
+      std::string name;
+      if (!reader.ReadString(&name)) {
+        break;
+      }
+      names.push_back(std::move(name));
+    }
+    record.name = names[name_index];
+
+    if (record.kind == ChannelRecord::Kind::kResult) {
+      if (!reader.ReadVarint(&record.call)) {
+        break;
+      }
+      // Results follow their call.
+      if (record.call >= result.size() ||
+          result[record.call].kind != ChannelRecord::Kind::kMethodCall) {
+        return false;
+      }
+    }
+
+    if (!reader.ReadVarint(&payload_size) ||
+        (record.payload_state != ChannelRecord::Payload::kDropped &&
+         !reader.ReadBytes(payload_size, &record.payload))) {
+      break;
+    }
+    record.payload_size = payload_size;
+
+    time += std::chrono::microseconds(delta);
+    record.time = time;
+    result.push_back(std::move(record));
+  }
+
+  *records = std::move(result);
+  return true;
+}
+
+bool RedactStandardMessage(std::vector<uint8_t>* message) {
+  return StandardMessageRedactor(message).Redact();
+}
+
+}  // namespace util
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "binary_stream.h"
+
+namespace util {
+
+// A message which crossed one of the plugin's channels.
+struct ChannelRecord {
+  enum class Kind : uint8_t {
+    // A method call from Dart.
+    kMethodCall = 0,
+    // An event sent to Dart.
+    kEvent = 1,
+    // The result of a method call which created instances, recorded so
+    // that replays can tell which instance is which.
+    kResult = 2,
+  };
+  enum class Payload : uint8_t {
+    kComplete = 0,
+    // Strings and byte buffers have been masked (see
+    // RedactStandardMessage). The layout is unchanged.
+    kRedacted = 1,
+    // The payload couldn't be redacted and has been left out.
+    kDropped = 2,
+  };
+
+  Kind kind = Kind::kMethodCall;
+  // Relative to the start of the recording.
+  std::chrono::microseconds time = std::chrono::microseconds::zero();
+  // The instance, or kPluginChannel.
+  int64_t texture_id = 0;
+  // The method name, or the event type.
+  std::string name;
+  // For results, the index of the call's record in the log.
+  uint64_t call = 0;
+  // The arguments, the event or the result, encoded by
+  // flutter::StandardMessageCodec.
+  std::vector<uint8_t> payload;
+  Payload payload_state = Payload::kComplete;
+  // The size of the original payload, also for dropped ones.
+  uint64_t payload_size = 0;
+};
+
+// The texture id of records of the io.jns.webview.win channel.
+constexpr int64_t kPluginChannel = -1;
+
+// Writes channel traffic to |out| in a compact binary format: a magic
+// number and a version followed by one entry per record. Timestamps are
+// stored as deltas, and names are sent once and referenced by index
+// afterwards.
+//
+// Not thread-safe; all records are expected on the platform thread.
+class ChannelRecorder {
+ public:
+  typedef std::chrono::steady_clock Clock;
+
+  // If |redact| is set, payloads are passed through RedactStandardMessage.
+  ChannelRecorder(std::unique_ptr<std::ostream> out, bool redact,
+                  Clock::time_point start = Clock::now());
+  ~ChannelRecorder();
+
+  ChannelRecorder(const ChannelRecorder&) = delete;
+  ChannelRecorder& operator=(const ChannelRecorder&) = delete;
+
+  // Returns the index of the record in the log.
+  size_t Record(ChannelRecord::Kind kind, int64_t texture_id,
+                std::string_view name, std::vector<uint8_t> payload,
+                Clock::time_point time = Clock::now());
+
+  // Records the result of the call recorded at index |call|.
+  void RecordResult(size_t call, std::string_view name,
+                    std::vector<uint8_t> payload,
+                    Clock::time_point time = Clock::now());
+
+  // Writes buffered records. Returns false once writing has failed.
+  bool Flush();
+
+  size_t record_count() const { return record_count_; }
+
+ private:
+  std::unique_ptr<std::ostream> out_;
+  bool redact_;
+  Clock::time_point start_;
+  std::chrono::microseconds last_time_ = std::chrono::microseconds::zero();
+  std::unordered_map<std::string, uint64_t> names_;
+  BinaryWriter writer_;
+  size_t record_count_ = 0;
+
+  size_t Write(ChannelRecord::Kind kind, int64_t texture_id,
+               std::string_view name, size_t call,
+               std::vector<uint8_t> payload, Clock::time_point time);
+};
+
+// Decodes a log written by ChannelRecorder. A log cut off in the middle of
+// a record (e.g. because the app crashed) yields the complete records.
+// Returns false if |data| is malformed or of an unknown version.
+bool ReadChannelLog(const uint8_t* data, size_t size,
+                    std::vector<ChannelRecord>* records);
+
+// Masks the contents of all strings (except map keys, which typically name
+// arguments) and byte buffers in a message encoded by
+// flutter::StandardMessageCodec, keeping their lengths. Numbers and the
+// structure are kept, so that handlers take the same paths on replay.
+// Returns false if |message| can't be parsed, e.g. because it contains
+// custom types.
+bool RedactStandardMessage(std::vector<uint8_t>* message);
+
+}  // namespace util
@@ -0,0 +1,61 @@
+#include "channel_replayer.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace util {
+
+ChannelReplayer::ChannelReplayer(std::vector<ChannelRecord> records,
+                                 double speed, Dispatcher dispatcher)
+    : records_(std::move(records)),
+      speed_(speed),
+      dispatcher_(std::move(dispatcher)) {}
+
+void ChannelReplayer::Start(Clock::time_point now) {
+  start_ = now;
+  position_ = 0;
+  max_lag_ = Clock::duration::zero();
+}
+
+std::optional<ChannelReplayer::Clock::time_point> ChannelReplayer::Run(
+    Clock::time_point now) {
+  while (!done()) {
+    const auto& record = records_[position_];
+    const auto due = DueTime(record);
+    if (due > now) {
+      return due;
+    }
+
+    max_lag_ = std::max(max_lag_, now - due);
+    const auto index = position_++;
+    {
+      const TaskMonitor::Scope scope(task_monitor_, TaskNameOf(record));
+      dispatcher_(index, record);
+    }
+  }
+  return std::nullopt;
+}
+
+// static
+std::string ChannelReplayer::TaskNameOf(const ChannelRecord& record) {
+  if (record.kind == ChannelRecord::Kind::kEvent) {
+    return "event." + record.name;
+  }
+  if (record.kind == ChannelRecord::Kind::kResult) {
+    return "result." + record.name;
+  }
+  return (record.texture_id == kPluginChannel ? "plugin." : "webview.") +
+         record.name;
+}
+
+ChannelReplayer::Clock::time_point ChannelReplayer::DueTime(
+    const ChannelRecord& record) const {
+  if (speed_ <= 0) {
+    return start_;
+  }
+  return start_ + std::chrono::duration_cast<Clock::duration>(
+                      std::chrono::duration<double, std::micro>(
+                          record.time.count() / speed_));
+}
+
+}  // namespace util
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "channel_log.h"
+#include "task_monitor.h"
+
+namespace util {
+
+// Feeds recorded channel traffic to a dispatcher, paced by the timestamps
+// of the records. The replayer doesn't wait itself: the owner calls Run()
+// whenever the previous call's deadline has passed, e.g. from a timer.
+class ChannelReplayer {
+ public:
+  typedef std::chrono::steady_clock Clock;
+  // |index| is the position of |record| in the log, as referred to by
+  // ChannelRecord::call.
+  typedef std::function<void(size_t index, const ChannelRecord& record)>
+      Dispatcher;
+
+  // |speed| scales the pace: 1 replays at the original pace, 4 four times
+  // as fast. A speed of 0 dispatches all records without delay.
+  ChannelReplayer(std::vector<ChannelRecord> records, double speed,
+                  Dispatcher dispatcher);
+
+  // Dispatches are timed by |monitor| if set, under the same names the
+  // plugin uses for live traffic (see TaskNameOf).
+  void SetTaskMonitor(TaskMonitor* monitor) { task_monitor_ = monitor; }
+
+  void Start(Clock::time_point now = Clock::now());
+
+  // Dispatches all records due at |now|. Returns the time the next record
+  // is due, or std::nullopt once all have been dispatched.
+  std::optional<Clock::time_point> Run(Clock::time_point now = Clock::now());
+
+  bool done() const { return position_ == records_.size(); }
+  size_t dispatched() const { return position_; }
+  size_t record_count() const { return records_.size(); }
+
+  // The largest delay between the time a record was due and the time it
+  // was dispatched. Grows if dispatching can't keep up with the pace.
+  Clock::duration max_lag() const { return max_lag_; }
+
+  // "plugin.<method>", "webview.<method>", "event.<type>" or
+  // "result.<method>".
+  static std::string TaskNameOf(const ChannelRecord& record);
+
+ private:
+  std::vector<ChannelRecord> records_;
+  double speed_;
+  Dispatcher dispatcher_;
+  TaskMonitor* task_monitor_ = nullptr;
+  Clock::time_point start_;
+  size_t position_ = 0;
+  Clock::duration max_lag_ = Clock::duration::zero();
+
+  Clock::time_point DueTime(const ChannelRecord& record) const;
+};
+
+}  // namespace util
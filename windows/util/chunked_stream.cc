@@ -0,0 +1,125 @@
+#include "chunked_stream.h"
+
+#include <wrl.h>
+
+#include <atomic>
+
+namespace util {
+
+namespace {
+
+using namespace Microsoft::WRL;
+
+// Upper bound for waiting on the producer before a read fails.
+constexpr std::chrono::milliseconds kReadTimeout{30000};
+
+class ChunkedStream
+    : public RuntimeClass<RuntimeClassFlags<ClassicCom>,
+                          ChainInterfaces<IStream, ISequentialStream>,
+                          FtmBase> {
+ public:
+  explicit ChunkedStream(std::shared_ptr<ChunkedStreamBuffer> buffer)
+      : buffer_(std::move(buffer)), producer_thread_(GetCurrentThreadId()) {}
+
+  // ISequentialStream
+  STDMETHODIMP Read(void* buffer, ULONG size, ULONG* read) override {
+    const auto timeout = GetCurrentThreadId() == producer_thread_
+                             ? std::chrono::milliseconds(0)
+                             : kReadTimeout;
+    size_t count = 0;
+    const auto status = buffer_->Read(static_cast<uint8_t*>(buffer), size,
+                                      &count, timeout);
+    position_ += count;
+    if (read) {
+      *read = static_cast<ULONG>(count);
+    }
+
+    switch (status) {
+      case ChunkedStreamBuffer::Status::kOk:
+        return S_OK;
+      case ChunkedStreamBuffer::Status::kEndOfStream:
+        return S_FALSE;
+      case ChunkedStreamBuffer::Status::kTimedOut:
+        // Hand out what we've got; the next read waits again.
+        if (count > 0) {
+          return S_OK;
+        }
+        return timeout.count() == 0 ? E_PENDING : STG_E_READFAULT;
+      case ChunkedStreamBuffer::Status::kCancelled:
+      default:
+        return E_ABORT;
+    }
+  }
+
+  STDMETHODIMP Write(const void*, ULONG, ULONG*) override {
+    return STG_E_ACCESSDENIED;
+  }
+
+  // IStream
+  // The stream is forward-only, so seeking is limited to querying the
+  // current position.
+  STDMETHODIMP Seek(LARGE_INTEGER move, DWORD origin,
+                    ULARGE_INTEGER* new_position) override {
+    const uint64_t position = position_;
+    if (!((origin == STREAM_SEEK_CUR && move.QuadPart == 0) ||
+          (origin == STREAM_SEEK_SET &&
+           static_cast<uint64_t>(move.QuadPart) == position))) {
+      return STG_E_INVALIDFUNCTION;
+    }
+    if (new_position) {
+      new_position->QuadPart = position;
+    }
+    return S_OK;
+  }
+
+  STDMETHODIMP SetSize(ULARGE_INTEGER) override { return STG_E_ACCESSDENIED; }
+
+  STDMETHODIMP CopyTo(IStream*, ULARGE_INTEGER, ULARGE_INTEGER*,
+                      ULARGE_INTEGER*) override {
+    return E_NOTIMPL;
+  }
+
+  STDMETHODIMP Commit(DWORD) override { return S_OK; }
+
+  STDMETHODIMP Revert() override { return E_NOTIMPL; }
+
+  STDMETHODIMP LockRegion(ULARGE_INTEGER, ULARGE_INTEGER, DWORD) override {
+    return STG_E_INVALIDFUNCTION;
+  }
+
+  STDMETHODIMP UnlockRegion(ULARGE_INTEGER, ULARGE_INTEGER, DWORD) override {
+    return STG_E_INVALIDFUNCTION;
+  }
+
+  // The size is only known once the producer has closed the buffer.
+  STDMETHODIMP Stat(STATSTG* stat, DWORD) override {
+    if (!stat) {
+      return STG_E_INVALIDPOINTER;
+    }
+    *stat = {};
+    stat->type = STGTY_STREAM;
+    stat->grfMode = STGM_READ;
+    if (buffer_->is_closed()) {
+      stat->cbSize.QuadPart = buffer_->total_size();
+    }
+    return S_OK;
+  }
+
+  STDMETHODIMP Clone(IStream**) override { return E_NOTIMPL; }
+
+ private:
+  const std::shared_ptr<ChunkedStreamBuffer> buffer_;
+  const DWORD producer_thread_;
+  std::atomic<uint64_t> position_ = 0;
+};
+
+}  // namespace
+
+wil::com_ptr<IStream> CreateChunkedStream(
+    std::shared_ptr<ChunkedStreamBuffer> buffer) {
+  wil::com_ptr<IStream> stream;
+  stream.attach(Make<ChunkedStream>(std::move(buffer)).Detach());
+  return stream;
+}
+
+}  // namespace util
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <objidl.h>
+#include <wil/com.h>
+
+#include <memory>
+
+#include "chunked_stream_buffer.h"
+
+namespace util {
+
+// Creates a read-only, free-threaded IStream reading from |buffer|.
+//
+// Reads block while the buffer is empty, except on the thread creating the
+// stream: that thread feeds the buffer, so reads on it fail with E_PENDING
+// instead of waiting for data that could never arrive.
+wil::com_ptr<IStream> CreateChunkedStream(
+    std::shared_ptr<ChunkedStreamBuffer> buffer);
+
+}  // namespace util
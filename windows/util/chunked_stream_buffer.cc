@@ -0,0 +1,134 @@
+#include "chunked_stream_buffer.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace util {
+
+ChunkedStreamBuffer::ChunkedStreamBuffer(size_t capacity)
+    : capacity_(std::max<size_t>(capacity, 1)) {}
+
+bool ChunkedStreamBuffer::Append(std::vector<uint8_t> chunk) {
+  {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    if (closed_ || cancelled_) {
+      return false;
+    }
+    if (chunk.empty()) {
+      return true;
+    }
+    buffered_ += chunk.size();
+    total_size_ += chunk.size();
+    chunks_.push_back(std::move(chunk));
+  }
+  data_available_.notify_all();
+  return true;
+}
+
+void ChunkedStreamBuffer::WhenWritable(WritableCallback callback) {
+  bool cancelled;
+  {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    if (!cancelled_ && buffered_ >= capacity_) {
+      writable_callbacks_.push_back(std::move(callback));
+      return;
+    }
+    cancelled = cancelled_;
+  }
+  callback(cancelled);
+}
+
+void ChunkedStreamBuffer::Close() {
+  {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    closed_ = true;
+  }
+  data_available_.notify_all();
+}
+
+void ChunkedStreamBuffer::Cancel() {
+  std::vector<WritableCallback> callbacks;
+  {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    cancelled_ = true;
+    chunks_.clear();
+    front_offset_ = 0;
+    buffered_ = 0;
+    callbacks.swap(writable_callbacks_);
+  }
+  data_available_.notify_all();
+  for (const auto& callback : callbacks) {
+    callback(true);
+  }
+}
+
+ChunkedStreamBuffer::Status ChunkedStreamBuffer::Read(
+    uint8_t* buffer, size_t size, size_t* read,
+    std::chrono::milliseconds timeout) {
+  Status status = Status::kOk;
+  size_t count = 0;
+  std::vector<WritableCallback> callbacks;
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (count < size) {
+      if (!data_available_.wait_for(lock, timeout, [this]() {
+            return buffered_ > 0 || closed_ || cancelled_;
+          })) {
+        status = Status::kTimedOut;
+        break;
+      }
+      if (cancelled_) {
+        status = Status::kCancelled;
+        break;
+      }
+      if (buffered_ == 0) {
+        status = Status::kEndOfStream;
+        break;
+      }
+
+      auto& front = chunks_.front();
+      const auto n = std::min(size - count, front.size() - front_offset_);
+      std::memcpy(buffer + count, front.data() + front_offset_, n);
+      count += n;
+      front_offset_ += n;
+      buffered_ -= n;
+      if (front_offset_ == front.size()) {
+        chunks_.pop_front();
+        front_offset_ = 0;
+      }
+    }
+    callbacks = TakeWritableCallbacks();
+  }
+
+  for (const auto& callback : callbacks) {
+    callback(false);
+  }
+  *read = count;
+  return status;
+}
+
+size_t ChunkedStreamBuffer::buffered() const {
+  const std::lock_guard<std::mutex> lock(mutex_);
+  return buffered_;
+}
+
+uint64_t ChunkedStreamBuffer::total_size() const {
+  const std::lock_guard<std::mutex> lock(mutex_);
+  return total_size_;
+}
+
+bool ChunkedStreamBuffer::is_closed() const {
+  const std::lock_guard<std::mutex> lock(mutex_);
+  return closed_;
+}
+
+std::vector<ChunkedStreamBuffer::WritableCallback>
+ChunkedStreamBuffer::TakeWritableCallbacks() {
+  std::vector<WritableCallback> callbacks;
+  if (buffered_ < capacity_) {
+    callbacks.swap(writable_callbacks_);
+  }
+  return callbacks;
+}
+
+}  // namespace util
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+namespace util {
+
+// A bounded byte queue connecting a producer handing over chunks with a
+// consumer reading a continuous stream on another thread. Producers don't
+// block: they append and ask to be called back once there's room again.
+class ChunkedStreamBuffer {
+ public:
+  enum class Status { kOk, kEndOfStream, kCancelled, kTimedOut };
+
+  typedef std::function<void(bool cancelled)> WritableCallback;
+
+  static constexpr size_t kDefaultCapacity = 1024 * 1024;
+
+  explicit ChunkedStreamBuffer(size_t capacity = kDefaultCapacity);
+
+  // Appends |chunk| even if that exceeds the capacity. Returns false if the
+  // buffer has been closed or cancelled.
+  bool Append(std::vector<uint8_t> chunk);
+
+  // Calls |callback| once less than the capacity is buffered, which may be
+  // right away, or when the buffer gets cancelled. The callback may run on
+  // the reading thread.
+  void WhenWritable(WritableCallback callback);
+
+  // Marks the end of the data.
+  void Close();
+
+  // Drops all data. Pending and future reads fail.
+  void Cancel();
+
+  // Reads |size| bytes into |buffer|, waiting up to |timeout| whenever the
+  // buffer runs empty. Fewer bytes are read (see |read|) if the stream ends,
+  // gets cancelled or the wait times out.
+  Status Read(uint8_t* buffer, size_t size, size_t* read,
+              std::chrono::milliseconds timeout);
+
+  size_t buffered() const;
+  // The number of bytes appended in total.
+  uint64_t total_size() const;
+  bool is_closed() const;
+
+ private:
+  const size_t capacity_;
+  mutable std::mutex mutex_;
+  std::condition_variable data_available_;
+  std::deque<std::vector<uint8_t>> chunks_;
+  // Bytes of the front chunk that have been read already.
+  size_t front_offset_ = 0;
+  size_t buffered_ = 0;
+  uint64_t total_size_ = 0;
+  bool closed_ = false;
+  bool cancelled_ = false;
+  std::vector<WritableCallback> writable_callbacks_;
+
+  // Returns the callbacks to run (outside of the lock) if the buffer has
+  // become writable.
+  std::vector<WritableCallback> TakeWritableCallbacks();
+};
+
+}  // namespace util
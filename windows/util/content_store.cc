@@ -0,0 +1,51 @@
+#include "content_store.h"
+
+#include <algorithm>
+
+namespace util {
+
+// static
+bool ContentStore::IsStoreUrl(std::string_view url) {
+  const auto prefix = kUrlFilter.substr(0, kUrlFilter.size() - 1);
+  return url.size() > prefix.size() && url.substr(0, prefix.size()) == prefix;
+}
+
+ContentStore::ContentStore() : random_(std::random_device()()) {}
+
+std::string ContentStore::Add(std::string content) {
+  constexpr char kHexDigits[] = "0123456789abcdef";
+
+  // The filter without its trailing wildcard, followed by 128 random bits.
+  std::string url(kUrlFilter.substr(0, kUrlFilter.size() - 1));
+  for (int i = 0; i < 2; i++) {
+    const auto bits = random_();
+    for (int shift = 60; shift >= 0; shift -= 4) {
+      url.push_back(kHexDigits[(bits >> shift) & 0xF]);
+    }
+  }
+
+  stored_bytes_ += content.size();
+  entries_.emplace_back(
+      url, std::make_shared<const std::string>(std::move(content)));
+  while (entries_.size() > 1 && (entries_.size() > kMaxEntries ||
+                                 stored_bytes_ > kMaxStoredBytes)) {
+    stored_bytes_ -= entries_.front().second->size();
+    entries_.pop_front();
+  }
+  return url;
+}
+
+std::shared_ptr<const std::string> ContentStore::Get(std::string_view url) {
+  const auto it =
+      std::find_if(entries_.begin(), entries_.end(),
+                   [&](const auto& entry) { return entry.first == url; });
+  if (it == entries_.end()) {
+    return nullptr;
+  }
+  auto entry = std::move(*it);
+  entries_.erase(it);
+  entries_.push_back(std::move(entry));
+  return entries_.back().second;
+}
+
+}  // namespace util
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <random>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace util {
+
+// Holds documents too large for NavigateToString and serves them from
+// synthetic URLs. Documents stay available for reloads and back/forward
+// navigations until they are evicted in least recently used order.
+class ContentStore {
+ public:
+  // The filter matching all URLs handed out by Add.
+  static constexpr std::string_view kUrlFilter =
+      "https://webview-content.invalid/*";
+
+  // Documents up to this size (in UTF-8 bytes) are loaded inline.
+  static constexpr size_t kInlineLimit = 512 * 1024;
+
+  // Documents are evicted once more than this many are stored, or once they
+  // take up more than kMaxStoredBytes. The most recent one is always kept.
+  static constexpr size_t kMaxEntries = 8;
+  static constexpr size_t kMaxStoredBytes = 64 * 1024 * 1024;
+
+  static bool ShouldStore(size_t size) { return size > kInlineLimit; }
+
+  // Whether |url| has been handed out by a store (not necessarily this one).
+  static bool IsStoreUrl(std::string_view url);
+
+  ContentStore();
+
+  // Stores |content| and returns the URL to navigate to. The URL contains a
+  // random token, so pages can't guess it.
+  std::string Add(std::string content);
+
+  // Returns the content for |url| and marks it as most recently used, or
+  // nullptr if it has been evicted.
+  std::shared_ptr<const std::string> Get(std::string_view url);
+
+  size_t size() const { return entries_.size(); }
+  size_t stored_bytes() const { return stored_bytes_; }
+
+ private:
+  std::mt19937_64 random_;
+  // (url, content) pairs, least recently used first.
+  std::deque<std::pair<std::string, std::shared_ptr<const std::string>>>
+      entries_;
+  size_t stored_bytes_ = 0;
+};
+
+}  // namespace util
@@ -0,0 +1,54 @@
+#include "cookie.h"
+
+#include <algorithm>
+#include <cctype>
+
+namespace util {
+
+namespace {
+
+std::string_view StripLeadingDot(std::string_view domain) {
+  if (!domain.empty() && domain.front() == '.') {
+    domain.remove_prefix(1);
+  }
+  return domain;
+}
+
+bool EqualsIgnoreCase(std::string_view a, std::string_view b) {
+  return a.size() == b.size() &&
+         std::equal(a.begin(), a.end(), b.begin(), [](char x, char y) {
+           return std::tolower(static_cast<unsigned char>(x)) ==
+                  std::tolower(static_cast<unsigned char>(y));
+         });
+}
+
+}  // namespace
+
+bool DomainMatches(std::string_view cookie_domain, std::string_view domain) {
+  cookie_domain = StripLeadingDot(cookie_domain);
+  domain = StripLeadingDot(domain);
+  if (domain.empty() || cookie_domain.size() < domain.size()) {
+    return false;
+  }
+
+  const auto prefix_length = cookie_domain.size() - domain.size();
+  if (!EqualsIgnoreCase(cookie_domain.substr(prefix_length), domain)) {
+    return false;
+  }
+  return prefix_length == 0 || cookie_domain[prefix_length - 1] == '.';
+}
+
+bool CookieFilter::Matches(const Cookie& cookie) const {
+  if (name && cookie.name != *name) {
+    return false;
+  }
+  if (domain && !DomainMatches(cookie.domain, *domain)) {
+    return false;
+  }
+  if (path && cookie.path != *path) {
+    return false;
+  }
+  return true;
+}
+
+}  // namespace util
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace util {
+
+enum class CookieSameSite { kNone, kLax, kStrict };
+
+struct Cookie {
+  std::string name;
+  std::string value;
+  std::string domain;
+  std::string path = "/";
+  // Seconds since the UNIX epoch. Ignored for session cookies.
+  double expires = -1;
+  bool is_http_only = false;
+  bool is_secure = false;
+  bool is_session = true;
+  CookieSameSite same_site = CookieSameSite::kLax;
+};
+
+// Selects cookies for bulk operations. Unset fields match any cookie.
+struct CookieFilter {
+  // Only matches cookies which would be sent to this URI.
+  std::optional<std::string> uri;
+  std::optional<std::string> name;
+  // Matches cookies of this domain and its subdomains.
+  std::optional<std::string> domain;
+  std::optional<std::string> path;
+
+  bool IsEmpty() const { return !uri && !name && !domain && !path; }
+
+  // Checks all fields except |uri|, which is left to the cookie store.
+  bool Matches(const Cookie& cookie) const;
+};
+
+// Returns whether |cookie_domain| equals |domain| or is a subdomain of it.
+// Leading dots are ignored and the comparison is case-insensitive.
+bool DomainMatches(std::string_view cookie_domain, std::string_view domain);
+
+}  // namespace util
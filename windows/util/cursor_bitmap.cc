@@ -0,0 +1,87 @@
+#include "cursor_bitmap.h"
+
+#include <algorithm>
+
+namespace util {
+
+namespace {
+
+bool GetMaskBit(const CursorBitmaps& bitmaps, uint32_t x, uint32_t y) {
+  const auto byte = bitmaps.mask[y * bitmaps.mask_stride + x / 8];
+  return (byte >> (7 - x % 8)) & 1;
+}
+
+}  // namespace
+
+bool ConvertCursorBitmaps(const CursorBitmaps& bitmaps, CursorImage* image) {
+  const auto width = bitmaps.width;
+  const auto height = bitmaps.height;
+  if (width == 0 || height == 0) {
+    return false;
+  }
+
+  const bool is_monochrome = bitmaps.color.empty();
+  const size_t pixel_count = static_cast<size_t>(width) * height;
+  if (!is_monochrome && bitmaps.color.size() < pixel_count * 4) {
+    return false;
+  }
+
+  const bool has_mask = !bitmaps.mask.empty();
+  const uint32_t mask_rows = is_monochrome ? height * 2 : height;
+  if (has_mask && (bitmaps.mask_stride < (width + 7) / 8 ||
+                   bitmaps.mask.size() <
+                       static_cast<size_t>(bitmaps.mask_stride) * mask_rows)) {
+    return false;
+  }
+  if (is_monochrome && !has_mask) {
+    return false;
+  }
+
+  bool has_alpha = false;
+  if (!is_monochrome) {
+    for (size_t i = 0; i < pixel_count; i++) {
+      if (bitmaps.color[i * 4 + 3] != 0) {
+        has_alpha = true;
+        break;
+      }
+    }
+  }
+
+  image->width = width;
+  image->height = height;
+  image->hotspot_x = std::min(bitmaps.hotspot_x, width - 1);
+  image->hotspot_y = std::min(bitmaps.hotspot_y, height - 1);
+  image->rgba.resize(pixel_count * 4);
+
+  for (uint32_t y = 0; y < height; y++) {
+    for (uint32_t x = 0; x < width; x++) {
+      const size_t i = (static_cast<size_t>(y) * width + x) * 4;
+      auto pixel = &image->rgba[i];
+
+      if (is_monochrome) {
+        const bool and_bit = GetMaskBit(bitmaps, x, y);
+        const bool xor_bit = GetMaskBit(bitmaps, x, y + height);
+        const uint8_t value = !and_bit && xor_bit ? 0xff : 0x00;
+        pixel[0] = pixel[1] = pixel[2] = value;
+        pixel[3] = and_bit && !xor_bit ? 0x00 : 0xff;
+        continue;
+      }
+
+      const auto bgra = &bitmaps.color[i];
+      pixel[0] = bgra[2];
+      pixel[1] = bgra[1];
+      pixel[2] = bgra[0];
+      if (has_alpha) {
+        pixel[3] = bgra[3];
+      } else if (has_mask) {
+        pixel[3] = GetMaskBit(bitmaps, x, y) ? 0x00 : 0xff;
+      } else {
+        pixel[3] = 0xff;
+      }
+    }
+  }
+
+  return true;
+}
+
+}  // namespace util
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace util {
+
+// A cursor image with straight (non-premultiplied) RGBA pixels in row-major
+// order, top row first.
+struct CursorImage {
+  uint32_t width = 0;
+  uint32_t height = 0;
+  uint32_t hotspot_x = 0;
+  uint32_t hotspot_y = 0;
+  std::vector<uint8_t> rgba;
+};
+
+// The raw bitmaps of a cursor, as returned by GetIconInfo/GetDIBits with
+// top-down rows.
+struct CursorBitmaps {
+  uint32_t width = 0;
+  uint32_t height = 0;
+  uint32_t hotspot_x = 0;
+  uint32_t hotspot_y = 0;
+  // 32bpp BGRA pixels of a color cursor with a stride of |width| * 4.
+  // Empty for monochrome cursors.
+  std::vector<uint8_t> color;
+  // 1bpp AND mask, followed by the XOR mask for monochrome cursors (which
+  // makes it 2 * |height| rows high).
+  std::vector<uint8_t> mask;
+  // The number of bytes per mask row (DIB rows are padded to 32 bits).
+  uint32_t mask_stride = 0;
+};
+
+// Returns the stride of a 1bpp DIB of the given width.
+inline uint32_t MaskStride(uint32_t width) { return ((width + 31) / 32) * 4; }
+
+// Converts the bitmaps of a cursor to RGBA.
+//
+// Color cursors carrying an alpha channel are converted as is, otherwise
+// transparency is taken from the AND mask. Monochrome cursors map to black,
+// white and transparent pixels; inverting pixels can't be represented and
+// are drawn black. The hotspot is clamped to the image.
+//
+// Returns false if the bitmaps are inconsistent.
+bool ConvertCursorBitmaps(const CursorBitmaps& bitmaps, CursorImage* image);
+
+}  // namespace util
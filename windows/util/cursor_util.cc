@@ -0,0 +1,76 @@
+#include "cursor_util.h"
+
+#include <wil/resource.h>
+
+namespace util {
+
+namespace {
+
+// A BITMAPINFO with room for the palette of a 1bpp bitmap.
+struct MonochromeBitmapInfo {
+  BITMAPINFOHEADER header;
+  RGBQUAD colors[2];
+};
+
+bool GetBitmapBits(HDC dc, HBITMAP bitmap, uint32_t width, uint32_t height,
+                   WORD bit_count, std::vector<uint8_t>* bits) {
+  MonochromeBitmapInfo info = {};
+  info.header.biSize = sizeof(BITMAPINFOHEADER);
+  info.header.biWidth = static_cast<LONG>(width);
+  // Negative heights request top-down rows.
+  info.header.biHeight = -static_cast<LONG>(height);
+  info.header.biPlanes = 1;
+  info.header.biBitCount = bit_count;
+  info.header.biCompression = BI_RGB;
+
+  const size_t stride =
+      bit_count == 1 ? MaskStride(width) : static_cast<size_t>(width) * 4;
+  bits->resize(stride * height);
+  return GetDIBits(dc, bitmap, 0, height, bits->data(),
+                   reinterpret_cast<BITMAPINFO*>(&info),
+                   DIB_RGB_COLORS) == static_cast<int>(height);
+}
+
+}  // namespace
+
+bool GetCursorImage(HCURSOR cursor, CursorImage* image) {
+  ICONINFO icon_info;
+  if (!cursor || !GetIconInfo(cursor, &icon_info)) {
+    return false;
+  }
+
+  wil::unique_hbitmap color(icon_info.hbmColor);
+  wil::unique_hbitmap mask(icon_info.hbmMask);
+
+  BITMAP mask_bitmap;
+  if (!mask || !GetObject(mask.get(), sizeof(mask_bitmap), &mask_bitmap)) {
+    return false;
+  }
+
+  wil::unique_hdc dc(CreateCompatibleDC(nullptr));
+  if (!dc) {
+    return false;
+  }
+
+  CursorBitmaps bitmaps;
+  bitmaps.width = static_cast<uint32_t>(mask_bitmap.bmWidth);
+  // The mask of monochrome cursors contains both the AND and the XOR mask.
+  const auto mask_height = static_cast<uint32_t>(mask_bitmap.bmHeight);
+  bitmaps.height = color ? mask_height : mask_height / 2;
+  bitmaps.mask_stride = MaskStride(bitmaps.width);
+  bitmaps.hotspot_x = icon_info.xHotspot;
+  bitmaps.hotspot_y = icon_info.yHotspot;
+
+  if (color && !GetBitmapBits(dc.get(), color.get(), bitmaps.width,
+                              bitmaps.height, 32, &bitmaps.color)) {
+    return false;
+  }
+  if (!GetBitmapBits(dc.get(), mask.get(), bitmaps.width, mask_height, 1,
+                     &bitmaps.mask)) {
+    return false;
+  }
+
+  return ConvertCursorBitmaps(bitmaps, image);
+}
+
+}  // namespace util
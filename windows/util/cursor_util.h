@@ -0,0 +1,12 @@
+#pragma once
+
+#include <windows.h>
+
+#include "cursor_bitmap.h"
+
+namespace util {
+
+// Reads the bitmaps of |cursor| and converts them to RGBA.
+bool GetCursorImage(HCURSOR cursor, CursorImage* image);
+
+}  // namespace util
@@ -0,0 +1,60 @@
+#include "frame_scheduler.h"
+
+namespace util {
+
+FrameScheduler::Action FrameScheduler::RequestFrame() {
+  if (capturing_) {
+    // The next delivered frame satisfies this request as well.
+    return Action::kNone;
+  }
+  capturing_ = true;
+  return Action::kStartCapture;
+}
+
+void FrameScheduler::NotifyActivity(Clock::time_point now) {
+  deadline_ = now + settle_delay_;
+}
+
+FrameScheduler::Action FrameScheduler::Tick(Clock::time_point now) {
+  if (!deadline_ || now < *deadline_) {
+    return Action::kNone;
+  }
+  deadline_.reset();
+  return RequestFrame();
+}
+
+FrameScheduler::Action FrameScheduler::FrameDelivered() {
+  if (!capturing_) {
+    return Action::kNone;
+  }
+  capturing_ = false;
+  return Action::kStopCapture;
+}
+
+void FrameScheduler::Reset() {
+  deadline_.reset();
+  capturing_ = false;
+}
+
+void FrameRateLimiter::SetMaxFps(std::optional<int> max_fps) {
+  if (max_fps.value_or(0) > 0) {
+    frame_interval_ = std::chrono::ceil<Clock::duration>(
+        std::chrono::duration<double>(1.0 / *max_fps));
+  } else {
+    frame_interval_.reset();
+    last_frame_time_.reset();
+  }
+}
+
+bool FrameRateLimiter::ShouldDropFrame(Clock::time_point now) {
+  if (!frame_interval_) {
+    return false;
+  }
+  if (last_frame_time_ && now - *last_frame_time_ < *frame_interval_) {
+    return true;
+  }
+  last_frame_time_ = now;
+  return false;
+}
+
+}  // namespace util
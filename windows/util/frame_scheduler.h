@@ -0,0 +1,90 @@
+#pragma once
+
+#include <chrono>
+#include <optional>
+
+namespace util {
+
+// Decides when to capture frames in render-on-demand mode, where capturing
+// is paused while nothing is requested.
+//
+// A frame is captured when explicitly requested, or once a settle delay has
+// passed after the last activity (navigation, input, resizing). Capturing
+// is paused again as soon as a frame has been delivered.
+//
+// The scheduler doesn't own a clock or timers: callers pass the current
+// time, and schedule a call to Tick() at deadline() whenever it changes.
+class FrameScheduler {
+ public:
+  typedef std::chrono::steady_clock Clock;
+
+  enum class Action {
+    kNone,
+    kStartCapture,
+    kStopCapture,
+  };
+
+  static constexpr Clock::duration kDefaultSettleDelay =
+      std::chrono::milliseconds(250);
+
+  explicit FrameScheduler(Clock::duration settle_delay = kDefaultSettleDelay)
+      : settle_delay_(settle_delay) {}
+
+  void set_settle_delay(Clock::duration settle_delay) {
+    settle_delay_ = settle_delay;
+  }
+  Clock::duration settle_delay() const { return settle_delay_; }
+
+  bool is_capturing() const { return capturing_; }
+
+  // The time at which Tick() needs to be called, if any.
+  std::optional<Clock::time_point> deadline() const { return deadline_; }
+
+  // Requests a frame to be captured as soon as possible.
+  Action RequestFrame();
+
+  // Notifies about activity likely changing the contents. Captures a frame
+  // once no further activity happened for the settle delay.
+  void NotifyActivity(Clock::time_point now);
+
+  // Starts capturing if the settle deadline has passed.
+  Action Tick(Clock::time_point now);
+
+  // Notifies that a frame captured after the last request has been
+  // delivered, which satisfies all outstanding requests.
+  Action FrameDelivered();
+
+  // Notifies that capturing has been stopped externally (e.g. the capture
+  // failed to start or the bridge was stopped) and resets the state.
+  void Reset();
+
+ private:
+  Clock::duration settle_delay_;
+  std::optional<Clock::time_point> deadline_;
+  bool capturing_ = false;
+};
+
+// Drops frames arriving faster than a maximum frame rate.
+class FrameRateLimiter {
+ public:
+  typedef std::chrono::steady_clock Clock;
+
+  // Limits the rate to |max_fps| frames per second. std::nullopt or a
+  // non-positive value removes the limit.
+  void SetMaxFps(std::optional<int> max_fps);
+
+  // The minimum time between two frames, if limited.
+  std::optional<Clock::duration> frame_interval() const {
+    return frame_interval_;
+  }
+
+  // Returns true if a frame arriving at |now| follows the last accepted one
+  // too closely. Otherwise, the frame is accepted.
+  bool ShouldDropFrame(Clock::time_point now);
+
+ private:
+  std::optional<Clock::duration> frame_interval_;
+  std::optional<Clock::time_point> last_frame_time_;
+};
+
+}  // namespace util
@@ -0,0 +1,116 @@
+#include "host_dispatcher.h"
+
+namespace util {
+
+void HostDispatcher::RegisterNative(const std::string& name,
+                                    NativeHandler handler) {
+  Register(name, handler ? std::move(handler)
+                         : [](const HostValue::List&) { return HostValue{}; });
+}
+
+void HostDispatcher::RegisterDeferred(const std::string& name) {
+  Register(name, nullptr);
+}
+
+bool HostDispatcher::Unregister(const std::string& name) {
+  const auto id = GetDispatchId(name);
+  if (!id) {
+    return false;
+  }
+  auto entry = GetEntry(*id);
+  entry->registered = false;
+  entry->handler = nullptr;
+  return true;
+}
+
+std::optional<HostDispatcher::DispatchId> HostDispatcher::GetDispatchId(
+    std::string_view name) const {
+  const auto it = ids_.find(std::string(name));
+  if (it == ids_.end() || !entries_[it->second - 1].registered) {
+    return std::nullopt;
+  }
+  return it->second;
+}
+
+HostDispatcher::InvokeResult HostDispatcher::Invoke(DispatchId id,
+                                                    HostValue::List args,
+                                                    HostValue* result,
+                                                    Completion completion) {
+  const auto entry = GetEntry(id);
+  if (!entry || !entry->registered) {
+    return InvokeResult::kUnknown;
+  }
+
+  if (entry->handler) {
+    // Copied, as the handler may re-register itself.
+    const auto handler = entry->handler;
+    *result = handler(args);
+    return InvokeResult::kCompleted;
+  }
+
+  const auto call_id = next_call_id_++;
+  pending_calls_.push_back({call_id, entry->name, std::move(args)});
+  completions_[call_id] = std::move(completion);
+  return InvokeResult::kDeferred;
+}
+
+std::vector<HostDispatcher::PendingCall> HostDispatcher::TakePendingCalls() {
+  std::vector<PendingCall> calls;
+  calls.swap(pending_calls_);
+  return calls;
+}
+
+bool HostDispatcher::Complete(uint64_t call_id, bool success,
+                              HostValue result) {
+  const auto it = completions_.find(call_id);
+  if (it == completions_.end()) {
+    return false;
+  }
+  auto completion = std::move(it->second);
+  completions_.erase(it);
+
+  for (auto call = pending_calls_.begin(); call != pending_calls_.end();
+       ++call) {
+    if (call->call_id == call_id) {
+      pending_calls_.erase(call);
+      break;
+    }
+  }
+
+  if (completion) {
+    completion(success, std::move(result));
+  }
+  return true;
+}
+
+void HostDispatcher::CancelAll() {
+  pending_calls_.clear();
+  auto completions = std::move(completions_);
+  completions_.clear();
+  for (auto& [call_id, completion] : completions) {
+    if (completion) {
+      completion(false, HostValue{std::string("Cancelled")});
+    }
+  }
+}
+
+HostDispatcher::Entry* HostDispatcher::GetEntry(DispatchId id) {
+  if (id < 1 || static_cast<size_t>(id) > entries_.size()) {
+    return nullptr;
+  }
+  return &entries_[id - 1];
+}
+
+void HostDispatcher::Register(const std::string& name, NativeHandler handler) {
+  const auto it = ids_.find(name);
+  if (it != ids_.end()) {
+    auto& entry = entries_[it->second - 1];
+    entry.handler = std::move(handler);
+    entry.registered = true;
+    return;
+  }
+  entries_.push_back({name, std::move(handler), true});
+  ids_[name] = static_cast<DispatchId>(entries_.size());
+}
+
+}  // namespace util
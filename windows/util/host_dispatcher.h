@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <variant>
+#include <vector>
+
+namespace util {
+
+// A value passed between script and host functions.
+struct HostValue {
+  typedef std::vector<HostValue> List;
+
+  std::variant<std::monostate, bool, int64_t, double, std::string, List> value;
+};
+
+// Routes calls of named host functions to their handlers. Native handlers
+// run synchronously. Deferred handlers (implemented in Dart) are queued
+// and completed later, so they can be dispatched in batches.
+class HostDispatcher {
+ public:
+  // Dispatch ids are positive and stay the same for a name, even across
+  // re-registration.
+  typedef int32_t DispatchId;
+  typedef std::function<HostValue(const HostValue::List& args)> NativeHandler;
+  typedef std::function<void(bool success, HostValue result)> Completion;
+
+  enum class InvokeResult { kCompleted, kDeferred, kUnknown };
+
+  struct PendingCall {
+    uint64_t call_id;
+    std::string name;
+    HostValue::List args;
+  };
+
+  // Registers or replaces a function.
+  void RegisterNative(const std::string& name, NativeHandler handler);
+  void RegisterDeferred(const std::string& name);
+  bool Unregister(const std::string& name);
+
+  // Returns the id of a registered function.
+  std::optional<DispatchId> GetDispatchId(std::string_view name) const;
+
+  // Calls a native handler, storing its return value in |result|, or queues
+  // a call to a deferred one, which will be finished with |completion|.
+  InvokeResult Invoke(DispatchId id, HostValue::List args, HostValue* result,
+                      Completion completion);
+
+  // Removes and returns the queued calls in the order they were made.
+  std::vector<PendingCall> TakePendingCalls();
+  bool has_pending_calls() const { return !pending_calls_.empty(); }
+
+  // Finishes a deferred call, whether or not it has been taken already.
+  // Returns false for unknown (or already completed) calls.
+  bool Complete(uint64_t call_id, bool success, HostValue result);
+
+  // Fails all unfinished deferred calls.
+  void CancelAll();
+
+  size_t outstanding_calls() const { return completions_.size(); }
+
+ private:
+  struct Entry {
+    std::string name;
+    // Empty for deferred functions.
+    NativeHandler handler;
+    bool registered;
+  };
+
+  // Indexed by DispatchId - 1.
+  std::vector<Entry> entries_;
+  std::unordered_map<std::string, DispatchId> ids_;
+  std::vector<PendingCall> pending_calls_;
+  std::unordered_map<uint64_t, Completion> completions_;
+  uint64_t next_call_id_ = 1;
+
+  Entry* GetEntry(DispatchId id);
+  void Register(const std::string& name, NativeHandler handler);
+};
+
+}  // namespace util
@@ -0,0 +1,47 @@
+#include "http_headers.h"
+
+#include <string_view>
+
+namespace util {
+
+namespace {
+
+// RFC 7230 token characters.
+bool IsTokenCharacter(char c) {
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+         (c >= '0' && c <= '9') ||
+         std::string_view("!#$%&'*+-.^_`|~").find(c) != std::string_view::npos;
+}
+
+}  // namespace
+
+bool FormatHttpHeaders(
+    const std::vector<std::pair<std::string, std::string>>& headers,
+    std::string* out) {
+  std::string result;
+  for (const auto& [name, value] : headers) {
+    if (name.empty()) {
+      return false;
+    }
+    for (const auto c : name) {
+      if (!IsTokenCharacter(c)) {
+        return false;
+      }
+    }
+    if (value.find_first_of("\r\n") != std::string::npos ||
+        value.find('\0') != std::string::npos) {
+      return false;
+    }
+
+    if (!result.empty()) {
+      result += "\r\n";
+    }
+    result += name;
+    result += ": ";
+    result += value;
+  }
+  *out = std::move(result);
+  return true;
+}
+
+}  // namespace util
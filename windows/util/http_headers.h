@@ -0,0 +1,16 @@
+#pragma once
+
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace util {
+
+// Formats |headers| as "Name: value" lines separated by CRLF. Returns false
+// if a name is empty or not a valid token, or a value contains line breaks,
+// which would allow injecting additional headers.
+bool FormatHttpHeaders(
+    const std::vector<std::pair<std::string, std::string>>& headers,
+    std::string* out);
+
+}  // namespace util
@@ -0,0 +1,258 @@
+#include "json.h"
+
+#include <cstdint>
+#include <cstdlib>
+
+namespace util {
+
+class JsonParser {
+ public:
+  explicit JsonParser(std::string_view json) : json_(json) {}
+
+  bool ParseDocument(JsonValue* value) {
+    if (!ParseValue(value, 0)) {
+      return false;
+    }
+    SkipWhitespace();
+    return pos_ == json_.size();
+  }
+
+ private:
+  // Guards against stack exhaustion on deeply nested input.
+  static constexpr int kMaxDepth = 64;
+
+  std::string_view json_;
+  size_t pos_ = 0;
+
+  void SkipWhitespace() {
+    while (pos_ < json_.size() &&
+           std::string_view(" \t\n\r").find(json_[pos_]) !=
+               std::string_view::npos) {
+      pos_++;
+    }
+  }
+
+  bool Consume(char c) {
+    SkipWhitespace();
+    if (pos_ < json_.size() && json_[pos_] == c) {
+      pos_++;
+      return true;
+    }
+    return false;
+  }
+
+  bool ConsumeLiteral(std::string_view literal) {
+    if (json_.substr(pos_, literal.size()) == literal) {
+      pos_ += literal.size();
+      return true;
+    }
+    return false;
+  }
+
+  bool ParseValue(JsonValue* value, int depth) {
+    if (depth > kMaxDepth) {
+      return false;
+    }
+    SkipWhitespace();
+    if (pos_ >= json_.size()) {
+      return false;
+    }
+
+    switch (json_[pos_]) {
+      case 'n':
+        value->type_ = JsonValue::Type::kNull;
+        return ConsumeLiteral("null");
+      case 't':
+        value->type_ = JsonValue::Type::kBool;
+        value->bool_ = true;
+        return ConsumeLiteral("true");
+      case 'f':
+        value->type_ = JsonValue::Type::kBool;
+        value->bool_ = false;
+        return ConsumeLiteral("false");
+      case '"':
+        value->type_ = JsonValue::Type::kString;
+        return ParseString(&value->string_);
+      case '[':
+        value->type_ = JsonValue::Type::kArray;
+        return ParseArray(&value->array_, depth);
+      case '{':
+        value->type_ = JsonValue::Type::kObject;
+        return ParseObject(&value->object_, depth);
+      default:
+        value->type_ = JsonValue::Type::kNumber;
+        return ParseNumber(&value->number_);
+    }
+  }
+
+  bool ParseArray(JsonValue::Array* array, int depth) {
+    pos_++;
+    if (Consume(']')) {
+      return true;
+    }
+    do {
+      JsonValue element;
+      if (!ParseValue(&element, depth + 1)) {
+        return false;
+      }
+      array->push_back(std::move(element));
+    } while (Consume(','));
+    return Consume(']');
+  }
+
+  bool ParseObject(JsonValue::Object* object, int depth) {
+    pos_++;
+    if (Consume('}')) {
+      return true;
+    }
+    do {
+      SkipWhitespace();
+      std::string key;
+      JsonValue member;
+      if (pos_ >= json_.size() || json_[pos_] != '"' || !ParseString(&key) ||
+          !Consume(':') || !ParseValue(&member, depth + 1)) {
+        return false;
+      }
+      object->emplace_back(std::move(key), std::move(member));
+    } while (Consume(','));
+    return Consume('}');
+  }
+
+  bool ParseNumber(double* number) {
+    const size_t start = pos_;
+    while (pos_ < json_.size() &&
+           std::string_view("+-0123456789.eE").find(json_[pos_]) !=
+               std::string_view::npos) {
+      pos_++;
+    }
+    if (pos_ == start) {
+      return false;
+    }
+    const std::string text(json_.substr(start, pos_ - start));
+    char* end = nullptr;
+    *number = std::strtod(text.c_str(), &end);
+    return end == text.c_str() + text.size();
+  }
+
+  bool ParseHex4(uint32_t* code_unit) {
+    if (pos_ + 4 > json_.size()) {
+      return false;
+    }
+    *code_unit = 0;
+    for (size_t i = 0; i < 4; i++) {
+      const char c = json_[pos_++];
+      *code_unit <<= 4;
+      if (c >= '0' && c <= '9') {
+        *code_unit |= c - '0';
+      } else if (c >= 'a' && c <= 'f') {
+        *code_unit |= c - 'a' + 10;
+      } else if (c >= 'A' && c <= 'F') {
+        *code_unit |= c - 'A' + 10;
+      } else {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  static void AppendUtf8(uint32_t code_point, std::string* out) {
+    if (code_point < 0x80) {
+      out->push_back(static_cast<char>(code_point));
+    } else if (code_point < 0x800) {
+      out->push_back(static_cast<char>(0xC0 | (code_point >> 6)));
+      out->push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+    } else if (code_point < 0x10000) {
+      out->push_back(static_cast<char>(0xE0 | (code_point >> 12)));
+      out->push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3F)));
+      out->push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+    } else {
+      out->push_back(static_cast<char>(0xF0 | (code_point >> 18)));
+      out->push_back(static_cast<char>(0x80 | ((code_point >> 12) & 0x3F)));
+      out->push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3F)));
+      out->push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+    }
+  }
+
+  bool ParseString(std::string* out) {
+    pos_++;
+    while (pos_ < json_.size()) {
+      const char c = json_[pos_++];
+      if (c == '"') {
+        return true;
+      }
+      if (c != '\\') {
+        out->push_back(c);
+        continue;
+      }
+      if (pos_ >= json_.size()) {
+        return false;
+      }
+      switch (json_[pos_++]) {
+        case '"':
+          out->push_back('"');
+          break;
+        case '\\':
+          out->push_back('\\');
+          break;
+        case '/':
+          out->push_back('/');
+          break;
+        case 'b':
+          out->push_back('\b');
+          break;
+        case 'f':
+          out->push_back('\f');
+          break;
+        case 'n':
+          out->push_back('\n');
+          break;
+        case 'r':
+          out->push_back('\r');
+          break;
+        case 't':
+          out->push_back('\t');
+          break;
+        case 'u': {
+          uint32_t code_point;
+          if (!ParseHex4(&code_point)) {
+            return false;
+          }
+          if (code_point >= 0xD800 && code_point < 0xDC00) {
+            uint32_t low;
+            if (!ConsumeLiteral("\\u") || !ParseHex4(&low) || low < 0xDC00 ||
+                low >= 0xE000) {
+              return false;
+            }
+            code_point = 0x10000 + ((code_point - 0xD800) << 10) +
+                         (low - 0xDC00);
+          }
+          AppendUtf8(code_point, out);
+          break;
+        }
+        default:
+          return false;
+      }
+    }
+    return false;
+  }
+};
+
+std::optional<JsonValue> JsonValue::Parse(std::string_view json) {
+  JsonValue value;
+  JsonParser parser(json);
+  if (!parser.ParseDocument(&value)) {
+    return std::nullopt;
+  }
+  return value;
+}
+
+const JsonValue* JsonValue::Find(std::string_view key) const {
+  for (const auto& [name, value] : object_) {
+    if (name == key) {
+      return &value;
+    }
+  }
+  return nullptr;
+}
+
+}  // namespace util
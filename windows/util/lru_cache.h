@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <list>
+#include <unordered_map>
+#include <utility>
+
+namespace util {
+
+// A map holding at most |capacity| entries. Inserting into a full cache
+// evicts the least recently used entry. Not thread-safe.
+template <typename Key, typename Value>
+class LruCache {
+ public:
+  explicit LruCache(size_t capacity) : capacity_(capacity) {}
+
+  size_t size() const { return index_.size(); }
+  size_t capacity() const { return capacity_; }
+
+  // Returns the value for |key| and marks it as most recently used, or
+  // nullptr if there is none.
+  Value* Get(const Key& key) {
+    const auto it = index_.find(key);
+    if (it == index_.end()) {
+      return nullptr;
+    }
+    entries_.splice(entries_.begin(), entries_, it->second);
+    return &it->second->second;
+  }
+
+  // Inserts or replaces the value for |key|.
+  Value* Put(const Key& key, Value value) {
+    if (auto existing = Get(key)) {
+      *existing = std::move(value);
+      return existing;
+    }
+
+    if (capacity_ == 0) {
+      return nullptr;
+    }
+    if (index_.size() >= capacity_) {
+      index_.erase(entries_.back().first);
+      entries_.pop_back();
+    }
+
+    entries_.emplace_front(key, std::move(value));
+    index_[key] = entries_.begin();
+    return &entries_.front().second;
+  }
+
+  bool Remove(const Key& key) {
+    const auto it = index_.find(key);
+    if (it == index_.end()) {
+      return false;
+    }
+    entries_.erase(it->second);
+    index_.erase(it);
+    return true;
+  }
+
+  void Clear() {
+    index_.clear();
+    entries_.clear();
+  }
+
+ private:
+  typedef std::list<std::pair<Key, Value>> EntryList;
+
+  size_t capacity_;
+  EntryList entries_;
+  std::unordered_map<Key, typename EntryList::iterator> index_;
+};
+
+}  // namespace util
@@ -0,0 +1,100 @@
+#include "permission_cache.h"
+
+#include <algorithm>
+
+namespace util {
+
+std::optional<PermissionCache::Clock::duration> PermissionCache::ParseTtl(
+    int64_t ttl_ms) {
+  constexpr auto kMaxTtl =
+      std::chrono::duration_cast<std::chrono::milliseconds>(
+          Clock::duration::max());
+  if (ttl_ms < 0) {
+    return std::nullopt;
+  }
+  if (ttl_ms >= kMaxTtl.count()) {
+    return Clock::duration::max();
+  }
+  return std::chrono::duration_cast<Clock::duration>(
+      std::chrono::milliseconds(ttl_ms));
+}
+
+bool PermissionCache::Remember(const std::string& origin, int32_t kind,
+                               bool allow, int64_t ttl_ms,
+                               Clock::time_point now) {
+  const auto ttl = ParseTtl(ttl_ms);
+  if (!ttl) {
+    return false;
+  }
+  Set(origin, kind, allow ? Decision::kAllow : Decision::kDeny, ttl, now);
+  return true;
+}
+
+void PermissionCache::Set(const std::string& origin, int32_t kind,
+                          Decision decision,
+                          std::optional<Clock::duration> ttl,
+                          Clock::time_point now) {
+  const auto key = std::make_pair(origin, kind);
+  if (entries_.find(key) == entries_.end()) {
+    MakeRoom(now);
+  }
+  std::optional<Clock::time_point> expires;
+  if (ttl) {
+    // Saturate long TTLs at the end of time.
+    expires = *ttl < Clock::time_point::max() - now ? now + *ttl
+                                                     : Clock::time_point::max();
+  }
+  entries_[key] = {decision, expires};
+}
+
+std::optional<PermissionCache::Decision> PermissionCache::Lookup(
+    const std::string& origin, int32_t kind, Clock::time_point now) {
+  const auto it = entries_.find({origin, kind});
+  if (it == entries_.end()) {
+    return std::nullopt;
+  }
+  if (it->second.expires && *it->second.expires <= now) {
+    entries_.erase(it);
+    return std::nullopt;
+  }
+  return it->second.decision;
+}
+
+bool PermissionCache::Remove(const std::string& origin, int32_t kind) {
+  return entries_.erase({origin, kind}) > 0;
+}
+
+void PermissionCache::RemoveOrigin(const std::string& origin) {
+  // Entries are ordered by origin first.
+  auto it = entries_.lower_bound({origin, INT32_MIN});
+  while (it != entries_.end() && it->first.first == origin) {
+    it = entries_.erase(it);
+  }
+}
+
+void PermissionCache::MakeRoom(Clock::time_point now) {
+  if (entries_.size() < max_entries_) {
+    return;
+  }
+
+  for (auto it = entries_.begin(); it != entries_.end();) {
+    if (it->second.expires && *it->second.expires <= now) {
+      it = entries_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+
+  if (entries_.size() >= max_entries_ && !entries_.empty()) {
+    // Decisions without expiry are dropped last.
+    const auto soonest = std::min_element(
+        entries_.begin(), entries_.end(), [](const auto& a, const auto& b) {
+          const auto& x = a.second.expires;
+          const auto& y = b.second.expires;
+          return x && (!y || *x < *y);
+        });
+    entries_.erase(soonest);
+  }
+}
+
+}  // namespace util
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <string>
+#include <utility>
+
+namespace util {
+
+// Remembers permission decisions per origin (see NormalizeOrigin) and
+// permission kind, so that repeated requests can be answered right away.
+//
+// Like FrameScheduler, the cache doesn't own a clock: callers pass the
+// current time.
+class PermissionCache {
+ public:
+  typedef std::chrono::steady_clock Clock;
+
+  enum class Decision { kAllow, kDeny };
+
+  static constexpr size_t kDefaultMaxEntries = 1024;
+
+  explicit PermissionCache(size_t max_entries = kDefaultMaxEntries)
+      : max_entries_(max_entries) {}
+
+  // Converts a TTL in milliseconds received from Dart, saturating instead
+  // of overflowing the clock's duration. Returns nullopt for negative TTLs.
+  static std::optional<Clock::duration> ParseTtl(int64_t ttl_ms);
+
+  // Stores a decision for |ttl|, or until removed if |ttl| is nullopt. If
+  // the cache is full, expired entries are dropped first, then the one
+  // expiring soonest.
+  void Set(const std::string& origin, int32_t kind, Decision decision,
+           std::optional<Clock::duration> ttl, Clock::time_point now);
+
+  // Stores the decision of a permissionRequested reply to be remembered
+  // ([bool allow, int ttlMs]). Returns false, storing nothing, if the TTL
+  // is invalid.
+  bool Remember(const std::string& origin, int32_t kind, bool allow,
+                int64_t ttl_ms, Clock::time_point now);
+
+  std::optional<Decision> Lookup(const std::string& origin, int32_t kind,
+                                 Clock::time_point now);
+
+  bool Remove(const std::string& origin, int32_t kind);
+  // Removes all decisions for |origin|.
+  void RemoveOrigin(const std::string& origin);
+  void Clear() { entries_.clear(); }
+
+  size_t size() const { return entries_.size(); }
+
+ private:
+  struct Entry {
+    Decision decision;
+    // nullopt for decisions that don't expire.
+    std::optional<Clock::time_point> expires;
+  };
+
+  const size_t max_entries_;
+  std::map<std::pair<std::string, int32_t>, Entry> entries_;
+
+  void MakeRoom(Clock::time_point now);
+};
+
+}  // namespace util
@@ -0,0 +1,42 @@
+#include "preview_frame_pipeline.h"
+
+namespace util {
+
+uint64_t HashBytes(const uint8_t* data, size_t size) {
+  uint64_t hash = 14695981039346656037ull;
+  for (size_t i = 0; i < size; i++) {
+    hash ^= data[i];
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+PreviewFramePipeline::Result PreviewFramePipeline::Process(
+    const uint8_t* data, size_t size) {
+  const auto hash = HashBytes(data, size);
+  if (last_hash_ == hash) {
+    return Result::kUnchanged;
+  }
+
+  auto& back = buffers_[1 - front_index_];
+  if (!decoder_(data, size, &back) ||
+      back.pixels.size() != back.width * back.height * 4) {
+    // The back buffer may have been partially overwritten.
+    last_hash_.reset();
+    has_pending_frame_ = false;
+    return Result::kFailed;
+  }
+
+  last_hash_ = hash;
+  has_pending_frame_ = true;
+  return Result::kDecoded;
+}
+
+void PreviewFramePipeline::Commit() {
+  if (has_pending_frame_) {
+    front_index_ = 1 - front_index_;
+    has_pending_frame_ = false;
+  }
+}
+
+}  // namespace util
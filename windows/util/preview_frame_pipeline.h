@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <vector>
+
+namespace util {
+
+// A decoded image with 4 bytes per pixel and no row padding.
+struct PixelFrame {
+  size_t width = 0;
+  size_t height = 0;
+  std::vector<uint8_t> pixels;
+};
+
+// Turns encoded preview images into pixel frames. Images identical to the
+// previous one are skipped without decoding. Frames are double-buffered:
+// images are decoded into the back buffer, whose storage is reused, and
+// only become visible once committed.
+class PreviewFramePipeline {
+ public:
+  // Decodes |size| bytes at |data| into |frame|, reusing its storage.
+  typedef std::function<bool(const uint8_t* data, size_t size,
+                             PixelFrame* frame)>
+      Decoder;
+
+  enum class Result { kUnchanged, kDecoded, kFailed };
+
+  explicit PreviewFramePipeline(Decoder decoder)
+      : decoder_(std::move(decoder)) {}
+
+  // Decodes an image into the back buffer unless it is unchanged. A failure
+  // drops a decoded frame that hasn't been committed yet.
+  Result Process(const uint8_t* data, size_t size);
+
+  // Makes the last decoded frame the front one. Must not run concurrently
+  // with reading front().
+  void Commit();
+
+  const PixelFrame& front() const { return buffers_[front_index_]; }
+
+  // Forgets the last image, so that the next one gets decoded again.
+  void Invalidate() { last_hash_.reset(); }
+
+ private:
+  Decoder decoder_;
+  PixelFrame buffers_[2];
+  size_t front_index_ = 0;
+  bool has_pending_frame_ = false;
+  std::optional<uint64_t> last_hash_;
+};
+
+// Returns the 64-bit FNV-1a hash of the given bytes.
+uint64_t HashBytes(const uint8_t* data, size_t size);
+
+}  // namespace util
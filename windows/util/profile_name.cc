@@ -0,0 +1,31 @@
+#include "profile_name.h"
+
+namespace util {
+
+namespace {
+
+constexpr size_t kMaxProfileNameLength = 64;
+
+bool IsAllowedCharacter(char c) {
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+         (c >= '0' && c <= '9') ||
+         std::string_view("#@$()+-_~.' ").find(c) != std::string_view::npos;
+}
+
+}  // namespace
+
+bool IsValidProfileName(std::string_view name) {
+  if (name.empty() || name.size() > kMaxProfileNameLength ||
+      name.back() == '.' || name.back() == ' ') {
+    return false;
+  }
+  for (const auto c : name) {
+    if (!IsAllowedCharacter(c)) {
+      return false;
+    }
+  }
+  // Reject names that would refer to the current or parent folder.
+  return name.find_first_not_of('.') != std::string_view::npos;
+}
+
+}  // namespace util
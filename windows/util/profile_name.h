@@ -0,0 +1,14 @@
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+
+namespace util {
+
+// Returns true if |name| is a valid WebView2 profile name: up to 64
+// characters out of letters, digits and #@$()+-_~.' and space, not ending
+// with a period or a space. Valid names are also safe to use as a folder
+// name.
+bool IsValidProfileName(std::string_view name);
+
+}  // namespace util
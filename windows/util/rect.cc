@@ -0,0 +1,48 @@
+#include "rect.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace util {
+
+namespace {
+int32_t Saturate(double value) {
+  constexpr auto kMin = std::numeric_limits<int32_t>::min();
+  constexpr auto kMax = std::numeric_limits<int32_t>::max();
+  if (std::isnan(value)) {
+    return 0;
+  }
+  return static_cast<int32_t>(
+      std::clamp(value, static_cast<double>(kMin), static_cast<double>(kMax)));
+}
+}  // namespace
+
+Rect Intersect(const Rect& a, const Rect& b) {
+  Rect result{std::max(a.left, b.left), std::max(a.top, b.top),
+              std::min(a.right, b.right), std::min(a.bottom, b.bottom)};
+  if (result.IsEmpty()) {
+    return {};
+  }
+  return result;
+}
+
+Rect ScaleToPhysical(double x, double y, double width, double height,
+                     double scale_factor) {
+  if (width <= 0 || height <= 0 || scale_factor <= 0) {
+    return {};
+  }
+  return {Saturate(std::floor(x * scale_factor)),
+          Saturate(std::floor(y * scale_factor)),
+          Saturate(std::ceil((x + width) * scale_factor)),
+          Saturate(std::ceil((y + height) * scale_factor))};
+}
+
+Rect ClipToSurface(const Rect& rect, uint32_t width, uint32_t height) {
+  const Rect bounds{
+      0, 0, static_cast<int32_t>(std::min<uint32_t>(width, INT32_MAX)),
+      static_cast<int32_t>(std::min<uint32_t>(height, INT32_MAX))};
+  return Intersect(rect, bounds);
+}
+
+}  // namespace util
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+
+namespace util {
+
+// An integer rectangle in physical pixels. |right| and |bottom| are
+// exclusive.
+struct Rect {
+  int32_t left = 0;
+  int32_t top = 0;
+  int32_t right = 0;
+  int32_t bottom = 0;
+
+  int32_t width() const { return right > left ? right - left : 0; }
+  int32_t height() const { return bottom > top ? bottom - top : 0; }
+  bool IsEmpty() const { return width() == 0 || height() == 0; }
+
+  bool operator==(const Rect& other) const {
+    return left == other.left && top == other.top && right == other.right &&
+           bottom == other.bottom;
+  }
+  bool operator!=(const Rect& other) const { return !(*this == other); }
+};
+
+// Returns the intersection of both rectangles or an empty rectangle if they
+// don't overlap.
+Rect Intersect(const Rect& a, const Rect& b);
+
+// Converts a rectangle given in logical pixels to physical pixels. Partially
+// covered pixels are included by rounding outwards.
+Rect ScaleToPhysical(double x, double y, double width, double height,
+                     double scale_factor);
+
+// Clips |rect| to a surface of the given size.
+Rect ClipToSurface(const Rect& rect, uint32_t width, uint32_t height);
+
+}  // namespace util
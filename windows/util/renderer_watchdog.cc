@@ -0,0 +1,121 @@
+#include "renderer_watchdog.h"
+
+#include <algorithm>
+
+namespace util {
+
+RendererWatchdog::RendererWatchdog() : RendererWatchdog(Options()) {}
+
+RendererWatchdog::RendererWatchdog(const Options& options)
+    : options_(options) {}
+
+std::optional<RendererWatchdog::Clock::time_point>
+RendererWatchdog::deadline() const {
+  switch (state_) {
+    case State::kHealthy:
+      return next_heartbeat_;
+    case State::kWaiting:
+      if (last_frame_ && *last_frame_ > heartbeat_sent_) {
+        return heartbeat_sent_ + options_.unresponsive_timeout;
+      }
+      return heartbeat_sent_ + options_.heartbeat_timeout;
+    case State::kRecoveryScheduled:
+    case State::kRecovering:
+      return recovery_deadline_;
+    default:
+      return std::nullopt;
+  }
+}
+
+void RendererWatchdog::Start(Clock::time_point now) {
+  recoveries_ = 0;
+  ScheduleHeartbeat(now);
+}
+
+void RendererWatchdog::Stop() { state_ = State::kStopped; }
+
+RendererWatchdog::Action RendererWatchdog::Tick(Clock::time_point now) {
+  const auto current_deadline = deadline();
+  if (!current_deadline || now < *current_deadline) {
+    return Action::kNone;
+  }
+
+  switch (state_) {
+    case State::kHealthy:
+      state_ = State::kWaiting;
+      heartbeat_sent_ = now;
+      heartbeat_id_++;
+      return Action::kSendHeartbeat;
+    case State::kWaiting:
+    case State::kRecovering:
+      return Recover(now);
+    case State::kRecoveryScheduled:
+      return StartRecovery(now);
+    default:
+      return Action::kNone;
+  }
+}
+
+void RendererWatchdog::OnHeartbeatCompleted(uint64_t id,
+                                            Clock::time_point now) {
+  if (state_ != State::kWaiting || id != heartbeat_id_) {
+    return;
+  }
+  recoveries_ = 0;
+  ScheduleHeartbeat(now);
+}
+
+void RendererWatchdog::OnNavigationStarted(Clock::time_point now) {
+  if (state_ == State::kWaiting) {
+    ScheduleHeartbeat(now);
+  }
+}
+
+void RendererWatchdog::OnRecovered(Clock::time_point now) {
+  if (state_ == State::kRecovering) {
+    ScheduleHeartbeat(now);
+  }
+}
+
+RendererWatchdog::Action RendererWatchdog::OnRendererFailed(
+    Clock::time_point now) {
+  if (state_ == State::kStopped || state_ == State::kFailed ||
+      state_ == State::kRecoveryScheduled) {
+    return Action::kNone;
+  }
+  return Recover(now);
+}
+
+RendererWatchdog::Action RendererWatchdog::Recover(Clock::time_point now) {
+  if (recoveries_ >= options_.max_recoveries) {
+    state_ = State::kFailed;
+    return Action::kGiveUp;
+  }
+  if (recoveries_ == 0) {
+    return StartRecovery(now);
+  }
+
+  auto delay = options_.recovery_delay;
+  for (int i = 1; i < recoveries_ && delay < options_.max_recovery_delay;
+       i++) {
+    delay *= 2;
+  }
+  state_ = State::kRecoveryScheduled;
+  recovery_deadline_ = now + std::min(delay, options_.max_recovery_delay);
+  return Action::kNone;
+}
+
+RendererWatchdog::Action RendererWatchdog::StartRecovery(
+    Clock::time_point now) {
+  recoveries_++;
+  state_ = State::kRecovering;
+  recovery_deadline_ = now + options_.recovery_timeout;
+  return Action::kRecover;
+}
+
+void RendererWatchdog::ScheduleHeartbeat(Clock::time_point now) {
+  state_ = State::kHealthy;
+  next_heartbeat_ = now + options_.heartbeat_interval;
+}
+
+}  // namespace util
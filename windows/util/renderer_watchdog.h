@@ -0,0 +1,123 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+
+namespace util {
+
+// Detects hung renderers and decides when to recover from hangs and
+// crashes.
+//
+// Liveness is probed with heartbeats (trivial scripts which have to
+// complete in time), combined with frame activity: an unanswered heartbeat
+// counts as a hang after |heartbeat_timeout| if no frame has arrived since
+// it was sent, as the texture is frozen then, but only after
+// |unresponsive_timeout| otherwise, since compositing may carry on while
+// scripts are blocked.
+//
+// The first recovery happens right away. Further ones without an answered
+// heartbeat in between are delayed by |recovery_delay|, doubling with every
+// attempt up to |max_recovery_delay|, so that a renderer crashing on load
+// isn't restarted in a tight loop.
+//
+// Like FrameScheduler, the watchdog doesn't own a clock or timers: callers
+// pass the current time, and schedule a call to Tick() at deadline()
+// whenever it changes.
+class RendererWatchdog {
+ public:
+  typedef std::chrono::steady_clock Clock;
+
+  enum class State {
+    kStopped,
+    kHealthy,
+    // A heartbeat is outstanding.
+    kWaiting,
+    // Waiting for the backoff delay before restarting the renderer.
+    kRecoveryScheduled,
+    // The renderer is being restarted.
+    kRecovering,
+    // Recovering failed repeatedly. Nothing is done until restarted.
+    kFailed,
+  };
+
+  enum class Action {
+    kNone,
+    // Send a heartbeat with id heartbeat_id().
+    kSendHeartbeat,
+    // Restart the renderer and report OnRecovered() once done.
+    kRecover,
+    // Give up recovering.
+    kGiveUp,
+  };
+
+  struct Options {
+    Clock::duration heartbeat_interval = std::chrono::seconds(2);
+    Clock::duration heartbeat_timeout = std::chrono::seconds(3);
+    Clock::duration unresponsive_timeout = std::chrono::seconds(10);
+    // Restarting taking longer counts as another failure.
+    Clock::duration recovery_timeout = std::chrono::seconds(15);
+    // The delay before the second recovery, doubled for each further one.
+    Clock::duration recovery_delay = std::chrono::seconds(1);
+    Clock::duration max_recovery_delay = std::chrono::seconds(30);
+    // The number of recoveries without an answered heartbeat in between,
+    // after which the watchdog gives up.
+    int max_recoveries = 3;
+  };
+
+  RendererWatchdog();
+  explicit RendererWatchdog(const Options& options);
+
+  const Options& options() const { return options_; }
+  // Takes effect with the next heartbeat.
+  void set_options(const Options& options) { options_ = options; }
+
+  State state() const { return state_; }
+  uint64_t heartbeat_id() const { return heartbeat_id_; }
+  // The number of recoveries since the last answered heartbeat.
+  int recoveries() const { return recoveries_; }
+
+  // The time at which Tick() needs to be called, if any.
+  std::optional<Clock::time_point> deadline() const;
+
+  // Starts watching, with the first heartbeat after the interval. Also
+  // leaves the failed state.
+  void Start(Clock::time_point now);
+  void Stop();
+
+  Action Tick(Clock::time_point now);
+
+  void OnFrame(Clock::time_point now) { last_frame_ = now; }
+
+  // Reports a heartbeat having completed, successfully or not, which shows
+  // that the renderer is processing scripts again.
+  void OnHeartbeatCompleted(uint64_t id, Clock::time_point now);
+
+  // Scripts are delayed while a new document loads, so an outstanding
+  // heartbeat is dropped in favor of a new one.
+  void OnNavigationStarted(Clock::time_point now);
+
+  // Reports the renderer to have been restarted after kRecover.
+  void OnRecovered(Clock::time_point now);
+
+  // Reports the renderer to have crashed or to have been found
+  // unresponsive by other means. Ignored while a recovery is scheduled.
+  Action OnRendererFailed(Clock::time_point now);
+
+ private:
+  Options options_;
+  State state_ = State::kStopped;
+  uint64_t heartbeat_id_ = 0;
+  int recoveries_ = 0;
+  Clock::time_point next_heartbeat_;
+  Clock::time_point heartbeat_sent_;
+  // The end of the backoff delay, or of the recovery timeout.
+  Clock::time_point recovery_deadline_;
+  std::optional<Clock::time_point> last_frame_;
+
+  Action Recover(Clock::time_point now);
+  Action StartRecovery(Clock::time_point now);
+  void ScheduleHeartbeat(Clock::time_point now);
+};
+
+}  // namespace util
@@ -0,0 +1,43 @@
+#include "restore_scheduler.h"
+
+#include <algorithm>
+#include <numeric>
+
+namespace util {
+
+RestoreScheduler::RestoreScheduler(const std::vector<int32_t>& priorities,
+                                   size_t max_parallel)
+    : order_(priorities.size()),
+      started_(priorities.size(), false),
+      completed_flags_(priorities.size(), false),
+      max_parallel_(std::max<size_t>(max_parallel, 1)) {
+  std::iota(order_.begin(), order_.end(), 0);
+  std::stable_sort(order_.begin(), order_.end(), [&](size_t a, size_t b) {
+    return priorities[a] > priorities[b];
+  });
+}
+
+std::vector<size_t> RestoreScheduler::Start() { return Fill(); }
+
+std::vector<size_t> RestoreScheduler::Complete(size_t index) {
+  if (index >= order_.size() || !started_[index] || completed_flags_[index]) {
+    return {};
+  }
+  completed_flags_[index] = true;
+  completed_++;
+  in_flight_--;
+  return Fill();
+}
+
+std::vector<size_t> RestoreScheduler::Fill() {
+  std::vector<size_t> started;
+  while (in_flight_ < max_parallel_ && next_ < order_.size()) {
+    const size_t index = order_[next_++];
+    started_[index] = true;
+    in_flight_++;
+    started.push_back(index);
+  }
+  return started;
+}
+
+}  // namespace util
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace util {
+
+// Decides in which order and how many instances are restored concurrently.
+// Instances are started by descending priority (ties keep their original
+// order) with at most |max_parallel| of them in flight at any time.
+class RestoreScheduler {
+ public:
+  RestoreScheduler(const std::vector<int32_t>& priorities, size_t max_parallel);
+
+  // Returns the instances to start right away.
+  std::vector<size_t> Start();
+
+  // Marks |index| as restored (successfully or not) and returns the
+  // instances to start next.
+  std::vector<size_t> Complete(size_t index);
+
+  size_t in_flight() const { return in_flight_; }
+  bool done() const { return completed_ == order_.size(); }
+
+ private:
+  std::vector<size_t> order_;
+  std::vector<bool> started_;
+  std::vector<bool> completed_flags_;
+  size_t max_parallel_;
+  size_t next_ = 0;
+  size_t in_flight_ = 0;
+  size_t completed_ = 0;
+
+  std::vector<size_t> Fill();
+};
+
+}  // namespace util
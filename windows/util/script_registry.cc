@@ -0,0 +1,59 @@
+#include "script_registry.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace util {
+
+ScriptRegistry::ScriptId ScriptRegistry::Add(std::wstring source) {
+  const auto id = next_id_++;
+  scripts_.push_back({id, std::move(source)});
+  return id;
+}
+
+std::optional<ScriptRegistry::InstanceScriptIds> ScriptRegistry::Remove(
+    ScriptId id) {
+  const auto it =
+      std::find_if(scripts_.begin(), scripts_.end(),
+                   [id](const Script& script) { return script.id == id; });
+  if (it == scripts_.end()) {
+    return std::nullopt;
+  }
+  scripts_.erase(it);
+
+  InstanceScriptIds ids;
+  constexpr auto kMinInstance = std::numeric_limits<InstanceId>::min();
+  auto first = instance_script_ids_.lower_bound({id, kMinInstance});
+  auto last = first;
+  for (; last != instance_script_ids_.end() && last->first.first == id;
+       ++last) {
+    ids.emplace_back(last->first.second, std::move(last->second));
+  }
+  instance_script_ids_.erase(first, last);
+  return ids;
+}
+
+bool ScriptRegistry::SetInstanceScriptId(ScriptId script, InstanceId instance,
+                                         std::string instance_script_id) {
+  const auto registered =
+      std::any_of(scripts_.begin(), scripts_.end(),
+                  [script](const Script& s) { return s.id == script; });
+  if (!registered) {
+    return false;
+  }
+  instance_script_ids_[{script, instance}] = std::move(instance_script_id);
+  return true;
+}
+
+void ScriptRegistry::RemoveInstance(InstanceId instance) {
+  for (auto it = instance_script_ids_.begin();
+       it != instance_script_ids_.end();) {
+    if (it->first.second == instance) {
+      it = instance_script_ids_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+}  // namespace util
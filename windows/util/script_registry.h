@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace util {
+
+// Scripts run on every document of every instance. Sources are kept as
+// UTF-16, so they are converted only once, and the ids WebView2 assigned
+// them per instance are tracked so that they can be removed again.
+class ScriptRegistry {
+ public:
+  typedef int64_t ScriptId;
+  typedef int64_t InstanceId;
+
+  struct Script {
+    ScriptId id;
+    std::wstring source;
+  };
+
+  // The ids of a script in the instances it was added to.
+  typedef std::vector<std::pair<InstanceId, std::string>> InstanceScriptIds;
+
+  ScriptId Add(std::wstring source);
+
+  // Unregisters a script, returning its ids per instance.
+  std::optional<InstanceScriptIds> Remove(ScriptId id);
+
+  // Records the id |script| got in |instance|. Returns false if the script
+  // has been removed in the meantime, in which case it should be removed
+  // from the instance as well.
+  bool SetInstanceScriptId(ScriptId script, InstanceId instance,
+                           std::string instance_script_id);
+
+  void RemoveInstance(InstanceId instance);
+
+  // The registered scripts in the order they were added.
+  const std::vector<Script>& scripts() const { return scripts_; }
+
+ private:
+  std::vector<Script> scripts_;
+  std::map<std::pair<ScriptId, InstanceId>, std::string> instance_script_ids_;
+  ScriptId next_id_ = 1;
+};
+
+}  // namespace util
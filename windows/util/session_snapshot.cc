@@ -0,0 +1,177 @@
+#include "session_snapshot.h"
+
+#include <utility>
+
+#include "binary_stream.h"
+
+namespace util {
+
+namespace {
+
+constexpr uint8_t kMagic[] = {'W', 'V', 'S', 'S'};
+// Version 2 added environments and profiles.
+constexpr uint8_t kVersion = 2;
+
+void WriteOptionalString(BinaryWriter& writer,
+                         const std::optional<std::string>& value) {
+  writer.WriteByte(value ? 1 : 0);
+  if (value) {
+    writer.WriteString(*value);
+  }
+}
+
+bool ReadOptionalString(BinaryReader& reader,
+                        std::optional<std::string>* value) {
+  uint8_t present;
+  if (!reader.ReadByte(&present) || present > 1) {
+    return false;
+  }
+  if (!present) {
+    value->reset();
+    return true;
+  }
+  std::string string;
+  if (!reader.ReadString(&string)) {
+    return false;
+  }
+  *value = std::move(string);
+  return true;
+}
+
+void WriteInstance(BinaryWriter& writer, const InstanceState& instance) {
+  writer.WriteSigned(instance.priority);
+  WriteOptionalString(writer, instance.environment);
+  WriteOptionalString(writer, instance.profile);
+  writer.WriteByte(instance.in_private ? 1 : 0);
+  writer.WriteString(instance.url);
+  writer.WriteDouble(instance.zoom_factor);
+  writer.WriteDouble(instance.scroll_x);
+  writer.WriteDouble(instance.scroll_y);
+  writer.WriteVarint(instance.history.size());
+  for (const auto& entry : instance.history) {
+    writer.WriteString(entry);
+  }
+  writer.WriteVarint(instance.history_index);
+  writer.WriteVarint(instance.init_scripts.size());
+  for (const auto& script : instance.init_scripts) {
+    writer.WriteString(script);
+  }
+  writer.WriteVarint(instance.host_mappings.size());
+  for (const auto& mapping : instance.host_mappings) {
+    writer.WriteString(mapping.host_name);
+    writer.WriteString(mapping.folder_path);
+    writer.WriteByte(mapping.access_kind);
+  }
+}
+
+bool ReadInstance(BinaryReader& reader, uint8_t version,
+                  InstanceState* instance) {
+  int64_t priority;
+  if (!reader.ReadSigned(&priority) || priority < INT32_MIN ||
+      priority > INT32_MAX) {
+    return false;
+  }
+  instance->priority = static_cast<int32_t>(priority);
+
+  if (version >= 2) {
+    uint8_t in_private;
+    if (!ReadOptionalString(reader, &instance->environment) ||
+        !ReadOptionalString(reader, &instance->profile) ||
+        !reader.ReadByte(&in_private) || in_private > 1) {
+      return false;
+    }
+    instance->in_private = in_private != 0;
+  }
+
+  uint64_t count;
+  if (!reader.ReadString(&instance->url) ||
+      !reader.ReadDouble(&instance->zoom_factor) ||
+      !reader.ReadDouble(&instance->scroll_x) ||
+      !reader.ReadDouble(&instance->scroll_y) || !reader.ReadCount(&count)) {
+    return false;
+  }
+
+  instance->history.resize(count);
+  for (auto& entry : instance->history) {
+    if (!reader.ReadString(&entry)) {
+      return false;
+    }
+  }
+
+  uint64_t history_index;
+  if (!reader.ReadVarint(&history_index) ||
+      (history_index != 0 && history_index >= instance->history.size()) ||
+      !reader.ReadCount(&count)) {
+    return false;
+  }
+  instance->history_index = static_cast<uint32_t>(history_index);
+
+  instance->init_scripts.resize(count);
+  for (auto& script : instance->init_scripts) {
+    if (!reader.ReadString(&script)) {
+      return false;
+    }
+  }
+
+  if (!reader.ReadCount(&count)) {
+    return false;
+  }
+  instance->host_mappings.resize(count);
+  for (auto& mapping : instance->host_mappings) {
+    if (!reader.ReadString(&mapping.host_name) ||
+        !reader.ReadString(&mapping.folder_path) ||
+        !reader.ReadByte(&mapping.access_kind)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+std::vector<uint8_t> SerializeSessionSnapshot(const SessionSnapshot& snapshot) {
+  BinaryWriter writer;
+  for (const auto byte : kMagic) {
+    writer.WriteByte(byte);
+  }
+  writer.WriteByte(kVersion);
+  writer.WriteVarint(snapshot.instances.size());
+  for (const auto& instance : snapshot.instances) {
+    WriteInstance(writer, instance);
+  }
+  return writer.Take();
+}
+
+bool DeserializeSessionSnapshot(const uint8_t* data, size_t size,
+                                SessionSnapshot* snapshot) {
+  BinaryReader reader(data, size);
+  for (const auto expected : kMagic) {
+    uint8_t byte;
+    if (!reader.ReadByte(&byte) || byte != expected) {
+      return false;
+    }
+  }
+
+  uint8_t version;
+  uint64_t count;
+  if (!reader.ReadByte(&version) || version < 1 || version > kVersion ||
+      !reader.ReadCount(&count)) {
+    return false;
+  }
+
+  SessionSnapshot result;
+  result.instances.resize(count);
+  for (auto& instance : result.instances) {
+    if (!ReadInstance(reader, version, &instance)) {
+      return false;
+    }
+  }
+  if (!reader.at_end()) {
+    return false;
+  }
+
+  *snapshot = std::move(result);
+  return true;
+}
+
+}  // namespace util
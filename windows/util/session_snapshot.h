@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace util {
+
+struct HostMapping {
+  std::string host_name;
+  std::string folder_path;
+  // WebviewHostResourceAccessKind
+  uint8_t access_kind = 0;
+};
+
+// The restorable state of a single webview instance.
+struct InstanceState {
+  // Instances with a higher priority (e.g. visible ones) are restored first.
+  int32_t priority = 0;
+  // The named environment and the profile the instance was created in. The
+  // default ones if not set.
+  std::optional<std::string> environment;
+  std::optional<std::string> profile;
+  bool in_private = false;
+  std::string url;
+  double zoom_factor = 1.0;
+  double scroll_x = 0;
+  double scroll_y = 0;
+  // The session history. |history_index| points at the current entry.
+  std::vector<std::string> history;
+  uint32_t history_index = 0;
+  std::vector<std::string> init_scripts;
+  std::vector<HostMapping> host_mappings;
+};
+
+struct SessionSnapshot {
+  std::vector<InstanceState> instances;
+};
+
+// Encodes |snapshot| into a compact binary format: a magic number and a
+// version followed by varint counts, length-prefixed strings and
+// little-endian doubles.
+std::vector<uint8_t> SerializeSessionSnapshot(const SessionSnapshot& snapshot);
+
+// Decodes a snapshot written by SerializeSessionSnapshot. Returns false if
+// |data| is truncated, malformed or of an unknown version. Version 1
+// snapshots, which lack environments and profiles, are still accepted.
+bool DeserializeSessionSnapshot(const uint8_t* data, size_t size,
+                                SessionSnapshot* snapshot);
+
+}  // namespace util
@@ -0,0 +1,130 @@
+#include "shard_balancer.h"
+
+#include <algorithm>
+#include <optional>
+
+namespace util {
+
+ShardBalancer::ShardBalancer(size_t shard_count)
+    : loads_(std::max<size_t>(shard_count, 1), 0),
+      usable_(loads_.size(), true) {}
+
+bool ShardBalancer::SetShardCount(size_t shard_count) {
+  if (!instances_.empty()) {
+    return false;
+  }
+  loads_.assign(std::max<size_t>(shard_count, 1), 0);
+  usable_.assign(loads_.size(), true);
+  return true;
+}
+
+size_t ShardBalancer::PickShard() const {
+  std::optional<size_t> least_loaded;
+  for (size_t shard = 0; shard < loads_.size(); shard++) {
+    if (usable_[shard] &&
+        (!least_loaded || loads_[shard] < loads_[*least_loaded])) {
+      least_loaded = shard;
+    }
+  }
+  return least_loaded.value_or(0);
+}
+
+void ShardBalancer::DisableShard(size_t shard) {
+  if (shard < usable_.size()) {
+    usable_[shard] = false;
+  }
+}
+
+void ShardBalancer::Add(int64_t instance, size_t shard, uint64_t weight) {
+  if (shard >= loads_.size()) {
+    return;
+  }
+  Remove(instance);
+  instances_[instance] = {shard, weight};
+  loads_[shard] += weight;
+}
+
+bool ShardBalancer::Reassign(int64_t instance, size_t shard) {
+  const auto it = instances_.find(instance);
+  if (it == instances_.end() || shard >= loads_.size()) {
+    return false;
+  }
+  auto& assignment = it->second;
+  loads_[assignment.shard] -= assignment.weight;
+  loads_[shard] += assignment.weight;
+  assignment.shard = shard;
+  return true;
+}
+
+void ShardBalancer::UpdateWeight(int64_t instance, uint64_t weight) {
+  const auto it = instances_.find(instance);
+  if (it != instances_.end()) {
+    auto& assignment = it->second;
+    loads_[assignment.shard] -= assignment.weight;
+    loads_[assignment.shard] += weight;
+    assignment.weight = weight;
+  }
+}
+
+void ShardBalancer::Remove(int64_t instance) {
+  const auto it = instances_.find(instance);
+  if (it != instances_.end()) {
+    loads_[it->second.shard] -= it->second.weight;
+    instances_.erase(it);
+  }
+}
+
+std::optional<size_t> ShardBalancer::ShardOf(int64_t instance) const {
+  const auto it = instances_.find(instance);
+  if (it != instances_.end()) {
+    return it->second.shard;
+  }
+  return std::nullopt;
+}
+
+std::vector<ShardBalancer::Move> ShardBalancer::Rebalance(size_t max_moves) {
+  std::vector<Move> moves;
+
+  while (moves.size() < max_moves) {
+    const size_t from = std::distance(
+        loads_.begin(), std::max_element(loads_.begin(), loads_.end()));
+    const size_t to = PickShard();
+    if (!usable_[to] || loads_[from] <= loads_[to]) {
+      break;
+    }
+    const uint64_t diff = loads_[from] - loads_[to];
+
+    // Moving an instance of weight w changes the difference to |diff - 2w|,
+    // which is an improvement for 0 < w < diff. Pick the one coming closest
+    // to an even split (ties go to the lowest instance id).
+    std::optional<int64_t> candidate;
+    uint64_t best_distance = 0;
+    for (const auto& [instance, assignment] : instances_) {
+      if (assignment.shard != from || assignment.weight == 0 ||
+          assignment.weight >= diff) {
+        continue;
+      }
+      const uint64_t twice = 2 * assignment.weight;
+      const uint64_t distance = twice > diff ? twice - diff : diff - twice;
+      if (!candidate || distance < best_distance ||
+          (distance == best_distance && instance < *candidate)) {
+        candidate = instance;
+        best_distance = distance;
+      }
+    }
+
+    if (!candidate) {
+      break;
+    }
+
+    auto& assignment = instances_[*candidate];
+    loads_[from] -= assignment.weight;
+    loads_[to] += assignment.weight;
+    assignment.shard = to;
+    moves.push_back({*candidate, from, to});
+  }
+
+  return moves;
+}
+
+}  // namespace util
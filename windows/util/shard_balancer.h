@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+namespace util {
+
+// Distributes weighted instances across a fixed number of shards.
+class ShardBalancer {
+ public:
+  struct Move {
+    int64_t instance;
+    size_t from;
+    size_t to;
+  };
+
+  explicit ShardBalancer(size_t shard_count = 1);
+
+  size_t shard_count() const { return loads_.size(); }
+
+  // Changes the number of shards. Only allowed while no instances are
+  // assigned.
+  bool SetShardCount(size_t shard_count);
+
+  // Returns the least loaded usable shard, or 0 if none is usable.
+  size_t PickShard() const;
+
+  // Excludes |shard| from PickShard and as the target of Rebalance, e.g.
+  // because its resources couldn't be created. Instances assigned to it
+  // stay until moved. Changing the shard count makes all shards usable
+  // again.
+  void DisableShard(size_t shard);
+  bool IsUsable(size_t shard) const {
+    return shard < usable_.size() && usable_[shard];
+  }
+
+  void Add(int64_t instance, size_t shard, uint64_t weight);
+  // Moves an instance to |shard|, keeping its weight. Returns false if it
+  // isn't assigned.
+  bool Reassign(int64_t instance, size_t shard);
+  void UpdateWeight(int64_t instance, uint64_t weight);
+  void Remove(int64_t instance);
+
+  std::optional<size_t> ShardOf(int64_t instance) const;
+  uint64_t LoadOf(size_t shard) const { return loads_[shard]; }
+
+  // Moves up to |max_moves| instances from the most loaded shard to the
+  // least loaded usable one. An instance is only moved if doing so strictly
+  // reduces the difference between both shards. The applied moves are
+  // returned.
+  std::vector<Move> Rebalance(size_t max_moves = 1);
+
+ private:
+  struct Assignment {
+    size_t shard;
+    uint64_t weight;
+  };
+
+  std::vector<uint64_t> loads_;
+  std::vector<bool> usable_;
+  std::unordered_map<int64_t, Assignment> instances_;
+};
+
+}  // namespace util
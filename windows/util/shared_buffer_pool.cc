@@ -0,0 +1,132 @@
+#include "shared_buffer_pool.h"
+
+namespace util {
+
+size_t SharedBufferPool::GetCapacity(size_t size) {
+  if (size == 0) {
+    return kPageSize;
+  }
+  return (size + kPageSize - 1) / kPageSize * kPageSize;
+}
+
+SharedBufferPool::Allocation SharedBufferPool::Acquire(const std::string& name,
+                                                       size_t size) {
+  const auto capacity = GetCapacity(size);
+
+  const auto it = bound_.find(name);
+  if (it != bound_.end()) {
+    auto& buffer = it->second;
+    if (buffer.capacity >= capacity) {
+      buffer.size = size;
+      return {buffer.id, buffer.capacity, false};
+    }
+    Recycle(buffer);
+    bound_.erase(it);
+  }
+
+  // Pick the smallest pooled buffer that fits, but don't waste more than
+  // half of a buffer.
+  auto best = pooled_.end();
+  for (auto pooled = pooled_.begin(); pooled != pooled_.end(); ++pooled) {
+    if (pooled->capacity >= capacity && pooled->capacity / 2 <= capacity &&
+        (best == pooled_.end() || pooled->capacity < best->capacity)) {
+      best = pooled;
+    }
+  }
+
+  if (best != pooled_.end()) {
+    const auto buffer = Buffer{best->id, best->capacity, size, false};
+    pooled_bytes_ -= best->capacity;
+    pooled_.erase(best);
+    bound_[name] = buffer;
+    return {buffer.id, buffer.capacity, false};
+  }
+
+  const auto buffer = Buffer{next_id_++, capacity, size, false};
+  bound_[name] = buffer;
+  return {buffer.id, buffer.capacity, true};
+}
+
+std::optional<SharedBufferPool::BufferId> SharedBufferPool::Find(
+    const std::string& name) const {
+  const auto it = bound_.find(name);
+  if (it == bound_.end()) {
+    return std::nullopt;
+  }
+  return it->second.id;
+}
+
+size_t SharedBufferPool::SizeOf(const std::string& name) const {
+  const auto it = bound_.find(name);
+  return it != bound_.end() ? it->second.size : 0;
+}
+
+bool SharedBufferPool::MarkPosted(const std::string& name) {
+  const auto it = bound_.find(name);
+  if (it == bound_.end()) {
+    return false;
+  }
+  it->second.posted = true;
+  return true;
+}
+
+std::optional<SharedBufferPool::BufferId> SharedBufferPool::Transfer(
+    const std::string& name) {
+  const auto it = bound_.find(name);
+  if (it == bound_.end()) {
+    return std::nullopt;
+  }
+  const auto id = it->second.id;
+  bound_.erase(it);
+  closed_.push_back(id);
+  return id;
+}
+
+bool SharedBufferPool::Release(const std::string& name) {
+  const auto it = bound_.find(name);
+  if (it == bound_.end()) {
+    return false;
+  }
+  Recycle(it->second);
+  bound_.erase(it);
+  return true;
+}
+
+void SharedBufferPool::ReleaseAll() {
+  for (const auto& [name, buffer] : bound_) {
+    closed_.push_back(buffer.id);
+  }
+  for (const auto& pooled : pooled_) {
+    closed_.push_back(pooled.id);
+  }
+  bound_.clear();
+  pooled_.clear();
+  pooled_bytes_ = 0;
+}
+
+std::vector<SharedBufferPool::BufferId> SharedBufferPool::TakeClosedBuffers() {
+  // Moving from |closed_| would leave it in an unspecified state.
+  std::vector<BufferId> closed;
+  closed.swap(closed_);
+  return closed;
+}
+
+void SharedBufferPool::Recycle(const Buffer& buffer) {
+  if (buffer.posted || buffer.capacity > max_pooled_bytes_) {
+    closed_.push_back(buffer.id);
+    return;
+  }
+
+  pooled_.push_back({buffer.id, buffer.capacity});
+  pooled_bytes_ += buffer.capacity;
+  // Evict the oldest buffers until the pool fits again.
+  auto evicted = pooled_.begin();
+  while (pooled_bytes_ > max_pooled_bytes_) {
+    pooled_bytes_ -= evicted->capacity;
+    closed_.push_back(evicted->id);
+    ++evicted;
+  }
+  pooled_.erase(pooled_.begin(), evicted);
+}
+
+}  // namespace util
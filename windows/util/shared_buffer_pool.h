@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace util {
+
+// Keeps track of named buffers shared with scripts and recycles their
+// memory. The pool only hands out ids; allocating and closing the actual
+// buffers is up to the caller.
+//
+// A buffer stays owned by the host until it is transferred. Buffers which
+// have been posted to a script are never recycled under another name, as
+// the script may still have access to them.
+class SharedBufferPool {
+ public:
+  typedef uint64_t BufferId;
+
+  struct Allocation {
+    BufferId id;
+    size_t capacity;
+    // Whether the caller must allocate a buffer of |capacity| bytes.
+    bool is_new;
+  };
+
+  // Capacities are rounded up to whole pages.
+  static constexpr size_t kPageSize = 4096;
+  static constexpr size_t kDefaultMaxPooledBytes = 64 * 1024 * 1024;
+
+  explicit SharedBufferPool(size_t max_pooled_bytes = kDefaultMaxPooledBytes)
+      : max_pooled_bytes_(max_pooled_bytes) {}
+
+  // Binds |name| to a buffer holding at least |size| bytes. The buffer
+  // already bound to |name| is written in place if it is large enough.
+  // Otherwise it is released and the closest fitting pooled buffer is
+  // reused, if any.
+  Allocation Acquire(const std::string& name, size_t size);
+
+  std::optional<BufferId> Find(const std::string& name) const;
+
+  // The number of bytes written by the last Acquire.
+  size_t SizeOf(const std::string& name) const;
+
+  // Marks the buffer as visible to scripts.
+  bool MarkPosted(const std::string& name);
+
+  // Unbinds |name| and hands the buffer over to scripts. The caller posts
+  // and then closes its own reference.
+  std::optional<BufferId> Transfer(const std::string& name);
+
+  // Unbinds |name|. The buffer is pooled unless it has been posted or the
+  // pool is full.
+  bool Release(const std::string& name);
+
+  // Closes all buffers, pooled ones included.
+  void ReleaseAll();
+
+  // Returns the buffers the caller must close since the last call.
+  std::vector<BufferId> TakeClosedBuffers();
+
+  size_t bound_count() const { return bound_.size(); }
+  size_t pooled_count() const { return pooled_.size(); }
+  size_t pooled_bytes() const { return pooled_bytes_; }
+
+  static size_t GetCapacity(size_t size);
+
+ private:
+  struct Buffer {
+    BufferId id;
+    size_t capacity;
+    size_t size;
+    bool posted;
+  };
+
+  struct PooledBuffer {
+    BufferId id;
+    size_t capacity;
+  };
+
+  const size_t max_pooled_bytes_;
+  std::unordered_map<std::string, Buffer> bound_;
+  // Oldest first.
+  std::vector<PooledBuffer> pooled_;
+  size_t pooled_bytes_ = 0;
+  std::vector<BufferId> closed_;
+  BufferId next_id_ = 1;
+
+  void Recycle(const Buffer& buffer);
+};
+
+}  // namespace util
@@ -0,0 +1,122 @@
+#include "string_stream.h"
+
+#include <wrl.h>
+
+#include <algorithm>
+#include <mutex>
+
+namespace util {
+
+namespace {
+
+using namespace Microsoft::WRL;
+
+class StringStream
+    : public RuntimeClass<RuntimeClassFlags<ClassicCom>,
+                          ChainInterfaces<IStream, ISequentialStream>,
+                          FtmBase> {
+ public:
+  explicit StringStream(std::shared_ptr<const std::string> data)
+      : data_(std::move(data)) {}
+
+  // ISequentialStream
+  STDMETHODIMP Read(void* buffer, ULONG size, ULONG* read) override {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    const uint64_t available =
+        position_ < data_->size() ? data_->size() - position_ : 0;
+    const auto count = static_cast<ULONG>(std::min<uint64_t>(size, available));
+    if (count > 0) {
+      memcpy(buffer, data_->data() + position_, count);
+      position_ += count;
+    }
+    if (read) {
+      *read = count;
+    }
+    return count < size ? S_FALSE : S_OK;
+  }
+
+  STDMETHODIMP Write(const void*, ULONG, ULONG*) override {
+    return STG_E_ACCESSDENIED;
+  }
+
+  // IStream
+  STDMETHODIMP Seek(LARGE_INTEGER move, DWORD origin,
+                    ULARGE_INTEGER* new_position) override {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    int64_t base;
+    switch (origin) {
+      case STREAM_SEEK_SET:
+        base = 0;
+        break;
+      case STREAM_SEEK_CUR:
+        base = static_cast<int64_t>(position_);
+        break;
+      case STREAM_SEEK_END:
+        base = static_cast<int64_t>(data_->size());
+        break;
+      default:
+        return STG_E_INVALIDFUNCTION;
+    }
+    if (base + move.QuadPart < 0) {
+      return STG_E_INVALIDFUNCTION;
+    }
+    position_ = static_cast<uint64_t>(base + move.QuadPart);
+    if (new_position) {
+      new_position->QuadPart = position_;
+    }
+    return S_OK;
+  }
+
+  STDMETHODIMP SetSize(ULARGE_INTEGER) override { return STG_E_ACCESSDENIED; }
+
+  STDMETHODIMP CopyTo(IStream*, ULARGE_INTEGER, ULARGE_INTEGER*,
+                      ULARGE_INTEGER*) override {
+    return E_NOTIMPL;
+  }
+
+  STDMETHODIMP Commit(DWORD) override { return S_OK; }
+
+  STDMETHODIMP Revert() override { return E_NOTIMPL; }
+
+  STDMETHODIMP LockRegion(ULARGE_INTEGER, ULARGE_INTEGER, DWORD) override {
+    return STG_E_INVALIDFUNCTION;
+  }
+
+  STDMETHODIMP UnlockRegion(ULARGE_INTEGER, ULARGE_INTEGER, DWORD) override {
+    return STG_E_INVALIDFUNCTION;
+  }
+
+  STDMETHODIMP Stat(STATSTG* stat, DWORD) override {
+    if (!stat) {
+      return STG_E_INVALIDPOINTER;
+    }
+    *stat = {};
+    stat->type = STGTY_STREAM;
+    stat->cbSize.QuadPart = data_->size();
+    stat->grfMode = STGM_READ;
+    return S_OK;
+  }
+
+  STDMETHODIMP Clone(IStream**) override { return E_NOTIMPL; }
+
+ private:
+  const std::shared_ptr<const std::string> data_;
+  std::mutex mutex_;
+  uint64_t position_ = 0;
+};
+
+}  // namespace
+
+wil::com_ptr<IStream> CreateStringStream(std::string data) {
+  return CreateStringStream(
+      std::make_shared<const std::string>(std::move(data)));
+}
+
+wil::com_ptr<IStream> CreateStringStream(
+    std::shared_ptr<const std::string> data) {
+  wil::com_ptr<IStream> stream;
+  stream.attach(Make<StringStream>(std::move(data)).Detach());
+  return stream;
+}
+
+}  // namespace util
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <objidl.h>
+#include <wil/com.h>
+
+#include <memory>
+#include <string>
+
+namespace util {
+
+// Creates a read-only, free-threaded IStream serving the bytes of |data|
+// without copying them.
+wil::com_ptr<IStream> CreateStringStream(std::string data);
+wil::com_ptr<IStream> CreateStringStream(
+    std::shared_ptr<const std::string> data);
+
+}  // namespace util
@@ -0,0 +1,64 @@
+#include "task_monitor.h"
+
+#include <algorithm>
+
+namespace util {
+
+TaskMonitor::Scope::Scope(TaskMonitor* monitor, std::string name)
+    : monitor_(monitor), name_(std::move(name)) {
+  if (monitor_) {
+    start_ = Clock::now();
+  }
+}
+
+TaskMonitor::Scope::~Scope() {
+  if (monitor_) {
+    const auto end = Clock::now();
+    monitor_->Record(name_, end - start_, end);
+  }
+}
+
+bool TaskMonitor::Record(std::string_view name, Clock::duration duration,
+                         Clock::time_point end) {
+  auto it = stats_.find(name);
+  if (it == stats_.end()) {
+    it = stats_.emplace(std::string(name), TaskStats()).first;
+  }
+
+  auto& stats = it->second;
+  stats.count++;
+  stats.total += duration;
+  stats.max = std::max(stats.max, duration);
+  stats.histogram[BucketOf(duration)]++;
+
+  if (duration <= budget_) {
+    return false;
+  }
+
+  stats.long_count++;
+  if (long_tasks_.size() == kMaxLongTasks) {
+    long_tasks_.pop_front();
+  }
+  long_tasks_.push_back({std::string(name), duration, end});
+  if (long_task_callback_) {
+    long_task_callback_(long_tasks_.back());
+  }
+  return true;
+}
+
+void TaskMonitor::Reset() {
+  stats_.clear();
+  long_tasks_.clear();
+}
+
+// static
+size_t TaskMonitor::BucketOf(Clock::duration duration) {
+  const auto bound = std::upper_bound(
+      kBucketBoundsMs.begin(), kBucketBoundsMs.end(), duration,
+      [](Clock::duration value, int bound_ms) {
+        return value < std::chrono::milliseconds(bound_ms);
+      });
+  return std::distance(kBucketBoundsMs.begin(), bound);
+}
+
+}  // namespace util
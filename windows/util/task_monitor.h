@@ -0,0 +1,98 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <string>
+#include <string_view>
+
+namespace util {
+
+// Times work running on the platform thread (method calls, WebView2
+// callbacks) against a budget. Keeps statistics and a latency histogram per
+// task name, and the most recent tasks which exceeded the budget.
+//
+// Nested tasks are recorded individually, so the time of a task includes
+// the time of the tasks it ran synchronously.
+class TaskMonitor {
+ public:
+  typedef std::chrono::steady_clock Clock;
+
+  // The exclusive upper bounds of the histogram buckets. The last bucket
+  // holds everything above.
+  static constexpr std::array<int, 9> kBucketBoundsMs = {1,  2,  4,   8,  16,
+                                                         32, 64, 128, 256};
+  static constexpr size_t kBucketCount = kBucketBoundsMs.size() + 1;
+
+  // Half of a frame at 60Hz.
+  static constexpr Clock::duration kDefaultBudget =
+      std::chrono::milliseconds(8);
+  static constexpr size_t kMaxLongTasks = 64;
+
+  struct TaskStats {
+    uint64_t count = 0;
+    uint64_t long_count = 0;
+    Clock::duration total = Clock::duration::zero();
+    Clock::duration max = Clock::duration::zero();
+    std::array<uint64_t, kBucketCount> histogram = {};
+  };
+
+  struct LongTask {
+    std::string name;
+    Clock::duration duration;
+    Clock::time_point end;
+  };
+
+  typedef std::function<void(const LongTask& task)> LongTaskCallback;
+
+  // Records the time from construction to destruction. |monitor| may be
+  // nullptr, in which case nothing is recorded.
+  class Scope {
+   public:
+    Scope(TaskMonitor* monitor, std::string name);
+    ~Scope();
+
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+   private:
+    TaskMonitor* monitor_;
+    std::string name_;
+    Clock::time_point start_;
+  };
+
+  void set_budget(Clock::duration budget) { budget_ = budget; }
+  Clock::duration budget() const { return budget_; }
+
+  // Called for every task exceeding the budget.
+  void SetOnLongTask(LongTaskCallback callback) {
+    long_task_callback_ = std::move(callback);
+  }
+
+  // Records a finished task. Returns whether it exceeded the budget.
+  bool Record(std::string_view name, Clock::duration duration,
+              Clock::time_point end);
+
+  const std::map<std::string, TaskStats, std::less<>>& stats() const {
+    return stats_;
+  }
+
+  // Oldest first.
+  const std::deque<LongTask>& long_tasks() const { return long_tasks_; }
+
+  void Reset();
+
+  static size_t BucketOf(Clock::duration duration);
+
+ private:
+  Clock::duration budget_ = kDefaultBudget;
+  std::map<std::string, TaskStats, std::less<>> stats_;
+  std::deque<LongTask> long_tasks_;
+  LongTaskCallback long_task_callback_;
+};
+
+}  // namespace util
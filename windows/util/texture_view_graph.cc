@@ -0,0 +1,76 @@
+#include "texture_view_graph.h"
+
+#include <tuple>
+
+namespace util {
+
+bool TextureCopy::operator<(const TextureCopy& other) const {
+  return std::tie(source.left, source.top, source.right, source.bottom, width,
+                  height) < std::tie(other.source.left, other.source.top,
+                                     other.source.right, other.source.bottom,
+                                     other.width, other.height);
+}
+
+bool TextureCopy::operator==(const TextureCopy& other) const {
+  return source == other.source && width == other.width &&
+         height == other.height;
+}
+
+TextureViewGraph::ViewId TextureViewGraph::AddView(
+    const TextureViewSpec& spec) {
+  const auto id = next_view_id_++;
+  views_[id] = spec;
+  return id;
+}
+
+bool TextureViewGraph::RemoveView(ViewId view) {
+  return views_.erase(view) != 0;
+}
+
+std::optional<TextureCopy> TextureViewGraph::Resolve(
+    ViewId view, uint32_t frame_width, uint32_t frame_height) const {
+  const auto it = views_.find(view);
+  if (it == views_.end()) {
+    return std::nullopt;
+  }
+
+  const auto& spec = it->second;
+  const Rect frame{0, 0, static_cast<int32_t>(frame_width),
+                   static_cast<int32_t>(frame_height)};
+  const Rect source =
+      spec.source_rect ? ClipToSurface(*spec.source_rect, frame_width,
+                                       frame_height)
+                       : frame;
+  if (source.IsEmpty()) {
+    return std::nullopt;
+  }
+
+  TextureCopy copy;
+  copy.source = source;
+  copy.width = spec.width.value_or(static_cast<uint32_t>(source.width()));
+  copy.height = spec.height.value_or(static_cast<uint32_t>(source.height()));
+  if (copy.width == 0 || copy.height == 0) {
+    return std::nullopt;
+  }
+  return copy;
+}
+
+std::vector<TextureViewGraph::CopyJob> TextureViewGraph::ResolveAll(
+    uint32_t frame_width, uint32_t frame_height) const {
+  std::map<TextureCopy, std::vector<ViewId>> grouped;
+  for (const auto& [id, spec] : views_) {
+    const auto copy = Resolve(id, frame_width, frame_height);
+    if (copy) {
+      grouped[*copy].push_back(id);
+    }
+  }
+
+  std::vector<CopyJob> jobs;
+  jobs.reserve(grouped.size());
+  for (auto& [copy, views] : grouped) {
+    jobs.push_back({copy, std::move(views)});
+  }
+  return jobs;
+}
+
+}  // namespace util
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <vector>
+
+#include "rect.h"
+
+namespace util {
+
+// Describes a texture derived from a captured frame.
+struct TextureViewSpec {
+  // The region of the frame (in physical pixels) to show. Defaults to the
+  // entire frame.
+  std::optional<Rect> source_rect;
+  // The size of the resulting texture. Defaults to the size of the source
+  // region, i.e. no scaling.
+  std::optional<uint32_t> width;
+  std::optional<uint32_t> height;
+};
+
+// A single copy (and optionally scale) operation from a frame into a
+// destination texture.
+struct TextureCopy {
+  Rect source;
+  uint32_t width = 0;
+  uint32_t height = 0;
+
+  bool needs_scaling() const {
+    return static_cast<uint32_t>(source.width()) != width ||
+           static_cast<uint32_t>(source.height()) != height;
+  }
+
+  bool operator<(const TextureCopy& other) const;
+  bool operator==(const TextureCopy& other) const;
+};
+
+// Keeps track of the views fed by a single capture and determines the
+// copies required to update them. Views resolving to identical copies
+// share a single copy.
+class TextureViewGraph {
+ public:
+  typedef int64_t ViewId;
+
+  struct CopyJob {
+    TextureCopy copy;
+    std::vector<ViewId> views;
+  };
+
+  ViewId AddView(const TextureViewSpec& spec);
+  bool RemoveView(ViewId view);
+  bool HasView(ViewId view) const { return views_.count(view) != 0; }
+  bool empty() const { return views_.empty(); }
+  size_t size() const { return views_.size(); }
+
+  // Resolves the copy for a single view. Returns std::nullopt if the view
+  // doesn't exist or its source region lies outside of the frame.
+  std::optional<TextureCopy> Resolve(ViewId view, uint32_t frame_width,
+                                     uint32_t frame_height) const;
+
+  // Resolves all views for a frame of the given size.
+  std::vector<CopyJob> ResolveAll(uint32_t frame_width,
+                                  uint32_t frame_height) const;
+
+ private:
+  ViewId next_view_id_ = 1;
+  std::map<ViewId, TextureViewSpec> views_;
+};
+
+}  // namespace util
@@ -0,0 +1,71 @@
+#include "url_origin.h"
+
+#include <algorithm>
+#include <cctype>
+
+namespace util {
+
+namespace {
+
+bool IsValid(std::string_view value, std::string_view extra) {
+  return std::all_of(value.begin(), value.end(), [extra](char c) {
+    return std::isalnum(static_cast<unsigned char>(c)) ||
+           extra.find(c) != std::string_view::npos;
+  });
+}
+
+}  // namespace
+
+std::optional<std::string> NormalizeOrigin(std::string_view url) {
+  const auto scheme_end = url.find("://");
+  if (scheme_end == std::string_view::npos || scheme_end == 0 ||
+      !std::isalpha(static_cast<unsigned char>(url[0]))) {
+    return std::nullopt;
+  }
+  const auto scheme = url.substr(0, scheme_end);
+
+  auto authority = url.substr(scheme_end + 3);
+  authority = authority.substr(0, authority.find_first_of("/?#"));
+
+  // Skip IPv6 literals when looking for the port.
+  const auto host_end = authority.empty() || authority[0] != '['
+                            ? 0
+                            : authority.find(']');
+  if (host_end == std::string_view::npos) {
+    return std::nullopt;
+  }
+  auto host = authority;
+  std::string_view port;
+  const auto colon = authority.find(':', host_end);
+  if (colon != std::string_view::npos) {
+    host = authority.substr(0, colon);
+    port = authority.substr(colon + 1);
+  }
+
+  // User info ("user:password@") is rejected by the character checks.
+  if (host.empty() || !IsValid(scheme, "+-.") ||
+      !IsValid(host, host[0] == '[' ? ".:[]" : "-._") ||
+      !std::all_of(port.begin(), port.end(),
+                   [](char c) { return c >= '0' && c <= '9'; }) ||
+      (host[0] == '[' && host_end != host.size() - 1)) {
+    return std::nullopt;
+  }
+
+  std::string origin(scheme);
+  origin += "://";
+  origin += host;
+  std::transform(origin.begin(), origin.end(), origin.begin(), [](char c) {
+    return static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+  });
+
+  const bool is_default_port =
+      (origin.rfind("http://", 0) == 0 && port == "80") ||
+      (origin.rfind("https://", 0) == 0 && port == "443");
+  if (!port.empty() && !is_default_port) {
+    origin += ":";
+    origin += port;
+  }
+  return origin;
+}
+
+}  // namespace util
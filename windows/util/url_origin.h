@@ -0,0 +1,17 @@
+#pragma once
+
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace util {
+
+// Reduces a URL to its origin ("scheme://host[:port]"), lowercased and
+// without the default ports of http and https, e.g.
+// "HTTPS://Example.com:443/path" becomes "https://example.com". Returns
+// std::nullopt for URLs without a host, with user info, or with characters
+// outside those valid in schemes, hosts and ports, which also keeps origins
+// safe to embed in JSON.
+std::optional<std::string> NormalizeOrigin(std::string_view url);
+
+}  // namespace util
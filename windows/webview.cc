@@ -2,10 +2,13 @@
 
 #include <wrl.h>
 
+#include <algorithm>
 #include <format>
 #include <iostream>
 
 #include "util/composition.desktop.interop.h"
+#include "util/json.h"
+#include "util/string_stream.h"
 #include "util/string_converter.h"
 #include "webview_host.h"
 
@@ -20,6 +23,164 @@ inline void ConvertColor(COREWEBVIEW2_COLOR& webview_color, int32_t color) {
   webview_color.A = (color >> 24) & 0xFF;
 }
 
+util::Cookie ConvertCookie(ICoreWebView2Cookie* cookie) {
+  util::Cookie result;
+
+  wil::unique_cotaskmem_string name;
+  if (cookie->get_Name(&name) == S_OK) {
+    result.name = util::Utf8FromUtf16(name.get());
+  }
+  wil::unique_cotaskmem_string value;
+  if (cookie->get_Value(&value) == S_OK) {
+    result.value = util::Utf8FromUtf16(value.get());
+  }
+  wil::unique_cotaskmem_string domain;
+  if (cookie->get_Domain(&domain) == S_OK) {
+    result.domain = util::Utf8FromUtf16(domain.get());
+  }
+  wil::unique_cotaskmem_string path;
+  if (cookie->get_Path(&path) == S_OK) {
+    result.path = util::Utf8FromUtf16(path.get());
+  }
+
+  BOOL flag = FALSE;
+  if (cookie->get_IsSession(&flag) == S_OK) {
+    result.is_session = flag;
+  }
+  if (!result.is_session) {
+    cookie->get_Expires(&result.expires);
+  }
+  if (cookie->get_IsHttpOnly(&flag) == S_OK) {
+    result.is_http_only = flag;
+  }
+  if (cookie->get_IsSecure(&flag) == S_OK) {
+    result.is_secure = flag;
+  }
+
+  COREWEBVIEW2_COOKIE_SAME_SITE_KIND same_site;
+  if (cookie->get_SameSite(&same_site) == S_OK) {
+    switch (same_site) {
+      case COREWEBVIEW2_COOKIE_SAME_SITE_KIND_NONE:
+        result.same_site = util::CookieSameSite::kNone;
+        break;
+      case COREWEBVIEW2_COOKIE_SAME_SITE_KIND_STRICT:
+        result.same_site = util::CookieSameSite::kStrict;
+        break;
+      default:
+        result.same_site = util::CookieSameSite::kLax;
+        break;
+    }
+  }
+  return result;
+}
+
+COREWEBVIEW2_COOKIE_SAME_SITE_KIND ConvertSameSite(
+    util::CookieSameSite same_site) {
+  switch (same_site) {
+    case util::CookieSameSite::kNone:
+      return COREWEBVIEW2_COOKIE_SAME_SITE_KIND_NONE;
+    case util::CookieSameSite::kStrict:
+      return COREWEBVIEW2_COOKIE_SAME_SITE_KIND_STRICT;
+    default:
+      return COREWEBVIEW2_COOKIE_SAME_SITE_KIND_LAX;
+  }
+}
+
+// Collects the cookies of |list| matching |filter| and passes them to
+// |callback| along with the corresponding cookie objects.
+void VisitCookies(
+    ICoreWebView2CookieList* list, const util::CookieFilter& filter,
+    const std::function<void(ICoreWebView2Cookie*, util::Cookie)>& callback) {
+  UINT count = 0;
+  if (!list || list->get_Count(&count) != S_OK) {
+    return;
+  }
+
+  for (UINT i = 0; i < count; i++) {
+    wil::com_ptr<ICoreWebView2Cookie> cookie;
+    if (list->GetValueAtIndex(i, cookie.put()) != S_OK) {
+      continue;
+    }
+    auto converted = ConvertCookie(cookie.get());
+    if (filter.Matches(converted)) {
+      callback(cookie.get(), std::move(converted));
+    }
+  }
+}
+
+struct ClearBrowsingDataOperation {
+  wil::com_ptr<ICoreWebView2> webview;
+  std::vector<util::ClearBrowsingDataStep> steps;
+  std::optional<Webview::TimeRange> time_range;
+  size_t completed = 0;
+  bool success = true;
+  Webview::ClearBrowsingDataProgressCallback progress_callback;
+  Webview::ClearBrowsingDataCompletedCallback completed_callback;
+};
+
+HRESULT ClearBrowsingDataStep(ICoreWebView2* webview,
+                              const util::ClearBrowsingDataStep& step,
+                              const std::optional<Webview::TimeRange>& range,
+                              std::function<void(bool)> done) {
+  if (step.origin) {
+    const auto json =
+        std::format(R"({{"origin":"{}","storageTypes":"{}"}})", *step.origin,
+                    util::GetOriginStorageTypes(step.kinds));
+    return webview->CallDevToolsProtocolMethod(
+        L"Storage.clearDataForOrigin", util::Utf16FromUtf8(json).c_str(),
+        Callback<ICoreWebView2CallDevToolsProtocolMethodCompletedHandler>(
+            [done](HRESULT result, LPCWSTR json_result) -> HRESULT {
+              done(SUCCEEDED(result));
+              return S_OK;
+            })
+            .Get());
+  }
+
+  wil::com_ptr<ICoreWebView2Profile> profile;
+  auto webview13 = wil::try_com_query<ICoreWebView2_13>(webview);
+  if (!webview13 || FAILED(webview13->get_Profile(profile.put()))) {
+    return E_NOINTERFACE;
+  }
+  auto profile2 = profile.try_query<ICoreWebView2Profile2>();
+  if (!profile2) {
+    return E_NOINTERFACE;
+  }
+
+  const auto kinds = static_cast<COREWEBVIEW2_BROWSING_DATA_KINDS>(step.kinds);
+  auto handler = Callback<ICoreWebView2ClearBrowsingDataCompletedHandler>(
+      [done](HRESULT result) -> HRESULT {
+        done(SUCCEEDED(result));
+        return S_OK;
+      });
+  if (range) {
+    return profile2->ClearBrowsingDataInTimeRange(kinds, range->first,
+                                                  range->second, handler.Get());
+  }
+  return profile2->ClearBrowsingData(kinds, handler.Get());
+}
+
+void RunClearBrowsingData(
+    std::shared_ptr<ClearBrowsingDataOperation> operation) {
+  if (operation->completed == operation->steps.size()) {
+    operation->completed_callback(operation->success);
+    return;
+  }
+
+  const auto on_step_done = [operation](bool success) {
+    operation->success &= success;
+    operation->completed++;
+    operation->progress_callback(operation->completed,
+                                 operation->steps.size());
+    RunClearBrowsingData(operation);
+  };
+
+  const auto& step = operation->steps[operation->completed];
+  if (FAILED(ClearBrowsingDataStep(operation->webview.get(), step,
+                                   operation->time_range, on_step_done))) {
+    on_step_done(false);
+  }
+}
+
 inline WebviewPermissionKind CW2PermissionKindToPermissionKind(
     COREWEBVIEW2_PERMISSION_KIND kind) {
   using k = COREWEBVIEW2_PERMISSION_KIND;
@@ -54,6 +215,29 @@ inline COREWEBVIEW2_PERMISSION_STATE WebViewPermissionStateToCW2PermissionState(
   }
 }
 
+// Reads the result of Page.getNavigationHistory into |state|.
+void ParseNavigationHistory(const std::string& json,
+                            util::InstanceState* state) {
+  const auto value = util::JsonValue::Parse(json);
+  const auto index = value ? value->Find("currentIndex") : nullptr;
+  const auto entries = value ? value->Find("entries") : nullptr;
+  if (!index || !entries || !entries->is_array()) {
+    return;
+  }
+
+  std::vector<std::string> history;
+  for (const auto& entry : entries->array_value()) {
+    const auto url = entry.Find("url");
+    history.push_back(url && url->is_string() ? url->string_value()
+                                              : std::string());
+  }
+  const double current = index->number_value();
+  if (current >= 0 && current < static_cast<double>(history.size())) {
+    state->history = std::move(history);
+    state->history_index = static_cast<uint32_t>(current);
+  }
+}
+
 }  // namespace
 
 Webview::Webview(
@@ -197,6 +381,16 @@ void Webview::RegisterEventHandlers() {
               on_load_error_callback_(web_error_status);
             }
 
+            if (is_success && pending_scroll_position_) {
+              const auto [x, y] = *pending_scroll_position_;
+              pending_scroll_position_.reset();
+              webview_->ExecuteScript(
+                  util::Utf16FromUtf8(
+                      std::format("window.scrollTo({}, {});", x, y))
+                      .c_str(),
+                  nullptr);
+            }
+
             if (loading_state_changed_callback_) {
               loading_state_changed_callback_(
                   WebviewLoadingState::NavigationCompleted);
@@ -352,6 +546,32 @@ void Webview::RegisterEventHandlers() {
                 args->put_NewWindow(webview_.get());
                 args->put_Handled(TRUE);
                 break;
+              case WebviewPopupWindowPolicy::NewInstance: {
+                if (!new_window_requested_callback_) {
+                  args->put_Handled(TRUE);
+                  break;
+                }
+
+                wil::unique_cotaskmem_string wuri;
+                args->get_Uri(&wuri);
+                wil::com_ptr<ICoreWebView2Deferral> deferral;
+                args->GetDeferral(deferral.put());
+
+                new_window_requested_callback_(
+                    wuri ? util::Utf8FromUtf16(wuri.get()) : std::string(),
+                    [deferral = std::move(deferral),
+                     args = wil::com_ptr<
+                         ICoreWebView2NewWindowRequestedEventArgs>(args)](
+                        Webview* new_window) {
+                      if (new_window && new_window->IsValid()) {
+                        args->put_NewWindow(new_window->webview_.get());
+                      }
+                      // Blocks the popup if no new window has been set.
+                      args->put_Handled(TRUE);
+                      deferral->Complete();
+                    });
+                break;
+              }
             }
 
             return S_OK;
@@ -359,6 +579,51 @@ void Webview::RegisterEventHandlers() {
           .Get(),
       &event_registrations_.new_windows_requested_token_);
 
+  webview_->add_WebResourceRequested(
+      Callback<ICoreWebView2WebResourceRequestedEventHandler>(
+          [this](ICoreWebView2* sender,
+                 ICoreWebView2WebResourceRequestedEventArgs* args) -> HRESULT {
+            wil::com_ptr<ICoreWebView2WebResourceRequest> request;
+            wil::unique_cotaskmem_string uri;
+            if (FAILED(args->get_Request(request.put())) ||
+                FAILED(request->get_Uri(&uri))) {
+              return S_OK;
+            }
+
+            const auto url = util::Utf8FromUtf16(uri.get());
+            if (!util::ContentStore::IsStoreUrl(url)) {
+              return S_OK;
+            }
+
+            wil::com_ptr<ICoreWebView2Environment> environment;
+            auto webview2 = webview_.try_query<ICoreWebView2_2>();
+            if (!webview2 ||
+                FAILED(webview2->get_Environment(environment.put()))) {
+              return S_OK;
+            }
+
+            // Entries are kept, as reloads and history navigations request
+            // them again. The stream serves the UTF-8 bytes as they are.
+            wil::com_ptr<ICoreWebView2WebResourceResponse> response;
+            HRESULT hr;
+            if (auto content = content_store_.Get(url)) {
+              hr = environment->CreateWebResourceResponse(
+                  util::CreateStringStream(std::move(content)).get(), 200,
+                  L"OK", L"Content-Type: text/html; charset=utf-8",
+                  response.put());
+            } else {
+              // Evicted; the synthetic host can't be resolved either way.
+              hr = environment->CreateWebResourceResponse(
+                  nullptr, 410, L"Gone", L"", response.put());
+            }
+            if (SUCCEEDED(hr)) {
+              args->put_Response(response.get());
+            }
+            return S_OK;
+          })
+          .Get(),
+      &event_registrations_.web_resource_requested_token_);
+
   webview_->add_ContainsFullScreenElementChanged(
       Callback<ICoreWebView2ContainsFullScreenElementChangedEventHandler>(
           [this](ICoreWebView2* sender, IUnknown* args) -> HRESULT {
@@ -372,6 +637,38 @@ void Webview::RegisterEventHandlers() {
           .Get(),
       &event_registrations_.contains_fullscreen_element_changed_token_);
 
+  webview_->add_ProcessFailed(
+      Callback<ICoreWebView2ProcessFailedEventHandler>(
+          [this](ICoreWebView2* sender,
+                 ICoreWebView2ProcessFailedEventArgs* args) -> HRESULT {
+            COREWEBVIEW2_PROCESS_FAILED_KIND kind;
+            if (!process_failed_callback_ ||
+                FAILED(args->get_ProcessFailedKind(&kind))) {
+              return S_OK;
+            }
+
+            switch (kind) {
+              case COREWEBVIEW2_PROCESS_FAILED_KIND_RENDER_PROCESS_EXITED:
+                process_failed_callback_(
+                    WebviewProcessFailedKind::RenderProcessExited);
+                break;
+              case COREWEBVIEW2_PROCESS_FAILED_KIND_RENDER_PROCESS_UNRESPONSIVE:
+                process_failed_callback_(
+                    WebviewProcessFailedKind::RenderProcessUnresponsive);
+                break;
+              case COREWEBVIEW2_PROCESS_FAILED_KIND_BROWSER_PROCESS_EXITED:
+                process_failed_callback_(
+                    WebviewProcessFailedKind::BrowserProcessExited);
+                break;
+              default:
+                process_failed_callback_(WebviewProcessFailedKind::Other);
+                break;
+            }
+            return S_OK;
+          })
+          .Get(),
+      &event_registrations_.process_failed_token_);
+
   auto webview24 = webview_.try_query<ICoreWebView2_4>();
   if (webview24) {
     webview24->add_DownloadStarting(
@@ -463,6 +760,103 @@ bool Webview::ClearCookies() {
                                               L"{}", nullptr) == S_OK;
 }
 
+ICoreWebView2CookieManager* Webview::cookie_manager() {
+  if (!cookie_manager_ && IsValid()) {
+    if (auto webview = webview_.try_query<ICoreWebView2_2>()) {
+      webview->get_CookieManager(cookie_manager_.put());
+    }
+  }
+  return cookie_manager_.get();
+}
+
+void Webview::GetCookies(const util::CookieFilter& filter,
+                         GetCookiesCallback callback) {
+  if (auto manager = cookie_manager()) {
+    const auto uri = util::Utf16FromUtf8(filter.uri.value_or(std::string()));
+    if (SUCCEEDED(manager->GetCookies(
+            uri.c_str(),
+            Callback<ICoreWebView2GetCookiesCompletedHandler>(
+                [filter, callback](HRESULT result,
+                                   ICoreWebView2CookieList* list) -> HRESULT {
+                  std::vector<util::Cookie> cookies;
+                  VisitCookies(list, filter,
+                               [&cookies](ICoreWebView2Cookie* cookie,
+                                          util::Cookie converted) {
+                                 cookies.push_back(std::move(converted));
+                               });
+                  callback(SUCCEEDED(result), std::move(cookies));
+                  return S_OK;
+                })
+                .Get()))) {
+      return;
+    }
+  }
+
+  callback(false, {});
+}
+
+size_t Webview::SetCookies(const std::vector<util::Cookie>& cookies) {
+  auto manager = cookie_manager();
+  if (!manager) {
+    return 0;
+  }
+
+  size_t count = 0;
+  for (const auto& cookie : cookies) {
+    wil::com_ptr<ICoreWebView2Cookie> webview_cookie;
+    if (FAILED(manager->CreateCookie(
+            util::Utf16FromUtf8(cookie.name).c_str(),
+            util::Utf16FromUtf8(cookie.value).c_str(),
+            util::Utf16FromUtf8(cookie.domain).c_str(),
+            util::Utf16FromUtf8(cookie.path).c_str(), webview_cookie.put()))) {
+      continue;
+    }
+
+    // Cookies without an expiry date are session cookies.
+    if (!cookie.is_session) {
+      webview_cookie->put_Expires(cookie.expires);
+    }
+    webview_cookie->put_IsHttpOnly(cookie.is_http_only);
+    webview_cookie->put_IsSecure(cookie.is_secure);
+    webview_cookie->put_SameSite(ConvertSameSite(cookie.same_site));
+
+    if (SUCCEEDED(manager->AddOrUpdateCookie(webview_cookie.get()))) {
+      count++;
+    }
+  }
+  return count;
+}
+
+void Webview::DeleteCookies(const util::CookieFilter& filter,
+                            DeleteCookiesCallback callback) {
+  wil::com_ptr<ICoreWebView2CookieManager> manager = cookie_manager();
+  if (!manager) {
+    callback(false, 0);
+    return;
+  }
+
+  const auto uri = util::Utf16FromUtf8(filter.uri.value_or(std::string()));
+  if (FAILED(manager->GetCookies(
+          uri.c_str(),
+          Callback<ICoreWebView2GetCookiesCompletedHandler>(
+              [manager, filter, callback](
+                  HRESULT result, ICoreWebView2CookieList* list) -> HRESULT {
+                size_t count = 0;
+                VisitCookies(list, filter,
+                             [&manager, &count](ICoreWebView2Cookie* cookie,
+                                                util::Cookie converted) {
+                               if (SUCCEEDED(manager->DeleteCookie(cookie))) {
+                                 count++;
+                               }
+                             });
+                callback(SUCCEEDED(result), count);
+                return S_OK;
+              })
+              .Get()))) {
+    callback(false, 0);
+  }
+}
+
 bool Webview::ClearCache() {
   if (!IsValid()) {
     return false;
@@ -471,6 +865,25 @@ bool Webview::ClearCache() {
                                               L"{}", nullptr) == S_OK;
 }
 
+void Webview::ClearBrowsingData(
+    std::vector<util::ClearBrowsingDataStep> steps,
+    std::optional<TimeRange> time_range,
+    ClearBrowsingDataProgressCallback progress_callback,
+    ClearBrowsingDataCompletedCallback completed_callback) {
+  if (!IsValid()) {
+    completed_callback(false);
+    return;
+  }
+
+  auto operation = std::make_shared<ClearBrowsingDataOperation>();
+  operation->webview = webview_;
+  operation->steps = std::move(steps);
+  operation->time_range = time_range;
+  operation->progress_callback = std::move(progress_callback);
+  operation->completed_callback = std::move(completed_callback);
+  RunClearBrowsingData(std::move(operation));
+}
+
 bool Webview::SetCacheDisabled(bool disabled) {
   if (!IsValid()) {
     return false;
@@ -671,11 +1084,54 @@ void Webview::LoadUrl(const std::string& url) {
 }
 
 void Webview::LoadStringContent(const std::string& content) {
-  if (IsValid()) {
+  if (!IsValid()) {
+    return;
+  }
+
+  if (util::ContentStore::ShouldStore(content.size()) &&
+      !content_store_filter_added_) {
+    content_store_filter_added_ =
+        SUCCEEDED(webview_->AddWebResourceRequestedFilter(
+            util::Utf16FromUtf8(util::ContentStore::kUrlFilter).c_str(),
+            COREWEBVIEW2_WEB_RESOURCE_CONTEXT_DOCUMENT));
+  }
+
+  // Large documents are served from memory to avoid NavigateToString's
+  // size limit and the UTF-16 copy.
+  if (util::ContentStore::ShouldStore(content.size()) &&
+      content_store_filter_added_) {
+    webview_->Navigate(
+        util::Utf16FromUtf8(content_store_.Add(content)).c_str());
+  } else {
     webview_->NavigateToString(util::Utf16FromUtf8(content).c_str());
   }
 }
 
+bool Webview::NavigateWithRequest(const std::string& method,
+                                  const std::string& url,
+                                  const std::string& headers, IStream* body) {
+  if (!IsValid()) {
+    return false;
+  }
+
+  wil::com_ptr<ICoreWebView2Environment> environment;
+  auto webview2 = webview_.try_query<ICoreWebView2_2>();
+  if (!webview2 || FAILED(webview2->get_Environment(environment.put()))) {
+    return false;
+  }
+
+  wil::com_ptr<ICoreWebView2WebResourceRequest> request;
+  auto environment2 = environment.try_query<ICoreWebView2Environment2>();
+  if (!environment2 ||
+      FAILED(environment2->CreateWebResourceRequest(
+          util::Utf16FromUtf8(url).c_str(), util::Utf16FromUtf8(method).c_str(),
+          body, util::Utf16FromUtf8(headers).c_str(), request.put()))) {
+    return false;
+  }
+
+  return SUCCEEDED(webview2->NavigateWithWebResourceRequest(request.get()));
+}
+
 bool Webview::Stop() {
   if (!IsValid()) {
     return false;
@@ -691,6 +1147,15 @@ bool Webview::Reload() {
   return SUCCEEDED(webview_->Reload());
 }
 
+bool Webview::RecoverRenderer(
+    std::optional<std::pair<double, double>> scroll_position) {
+  if (!IsValid()) {
+    return false;
+  }
+  pending_scroll_position_ = scroll_position;
+  return SUCCEEDED(webview_->Reload());
+}
+
 bool Webview::GoBack() {
   if (!IsValid()) {
     return false;
@@ -713,8 +1178,12 @@ void Webview::AddScriptToExecuteOnDocumentCreated(
             util::Utf16FromUtf8(script).c_str(),
             Callback<
                 ICoreWebView2AddScriptToExecuteOnDocumentCreatedCompletedHandler>(
-                [callback](HRESULT result, LPCWSTR wsid) -> HRESULT {
+                [this, lifetime = std::weak_ptr<bool>(lifetime_), script,
+                 callback](HRESULT result, LPCWSTR wsid) -> HRESULT {
                   std::string sid = util::Utf8FromUtf16(wsid);
+                  if (SUCCEEDED(result) && !lifetime.expired()) {
+                    init_scripts_.emplace_back(sid, script);
+                  }
                   callback(SUCCEEDED(result), sid);
                   return S_OK;
                 })
@@ -726,12 +1195,63 @@ void Webview::AddScriptToExecuteOnDocumentCreated(
   callback(false, std::string());
 }
 
+void Webview::AddRegisteredScript(
+    const std::wstring& script,
+    AddScriptToExecuteOnDocumentCreatedCallback callback) {
+  if (IsValid()) {
+    if (SUCCEEDED(webview_->AddScriptToExecuteOnDocumentCreated(
+            script.c_str(),
+            Callback<
+                ICoreWebView2AddScriptToExecuteOnDocumentCreatedCompletedHandler>(
+                [callback](HRESULT result, LPCWSTR wsid) -> HRESULT {
+                  if (SUCCEEDED(result)) {
+                    callback(true, util::Utf8FromUtf16(wsid));
+                  } else {
+                    callback(false, std::string());
+                  }
+                  return S_OK;
+                })
+                .Get()))) {
+      return;
+    }
+  }
+
+  callback(false, std::string());
+}
+
 void Webview::RemoveScriptToExecuteOnDocumentCreated(
     const std::string& script_id) {
   if (IsValid()) {
     webview_->RemoveScriptToExecuteOnDocumentCreated(
         util::Utf16FromUtf8(script_id).c_str());
+    init_scripts_.erase(
+        std::remove_if(
+            init_scripts_.begin(), init_scripts_.end(),
+            [&](const auto& entry) { return entry.first == script_id; }),
+        init_scripts_.end());
+  }
+}
+
+bool Webview::AddHostObject(const std::string& name, IDispatch* object,
+                            const std::string& document_script) {
+  if (!IsValid()) {
+    return false;
   }
+
+  VARIANT variant = {};
+  V_VT(&variant) = VT_DISPATCH;
+  V_DISPATCH(&variant) = object;
+  if (FAILED(webview_->AddHostObjectToScript(
+          util::Utf16FromUtf8(name).c_str(), &variant))) {
+    return false;
+  }
+
+  // The shim is also run on the current document in case it has already
+  // been created.
+  const auto script = util::Utf16FromUtf8(document_script);
+  webview_->AddScriptToExecuteOnDocumentCreated(script.c_str(), nullptr);
+  webview_->ExecuteScript(script.c_str(), nullptr);
+  return true;
 }
 
 void Webview::ExecuteScript(const std::string& script,
@@ -753,6 +1273,24 @@ void Webview::ExecuteScript(const std::string& script,
   callback(false, std::string());
 }
 
+void Webview::CapturePreview(IStream* stream,
+                             CapturePreviewCallback callback) {
+  if (IsValid()) {
+    if (SUCCEEDED(webview_->CapturePreview(
+            COREWEBVIEW2_CAPTURE_PREVIEW_IMAGE_FORMAT_PNG, stream,
+            Callback<ICoreWebView2CapturePreviewCompletedHandler>(
+                [callback](HRESULT result) {
+                  callback(SUCCEEDED(result));
+                  return S_OK;
+                })
+                .Get()))) {
+      return;
+    }
+  }
+
+  callback(false);
+}
+
 bool Webview::PostWebMessage(const std::string& json) {
   if (!IsValid()) {
     return false;
@@ -761,6 +1299,46 @@ bool Webview::PostWebMessage(const std::string& json) {
          S_OK;
 }
 
+wil::com_ptr<ICoreWebView2SharedBuffer> Webview::CreateSharedBuffer(
+    size_t size) {
+  if (!IsValid()) {
+    return nullptr;
+  }
+
+  wil::com_ptr<ICoreWebView2Environment> environment;
+  auto webview2 = webview_.try_query<ICoreWebView2_2>();
+  if (!webview2 || FAILED(webview2->get_Environment(environment.put()))) {
+    return nullptr;
+  }
+
+  wil::com_ptr<ICoreWebView2SharedBuffer> buffer;
+  auto environment12 = environment.try_query<ICoreWebView2Environment12>();
+  if (!environment12 ||
+      FAILED(environment12->CreateSharedBuffer(size, buffer.put()))) {
+    return nullptr;
+  }
+  return buffer;
+}
+
+bool Webview::PostSharedBuffer(ICoreWebView2SharedBuffer* buffer,
+                               bool read_only,
+                               const std::string& additional_data_json) {
+  if (!IsValid()) {
+    return false;
+  }
+
+  auto webview = webview_.try_query<ICoreWebView2_17>();
+  if (!webview) {
+    return false;
+  }
+
+  return SUCCEEDED(webview->PostSharedBufferToScript(
+      buffer,
+      read_only ? COREWEBVIEW2_SHARED_BUFFER_ACCESS_READ_ONLY
+                : COREWEBVIEW2_SHARED_BUFFER_ACCESS_READ_WRITE,
+      util::Utf16FromUtf8(additional_data_json).c_str()));
+}
+
 bool Webview::Suspend() {
   if (!IsValid()) {
     return false;
@@ -822,9 +1400,23 @@ bool Webview::SetVirtualHostNameMapping(
       break;
   }
 
-  return webview->SetVirtualHostNameToFolderMapping(
-      util::Utf16FromUtf8(hostName).c_str(), util::Utf16FromUtf8(path).c_str(),
-      accessKindIntValue);
+  if (FAILED(webview->SetVirtualHostNameToFolderMapping(
+          util::Utf16FromUtf8(hostName).c_str(),
+          util::Utf16FromUtf8(path).c_str(), accessKindIntValue))) {
+    return false;
+  }
+
+  const auto mapping = util::HostMapping{
+      hostName, path, static_cast<uint8_t>(accessKind)};
+  const auto it =
+      std::find_if(host_mappings_.begin(), host_mappings_.end(),
+                   [&](const auto& m) { return m.host_name == hostName; });
+  if (it != host_mappings_.end()) {
+    *it = mapping;
+  } else {
+    host_mappings_.push_back(mapping);
+  }
+  return true;
 }
 
 bool Webview::ClearVirtualHostNameMapping(const std::string& hostName) {
@@ -838,8 +1430,122 @@ bool Webview::ClearVirtualHostNameMapping(const std::string& hostName) {
     return false;
   }
 
-  return webview->ClearVirtualHostNameToFolderMapping(
-      util::Utf16FromUtf8(hostName).c_str());
+  if (FAILED(webview->ClearVirtualHostNameToFolderMapping(
+          util::Utf16FromUtf8(hostName).c_str()))) {
+    return false;
+  }
+
+  host_mappings_.erase(
+      std::remove_if(host_mappings_.begin(), host_mappings_.end(),
+                     [&](const auto& m) { return m.host_name == hostName; }),
+      host_mappings_.end());
+  return true;
+}
+
+void Webview::CaptureState(CaptureStateCallback callback) {
+  auto state = std::make_shared<util::InstanceState>();
+  if (!IsValid()) {
+    callback(std::move(*state));
+    return;
+  }
+
+  wil::unique_cotaskmem_string source;
+  if (SUCCEEDED(webview_->get_Source(&source))) {
+    state->url = util::Utf8FromUtf16(source.get());
+  }
+  state->history = {state->url};
+  webview_controller_->get_ZoomFactor(&state->zoom_factor);
+  for (const auto& [id, script] : init_scripts_) {
+    state->init_scripts.push_back(script);
+  }
+  state->host_mappings = host_mappings_;
+
+  // Completes once both the scroll position and the history are known.
+  auto pending = std::make_shared<int>(2);
+  auto done = [state, pending, callback = std::move(callback)]() {
+    if (--*pending == 0) {
+      // Documents served from the content store don't outlive this
+      // instance, just like ones loaded with NavigateToString.
+      auto forget_stored = [](std::string& url) {
+        if (util::ContentStore::IsStoreUrl(url)) {
+          url = "about:blank";
+        }
+      };
+      forget_stored(state->url);
+      std::for_each(state->history.begin(), state->history.end(),
+                    forget_stored);
+      callback(std::move(*state));
+    }
+  };
+
+  ExecuteScript("[window.scrollX, window.scrollY]",
+                [state, done](bool success, const std::string& json) {
+                  const auto value = util::JsonValue::Parse(json);
+                  if (success && value && value->is_array() &&
+                      value->array_value().size() == 2) {
+                    state->scroll_x = value->array_value()[0].number_value();
+                    state->scroll_y = value->array_value()[1].number_value();
+                  }
+                  done();
+                });
+
+  if (FAILED(webview_->CallDevToolsProtocolMethod(
+          L"Page.getNavigationHistory", L"{}",
+          Callback<ICoreWebView2CallDevToolsProtocolMethodCompletedHandler>(
+              [state, done](HRESULT result, LPCWSTR json_result) -> HRESULT {
+                if (SUCCEEDED(result)) {
+                  ParseNavigationHistory(util::Utf8FromUtf16(json_result),
+                                         state.get());
+                }
+                done();
+                return S_OK;
+              })
+              .Get()))) {
+    done();
+  }
+}
+
+void Webview::RestoreState(const util::InstanceState& state) {
+  if (!IsValid()) {
+    return;
+  }
+
+  for (const auto& mapping : state.host_mappings) {
+    if (mapping.access_kind <=
+        static_cast<uint8_t>(WebviewHostResourceAccessKind::DenyCors)) {
+      SetVirtualHostNameMapping(
+          mapping.host_name, mapping.folder_path,
+          static_cast<WebviewHostResourceAccessKind>(mapping.access_kind));
+    }
+  }
+  SetZoomFactor(state.zoom_factor);
+  if (state.scroll_x != 0 || state.scroll_y != 0) {
+    pending_scroll_position_ = {state.scroll_x, state.scroll_y};
+  }
+
+  // WebView2 offers no way to seed the back/forward list, so only the
+  // current history entry is loaded.
+  const auto url = state.history_index < state.history.size()
+                       ? state.history[state.history_index]
+                       : state.url;
+  if (url.empty()) {
+    return;
+  }
+
+  // Navigate only after all document scripts have been registered so that
+  // they run for the restored document, too.
+  auto pending = std::make_shared<size_t>(state.init_scripts.size() + 1);
+  auto navigate = [this, lifetime = std::weak_ptr<bool>(lifetime_), pending,
+                   url]() {
+    if (--*pending == 0 && !lifetime.expired()) {
+      LoadUrl(url);
+    }
+  };
+  for (const auto& script : state.init_scripts) {
+    AddScriptToExecuteOnDocumentCreated(
+        script, [navigate](bool, const std::string&) { navigate(); });
+  }
+  navigate();
 }
 
 void Webview::UpdateDownloadProgress(ICoreWebView2DownloadOperation* download) {
@@ -903,4 +1609,4 @@ void Webview::UpdateDownloadProgress(ICoreWebView2DownloadOperation* download) {
           })
           .Get(),
       &event_registrations_.download_state_changed_token_);
-}
\ No newline at end of file
+}
\ No newline at end of file
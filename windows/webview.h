@@ -7,6 +7,16 @@
 #include <winrt/base.h>
 
 #include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "util/browsing_data.h"
+#include "util/content_store.h"
+#include "util/cookie.h"
+#include "util/session_snapshot.h"
 
 class WebviewHost;
 
@@ -34,10 +44,26 @@ enum class WebviewPermissionKind {
 
 enum class WebviewPermissionState { Default, Allow, Deny };
 
-enum class WebviewPopupWindowPolicy { Allow, Deny, ShowInSameWindow };
+// NewInstance opens popups in another Webview, supplied through
+// OnNewWindowRequested.
+enum class WebviewPopupWindowPolicy {
+  Allow,
+  Deny,
+  ShowInSameWindow,
+  NewInstance
+};
 
 enum class WebviewHostResourceAccessKind { Deny, Allow, DenyCors };
 
+// Failures of other processes (GPU, utilities, frames) are recovered from
+// by WebView2 itself and reported as Other.
+enum class WebviewProcessFailedKind {
+  RenderProcessExited,
+  RenderProcessUnresponsive,
+  BrowserProcessExited,
+  Other
+};
+
 struct WebviewHistoryChanged {
   BOOL can_go_back;
   BOOL can_go_forward;
@@ -104,6 +130,8 @@ struct EventRegistrations {
   EventRegistrationToken download_starting_token_{};
   EventRegistrationToken download_bytes_received_token_{};
   EventRegistrationToken download_state_changed_token_{};
+  EventRegistrationToken web_resource_requested_token_{};
+  EventRegistrationToken process_failed_token_{};
 };
 
 class Webview {
@@ -133,7 +161,26 @@ class Webview {
       PermissionRequestedCallback;
   typedef std::function<void(bool contains_fullscreen_element)>
       ContainsFullScreenElementChangedCallback;
+  // Must be passed a Webview which hasn't navigated yet, or nullptr to
+  // block the popup.
+  typedef std::function<void(Webview* new_window)> NewWindowCompleter;
+  typedef std::function<void(const std::string& url,
+                             NewWindowCompleter completer)>
+      NewWindowRequestedCallback;
   typedef std::function<void(WebviewDownloadEvent)> DownloadEventCallback;
+  typedef std::function<void(bool success, std::vector<util::Cookie> cookies)>
+      GetCookiesCallback;
+  typedef std::function<void(bool success, size_t count)>
+      DeleteCookiesCallback;
+  typedef std::function<void(size_t completed, size_t total)>
+      ClearBrowsingDataProgressCallback;
+  typedef std::function<void(bool success)> ClearBrowsingDataCompletedCallback;
+  // Start and end in seconds since the UNIX epoch.
+  typedef std::pair<double, double> TimeRange;
+  typedef std::function<void(util::InstanceState state)> CaptureStateCallback;
+  typedef std::function<void(bool success)> CapturePreviewCallback;
+  typedef std::function<void(WebviewProcessFailedKind kind)>
+      ProcessFailedCallback;
 
   ~Webview();
 
@@ -143,6 +190,8 @@ class Webview {
 
   bool IsValid() { return is_valid_; }
 
+  float scale_factor() const { return scale_factor_; }
+
   void SetSurfaceSize(size_t width, size_t height, float scale_factor);
   void SetCursorPos(double x, double y);
   void SetPointerUpdate(int32_t pointer, WebviewPointerEventKind eventKind,
@@ -151,19 +200,58 @@ class Webview {
   void SetScrollDelta(double delta_x, double delta_y);
   void LoadUrl(const std::string& url);
   void LoadStringContent(const std::string& content);
+  // Navigates with a custom request. |headers| are "Name: value" lines
+  // separated by CRLF. |body| is read while the request is being sent.
+  bool NavigateWithRequest(const std::string& method, const std::string& url,
+                           const std::string& headers, IStream* body);
   bool Stop();
   bool Reload();
+  // Reloads the current document after its renderer crashed or hung, and
+  // scrolls back to |scroll_position| once it has loaded.
+  bool RecoverRenderer(
+      std::optional<std::pair<double, double>> scroll_position);
   bool GoBack();
   bool GoForward();
   void AddScriptToExecuteOnDocumentCreated(
       const std::string& script,
       AddScriptToExecuteOnDocumentCreatedCallback callback);
   void RemoveScriptToExecuteOnDocumentCreated(const std::string& script_id);
+  // Adds a script of the plugin-wide registry. Unlike scripts added above,
+  // it isn't part of the captured state, as restored instances get it from
+  // the registry anyway.
+  void AddRegisteredScript(
+      const std::wstring& script,
+      AddScriptToExecuteOnDocumentCreatedCallback callback);
+  // Exposes |object| to scripts as chrome.webview.hostObjects.<name>.
+  // |document_script| is run on every document to wrap it and, unlike
+  // scripts added above, isn't part of the captured state.
+  bool AddHostObject(const std::string& name, IDispatch* object,
+                     const std::string& document_script);
   void ExecuteScript(const std::string& script,
                      ScriptExecutedCallback callback);
   bool PostWebMessage(const std::string& json);
+  // Writes a PNG image of the current contents to |stream|.
+  void CapturePreview(IStream* stream, CapturePreviewCallback callback);
+  // Allocates memory which can be shared with scripts.
+  wil::com_ptr<ICoreWebView2SharedBuffer> CreateSharedBuffer(size_t size);
+  // Posts |buffer| to the current document, where it shows up as the
+  // ArrayBuffer of a "sharedbufferreceived" event of chrome.webview.
+  bool PostSharedBuffer(ICoreWebView2SharedBuffer* buffer, bool read_only,
+                        const std::string& additional_data_json);
   bool ClearCookies();
+  void GetCookies(const util::CookieFilter& filter,
+                  GetCookiesCallback callback);
+  // Adds or updates the given cookies. Returns the number of cookies set.
+  size_t SetCookies(const std::vector<util::Cookie>& cookies);
+  void DeleteCookies(const util::CookieFilter& filter,
+                     DeleteCookiesCallback callback);
   bool ClearCache();
+  // Runs the given steps one after another, reporting progress after each
+  // one. Profile-wide steps are limited to |time_range| if given.
+  void ClearBrowsingData(std::vector<util::ClearBrowsingDataStep> steps,
+                         std::optional<TimeRange> time_range,
+                         ClearBrowsingDataProgressCallback progress_callback,
+                         ClearBrowsingDataCompletedCallback completed_callback);
   bool SetCacheDisabled(bool disabled);
   void SetPopupWindowPolicy(WebviewPopupWindowPolicy policy);
   bool SetUserAgent(const std::string& user_agent);
@@ -178,6 +266,15 @@ class Webview {
                                  WebviewHostResourceAccessKind accessKind);
   bool ClearVirtualHostNameMapping(const std::string& hostName);
 
+  // Collects everything needed to recreate this instance later. The scroll
+  // position and the session history are queried asynchronously.
+  void CaptureState(CaptureStateCallback callback);
+
+  // Applies a captured state to a freshly created instance: host mappings,
+  // document scripts and zoom first, then navigates to the current history
+  // entry and restores the scroll position once it has loaded.
+  void RestoreState(const util::InstanceState& state);
+
   void UpdateDownloadProgress(ICoreWebView2DownloadOperation* download);
 
   void OnUrlChanged(UrlChangedCallback callback) {
@@ -224,6 +321,10 @@ class Webview {
     permission_requested_callback_ = std::move(callback);
   }
 
+  void OnNewWindowRequested(NewWindowRequestedCallback callback) {
+    new_window_requested_callback_ = std::move(callback);
+  }
+
   void OnDevtoolsProtocolEvent(DevtoolsProtocolEventCallback callback) {
     devtools_protocol_event_callback_ = std::move(callback);
   }
@@ -233,6 +334,10 @@ class Webview {
     contains_fullscreen_element_changed_callback_ = std::move(callback);
   }
 
+  void OnProcessFailed(ProcessFailedCallback callback) {
+    process_failed_callback_ = std::move(callback);
+  }
+
  private:
   HWND hwnd_;
   bool owns_window_;
@@ -244,11 +349,26 @@ class Webview {
   wil::com_ptr<ICoreWebView2DevToolsProtocolEventReceiver>
       devtools_protocol_event_receiver_;
   wil::com_ptr<ICoreWebView2Settings2> settings2_;
+  wil::com_ptr<ICoreWebView2CookieManager> cookie_manager_;
   POINT last_cursor_pos_ = {0, 0};
   VirtualKeyState virtual_keys_;
   WebviewPopupWindowPolicy popup_window_policy_ =
       WebviewPopupWindowPolicy::Allow;
 
+  // Tracked for CaptureState. Scripts are kept as (id, script) pairs in the
+  // order they were added.
+  std::vector<std::pair<std::string, std::string>> init_scripts_;
+  std::vector<util::HostMapping> host_mappings_;
+  std::optional<std::pair<double, double>> pending_scroll_position_;
+
+  // Documents passed to LoadStringContent which exceed NavigateToString's
+  // size limit.
+  util::ContentStore content_store_;
+  bool content_store_filter_added_ = false;
+
+  // Guards completion handlers which may run after destruction.
+  std::shared_ptr<bool> lifetime_ = std::make_shared<bool>(true);
+
   winrt::com_ptr<ABI::Windows::UI::Composition::IVisual> surface_;
   winrt::com_ptr<ABI::Windows::UI::Composition::Desktop::IDesktopWindowTarget>
       window_target_;
@@ -267,9 +387,11 @@ class Webview {
   FocusChangedCallback focus_changed_callback_;
   WebMessageReceivedCallback web_message_received_callback_;
   PermissionRequestedCallback permission_requested_callback_;
+  NewWindowRequestedCallback new_window_requested_callback_;
   DevtoolsProtocolEventCallback devtools_protocol_event_callback_;
   ContainsFullScreenElementChangedCallback
       contains_fullscreen_element_changed_callback_;
+  ProcessFailedCallback process_failed_callback_;
 
   Webview(
       wil::com_ptr<ICoreWebView2CompositionController> composition_controller,
@@ -281,4 +403,5 @@ class Webview {
   void RegisterEventHandlers();
   void EnableSecurityUpdates();
   void SendScroll(double offset, bool horizontal);
+  ICoreWebView2CookieManager* cookie_manager();
 };
@@ -2,16 +2,33 @@
 
 #include <flutter/event_stream_handler_functions.h>
 #include <flutter/method_result_functions.h>
+#include <flutter/standard_message_codec.h>
 
+#include <algorithm>
+#include <array>
+#include <cstring>
 #include <format>
+#include <mutex>
 
+#include "host_object.h"
 #include "texture_bridge_gpu.h"
+#include "texture_bridge_preview.h"
+#include "util/chunked_stream.h"
+#include "util/cursor_util.h"
+#include "util/http_headers.h"
+#include "util/json.h"
+#include "util/lru_cache.h"
+#include "util/rect.h"
+#include "util/url_origin.h"
 
 namespace {
 constexpr auto kErrorInvalidArgs = "invalidArguments";
 
 constexpr auto kMethodLoadUrl = "loadUrl";
 constexpr auto kMethodLoadStringContent = "loadStringContent";
+constexpr auto kMethodNavigateWithRequest = "navigateWithRequest";
+constexpr auto kMethodAppendRequestBody = "appendRequestBody";
+constexpr auto kMethodCloseRequestBody = "closeRequestBody";
 constexpr auto kMethodReload = "reload";
 constexpr auto kMethodStop = "stop";
 constexpr auto kMethodGoBack = "goBack";
@@ -37,10 +54,48 @@ constexpr auto kMethodSetVirtualHostNameMapping = "setVirtualHostNameMapping";
 constexpr auto kMethodClearVirtualHostNameMapping =
     "clearVirtualHostNameMapping";
 constexpr auto kMethodClearCookies = "clearCookies";
+constexpr auto kMethodGetCookies = "getCookies";
+constexpr auto kMethodSetCookies = "setCookies";
+constexpr auto kMethodDeleteCookies = "deleteCookies";
 constexpr auto kMethodClearCache = "clearCache";
+constexpr auto kMethodClearBrowsingData = "clearBrowsingData";
 constexpr auto kMethodSetCacheDisabled = "setCacheDisabled";
 constexpr auto kMethodSetPopupWindowPolicy = "setPopupWindowPolicy";
 constexpr auto kMethodSetFpsLimit = "setFpsLimit";
+constexpr auto kMethodSetVisibleRect = "setVisibleRect";
+constexpr auto kMethodCreateTextureView = "createTextureView";
+constexpr auto kMethodDisposeTextureView = "disposeTextureView";
+constexpr auto kMethodSetRenderMode = "setRenderMode";
+constexpr auto kMethodRequestFrame = "requestFrame";
+constexpr auto kMethodAddHostFunction = "addHostFunction";
+constexpr auto kMethodRemoveHostFunction = "removeHostFunction";
+constexpr auto kMethodSetHostValue = "setHostValue";
+constexpr auto kMethodCompleteHostCalls = "completeHostCalls";
+constexpr auto kMethodWriteSharedBuffer = "writeSharedBuffer";
+constexpr auto kMethodPostSharedBuffer = "postSharedBuffer";
+constexpr auto kMethodReleaseSharedBuffer = "releaseSharedBuffer";
+constexpr auto kMethodSetPermissionDecision = "setPermissionDecision";
+constexpr auto kMethodClearPermissionDecisions = "clearPermissionDecisions";
+constexpr auto kMethodSetRendererWatchdog = "setRendererWatchdog";
+
+// Methods likely changing the contents. In on-demand render mode, a frame is
+// captured once they have settled.
+constexpr const char* kActivityMethods[] = {
+    kMethodLoadUrl,
+    kMethodLoadStringContent,
+    kMethodNavigateWithRequest,
+    kMethodReload,
+    kMethodGoBack,
+    kMethodGoForward,
+    kMethodExecuteScript,
+    kMethodPostWebMessage,
+    kMethodSetCursorPos,
+    kMethodSetPointerUpdate,
+    kMethodSetPointerButton,
+    kMethodSetScrollDelta,
+    kMethodSetZoomFactor,
+    kMethodSetBackgroundColor,
+};
 
 constexpr auto kEventType = "type";
 constexpr auto kEventValue = "value";
@@ -49,6 +104,23 @@ constexpr auto kErrorNotSupported = "not_supported";
 constexpr auto kScriptFailed = "script_failed";
 constexpr auto kMethodFailed = "method_failed";
 
+constexpr auto kHostObjectName = "flutter";
+
+// The number of events kept while Dart isn't listening. Older ones are
+// dropped.
+constexpr size_t kMaxPendingEvents = 256;
+
+// Standard codec integers arrive as int32 or int64 depending on their value.
+static std::optional<int64_t> GetInt64(const flutter::EncodableValue& value) {
+  if (const auto i32 = std::get_if<int32_t>(&value)) {
+    return *i32;
+  }
+  if (const auto i64 = std::get_if<int64_t>(&value)) {
+    return *i64;
+  }
+  return std::nullopt;
+}
+
 static const std::optional<std::pair<double, double>> GetPointFromArgs(
     const flutter::EncodableValue* args) {
   const flutter::EncodableList* list =
@@ -80,57 +152,269 @@ GetPointAndScaleFactorFromArgs(const flutter::EncodableValue* args) {
   return std::make_tuple(*x, *y, *z);
 }
 
-static const std::string& GetCursorName(const HCURSOR cursor) {
-  // The cursor names correspond to the Flutter Engine names:
-  // in shell/platform/windows/flutter_window_win32.cc
-  static const std::string kDefaultCursorName = "basic";
-  static const std::pair<std::string, const wchar_t*> mappings[] = {
-      {"allScroll", IDC_SIZEALL},
-      {kDefaultCursorName, IDC_ARROW},
-      {"click", IDC_HAND},
-      {"forbidden", IDC_NO},
-      {"help", IDC_HELP},
-      {"move", IDC_SIZEALL},
-      {"none", nullptr},
-      {"noDrop", IDC_NO},
-      {"precise", IDC_CROSS},
-      {"progress", IDC_APPSTARTING},
-      {"text", IDC_IBEAM},
-      {"resizeColumn", IDC_SIZEWE},
-      {"resizeDown", IDC_SIZENS},
-      {"resizeDownLeft", IDC_SIZENESW},
-      {"resizeDownRight", IDC_SIZENWSE},
-      {"resizeLeft", IDC_SIZEWE},
-      {"resizeLeftRight", IDC_SIZEWE},
-      {"resizeRight", IDC_SIZEWE},
-      {"resizeRow", IDC_SIZENS},
-      {"resizeUp", IDC_SIZENS},
-      {"resizeUpDown", IDC_SIZENS},
-      {"resizeUpLeft", IDC_SIZENWSE},
-      {"resizeUpRight", IDC_SIZENESW},
-      {"resizeUpLeftDownRight", IDC_SIZENWSE},
-      {"resizeUpRightDownLeft", IDC_SIZENESW},
-      {"wait", IDC_WAIT},
-  };
-
-  static std::map<HCURSOR, std::string> cursors;
-  static bool initialized = false;
-
-  if (!initialized) {
-    initialized = true;
-    for (const auto& pair : mappings) {
-      HCURSOR cursor_handle = LoadCursor(nullptr, pair.second);
-      if (cursor_handle) {
-        cursors[cursor_handle] = pair.first;
+static const std::optional<std::tuple<double, double, double, double>>
+GetRectFromArgs(const flutter::EncodableValue* args) {
+  const flutter::EncodableList* list =
+      std::get_if<flutter::EncodableList>(args);
+  if (!list || list->size() != 4) {
+    return std::nullopt;
+  }
+  const auto x = std::get_if<double>(&(*list)[0]);
+  const auto y = std::get_if<double>(&(*list)[1]);
+  const auto width = std::get_if<double>(&(*list)[2]);
+  const auto height = std::get_if<double>(&(*list)[3]);
+  if (!x || !y || !width || !height) {
+    return std::nullopt;
+  }
+  return std::make_tuple(*x, *y, *width, *height);
+}
+
+// Cookies are encoded as lists to keep bulk transfers compact:
+// [String name, String value, String domain, String path, double expires,
+//  int flags, int sameSite]
+enum CookieField {
+  kCookieName,
+  kCookieValue,
+  kCookieDomain,
+  kCookiePath,
+  kCookieExpires,
+  kCookieFlags,
+  kCookieSameSite,
+  kCookieFieldCount
+};
+
+enum CookieFlags {
+  kCookieHttpOnly = 1 << 0,
+  kCookieSecure = 1 << 1,
+  kCookieSession = 1 << 2,
+};
+
+static flutter::EncodableValue EncodeCookies(
+    const std::vector<util::Cookie>& cookies) {
+  flutter::EncodableList list;
+  list.reserve(cookies.size());
+  for (const auto& cookie : cookies) {
+    const int32_t flags = (cookie.is_http_only ? kCookieHttpOnly : 0) |
+                          (cookie.is_secure ? kCookieSecure : 0) |
+                          (cookie.is_session ? kCookieSession : 0);
+    list.push_back(flutter::EncodableValue(flutter::EncodableList{
+        flutter::EncodableValue(cookie.name),
+        flutter::EncodableValue(cookie.value),
+        flutter::EncodableValue(cookie.domain),
+        flutter::EncodableValue(cookie.path),
+        flutter::EncodableValue(cookie.expires),
+        flutter::EncodableValue(flags),
+        flutter::EncodableValue(static_cast<int32_t>(cookie.same_site)),
+    }));
+  }
+  return flutter::EncodableValue(std::move(list));
+}
+
+static std::optional<util::Cookie> DecodeCookie(
+    const flutter::EncodableValue& value) {
+  const auto list = std::get_if<flutter::EncodableList>(&value);
+  if (!list || list->size() != kCookieFieldCount) {
+    return std::nullopt;
+  }
+
+  const auto name = std::get_if<std::string>(&(*list)[kCookieName]);
+  const auto cookie_value = std::get_if<std::string>(&(*list)[kCookieValue]);
+  const auto domain = std::get_if<std::string>(&(*list)[kCookieDomain]);
+  const auto path = std::get_if<std::string>(&(*list)[kCookiePath]);
+  const auto expires = std::get_if<double>(&(*list)[kCookieExpires]);
+  const auto flags = std::get_if<int32_t>(&(*list)[kCookieFlags]);
+  const auto same_site = std::get_if<int32_t>(&(*list)[kCookieSameSite]);
+  if (!name || !cookie_value || !domain || !path || !expires || !flags ||
+      !same_site || *same_site < 0 ||
+      *same_site > static_cast<int32_t>(util::CookieSameSite::kStrict)) {
+    return std::nullopt;
+  }
+
+  util::Cookie cookie;
+  cookie.name = *name;
+  cookie.value = *cookie_value;
+  cookie.domain = *domain;
+  cookie.path = *path;
+  cookie.expires = *expires;
+  cookie.is_http_only = *flags & kCookieHttpOnly;
+  cookie.is_secure = *flags & kCookieSecure;
+  cookie.is_session = *flags & kCookieSession;
+  cookie.same_site = static_cast<util::CookieSameSite>(*same_site);
+  return cookie;
+}
+
+// [String uri | null, String name | null, String domain | null,
+//  String path | null]
+static std::optional<util::CookieFilter> GetCookieFilterFromArgs(
+    const flutter::EncodableValue* args) {
+  const auto list = std::get_if<flutter::EncodableList>(args);
+  if (!list || list->size() != 4) {
+    return std::nullopt;
+  }
+
+  util::CookieFilter filter;
+  std::optional<std::string>* const fields[] = {&filter.uri, &filter.name,
+                                                &filter.domain, &filter.path};
+  for (size_t i = 0; i < std::size(fields); i++) {
+    const auto& value = (*list)[i];
+    if (const auto string_value = std::get_if<std::string>(&value)) {
+      *fields[i] = *string_value;
+    } else if (!value.IsNull()) {
+      return std::nullopt;
+    }
+  }
+  return filter;
+}
+
+// Host values are limited to null, bool, int, double, String and lists
+// thereof.
+static std::optional<util::HostValue> DecodeHostValue(
+    const flutter::EncodableValue& value) {
+  if (value.IsNull()) {
+    return util::HostValue{};
+  }
+  if (const auto flag = std::get_if<bool>(&value)) {
+    return util::HostValue{*flag};
+  }
+  if (const auto integer = std::get_if<int32_t>(&value)) {
+    return util::HostValue{static_cast<int64_t>(*integer)};
+  }
+  if (const auto integer = std::get_if<int64_t>(&value)) {
+    return util::HostValue{*integer};
+  }
+  if (const auto number = std::get_if<double>(&value)) {
+    return util::HostValue{*number};
+  }
+  if (const auto string = std::get_if<std::string>(&value)) {
+    return util::HostValue{*string};
+  }
+  if (const auto list = std::get_if<flutter::EncodableList>(&value)) {
+    util::HostValue::List values;
+    values.reserve(list->size());
+    for (const auto& element : *list) {
+      auto decoded = DecodeHostValue(element);
+      if (!decoded) {
+        return std::nullopt;
       }
+      values.push_back(std::move(*decoded));
+    }
+    return util::HostValue{std::move(values)};
+  }
+  return std::nullopt;
+}
+
+static flutter::EncodableValue EncodeHostValue(const util::HostValue& value) {
+  if (const auto flag = std::get_if<bool>(&value.value)) {
+    return flutter::EncodableValue(*flag);
+  }
+  if (const auto integer = std::get_if<int64_t>(&value.value)) {
+    return flutter::EncodableValue(*integer);
+  }
+  if (const auto number = std::get_if<double>(&value.value)) {
+    return flutter::EncodableValue(*number);
+  }
+  if (const auto string = std::get_if<std::string>(&value.value)) {
+    return flutter::EncodableValue(*string);
+  }
+  if (const auto list = std::get_if<util::HostValue::List>(&value.value)) {
+    flutter::EncodableList values;
+    values.reserve(list->size());
+    for (const auto& element : *list) {
+      values.push_back(EncodeHostValue(element));
+    }
+    return flutter::EncodableValue(std::move(values));
+  }
+  return flutter::EncodableValue();
+}
+
+struct CursorMapping {
+  const char* name;
+  const wchar_t* id;
+};
+
+// The cursor names correspond to the Flutter Engine names:
+// in shell/platform/windows/flutter_window_win32.cc
+constexpr auto kDefaultCursorName = "basic";
+constexpr CursorMapping kCursorMappings[] = {
+    {"allScroll", IDC_SIZEALL},
+    {kDefaultCursorName, IDC_ARROW},
+    {"click", IDC_HAND},
+    {"forbidden", IDC_NO},
+    {"help", IDC_HELP},
+    {"move", IDC_SIZEALL},
+    {"none", nullptr},
+    {"noDrop", IDC_NO},
+    {"precise", IDC_CROSS},
+    {"progress", IDC_APPSTARTING},
+    {"text", IDC_IBEAM},
+    {"resizeColumn", IDC_SIZEWE},
+    {"resizeDown", IDC_SIZENS},
+    {"resizeDownLeft", IDC_SIZENESW},
+    {"resizeDownRight", IDC_SIZENWSE},
+    {"resizeLeft", IDC_SIZEWE},
+    {"resizeLeftRight", IDC_SIZEWE},
+    {"resizeRight", IDC_SIZEWE},
+    {"resizeRow", IDC_SIZENS},
+    {"resizeUp", IDC_SIZENS},
+    {"resizeUpDown", IDC_SIZENS},
+    {"resizeUpLeft", IDC_SIZENWSE},
+    {"resizeUpRight", IDC_SIZENESW},
+    {"resizeUpLeftDownRight", IDC_SIZENWSE},
+    {"resizeUpRightDownLeft", IDC_SIZENESW},
+    {"wait", IDC_WAIT},
+};
+
+// The number of custom cursors kept around after converting them.
+constexpr size_t kMaxCachedCursors = 16;
+
+// Returns the name of a standard cursor or nullptr for custom cursors.
+static const char* GetStandardCursorName(const HCURSOR cursor) {
+  // Shared cursors stay valid for the lifetime of the process, so their
+  // handles only need to be loaded once.
+  static const auto handles = []() {
+    std::array<HCURSOR, std::size(kCursorMappings)> handles;
+    for (size_t i = 0; i < handles.size(); i++) {
+      const auto id = kCursorMappings[i].id;
+      handles[i] = id ? LoadCursor(nullptr, id) : nullptr;
+    }
+    return handles;
+  }();
+
+  for (size_t i = 0; i < handles.size(); i++) {
+    if (handles[i] && handles[i] == cursor) {
+      return kCursorMappings[i].name;
     }
   }
+  return nullptr;
+}
+
+struct CustomCursor {
+  // Unique per converted cursor, as handles may get reused.
+  std::string name;
+  util::CursorImage image;
+};
+
+// Returns the converted image of a custom cursor. Cursors are only converted
+// once as long as they stay in the cache.
+static std::shared_ptr<const CustomCursor> GetCustomCursor(
+    const HCURSOR cursor) {
+  static std::mutex mutex;
+  static util::LruCache<HCURSOR, std::shared_ptr<const CustomCursor>> cache(
+      kMaxCachedCursors);
+  static uint64_t next_cursor_id = 1;
+
+  const std::lock_guard<std::mutex> lock(mutex);
+  if (const auto cached = cache.Get(cursor)) {
+    return *cached;
+  }
 
-  const auto it = cursors.find(cursor);
-  if (it != cursors.end()) {
-    return it->second;
+  auto custom_cursor = std::make_shared<CustomCursor>();
+  if (!util::GetCursorImage(cursor, &custom_cursor->image)) {
+    return nullptr;
   }
-  return kDefaultCursorName;
+  custom_cursor->name = std::format("webview_windows/{}", next_cursor_id++);
+  cache.Put(cursor, custom_cursor);
+  return custom_cursor;
 }
 
 }  // namespace
@@ -138,23 +422,59 @@ static const std::string& GetCursorName(const HCURSOR cursor) {
 WebviewBridge::WebviewBridge(flutter::BinaryMessenger* messenger,
                              flutter::TextureRegistrar* texture_registrar,
                              GraphicsContext* graphics_context,
-                             std::unique_ptr<Webview> webview)
-    : webview_(std::move(webview)), texture_registrar_(texture_registrar) {
-  texture_bridge_ =
-      std::make_unique<TextureBridgeGpu>(graphics_context, webview_->surface());
-
-  flutter_texture_ =
-      std::make_unique<flutter::TextureVariant>(flutter::GpuSurfaceTexture(
-          kFlutterDesktopGpuSurfaceTypeDxgiSharedHandle,
-          [bridge = static_cast<TextureBridgeGpu*>(texture_bridge_.get())](
-              size_t width,
-              size_t height) -> const FlutterDesktopGpuSurfaceDescriptor* {
-            return bridge->GetSurfaceDescriptor(width, height);
-          }));
+                             std::unique_ptr<Webview> webview,
+                             bool capture_supported)
+    : webview_(std::move(webview)),
+      texture_registrar_(texture_registrar),
+      task_runner_(graphics_context->task_runner()),
+      gpu_surface_(capture_supported) {
+  if (gpu_surface_) {
+    auto bridge = std::make_unique<TextureBridgeGpu>(graphics_context,
+                                                     webview_->surface());
+    flutter_texture_ =
+        std::make_unique<flutter::TextureVariant>(flutter::GpuSurfaceTexture(
+            kFlutterDesktopGpuSurfaceTypeDxgiSharedHandle,
+            [bridge = bridge.get()](size_t width, size_t height)
+                -> const FlutterDesktopGpuSurfaceDescriptor* {
+              return bridge->GetSurfaceDescriptor(width, height);
+            }));
+    texture_bridge_ = std::move(bridge);
+  } else {
+    auto bridge = std::make_unique<TextureBridgePreview>(graphics_context,
+                                                         webview_.get());
+    flutter_texture_ =
+        std::make_unique<flutter::TextureVariant>(flutter::PixelBufferTexture(
+            [bridge = bridge.get()](size_t width, size_t height)
+                -> const FlutterDesktopPixelBuffer* {
+              return bridge->CopyPixelBuffer(width, height);
+            }));
+    texture_bridge_ = std::move(bridge);
+  }
 
   texture_id_ = texture_registrar->RegisterTexture(flutter_texture_.get());
-  texture_bridge_->SetOnFrameAvailable(
-      [this]() { texture_registrar_->MarkTextureFrameAvailable(texture_id_); });
+  texture_bridge_->SetOnFrameAvailable([this]() {
+    last_frame_time_ =
+        util::RendererWatchdog::Clock::now().time_since_epoch().count();
+    texture_registrar_->MarkTextureFrameAvailable(texture_id_);
+    for (const auto& [texture_id, view] : texture_views_) {
+      texture_registrar_->MarkTextureFrameAvailable(texture_id);
+    }
+  });
+  texture_bridge_->SetOnCaptureRecovery(
+      [this](TextureBridge::CaptureRecoveryState state, int attempt) {
+        const auto event = flutter::EncodableValue(flutter::EncodableMap{
+            {flutter::EncodableValue(kEventType),
+             flutter::EncodableValue("captureRecovery")},
+            {flutter::EncodableValue(kEventValue),
+             flutter::EncodableValue(flutter::EncodableMap{
+                 {flutter::EncodableValue("state"),
+                  flutter::EncodableValue(static_cast<int>(state))},
+                 {flutter::EncodableValue("attempt"),
+                  flutter::EncodableValue(attempt)},
+             })},
+        });
+        EmitEvent(event);
+      });
   // texture_bridge_->SetOnSurfaceSizeChanged([this](Size size) {
   //  webview_->SetSurfaceSize(size.width, size.height);
   //});
@@ -182,7 +502,10 @@ WebviewBridge::WebviewBridge(flutter::BinaryMessenger* messenger,
              std::unique_ptr<flutter::EventSink<flutter::EncodableValue>>&&
                  events) {
         event_sink_ = std::move(events);
-        RegisterEventHandlers();
+        while (!pending_events_.empty()) {
+          event_sink_->Success(pending_events_.front());
+          pending_events_.pop_front();
+        }
         return nullptr;
       },
       [this](const flutter::EncodableValue* arguments) {
@@ -191,15 +514,297 @@ WebviewBridge::WebviewBridge(flutter::BinaryMessenger* messenger,
       });
 
   event_channel_->SetStreamHandler(std::move(handler));
+
+  // Events are buffered until Dart listens, so that navigations may start
+  // right away.
+  RegisterEventHandlers();
+  StartRendererWatchdog();
 }
 
 WebviewBridge::~WebviewBridge() {
   method_channel_->SetMethodCallHandler(nullptr);
+  host_dispatcher_->CancelAll();
+  shared_buffer_pool_.ReleaseAll();
+  CloseSharedBuffers();
+  // Unblocks readers still waiting for data.
+  for (const auto& [id, buffer] : request_bodies_) {
+    buffer->Cancel();
+  }
+  for (const auto& [texture_id, view] : texture_views_) {
+    texture_registrar_->UnregisterTexture(texture_id);
+  }
   texture_registrar_->UnregisterTexture(texture_id_);
 }
 
+int64_t WebviewBridge::CreateTextureView(const util::TextureViewSpec& spec) {
+  auto bridge = static_cast<TextureBridgeGpu*>(texture_bridge_.get());
+  const auto view_id = bridge->AddView(spec);
+
+  auto texture =
+      std::make_unique<flutter::TextureVariant>(flutter::GpuSurfaceTexture(
+          kFlutterDesktopGpuSurfaceTypeDxgiSharedHandle,
+          [bridge, view_id](size_t width, size_t height)
+              -> const FlutterDesktopGpuSurfaceDescriptor* {
+            return bridge->GetViewSurfaceDescriptor(view_id);
+          }));
+
+  const auto texture_id = texture_registrar_->RegisterTexture(texture.get());
+  texture_views_[texture_id] = {view_id, std::move(texture)};
+  return texture_id;
+}
+
+bool WebviewBridge::DisposeTextureView(int64_t texture_id) {
+  const auto it = texture_views_.find(texture_id);
+  if (it == texture_views_.end()) {
+    return false;
+  }
+
+  texture_registrar_->UnregisterTexture(texture_id);
+  static_cast<TextureBridgeGpu*>(texture_bridge_.get())
+      ->RemoveView(it->second.view_id);
+  texture_views_.erase(it);
+  return true;
+}
+
+bool WebviewBridge::EnsureHostObject() {
+  if (host_object_added_) {
+    return true;
+  }
+
+  auto object = CreateHostObject(
+      host_dispatcher_, [this, lifetime = std::weak_ptr<bool>(lifetime_)]() {
+        if (lifetime.expired() || host_calls_flush_pending_) {
+          return;
+        }
+        // Calls made while the current script runs end up in the same
+        // batch.
+        host_calls_flush_pending_ = true;
+        task_runner_->PostTask([this, lifetime]() {
+          if (!lifetime.expired()) {
+            FlushHostCalls();
+          }
+        });
+      });
+  host_object_added_ = webview_->AddHostObject(
+      kHostObjectName, object.get(), GetHostObjectScript(kHostObjectName));
+  return host_object_added_;
+}
+
+void WebviewBridge::FlushHostCalls() {
+  host_calls_flush_pending_ = false;
+  auto calls = host_dispatcher_->TakePendingCalls();
+  if (!event_sink_) {
+    for (auto& call : calls) {
+      host_dispatcher_->Complete(call.call_id, false,
+                                 {std::string("No listener")});
+    }
+    return;
+  }
+
+  // [[int callId, String name, List args], ...]
+  flutter::EncodableList list;
+  list.reserve(calls.size());
+  for (auto& call : calls) {
+    list.push_back(flutter::EncodableValue(flutter::EncodableList{
+        flutter::EncodableValue(static_cast<int64_t>(call.call_id)),
+        flutter::EncodableValue(call.name),
+        EncodeHostValue(util::HostValue{std::move(call.args)}),
+    }));
+  }
+
+  const auto event = flutter::EncodableValue(flutter::EncodableMap{
+      {flutter::EncodableValue(kEventType),
+       flutter::EncodableValue("hostCalls")},
+      {flutter::EncodableValue(kEventValue),
+       flutter::EncodableValue(std::move(list))},
+  });
+  EmitEvent(event);
+}
+
+void WebviewBridge::CloseSharedBuffers() {
+  for (const auto id : shared_buffer_pool_.TakeClosedBuffers()) {
+    const auto it = shared_buffers_.find(id);
+    if (it != shared_buffers_.end()) {
+      // Scripts keep access to buffers posted to them.
+      it->second->Close();
+      shared_buffers_.erase(it);
+    }
+  }
+}
+
+void WebviewBridge::BufferEvent(flutter::EncodableValue event) {
+  if (pending_events_.size() == kMaxPendingEvents) {
+    pending_events_.pop_front();
+  }
+  pending_events_.push_back(std::move(event));
+}
+
+void WebviewBridge::RecordEvent(const flutter::EncodableValue& event) {
+  std::string type;
+  if (const auto map = std::get_if<flutter::EncodableMap>(&event)) {
+    const auto it = map->find(flutter::EncodableValue(kEventType));
+    if (it != map->end()) {
+      if (const auto value = std::get_if<std::string>(&it->second)) {
+        type = *value;
+      }
+    }
+  }
+  RecordMessage(util::ChannelRecord::Kind::kEvent, type, &event);
+}
+
+void WebviewBridge::RecordMessage(util::ChannelRecord::Kind kind,
+                                  const std::string& name,
+                                  const flutter::EncodableValue* payload) {
+  std::vector<uint8_t> encoded;
+  if (payload && !payload->IsNull()) {
+    encoded = std::move(
+        *flutter::StandardMessageCodec::GetInstance().EncodeMessage(*payload));
+  }
+  channel_recorder_->Record(kind, texture_id_, name, std::move(encoded));
+}
+
+void WebviewBridge::StartRendererWatchdog() {
+  if (renderer_watchdog_enabled_) {
+    renderer_watchdog_.Start(util::RendererWatchdog::Clock::now());
+    ScheduleWatchdogTick();
+  }
+}
+
+void WebviewBridge::ScheduleWatchdogTick() {
+  const auto deadline = renderer_watchdog_.deadline();
+  if (!deadline || (watchdog_tick_time_ && *watchdog_tick_time_ <= *deadline)) {
+    return;
+  }
+
+  const auto delay = std::chrono::ceil<std::chrono::milliseconds>(
+      *deadline - util::RendererWatchdog::Clock::now());
+  if (task_runner_->PostDelayedTask(
+          [this, lifetime = std::weak_ptr<bool>(lifetime_),
+           time = *deadline]() {
+            if (!lifetime.expired()) {
+              OnWatchdogTick(time);
+            }
+          },
+          std::max(delay, std::chrono::milliseconds(0)))) {
+    watchdog_tick_time_ = *deadline;
+  }
+}
+
+void WebviewBridge::OnWatchdogTick(
+    util::RendererWatchdog::Clock::time_point time) {
+  if (watchdog_tick_time_ == time) {
+    watchdog_tick_time_.reset();
+  }
+
+  if (const auto last_frame_time = last_frame_time_.load()) {
+    renderer_watchdog_.OnFrame(util::RendererWatchdog::Clock::time_point(
+        util::RendererWatchdog::Clock::duration(last_frame_time)));
+  }
+
+  // Recovering again means the previous recovery timed out, or was delayed.
+  const auto state = renderer_watchdog_.state();
+  const auto kind =
+      state == util::RendererWatchdog::State::kRecovering ||
+              state == util::RendererWatchdog::State::kRecoveryScheduled
+          ? renderer_failure_kind_
+          : RendererFailureKind::kHeartbeatTimeout;
+  const auto action =
+      renderer_watchdog_.Tick(util::RendererWatchdog::Clock::now());
+  if (action == util::RendererWatchdog::Action::kSendHeartbeat) {
+    SendHeartbeat(renderer_watchdog_.heartbeat_id());
+  } else {
+    HandleWatchdogAction(action, kind);
+  }
+  ScheduleWatchdogTick();
+}
+
+void WebviewBridge::SendHeartbeat(uint64_t id) {
+  // Also remembers the scroll position for restoring it after a crash.
+  webview_->ExecuteScript(
+      "[window.scrollX, window.scrollY]",
+      [this, lifetime = std::weak_ptr<bool>(lifetime_), id](
+          bool success, const std::string& json) {
+        if (lifetime.expired()) {
+          return;
+        }
+
+        const auto value = util::JsonValue::Parse(json);
+        if (success && value && value->is_array() &&
+            value->array_value().size() == 2) {
+          last_scroll_position_ = {value->array_value()[0].number_value(),
+                                   value->array_value()[1].number_value()};
+        }
+        renderer_watchdog_.OnHeartbeatCompleted(
+            id, util::RendererWatchdog::Clock::now());
+        ScheduleWatchdogTick();
+      });
+}
+
+void WebviewBridge::HandleWatchdogAction(
+    util::RendererWatchdog::Action action, RendererFailureKind kind) {
+  if (action == util::RendererWatchdog::Action::kRecover) {
+    renderer_failure_kind_ = kind;
+    EmitRendererFailure(kind, RendererFailureState::kRecovering,
+                        renderer_watchdog_.recoveries());
+    // Failing to reload shows as the recovery timing out.
+    webview_->RecoverRenderer(last_scroll_position_);
+  } else if (action == util::RendererWatchdog::Action::kNone &&
+             renderer_watchdog_.state() ==
+                 util::RendererWatchdog::State::kRecoveryScheduled) {
+    // Reported once the delayed recovery starts.
+    renderer_failure_kind_ = kind;
+  } else if (action == util::RendererWatchdog::Action::kGiveUp) {
+    EmitRendererFailure(kind, RendererFailureState::kFailed,
+                        renderer_watchdog_.recoveries());
+  }
+}
+
+void WebviewBridge::EmitRendererFailure(RendererFailureKind kind,
+                                        RendererFailureState state,
+                                        int attempt) {
+  const auto event = flutter::EncodableValue(flutter::EncodableMap{
+      {flutter::EncodableValue(kEventType),
+       flutter::EncodableValue("rendererFailure")},
+      {flutter::EncodableValue(kEventValue),
+       flutter::EncodableValue(flutter::EncodableMap{
+           {flutter::EncodableValue("kind"),
+            flutter::EncodableValue(static_cast<int>(kind))},
+           {flutter::EncodableValue("state"),
+            flutter::EncodableValue(static_cast<int>(state))},
+           {flutter::EncodableValue("attempt"),
+            flutter::EncodableValue(attempt)},
+       })},
+  });
+  EmitEvent(event);
+}
+
 void WebviewBridge::RegisterEventHandlers() {
+  webview_->OnProcessFailed([this](WebviewProcessFailedKind kind) {
+    const auto scope = MonitorTask("event.processFailed");
+    const auto now = util::RendererWatchdog::Clock::now();
+    switch (kind) {
+      case WebviewProcessFailedKind::RenderProcessExited:
+        HandleWatchdogAction(renderer_watchdog_.OnRendererFailed(now),
+                             RendererFailureKind::kExited);
+        break;
+      case WebviewProcessFailedKind::RenderProcessUnresponsive:
+        HandleWatchdogAction(renderer_watchdog_.OnRendererFailed(now),
+                             RendererFailureKind::kUnresponsive);
+        break;
+      case WebviewProcessFailedKind::BrowserProcessExited:
+        // The instance can't be used anymore and needs to be recreated.
+        renderer_watchdog_.Stop();
+        EmitRendererFailure(RendererFailureKind::kBrowserExited,
+                            RendererFailureState::kFailed, 0);
+        return;
+      default:
+        return;
+    }
+    ScheduleWatchdogTick();
+  });
+
   webview_->OnUrlChanged([this](const std::string& url) {
+    const auto scope = MonitorTask("event.urlChanged");
     const auto event = flutter::EncodableValue(flutter::EncodableMap{
         {flutter::EncodableValue(kEventType),
          flutter::EncodableValue("urlChanged")},
@@ -209,6 +814,7 @@ void WebviewBridge::RegisterEventHandlers() {
   });
 
   webview_->OnLoadError([this](COREWEBVIEW2_WEB_ERROR_STATUS web_status) {
+    const auto scope = MonitorTask("event.loadError");
     const auto event = flutter::EncodableValue(flutter::EncodableMap{
         {flutter::EncodableValue(kEventType),
          flutter::EncodableValue("onLoadError")},
@@ -219,6 +825,22 @@ void WebviewBridge::RegisterEventHandlers() {
   });
 
   webview_->OnLoadingStateChanged([this](WebviewLoadingState state) {
+    const auto scope = MonitorTask("event.loadingStateChanged");
+    texture_bridge_->NotifyActivity();
+    const auto now = util::RendererWatchdog::Clock::now();
+    if (state == WebviewLoadingState::Loading) {
+      renderer_watchdog_.OnNavigationStarted(now);
+      ScheduleWatchdogTick();
+    } else if (state == WebviewLoadingState::NavigationCompleted &&
+               renderer_watchdog_.state() ==
+                   util::RendererWatchdog::State::kRecovering) {
+      renderer_watchdog_.OnRecovered(now);
+      EmitRendererFailure(renderer_failure_kind_,
+                          RendererFailureState::kRecovered,
+                          renderer_watchdog_.recoveries());
+      ScheduleWatchdogTick();
+    }
+
     const auto event = flutter::EncodableValue(flutter::EncodableMap{
         {flutter::EncodableValue(kEventType),
          flutter::EncodableValue("loadingStateChanged")},
@@ -229,6 +851,7 @@ void WebviewBridge::RegisterEventHandlers() {
   });
 
   webview_->OnDownloadEvent([this](WebviewDownloadEvent webviewDownloadEvent) {
+    const auto scope = MonitorTask("event.downloadEvent");
     const auto event = flutter::EncodableValue(flutter::EncodableMap{
         {flutter::EncodableValue(kEventType),
          flutter::EncodableValue("downloadEvent")},
@@ -251,6 +874,7 @@ void WebviewBridge::RegisterEventHandlers() {
   });
 
   webview_->OnHistoryChanged([this](WebviewHistoryChanged historyChanged) {
+    const auto scope = MonitorTask("event.historyChanged");
     const auto event = flutter::EncodableValue(flutter::EncodableMap{
         {flutter::EncodableValue(kEventType),
          flutter::EncodableValue("historyChanged")},
@@ -268,6 +892,7 @@ void WebviewBridge::RegisterEventHandlers() {
   });
 
   webview_->OnDevtoolsProtocolEvent([this](const std::string& json) {
+    const auto scope = MonitorTask("event.devtoolsProtocolEvent");
     const auto event = flutter::EncodableValue(flutter::EncodableMap{
         {flutter::EncodableValue(kEventType),
          flutter::EncodableValue("securityStateChanged")},
@@ -276,6 +901,7 @@ void WebviewBridge::RegisterEventHandlers() {
   });
 
   webview_->OnDocumentTitleChanged([this](const std::string& title) {
+    const auto scope = MonitorTask("event.documentTitleChanged");
     const auto event = flutter::EncodableValue(flutter::EncodableMap{
         {flutter::EncodableValue(kEventType),
          flutter::EncodableValue("titleChanged")},
@@ -285,19 +911,56 @@ void WebviewBridge::RegisterEventHandlers() {
   });
 
   webview_->OnSurfaceSizeChanged([this](size_t width, size_t height) {
+    const auto scope = MonitorTask("event.surfaceSizeChanged");
     texture_bridge_->NotifySurfaceSizeChanged();
+    if (surface_size_changed_callback_) {
+      surface_size_changed_callback_(width, height);
+    }
   });
 
   webview_->OnCursorChanged([this](const HCURSOR cursor) {
-    const auto& name = GetCursorName(cursor);
-    const auto event = flutter::EncodableValue(
-        flutter::EncodableMap{{flutter::EncodableValue(kEventType),
-                               flutter::EncodableValue("cursorChanged")},
-                              {flutter::EncodableValue(kEventValue), name}});
+    const auto scope = MonitorTask("event.cursorChanged");
+    const auto name = GetStandardCursorName(cursor);
+    if (!name) {
+      if (const auto custom_cursor = GetCustomCursor(cursor)) {
+        const auto& image = custom_cursor->image;
+        const auto event = flutter::EncodableValue(flutter::EncodableMap{
+            {flutter::EncodableValue(kEventType),
+             flutter::EncodableValue("customCursorChanged")},
+            {flutter::EncodableValue(kEventValue),
+             flutter::EncodableValue(flutter::EncodableMap{
+                 {flutter::EncodableValue("name"),
+                  flutter::EncodableValue(custom_cursor->name)},
+                 {flutter::EncodableValue("width"),
+                  flutter::EncodableValue(static_cast<int32_t>(image.width))},
+                 {flutter::EncodableValue("height"),
+                  flutter::EncodableValue(static_cast<int32_t>(image.height))},
+                 {flutter::EncodableValue("hotX"),
+                  flutter::EncodableValue(
+                      static_cast<double>(image.hotspot_x))},
+                 {flutter::EncodableValue("hotY"),
+                  flutter::EncodableValue(
+                      static_cast<double>(image.hotspot_y))},
+                 {flutter::EncodableValue("buffer"),
+                  flutter::EncodableValue(image.rgba)},
+             })},
+        });
+        EmitEvent(event);
+        return;
+      }
+    }
+
+    const auto event = flutter::EncodableValue(flutter::EncodableMap{
+        {flutter::EncodableValue(kEventType),
+         flutter::EncodableValue("cursorChanged")},
+        {flutter::EncodableValue(kEventValue),
+         flutter::EncodableValue(name ? name : kDefaultCursorName)},
+    });
     EmitEvent(event);
   });
 
   webview_->OnWebMessageReceived([this](const std::string& message) {
+    const auto scope = MonitorTask("event.webMessageReceived");
     const auto event = flutter::EncodableValue(
         flutter::EncodableMap{{flutter::EncodableValue(kEventType),
                                flutter::EncodableValue("webMessageReceived")},
@@ -305,15 +968,49 @@ void WebviewBridge::RegisterEventHandlers() {
     EmitEvent(event);
   });
 
+  webview_->OnNewWindowRequested(
+      [this](const std::string& url, Webview::NewWindowCompleter completer) {
+        const auto scope = MonitorTask("event.newWindowRequested");
+        if (!popup_provider_.take) {
+          return completer(nullptr);
+        }
+        popup_provider_.take(
+            [this, url, completer, lifetime = std::weak_ptr<bool>(lifetime_)](
+                WebviewBridge* popup) {
+              if (!popup) {
+                return completer(nullptr);
+              }
+              completer(popup->webview());
+              if (lifetime.expired()) {
+                return;
+              }
+
+              const auto event = flutter::EncodableValue(flutter::EncodableMap{
+                  {flutter::EncodableValue(kEventType),
+                   flutter::EncodableValue("popupOpened")},
+                  {flutter::EncodableValue(kEventValue),
+                   flutter::EncodableValue(flutter::EncodableMap{
+                       {flutter::EncodableValue("textureId"),
+                        flutter::EncodableValue(popup->texture_id())},
+                       {flutter::EncodableValue("url"),
+                        flutter::EncodableValue(url)},
+                   })},
+              });
+              EmitEvent(event);
+            });
+      });
+
   webview_->OnPermissionRequested(
       [this](const std::string& url, WebviewPermissionKind kind,
              bool is_user_initiated,
              Webview::WebviewPermissionRequestedCompleter completer) {
+        const auto scope = MonitorTask("event.permissionRequested");
         OnPermissionRequested(url, kind, is_user_initiated, completer);
       });
 
   webview_->OnContainsFullScreenElementChanged(
       [this](bool contains_fullscreen_element) {
+        const auto scope = MonitorTask("event.fullScreenElementChanged");
         const auto event = flutter::EncodableValue(flutter::EncodableMap{
             {flutter::EncodableValue(kEventType),
              flutter::EncodableValue("containsFullScreenElementChanged")},
@@ -328,16 +1025,41 @@ void WebviewBridge::OnPermissionRequested(
     WebviewPermissionKind permissionKind,
     bool isUserInitiated,
     Webview::WebviewPermissionRequestedCompleter completer) {
+  const auto origin = util::NormalizeOrigin(url);
+  const auto kind = static_cast<int32_t>(permissionKind);
+  if (origin) {
+    if (const auto decision = permission_cache_.Lookup(
+            *origin, kind, util::PermissionCache::Clock::now())) {
+      return completer(*decision == util::PermissionCache::Decision::kAllow
+                           ? WebviewPermissionState::Allow
+                           : WebviewPermissionState::Deny);
+    }
+  }
+
   auto args = std::make_unique<flutter::EncodableValue>(flutter::EncodableMap{
       {"url", url},
       {"isUserInitiated", isUserInitiated},
       {"permissionKind", static_cast<int>(permissionKind)}});
 
+  // The reply is either bool? or [bool allow, int ttlMs] for decisions to
+  // be remembered.
   method_channel_->InvokeMethod(
       "permissionRequested", std::move(args),
       std::make_unique<flutter::MethodResultFunctions<flutter::EncodableValue>>(
-          [completer](const flutter::EncodableValue* result) {
+          [this, completer, origin, kind,
+           lifetime = std::weak_ptr<bool>(lifetime_)](
+              const flutter::EncodableValue* result) {
             auto allow = std::get_if<bool>(result);
+            const auto list = std::get_if<flutter::EncodableList>(result);
+            if (list && list->size() == 2) {
+              allow = std::get_if<bool>(&list->at(0));
+              // TTLs of 2^31 ms (~25 days) and more arrive as int64.
+              const auto ttl = GetInt64(list->at(1));
+              if (allow && ttl && origin && !lifetime.expired()) {
+                permission_cache_.Remember(*origin, kind, *allow, *ttl,
+                                           util::PermissionCache::Clock::now());
+              }
+            }
             if (allow != nullptr) {
               return completer(*allow ? WebviewPermissionState::Allow
                                       : WebviewPermissionState::Deny);
@@ -356,6 +1078,18 @@ void WebviewBridge::HandleMethodCall(
     const flutter::MethodCall<flutter::EncodableValue>& method_call,
     std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result) {
   const auto& method_name = method_call.method_name();
+  const auto scope = MonitorTask("webview." + method_name);
+  if (channel_recorder_) {
+    RecordMessage(util::ChannelRecord::Kind::kMethodCall, method_name,
+                  method_call.arguments());
+  }
+
+  for (const auto activity_method : kActivityMethods) {
+    if (method_name.compare(activity_method) == 0) {
+      texture_bridge_->NotifyActivity();
+      break;
+    }
+  }
 
   // setCursorPos: [double x, double y]
   if (method_name.compare(kMethodSetCursorPos) == 0) {
@@ -490,6 +1224,8 @@ void WebviewBridge::HandleMethodCall(
   // suspend
   if (method_name.compare(kMethodSuspend) == 0) {
     texture_bridge_->Stop();
+    // Suspended renderers don't answer heartbeats.
+    renderer_watchdog_.Stop();
     webview_->Suspend();
     return result->Success();
   }
@@ -498,6 +1234,7 @@ void WebviewBridge::HandleMethodCall(
   if (method_name.compare(kMethodResume) == 0) {
     webview_->Resume();
     texture_bridge_->Start();
+    StartRendererWatchdog();
     return result->Success();
   }
 
@@ -649,6 +1386,71 @@ void WebviewBridge::HandleMethodCall(
     return result->Error(kMethodFailed);
   }
 
+  // getCookies: filter (see GetCookieFilterFromArgs)
+  if (method_name.compare(kMethodGetCookies) == 0) {
+    const auto filter = GetCookieFilterFromArgs(method_call.arguments());
+    if (!filter) {
+      return result->Error(kErrorInvalidArgs);
+    }
+
+    std::shared_ptr<flutter::MethodResult<flutter::EncodableValue>>
+        shared_result = std::move(result);
+    webview_->GetCookies(
+        *filter,
+        [shared_result](bool success, std::vector<util::Cookie> cookies) {
+          if (success) {
+            shared_result->Success(EncodeCookies(cookies));
+          } else {
+            shared_result->Error(kMethodFailed, "Getting cookies failed.");
+          }
+        });
+    return;
+  }
+
+  // setCookies: [cookie...] (see DecodeCookie)
+  if (method_name.compare(kMethodSetCookies) == 0) {
+    const auto list =
+        std::get_if<flutter::EncodableList>(method_call.arguments());
+    if (!list) {
+      return result->Error(kErrorInvalidArgs);
+    }
+
+    std::vector<util::Cookie> cookies;
+    cookies.reserve(list->size());
+    for (const auto& value : *list) {
+      auto cookie = DecodeCookie(value);
+      if (!cookie) {
+        return result->Error(kErrorInvalidArgs);
+      }
+      cookies.push_back(std::move(*cookie));
+    }
+
+    const auto count = webview_->SetCookies(cookies);
+    return result->Success(
+        flutter::EncodableValue(static_cast<int32_t>(count)));
+  }
+
+  // deleteCookies: filter (see GetCookieFilterFromArgs)
+  if (method_name.compare(kMethodDeleteCookies) == 0) {
+    const auto filter = GetCookieFilterFromArgs(method_call.arguments());
+    if (!filter) {
+      return result->Error(kErrorInvalidArgs);
+    }
+
+    std::shared_ptr<flutter::MethodResult<flutter::EncodableValue>>
+        shared_result = std::move(result);
+    webview_->DeleteCookies(
+        *filter, [shared_result](bool success, size_t count) {
+          if (success) {
+            shared_result->Success(
+                flutter::EncodableValue(static_cast<int32_t>(count)));
+          } else {
+            shared_result->Error(kMethodFailed, "Deleting cookies failed.");
+          }
+        });
+    return;
+  }
+
   // clearCache
   if (method_name.compare(kMethodClearCache) == 0) {
     if (webview_->ClearCache()) {
@@ -657,6 +1459,74 @@ void WebviewBridge::HandleMethodCall(
     return result->Error(kMethodFailed);
   }
 
+  // clearBrowsingData: [int kinds, [String origin...], double start | null,
+  //                     double end | null, int requestId]
+  if (method_name.compare(kMethodClearBrowsingData) == 0) {
+    const flutter::EncodableList* list =
+        std::get_if<flutter::EncodableList>(method_call.arguments());
+    if (!list || list->size() != 5) {
+      return result->Error(kErrorInvalidArgs);
+    }
+
+    const auto kinds = std::get_if<int32_t>(&(*list)[0]);
+    const auto origin_list = std::get_if<flutter::EncodableList>(&(*list)[1]);
+    const auto start = std::get_if<double>(&(*list)[2]);
+    const auto end = std::get_if<double>(&(*list)[3]);
+    const auto request_id = std::get_if<int32_t>(&(*list)[4]);
+    if (!kinds || !origin_list || !request_id || (!start != !end)) {
+      return result->Error(kErrorInvalidArgs);
+    }
+
+    std::vector<std::string> origins;
+    for (const auto& value : *origin_list) {
+      const auto origin = std::get_if<std::string>(&value);
+      if (!origin) {
+        return result->Error(kErrorInvalidArgs);
+      }
+      origins.push_back(*origin);
+    }
+
+    // Time ranges are only supported when clearing the entire profile.
+    auto steps =
+        util::PlanClearBrowsingData(static_cast<uint32_t>(*kinds), origins);
+    if (!steps || (start && !origins.empty())) {
+      return result->Error(kErrorInvalidArgs);
+    }
+
+    std::shared_ptr<flutter::MethodResult<flutter::EncodableValue>>
+        shared_result = std::move(result);
+    webview_->ClearBrowsingData(
+        std::move(*steps),
+        start ? std::make_optional(std::make_pair(*start, *end))
+              : std::nullopt,
+        [this, lifetime = std::weak_ptr<bool>(lifetime_),
+         id = *request_id](size_t completed, size_t total) {
+          if (lifetime.expired()) {
+            return;
+          }
+          const auto event = flutter::EncodableValue(flutter::EncodableMap{
+              {flutter::EncodableValue(kEventType),
+               flutter::EncodableValue("clearBrowsingDataProgress")},
+              {flutter::EncodableValue(kEventValue),
+               flutter::EncodableValue(flutter::EncodableList{
+                   flutter::EncodableValue(id),
+                   flutter::EncodableValue(static_cast<int32_t>(completed)),
+                   flutter::EncodableValue(static_cast<int32_t>(total)),
+               })},
+          });
+          EmitEvent(event);
+        },
+        [shared_result](bool success) {
+          if (success) {
+            shared_result->Success();
+          } else {
+            shared_result->Error(kMethodFailed,
+                                 "Clearing browsing data failed.");
+          }
+        });
+    return;
+  }
+
   // setCacheDisabled: bool
   if (method_name.compare(kMethodSetCacheDisabled) == 0) {
     if (const auto disabled = std::get_if<bool>(method_call.arguments())) {
@@ -678,6 +1548,13 @@ void WebviewBridge::HandleMethodCall(
           webview_->SetPopupWindowPolicy(
               WebviewPopupWindowPolicy::ShowInSameWindow);
           break;
+        case 3:
+          webview_->SetPopupWindowPolicy(
+              WebviewPopupWindowPolicy::NewInstance);
+          if (popup_provider_.prewarm) {
+            popup_provider_.prewarm();
+          }
+          break;
         default:
           webview_->SetPopupWindowPolicy(WebviewPopupWindowPolicy::Allow);
           break;
@@ -687,6 +1564,474 @@ void WebviewBridge::HandleMethodCall(
     return result->Error(kErrorInvalidArgs);
   }
 
+  // setVisibleRect: [double x, double y, double width, double height] | null
+  if (method_name.compare(kMethodSetVisibleRect) == 0) {
+    const auto arguments = method_call.arguments();
+    if (!arguments || arguments->IsNull()) {
+      texture_bridge_->SetVisibleRect(std::nullopt);
+      return result->Success();
+    }
+
+    if (const auto rect = GetRectFromArgs(arguments)) {
+      const auto [x, y, width, height] = rect.value();
+      texture_bridge_->SetVisibleRect(util::ScaleToPhysical(
+          x, y, width, height, webview_->scale_factor()));
+      return result->Success();
+    }
+    return result->Error(kErrorInvalidArgs);
+  }
+
+  // createTextureView:
+  // [[double x, double y, double width, double height] | null,
+  //  double width | null, double height | null]
+  if (method_name.compare(kMethodCreateTextureView) == 0) {
+    if (!gpu_surface_) {
+      return result->Error(kErrorNotSupported,
+                           "Texture views require Windows.Graphics.Capture.");
+    }
+
+    const flutter::EncodableList* list =
+        std::get_if<flutter::EncodableList>(method_call.arguments());
+    if (!list || list->size() != 3) {
+      return result->Error(kErrorInvalidArgs);
+    }
+
+    const auto scale_factor = webview_->scale_factor();
+    util::TextureViewSpec spec;
+    if (!(*list)[0].IsNull()) {
+      const auto rect = GetRectFromArgs(&(*list)[0]);
+      if (!rect) {
+        return result->Error(kErrorInvalidArgs);
+      }
+      const auto [x, y, width, height] = rect.value();
+      spec.source_rect =
+          util::ScaleToPhysical(x, y, width, height, scale_factor);
+    }
+
+    const auto width = std::get_if<double>(&(*list)[1]);
+    const auto height = std::get_if<double>(&(*list)[2]);
+    if ((!width && !(*list)[1].IsNull()) ||
+        (!height && !(*list)[2].IsNull())) {
+      return result->Error(kErrorInvalidArgs);
+    }
+    if (width) {
+      spec.width = static_cast<uint32_t>(std::max(*width * scale_factor, 1.0));
+    }
+    if (height) {
+      spec.height =
+          static_cast<uint32_t>(std::max(*height * scale_factor, 1.0));
+    }
+
+    return result->Success(flutter::EncodableValue(CreateTextureView(spec)));
+  }
+
+  // setRenderMode: [int mode, int settleDelayMs | null]
+  if (method_name.compare(kMethodSetRenderMode) == 0) {
+    const flutter::EncodableList* list =
+        std::get_if<flutter::EncodableList>(method_call.arguments());
+    if (!list || list->size() != 2) {
+      return result->Error(kErrorInvalidArgs);
+    }
+
+    const auto mode = std::get_if<int32_t>(&(*list)[0]);
+    const auto settle_delay = std::get_if<int32_t>(&(*list)[1]);
+    if (!mode || *mode < 0 ||
+        *mode > static_cast<int32_t>(TextureBridge::RenderMode::kOnDemand)) {
+      return result->Error(kErrorInvalidArgs);
+    }
+
+    texture_bridge_->SetRenderMode(
+        static_cast<TextureBridge::RenderMode>(*mode),
+        settle_delay ? std::make_optional(std::chrono::milliseconds(
+                           std::max(*settle_delay, 0)))
+                     : std::nullopt);
+    return result->Success();
+  }
+
+  if (method_name.compare(kMethodRequestFrame) == 0) {
+    std::shared_ptr<flutter::MethodResult<flutter::EncodableValue>>
+        shared_result = std::move(result);
+    texture_bridge_->RequestFrame(
+        [shared_result]() { shared_result->Success(); });
+    return;
+  }
+
+  // navigateWithRequest: [String method, String url, Map headers,
+  //                       Uint8List? body, int? bodyStreamId]
+  if (method_name.compare(kMethodNavigateWithRequest) == 0) {
+    const auto list =
+        std::get_if<flutter::EncodableList>(method_call.arguments());
+    if (!list || list->size() != 5) {
+      return result->Error(kErrorInvalidArgs);
+    }
+    const auto method = std::get_if<std::string>(&list->at(0));
+    const auto url = std::get_if<std::string>(&list->at(1));
+    const auto header_map = std::get_if<flutter::EncodableMap>(&list->at(2));
+    const auto body = std::get_if<std::vector<uint8_t>>(&list->at(3));
+    const auto stream_id = std::get_if<int32_t>(&list->at(4));
+    if (!method || !url || !header_map) {
+      return result->Error(kErrorInvalidArgs);
+    }
+
+    std::vector<std::pair<std::string, std::string>> headers;
+    for (const auto& [key, value] : *header_map) {
+      const auto name = std::get_if<std::string>(&key);
+      const auto text = std::get_if<std::string>(&value);
+      if (!name || !text) {
+        return result->Error(kErrorInvalidArgs);
+      }
+      headers.emplace_back(*name, *text);
+    }
+    std::string formatted_headers;
+    if (!util::FormatHttpHeaders(headers, &formatted_headers)) {
+      return result->Error(kErrorInvalidArgs, "Invalid request headers");
+    }
+
+    std::shared_ptr<util::ChunkedStreamBuffer> buffer;
+    wil::com_ptr<IStream> stream;
+    if (stream_id || body) {
+      buffer = std::make_shared<util::ChunkedStreamBuffer>();
+      if (body) {
+        buffer->Append(*body);
+        buffer->Close();
+      }
+      stream = util::CreateChunkedStream(buffer);
+    }
+
+    if (!webview_->NavigateWithRequest(*method, *url, formatted_headers,
+                                       stream.get())) {
+      return result->Error(kMethodFailed);
+    }
+    if (stream_id) {
+      const auto it = request_bodies_.find(*stream_id);
+      if (it != request_bodies_.end()) {
+        it->second->Cancel();
+      }
+      request_bodies_[*stream_id] = std::move(buffer);
+    }
+    return result->Success();
+  }
+
+  // appendRequestBody: [int bodyStreamId, Uint8List chunk]
+  // Completes once the buffered body has drained below its capacity.
+  if (method_name.compare(kMethodAppendRequestBody) == 0) {
+    const auto list =
+        std::get_if<flutter::EncodableList>(method_call.arguments());
+    if (!list || list->size() != 2) {
+      return result->Error(kErrorInvalidArgs);
+    }
+    const auto stream_id = std::get_if<int32_t>(&list->at(0));
+    const auto chunk = std::get_if<std::vector<uint8_t>>(&list->at(1));
+    const auto it =
+        stream_id ? request_bodies_.find(*stream_id) : request_bodies_.end();
+    if (!chunk || it == request_bodies_.end()) {
+      return result->Error(kErrorInvalidArgs);
+    }
+    if (!it->second->Append(*chunk)) {
+      return result->Error(kMethodFailed, "The request body is closed");
+    }
+
+    std::shared_ptr<flutter::MethodResult<flutter::EncodableValue>>
+        shared_result = std::move(result);
+    it->second->WhenWritable(
+        [task_runner = task_runner_, shared_result](bool cancelled) {
+          // May run on the thread reading the body.
+          task_runner->PostTask([shared_result, cancelled]() {
+            if (cancelled) {
+              shared_result->Error(kMethodFailed,
+                                   "The request body was cancelled");
+            } else {
+              shared_result->Success();
+            }
+          });
+        });
+    return;
+  }
+
+  // closeRequestBody: [int bodyStreamId, bool cancel]
+  if (method_name.compare(kMethodCloseRequestBody) == 0) {
+    const auto list =
+        std::get_if<flutter::EncodableList>(method_call.arguments());
+    if (!list || list->size() != 2) {
+      return result->Error(kErrorInvalidArgs);
+    }
+    const auto stream_id = std::get_if<int32_t>(&list->at(0));
+    const auto cancel = std::get_if<bool>(&list->at(1));
+    const auto it =
+        stream_id ? request_bodies_.find(*stream_id) : request_bodies_.end();
+    if (!cancel || it == request_bodies_.end()) {
+      return result->Error(kErrorInvalidArgs);
+    }
+    if (*cancel) {
+      it->second->Cancel();
+    } else {
+      it->second->Close();
+    }
+    request_bodies_.erase(it);
+    return result->Success();
+  }
+
+  // addHostFunction: String name
+  if (method_name.compare(kMethodAddHostFunction) == 0) {
+    const auto name = std::get_if<std::string>(method_call.arguments());
+    if (!name) {
+      return result->Error(kErrorInvalidArgs);
+    }
+    if (!EnsureHostObject()) {
+      return result->Error(kMethodFailed, "Adding the host object failed");
+    }
+    host_dispatcher_->RegisterDeferred(*name);
+    return result->Success();
+  }
+
+  // removeHostFunction: String name
+  if (method_name.compare(kMethodRemoveHostFunction) == 0) {
+    const auto name = std::get_if<std::string>(method_call.arguments());
+    if (!name) {
+      return result->Error(kErrorInvalidArgs);
+    }
+    return result->Success(
+        flutter::EncodableValue(host_dispatcher_->Unregister(*name)));
+  }
+
+  // setHostValue: [String name, dynamic value]
+  // The value is returned synchronously by a native function.
+  if (method_name.compare(kMethodSetHostValue) == 0) {
+    const auto list =
+        std::get_if<flutter::EncodableList>(method_call.arguments());
+    if (!list || list->size() != 2) {
+      return result->Error(kErrorInvalidArgs);
+    }
+    const auto name = std::get_if<std::string>(&list->at(0));
+    auto value = DecodeHostValue(list->at(1));
+    if (!name || !value) {
+      return result->Error(kErrorInvalidArgs);
+    }
+    if (!EnsureHostObject()) {
+      return result->Error(kMethodFailed, "Adding the host object failed");
+    }
+    host_dispatcher_->RegisterNative(
+        *name, [value = std::move(*value)](const util::HostValue::List&) {
+          return value;
+        });
+    return result->Success();
+  }
+
+  // completeHostCalls: [[int callId, bool success, dynamic result], ...]
+  if (method_name.compare(kMethodCompleteHostCalls) == 0) {
+    const auto list =
+        std::get_if<flutter::EncodableList>(method_call.arguments());
+    if (!list) {
+      return result->Error(kErrorInvalidArgs);
+    }
+    for (const auto& entry : *list) {
+      const auto call = std::get_if<flutter::EncodableList>(&entry);
+      if (!call || call->size() != 3) {
+        return result->Error(kErrorInvalidArgs);
+      }
+      // Call ids are sent as int64 once they no longer fit into 32 bits.
+      const auto call_id = GetInt64(call->at(0));
+      const auto success = std::get_if<bool>(&call->at(1));
+      auto value = DecodeHostValue(call->at(2));
+      if (!call_id || !success) {
+        return result->Error(kErrorInvalidArgs);
+      }
+      if (!value) {
+        // Report unsupported results to the script instead.
+        host_dispatcher_->Complete(
+            *call_id, false, {std::string("Unsupported result type")});
+        continue;
+      }
+      host_dispatcher_->Complete(*call_id, *success, std::move(*value));
+    }
+    return result->Success();
+  }
+
+  // writeSharedBuffer: [String name, Uint8List data]
+  // Copies |data| into the buffer named |name|, reusing its memory if
+  // possible.
+  if (method_name.compare(kMethodWriteSharedBuffer) == 0) {
+    const auto list =
+        std::get_if<flutter::EncodableList>(method_call.arguments());
+    if (!list || list->size() != 2) {
+      return result->Error(kErrorInvalidArgs);
+    }
+    const auto name = std::get_if<std::string>(&list->at(0));
+    const auto data = std::get_if<std::vector<uint8_t>>(&list->at(1));
+    if (!name || !data) {
+      return result->Error(kErrorInvalidArgs);
+    }
+
+    const auto allocation = shared_buffer_pool_.Acquire(*name, data->size());
+    if (allocation.is_new) {
+      auto buffer = webview_->CreateSharedBuffer(allocation.capacity);
+      if (!buffer) {
+        // Drops the id without pooling it.
+        shared_buffer_pool_.Transfer(*name);
+        CloseSharedBuffers();
+        return result->Error(kMethodFailed,
+                             "Creating the shared buffer failed");
+      }
+      shared_buffers_[allocation.id] = std::move(buffer);
+    }
+    CloseSharedBuffers();
+
+    BYTE* bytes = nullptr;
+    if (FAILED(shared_buffers_[allocation.id]->get_Buffer(&bytes))) {
+      return result->Error(kMethodFailed);
+    }
+    if (!data->empty()) {
+      std::memcpy(bytes, data->data(), data->size());
+    }
+    return result->Success(flutter::EncodableValue(
+        static_cast<int64_t>(allocation.capacity)));
+  }
+
+  // postSharedBuffer: [String name, bool transfer, String additionalData]
+  // Transferred buffers are handed over to the script with read-write
+  // access and unbound from |name|. Otherwise the script gets read-only
+  // access and sees later writes.
+  if (method_name.compare(kMethodPostSharedBuffer) == 0) {
+    const auto list =
+        std::get_if<flutter::EncodableList>(method_call.arguments());
+    if (!list || list->size() != 3) {
+      return result->Error(kErrorInvalidArgs);
+    }
+    const auto name = std::get_if<std::string>(&list->at(0));
+    const auto transfer = std::get_if<bool>(&list->at(1));
+    const auto additional_data = std::get_if<std::string>(&list->at(2));
+    const auto id = name ? shared_buffer_pool_.Find(*name) : std::nullopt;
+    if (!transfer || !additional_data || !id) {
+      return result->Error(kErrorInvalidArgs);
+    }
+
+    if (!webview_->PostSharedBuffer(shared_buffers_[*id].get(), !*transfer,
+                                    *additional_data)) {
+      return result->Error(kMethodFailed);
+    }
+    if (*transfer) {
+      shared_buffer_pool_.Transfer(*name);
+    } else {
+      shared_buffer_pool_.MarkPosted(*name);
+    }
+    CloseSharedBuffers();
+    return result->Success();
+  }
+
+  // releaseSharedBuffer: String name
+  if (method_name.compare(kMethodReleaseSharedBuffer) == 0) {
+    const auto name = std::get_if<std::string>(method_call.arguments());
+    if (!name) {
+      return result->Error(kErrorInvalidArgs);
+    }
+    const auto released = shared_buffer_pool_.Release(*name);
+    CloseSharedBuffers();
+    return result->Success(flutter::EncodableValue(released));
+  }
+
+  // setPermissionDecision: [String origin, int kind, int decision, int? ttlMs]
+  // The decision is a WebviewPermissionDecision index; none removes the
+  // entry. Without a TTL, the decision is kept until cleared.
+  if (method_name.compare(kMethodSetPermissionDecision) == 0) {
+    const auto list =
+        std::get_if<flutter::EncodableList>(method_call.arguments());
+    if (!list || list->size() != 4) {
+      return result->Error(kErrorInvalidArgs);
+    }
+    const auto url = std::get_if<std::string>(&list->at(0));
+    const auto kind = std::get_if<int32_t>(&list->at(1));
+    const auto decision = std::get_if<int32_t>(&list->at(2));
+    // TTLs of 2^31 ms (~25 days) and more arrive as int64.
+    const auto ttl_ms = GetInt64(list->at(3));
+    const auto ttl =
+        ttl_ms ? util::PermissionCache::ParseTtl(*ttl_ms) : std::nullopt;
+    const auto origin = url ? util::NormalizeOrigin(*url) : std::nullopt;
+    if (!origin || !kind || !decision || *decision < 0 || *decision > 2 ||
+        (!ttl && !list->at(3).IsNull())) {
+      return result->Error(kErrorInvalidArgs);
+    }
+
+    if (*decision == 0) {
+      permission_cache_.Remove(*origin, *kind);
+    } else {
+      permission_cache_.Set(*origin, *kind,
+                            *decision == 1
+                                ? util::PermissionCache::Decision::kAllow
+                                : util::PermissionCache::Decision::kDeny,
+                            ttl, util::PermissionCache::Clock::now());
+    }
+    return result->Success();
+  }
+
+  // clearPermissionDecisions: String? origin
+  if (method_name.compare(kMethodClearPermissionDecisions) == 0) {
+    const auto arguments = method_call.arguments();
+    if (const auto url = std::get_if<std::string>(arguments)) {
+      const auto origin = util::NormalizeOrigin(*url);
+      if (!origin) {
+        return result->Error(kErrorInvalidArgs);
+      }
+      permission_cache_.RemoveOrigin(*origin);
+    } else {
+      permission_cache_.Clear();
+    }
+    return result->Success();
+  }
+
+  // setRendererWatchdog:
+  // [bool enabled, int heartbeatIntervalMs | null,
+  //  int heartbeatTimeoutMs | null]
+  if (method_name.compare(kMethodSetRendererWatchdog) == 0) {
+    const flutter::EncodableList* list =
+        std::get_if<flutter::EncodableList>(method_call.arguments());
+    if (!list || list->size() != 3) {
+      return result->Error(kErrorInvalidArgs);
+    }
+
+    const auto enabled = std::get_if<bool>(&(*list)[0]);
+    const auto interval = std::get_if<int32_t>(&(*list)[1]);
+    const auto timeout = std::get_if<int32_t>(&(*list)[2]);
+    if (!enabled || (!interval && !(*list)[1].IsNull()) ||
+        (!timeout && !(*list)[2].IsNull()) || (interval && *interval <= 0) ||
+        (timeout && *timeout <= 0)) {
+      return result->Error(kErrorInvalidArgs);
+    }
+
+    auto options = renderer_watchdog_.options();
+    if (interval) {
+      options.heartbeat_interval = std::chrono::milliseconds(*interval);
+    }
+    if (timeout) {
+      options.heartbeat_timeout = std::chrono::milliseconds(*timeout);
+      options.unresponsive_timeout =
+          std::max(options.unresponsive_timeout, options.heartbeat_timeout);
+    }
+    renderer_watchdog_.set_options(options);
+
+    renderer_watchdog_enabled_ = *enabled;
+    if (*enabled) {
+      StartRendererWatchdog();
+    } else {
+      renderer_watchdog_.Stop();
+    }
+    return result->Success();
+  }
+
+  // disposeTextureView: int textureId
+  if (method_name.compare(kMethodDisposeTextureView) == 0) {
+    const auto arguments = method_call.arguments();
+    const auto texture_id =
+        arguments ? GetInt64(*arguments) : std::optional<int64_t>();
+    if (!texture_id) {
+      return result->Error(kErrorInvalidArgs);
+    }
+
+    if (DisposeTextureView(*texture_id)) {
+      return result->Success();
+    }
+    return result->Error(kErrorInvalidArgs);
+  }
+
   if (method_name.compare(kMethodSetFpsLimit) == 0) {
     if (const auto value = std::get_if<int32_t>(method_call.arguments())) {
       texture_bridge_->SetFpsLimit(*value == 0 ? std::nullopt
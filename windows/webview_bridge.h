@@ -5,49 +5,200 @@
 #include <flutter/standard_method_codec.h>
 #include <flutter/texture_registrar.h>
 
+#include <atomic>
+#include <deque>
+#include <functional>
 #include <memory>
+#include <optional>
+#include <unordered_map>
+#include <utility>
 
 #include "graphics_context.h"
+#include "task_runner.h"
 #include "texture_bridge.h"
+#include "util/channel_log.h"
+#include "util/chunked_stream_buffer.h"
+#include "util/host_dispatcher.h"
+#include "util/permission_cache.h"
+#include "util/renderer_watchdog.h"
+#include "util/shared_buffer_pool.h"
+#include "util/task_monitor.h"
+#include "util/texture_view_graph.h"
 #include "webview.h"
 
 class WebviewBridge {
  public:
+  typedef std::function<void(size_t width, size_t height)>
+      SurfaceSizeChangedCallback;
+  typedef std::function<void(WebviewBridge* popup)> PopupInstanceCallback;
+
+  // Supplies the instances popups are opened in (see
+  // WebviewPopupWindowPolicy::NewInstance).
+  struct PopupProvider {
+    // Creates spare instances, so that popups open without delay.
+    std::function<void()> prewarm;
+    // Hands out an instance which hasn't navigated yet, or nullptr.
+    std::function<void(PopupInstanceCallback callback)> take;
+  };
+
+  // Without |capture_supported|, frames are obtained from preview images
+  // and handed to Flutter as pixel buffers (see TextureBridgePreview).
   WebviewBridge(flutter::BinaryMessenger* messenger,
                 flutter::TextureRegistrar* texture_registrar,
                 GraphicsContext* graphics_context,
-                std::unique_ptr<Webview> webview);
+                std::unique_ptr<Webview> webview,
+                bool capture_supported = true);
   ~WebviewBridge();
 
   TextureBridge* texture_bridge() const { return texture_bridge_.get(); }
 
+  Webview* webview() const { return webview_.get(); }
+
   int64_t texture_id() const { return texture_id_; }
 
+  void SetGraphicsContext(GraphicsContext* graphics_context) {
+    texture_bridge_->SetGraphicsContext(graphics_context);
+  }
+
+  void OnSurfaceSizeChanged(SurfaceSizeChangedCallback callback) {
+    surface_size_changed_callback_ = std::move(callback);
+  }
+
+  void SetPopupProvider(PopupProvider provider) {
+    popup_provider_ = std::move(provider);
+  }
+
+  // Method calls and WebView2 events are timed by |monitor| if set.
+  void SetTaskMonitor(util::TaskMonitor* monitor) { task_monitor_ = monitor; }
+
+  // Method calls and events are written to |recorder| if set.
+  void SetChannelRecorder(util::ChannelRecorder* recorder) {
+    channel_recorder_ = recorder;
+  }
+
+  // Handles a method call as if Dart had sent it on this instance's
+  // channel (see util::ChannelReplayer).
+  void ReplayMethodCall(
+      const flutter::MethodCall<flutter::EncodableValue>& method_call,
+      std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>>
+          result) {
+    HandleMethodCall(method_call, std::move(result));
+  }
+
  private:
+  enum class RendererFailureKind {
+    kExited,
+    kUnresponsive,
+    kHeartbeatTimeout,
+    kBrowserExited,
+  };
+  enum class RendererFailureState { kRecovering, kRecovered, kFailed };
+
+  struct TextureView {
+    int64_t view_id;
+    std::unique_ptr<flutter::TextureVariant> texture;
+  };
+
   std::unique_ptr<flutter::TextureVariant> flutter_texture_;
   std::unique_ptr<TextureBridge> texture_bridge_;
   std::unique_ptr<Webview> webview_;
   std::unique_ptr<flutter::EventSink<flutter::EncodableValue>> event_sink_;
+  // Events emitted while Dart isn't listening, replayed on listen.
+  std::deque<flutter::EncodableValue> pending_events_;
   std::unique_ptr<flutter::EventChannel<flutter::EncodableValue>>
       event_channel_;
   std::unique_ptr<flutter::MethodChannel<flutter::EncodableValue>>
       method_channel_;
 
   flutter::TextureRegistrar* texture_registrar_;
+  TaskRunner* task_runner_;
   int64_t texture_id_;
+  // Texture views are only available for GPU surfaces.
+  bool gpu_surface_;
+  // Additional textures fed by the same capture, keyed by texture id.
+  std::unordered_map<int64_t, TextureView> texture_views_;
+  SurfaceSizeChangedCallback surface_size_changed_callback_;
+  PopupProvider popup_provider_;
+  util::TaskMonitor* task_monitor_ = nullptr;
+  util::ChannelRecorder* channel_recorder_ = nullptr;
+  // Request bodies streamed from Dart, keyed by the id Dart assigned.
+  std::unordered_map<int64_t, std::shared_ptr<util::ChunkedStreamBuffer>>
+      request_bodies_;
+  // Functions exposed to scripts through the "flutter" host object, which
+  // is added with the first function.
+  std::shared_ptr<util::HostDispatcher> host_dispatcher_ =
+      std::make_shared<util::HostDispatcher>();
+  bool host_object_added_ = false;
+  bool host_calls_flush_pending_ = false;
+  // Decisions answering permission requests without asking Dart.
+  util::PermissionCache permission_cache_;
+  // Buffers shared with scripts, keyed by the pool's buffer ids.
+  util::SharedBufferPool shared_buffer_pool_;
+  std::unordered_map<util::SharedBufferPool::BufferId,
+                     wil::com_ptr<ICoreWebView2SharedBuffer>>
+      shared_buffers_;
+  // Restarts crashed or hung renderers (see util::RendererWatchdog).
+  util::RendererWatchdog renderer_watchdog_;
+  bool renderer_watchdog_enabled_ = true;
+  // The deadline of the earliest scheduled watchdog tick.
+  std::optional<util::RendererWatchdog::Clock::time_point>
+      watchdog_tick_time_;
+  RendererFailureKind renderer_failure_kind_ =
+      RendererFailureKind::kHeartbeatTimeout;
+  // Reported by the last heartbeat, restored after recovering.
+  std::optional<std::pair<double, double>> last_scroll_position_;
+  // The time of the last frame since the clock's epoch, or 0. Frames may
+  // be delivered on the raster thread.
+  std::atomic<util::RendererWatchdog::Clock::rep> last_frame_time_ = 0;
+  // Expires when the bridge is destroyed. Guards asynchronous callbacks
+  // emitting events.
+  std::shared_ptr<bool> lifetime_ = std::make_shared<bool>(true);
 
   void HandleMethodCall(
       const flutter::MethodCall<flutter::EncodableValue>& method_call,
       std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result);
   void RegisterEventHandlers();
 
+  util::TaskMonitor::Scope MonitorTask(std::string name) {
+    return util::TaskMonitor::Scope(task_monitor_, std::move(name));
+  }
+
+  int64_t CreateTextureView(const util::TextureViewSpec& spec);
+  bool DisposeTextureView(int64_t texture_id);
+
+  bool EnsureHostObject();
+  // Sends all queued calls of Dart host functions in a single event.
+  void FlushHostCalls();
+
+  // Closes the buffers the pool let go of.
+  void CloseSharedBuffers();
+
   template <typename T>
   void EmitEvent(const T& value) {
+    if (channel_recorder_) {
+      RecordEvent(flutter::EncodableValue(value));
+    }
     if (event_sink_) {
       event_sink_->Success(value);
+    } else {
+      BufferEvent(flutter::EncodableValue(value));
     }
   }
 
+  void BufferEvent(flutter::EncodableValue event);
+  void RecordEvent(const flutter::EncodableValue& event);
+  void RecordMessage(util::ChannelRecord::Kind kind, const std::string& name,
+                     const flutter::EncodableValue* payload);
+
+  void StartRendererWatchdog();
+  void ScheduleWatchdogTick();
+  void OnWatchdogTick(util::RendererWatchdog::Clock::time_point time);
+  void SendHeartbeat(uint64_t id);
+  void HandleWatchdogAction(util::RendererWatchdog::Action action,
+                            RendererFailureKind kind);
+  void EmitRendererFailure(RendererFailureKind kind,
+                           RendererFailureState state, int attempt);
+
   void OnPermissionRequested(
       const std::string& url, WebviewPermissionKind permissionKind,
       bool is_user_initiated,
@@ -6,6 +6,7 @@
 #include <iostream>
 
 #include "util/rohelper.h"
+#include "util/string_converter.h"
 
 using namespace Microsoft::WRL;
 
@@ -17,8 +18,8 @@ std::unique_ptr<WebviewHost> WebviewHost::Create(
   wil::com_ptr<CoreWebView2EnvironmentOptions> opts;
   if (arguments.has_value()) {
     opts = Microsoft::WRL::Make<CoreWebView2EnvironmentOptions>();
-    std::wstring warguments(arguments.value().begin(), arguments.value().end());
-    opts->put_AdditionalBrowserArguments(warguments.c_str());
+    opts->put_AdditionalBrowserArguments(
+        util::Utf16FromUtf8(arguments.value()).c_str());
   }
 
   std::promise<HRESULT> result_promise;
@@ -40,8 +41,9 @@ std::unique_ptr<WebviewHost> WebviewHost::Create(
     if ((SUCCEEDED(result) || result == RPC_E_CHANGED_MODE) && env) {
       auto webview_env3 = env.try_query<ICoreWebView2Environment3>();
       if (webview_env3) {
-        return std::unique_ptr<WebviewHost>(
-            new WebviewHost(platform, std::move(webview_env3)));
+        return std::unique_ptr<WebviewHost>(new WebviewHost(
+            platform, std::move(webview_env3), std::move(user_data_directory),
+            std::move(browser_exe_path), std::move(arguments)));
       }
     }
   }
@@ -50,16 +52,68 @@ std::unique_ptr<WebviewHost> WebviewHost::Create(
 }
 
 WebviewHost::WebviewHost(WebviewPlatform* platform,
-                         wil::com_ptr<ICoreWebView2Environment3> webview_env)
-    : webview_env_(webview_env) {
+                         wil::com_ptr<ICoreWebView2Environment3> webview_env,
+                         std::optional<std::wstring> user_data_directory,
+                         std::optional<std::wstring> browser_exe_path,
+                         std::optional<std::string> arguments)
+    : platform_(platform),
+      webview_env_(webview_env),
+      user_data_directory_(std::move(user_data_directory)),
+      browser_exe_path_(std::move(browser_exe_path)),
+      arguments_(std::move(arguments)) {
   compositor_ = platform->graphics_context()->CreateCompositor();
 }
 
+bool WebviewHost::SupportsProfiles() const {
+  return webview_env_.try_query<ICoreWebView2Environment10>() != nullptr;
+}
+
 void WebviewHost::CreateWebview(HWND hwnd, bool offscreen_only,
                                 bool owns_window,
-                                WebviewCreationCallback callback) {
+                                WebviewCreationCallback callback,
+                                const WebviewProfileOptions& profile) {
+  wil::com_ptr<ICoreWebView2ControllerOptions> options;
+  if (!profile.IsDefault()) {
+    if (!SupportsProfiles()) {
+      if (profile.in_private) {
+        return callback(nullptr,
+                        WebviewCreationError::create(
+                            E_NOTIMPL,
+                            "InPrivate mode requires a newer WebView2 "
+                            "runtime."));
+      }
+
+      // Fall back to a separate environment (and browser process) for the
+      // profile.
+      auto host = GetProfileHost(*profile.name);
+      if (!host) {
+        return callback(nullptr, WebviewCreationError::create(
+                                     E_FAIL,
+                                     "Creating the profile environment "
+                                     "failed."));
+      }
+      return host->CreateWebview(hwnd, offscreen_only, owns_window,
+                                 std::move(callback));
+    }
+
+    auto env10 = webview_env_.query<ICoreWebView2Environment10>();
+    auto hr = env10->CreateCoreWebView2ControllerOptions(options.put());
+    if (SUCCEEDED(hr) && profile.name) {
+      hr = options->put_ProfileName(
+          util::Utf16FromUtf8(*profile.name).c_str());
+    }
+    if (SUCCEEDED(hr)) {
+      hr = options->put_IsInPrivateModeEnabled(profile.in_private);
+    }
+    if (FAILED(hr)) {
+      return callback(nullptr,
+                      WebviewCreationError::create(
+                          hr, "Creating the controller options failed."));
+    }
+  }
+
   CreateWebViewCompositionController(
-      hwnd, [=, self = this](
+      hwnd, options.get(), [=, self = this](
                 wil::com_ptr<ICoreWebView2CompositionController> controller,
                 std::unique_ptr<WebviewCreationError> error) {
         if (controller) {
@@ -84,30 +138,60 @@ void WebviewHost::CreateWebViewPointerInfo(PointerInfoCreationCallback callback)
   }
 }
 
+WebviewHost* WebviewHost::GetProfileHost(const std::string& name) {
+  const auto it = profile_hosts_.find(name);
+  if (it != profile_hosts_.end()) {
+    return it->second.get();
+  }
+
+  // Profile environments live in subfolders of the user data directory.
+  if (!user_data_directory_) {
+    return nullptr;
+  }
+
+  // Profile names are valid folder names (see util::IsValidProfileName).
+  auto host = Create(platform_,
+                     *user_data_directory_ + L"\\Profiles\\" +
+                         util::Utf16FromUtf8(name),
+                     browser_exe_path_, arguments_);
+  if (!host) {
+    return nullptr;
+  }
+  return (profile_hosts_[name] = std::move(host)).get();
+}
+
 void WebviewHost::CreateWebViewCompositionController(
-    HWND hwnd, CompositionControllerCreationCallback callback) {
-  auto hr = webview_env_->CreateCoreWebView2CompositionController(
-      hwnd,
-      Callback<
-          ICoreWebView2CreateCoreWebView2CompositionControllerCompletedHandler>(
-          [callback](HRESULT hr,
-                     ICoreWebView2CompositionController* compositionController)
-              -> HRESULT {
-            if (SUCCEEDED(hr)) {
-              callback(
-                  std::move(wil::com_ptr<ICoreWebView2CompositionController>(
-                      compositionController)),
-                  nullptr);
-            } else {
-              callback(nullptr, WebviewCreationError::create(
-                                    hr,
-                                    "CreateCoreWebView2CompositionController "
-                                    "completion handler failed."));
-            }
+    HWND hwnd, ICoreWebView2ControllerOptions* options,
+    CompositionControllerCreationCallback callback) {
+  auto handler = Callback<
+      ICoreWebView2CreateCoreWebView2CompositionControllerCompletedHandler>(
+      [callback](HRESULT hr,
+                 ICoreWebView2CompositionController* compositionController)
+          -> HRESULT {
+        if (SUCCEEDED(hr)) {
+          callback(
+              std::move(wil::com_ptr<ICoreWebView2CompositionController>(
+                  compositionController)),
+              nullptr);
+        } else {
+          callback(nullptr, WebviewCreationError::create(
+                                hr,
+                                "CreateCoreWebView2CompositionController "
+                                "completion handler failed."));
+        }
 
-            return S_OK;
-          })
-          .Get());
+        return S_OK;
+      });
+
+  HRESULT hr;
+  if (options) {
+    auto env10 = webview_env_.query<ICoreWebView2Environment10>();
+    hr = env10->CreateCoreWebView2CompositionControllerWithOptions(
+        hwnd, options, handler.Get());
+  } else {
+    hr = webview_env_->CreateCoreWebView2CompositionController(hwnd,
+                                                              handler.Get());
+  }
 
   if (FAILED(hr)) {
     callback(nullptr,
@@ -5,6 +5,10 @@
 #include <wil/com.h>
 
 #include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
 
 #include "graphics_context.h"
 #include "webview.h"
@@ -24,6 +28,16 @@ struct WebviewCreationError {
   }
 };
 
+// Selects the browser profile of a webview. Profiles of one environment
+// share its browser process but keep their storage separate.
+struct WebviewProfileOptions {
+  // The default profile if not set.
+  std::optional<std::string> name;
+  bool in_private = false;
+
+  bool IsDefault() const { return !name && !in_private; }
+};
+
 class WebviewHost {
  public:
   typedef std::function<void(std::unique_ptr<Webview>,
@@ -43,7 +57,13 @@ class WebviewHost {
       std::optional<std::string> arguments = std::nullopt);
 
   void CreateWebview(HWND hwnd, bool offscreen_only, bool owns_window,
-                     WebviewCreationCallback callback);
+                     WebviewCreationCallback callback,
+                     const WebviewProfileOptions& profile = {});
+
+  // Whether profiles are hosted in this environment's browser process.
+  // Otherwise, each named profile gets an environment of its own in a
+  // subfolder of the user data directory.
+  bool SupportsProfiles() const;
 
   void CreateWebViewPointerInfo(PointerInfoCreationCallback cb);
 
@@ -53,11 +73,22 @@ class WebviewHost {
   }
 
  private:
+  WebviewPlatform* platform_;
   winrt::com_ptr<ABI::Windows::UI::Composition::ICompositor> compositor_;
   wil::com_ptr<ICoreWebView2Environment3> webview_env_;
+  std::optional<std::wstring> user_data_directory_;
+  std::optional<std::wstring> browser_exe_path_;
+  std::optional<std::string> arguments_;
+  // Environments emulating profiles on runtimes without profile support.
+  std::unordered_map<std::string, std::unique_ptr<WebviewHost>> profile_hosts_;
 
   WebviewHost(WebviewPlatform* platform,
-              wil::com_ptr<ICoreWebView2Environment3> webview_env);
+              wil::com_ptr<ICoreWebView2Environment3> webview_env,
+              std::optional<std::wstring> user_data_directory,
+              std::optional<std::wstring> browser_exe_path,
+              std::optional<std::string> arguments);
   void CreateWebViewCompositionController(
-      HWND hwnd, CompositionControllerCreationCallback cb);
+      HWND hwnd, ICoreWebView2ControllerOptions* options,
+      CompositionControllerCreationCallback cb);
+  WebviewHost* GetProfileHost(const std::string& name);
 };
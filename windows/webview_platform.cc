@@ -4,6 +4,7 @@
 #include <shlobj.h>
 #include <windows.graphics.capture.h>
 
+#include <algorithm>
 #include <filesystem>
 #include <iostream>
 
@@ -19,18 +20,54 @@ WebviewPlatform::WebviewPlatform()
       return;
     }
 
-    if (!IsGraphicsCaptureSessionSupported()) {
+    winrt::com_ptr<ABI::Windows::System::IDispatcherQueue> dispatcher_queue;
+    if (FAILED(dispatcher_queue_controller_->get_DispatcherQueue(
+            dispatcher_queue.put()))) {
+      std::cerr << "Obtaining the DispatcherQueue failed." << std::endl;
+      return;
+    }
+    task_runner_ = std::make_unique<TaskRunner>(std::move(dispatcher_queue));
+
+    capture_supported_ = IsGraphicsCaptureSessionSupported();
+    if (!capture_supported_) {
       std::cerr << "Windows::Graphics::Capture::GraphicsCaptureSession is not "
-                   "supported."
+                   "supported. Falling back to preview images."
                 << std::endl;
-      return;
     }
 
-    graphics_context_ = std::make_unique<GraphicsContext>(rohelper_.get());
-    valid_ = graphics_context_->IsValid();
+    graphics_contexts_.push_back(
+        std::make_unique<GraphicsContext>(rohelper_.get(), task_runner_.get()));
+    valid_ = graphics_contexts_[0]->IsValid();
   }
 }
 
+GraphicsContext* WebviewPlatform::graphics_context(size_t shard) {
+  if (shard == 0 || shard >= shard_count_ || graphics_contexts_.empty()) {
+    return graphics_context();
+  }
+
+  if (graphics_contexts_.size() <= shard) {
+    graphics_contexts_.resize(shard + 1);
+  }
+
+  auto& context = graphics_contexts_[shard];
+  if (!context) {
+    context =
+        std::make_unique<GraphicsContext>(rohelper_.get(), task_runner_.get());
+  }
+
+  if (!context->IsValid()) {
+    std::cerr << "Creating graphics context shard " << shard << " failed."
+              << std::endl;
+    return nullptr;
+  }
+  return context.get();
+}
+
+void WebviewPlatform::SetGraphicsContextShardCount(size_t count) {
+  shard_count_ = std::max<size_t>(count, 1);
+}
+
 bool WebviewPlatform::IsGraphicsCaptureSessionSupported() {
   HSTRING className;
   HSTRING_HEADER classNameHeader;
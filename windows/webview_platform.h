@@ -5,26 +5,47 @@
 #include <memory>
 #include <optional>
 #include <string>
+#include <vector>
 
 #include "graphics_context.h"
+#include "task_runner.h"
 #include "util/rohelper.h"
 
 class WebviewPlatform {
  public:
   WebviewPlatform();
   bool IsSupported() { return valid_; }
+  // Whether frames can be captured using Windows.Graphics.Capture. If not,
+  // instances fall back to polling preview images.
+  bool capture_supported() const { return capture_supported_; }
   std::optional<std::wstring> GetDefaultDataDirectory();
   bool IsGraphicsCaptureSessionSupported();
   GraphicsContext* graphics_context() const {
-    return graphics_context_.get();
+    return graphics_contexts_.empty() ? nullptr : graphics_contexts_[0].get();
   };
 
+  // Returns the graphics context of the given shard, which is created on
+  // first use, or nullptr if creating it has failed. Shard 0 is the primary
+  // context.
+  GraphicsContext* graphics_context(size_t shard);
+
+  size_t graphics_context_shard_count() const { return shard_count_; }
+
+  // Sets the number of graphics context shards. Each shard owns a separate
+  // device and immediate context so that instances assigned to different
+  // shards can capture and copy in parallel.
+  void SetGraphicsContextShardCount(size_t count);
+
   rx::RoHelper* rohelper() const { return rohelper_.get(); }
+  TaskRunner* task_runner() const { return task_runner_.get(); }
 
  private:
   std::unique_ptr<rx::RoHelper> rohelper_;
   winrt::com_ptr<ABI::Windows::System::IDispatcherQueueController>
       dispatcher_queue_controller_;
-  std::unique_ptr<GraphicsContext> graphics_context_;
+  std::unique_ptr<TaskRunner> task_runner_;
+  std::vector<std::unique_ptr<GraphicsContext>> graphics_contexts_;
+  size_t shard_count_ = 1;
   bool valid_ = false;
+  bool capture_supported_ = false;
 };
@@ -1,18 +1,39 @@
 #include "include/webview_windows/webview_windows_plugin.h"
 
 #include <flutter/method_channel.h>
+#include <flutter/method_result_functions.h>
 #include <flutter/plugin_registrar_windows.h>
+#include <flutter/standard_message_codec.h>
 #include <flutter/standard_method_codec.h>
 #include <windows.h>
 
+#include <algorithm>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <iterator>
+#include <map>
 #include <memory>
 #include <string>
+#include <tuple>
 #include <unordered_map>
+#include <unordered_set>
 
 #include "webview_bridge.h"
 #include "webview_host.h"
 #include "webview_platform.h"
+#include "util/browser_arguments.h"
+#include "util/channel_log.h"
+#include "util/channel_replayer.h"
+#include "util/profile_name.h"
+#include "util/restore_scheduler.h"
+#include "util/script_registry.h"
+#include "util/session_snapshot.h"
+#include "util/shard_balancer.h"
 #include "util/string_converter.h"
+#include "util/task_monitor.h"
 
 #pragma comment(lib, "dxgi.lib")
 #pragma comment(lib, "d3d11.lib")
@@ -23,14 +44,41 @@ constexpr auto kMethodInitialize = "initialize";
 constexpr auto kMethodDispose = "dispose";
 constexpr auto kMethodInitializeEnvironment = "initializeEnvironment";
 constexpr auto kMethodGetWebViewVersion = "getWebViewVersion";
+constexpr auto kMethodSnapshotSession = "snapshotSession";
+constexpr auto kMethodRestoreSession = "restoreSession";
+constexpr auto kMethodAddGlobalScript = "addGlobalScript";
+constexpr auto kMethodRemoveGlobalScript = "removeGlobalScript";
+constexpr auto kMethodGetTaskStats = "getTaskStats";
+constexpr auto kMethodConfigureTaskMonitor = "configureTaskMonitor";
+constexpr auto kMethodResetTaskStats = "resetTaskStats";
+constexpr auto kMethodStartChannelRecording = "startChannelRecording";
+constexpr auto kMethodStopChannelRecording = "stopChannelRecording";
+constexpr auto kMethodReplayChannelLog = "replayChannelLog";
+
+// Invoked on Dart for tasks exceeding the budget, if enabled.
+constexpr auto kMethodSlowCall = "slowCall";
 
 constexpr auto kErrorCodeInvalidId = "invalid_id";
+constexpr auto kErrorCodeInvalidArgs = "invalidArguments";
 constexpr auto kErrorCodeEnvironmentCreationFailed =
     "environment_creation_failed";
 constexpr auto kErrorCodeEnvironmentAlreadyInitialized =
     "environment_already_initialized";
 constexpr auto kErrorCodeWebviewCreationFailed = "webview_creation_failed";
+constexpr auto kErrorCodeUnknownEnvironment = "unknown_environment";
 constexpr auto kErrorUnsupportedPlatform = "unsupported_platform";
+constexpr auto kErrorCodeRecordingFailed = "recording_failed";
+constexpr auto kErrorCodeReplayFailed = "replay_failed";
+
+// The initial surface size of a webview (see Webview::CreateSurface).
+constexpr uint64_t kDefaultSurfaceWeight = 1280 * 720;
+
+// The number of webviews created concurrently when restoring a session.
+constexpr int32_t kDefaultRestoreParallelism = 4;
+
+// The number of spare webviews kept per environment and profile once popups
+// are opened in new instances.
+constexpr size_t kWarmPoolSize = 1;
 
 template <typename T>
 std::optional<T> GetOptionalValue(const flutter::EncodableMap& map,
@@ -45,6 +93,114 @@ std::optional<T> GetOptionalValue(const flutter::EncodableMap& map,
   return std::nullopt;
 }
 
+// Standard codec integers arrive as int32 or int64 depending on their value.
+std::optional<int64_t> GetInt64(const flutter::EncodableValue& value) {
+  if (const auto i32 = std::get_if<int32_t>(&value)) {
+    return *i32;
+  }
+  if (const auto i64 = std::get_if<int64_t>(&value)) {
+    return *i64;
+  }
+  return std::nullopt;
+}
+
+// Method call arguments as written to channel logs.
+std::vector<uint8_t> EncodePayload(const flutter::EncodableValue* value) {
+  if (!value || value->IsNull()) {
+    return {};
+  }
+  return std::move(
+      *flutter::StandardMessageCodec::GetInstance().EncodeMessage(*value));
+}
+
+// Calls whose results are recorded, so that replays can map the instances
+// they create to the recorded ones.
+bool CreatesInstances(const std::string& method_name) {
+  return method_name == kMethodInitialize ||
+         method_name == kMethodRestoreSession;
+}
+
+// The texture ids in the result of a call creating instances, in order, or
+// nullopt for instances which couldn't be created.
+std::vector<std::optional<int64_t>> GetCreatedTextureIds(
+    const flutter::EncodableValue& result) {
+  std::vector<std::optional<int64_t>> texture_ids;
+  if (const auto map = std::get_if<flutter::EncodableMap>(&result)) {
+    const auto it = map->find(flutter::EncodableValue("textureId"));
+    texture_ids.push_back(it != map->end() ? GetInt64(it->second)
+                                           : std::nullopt);
+  } else if (const auto list = std::get_if<flutter::EncodableList>(&result)) {
+    for (const auto& entry : *list) {
+      texture_ids.push_back(GetInt64(entry));
+    }
+  }
+  return texture_ids;
+}
+
+int64_t ToMicroseconds(util::TaskMonitor::Clock::duration duration) {
+  return std::chrono::duration_cast<std::chrono::microseconds>(duration)
+      .count();
+}
+
+flutter::EncodableValue EncodeTaskStats(const util::TaskMonitor& monitor) {
+  flutter::EncodableList bucket_bounds;
+  for (const auto bound : util::TaskMonitor::kBucketBoundsMs) {
+    bucket_bounds.push_back(flutter::EncodableValue(bound));
+  }
+
+  flutter::EncodableMap tasks;
+  for (const auto& [name, stats] : monitor.stats()) {
+    flutter::EncodableList histogram;
+    for (const auto count : stats.histogram) {
+      histogram.push_back(flutter::EncodableValue(static_cast<int64_t>(count)));
+    }
+    tasks[flutter::EncodableValue(name)] =
+        flutter::EncodableValue(flutter::EncodableMap{
+            {flutter::EncodableValue("count"),
+             flutter::EncodableValue(static_cast<int64_t>(stats.count))},
+            {flutter::EncodableValue("longCount"),
+             flutter::EncodableValue(static_cast<int64_t>(stats.long_count))},
+            {flutter::EncodableValue("totalUs"),
+             flutter::EncodableValue(ToMicroseconds(stats.total))},
+            {flutter::EncodableValue("maxUs"),
+             flutter::EncodableValue(ToMicroseconds(stats.max))},
+            {flutter::EncodableValue("histogram"),
+             flutter::EncodableValue(std::move(histogram))},
+        });
+  }
+
+  const auto now = util::TaskMonitor::Clock::now();
+  flutter::EncodableList long_tasks;
+  for (const auto& task : monitor.long_tasks()) {
+    long_tasks.push_back(flutter::EncodableValue(flutter::EncodableMap{
+        {flutter::EncodableValue("name"), flutter::EncodableValue(task.name)},
+        {flutter::EncodableValue("durationUs"),
+         flutter::EncodableValue(ToMicroseconds(task.duration))},
+        {flutter::EncodableValue("ageUs"),
+         flutter::EncodableValue(ToMicroseconds(now - task.end))},
+    }));
+  }
+
+  return flutter::EncodableValue(flutter::EncodableMap{
+      {flutter::EncodableValue("budgetUs"),
+       flutter::EncodableValue(ToMicroseconds(monitor.budget()))},
+      {flutter::EncodableValue("bucketBoundsMs"),
+       flutter::EncodableValue(std::move(bucket_bounds))},
+      {flutter::EncodableValue("tasks"),
+       flutter::EncodableValue(std::move(tasks))},
+      {flutter::EncodableValue("longTasks"),
+       flutter::EncodableValue(std::move(long_tasks))},
+  });
+}
+
+std::string GetCreationErrorMessage(const WebviewCreationError* error) {
+  if (error) {
+    return std::format("Creating the webview failed: {} (HRESULT: {:#010x})",
+                       error->message, error->hr);
+  }
+  return "Creating the webview failed.";
+}
+
 class WebviewWindowsPlugin : public flutter::Plugin {
  public:
   static void RegisterWithRegistrar(flutter::PluginRegistrarWindows* registrar);
@@ -56,17 +212,126 @@ class WebviewWindowsPlugin : public flutter::Plugin {
 
  private:
   std::unique_ptr<WebviewPlatform> platform_;
+  // The default environment.
   std::unique_ptr<WebviewHost> webview_host_;
+  // Environments created by initializeEnvironment with a name.
+  std::unordered_map<std::string, std::unique_ptr<WebviewHost>> environments_;
   std::unordered_map<int64_t, std::unique_ptr<WebviewBridge>> instances_;
+  // The environment and profile each instance was created in, which session
+  // snapshots record.
+  struct InstanceOrigin {
+    WebviewHost* host = nullptr;
+    WebviewProfileOptions profile;
+  };
+  std::unordered_map<int64_t, InstanceOrigin> instance_origins_;
+  util::ShardBalancer shard_balancer_;
+  // Scripts added to every instance.
+  util::ScriptRegistry script_registry_;
+
+  // Popups must be opened in an instance of the same environment and
+  // profile as their opener.
+  typedef std::tuple<WebviewHost*, std::string, bool> WarmPoolKey;
+  // Spare instances which haven't navigated yet, for opening popups.
+  struct WarmPool {
+    // Keys of instances_, which Dart doesn't know about yet.
+    std::deque<int64_t> texture_ids;
+    size_t creating = 0;
+    std::deque<WebviewBridge::PopupInstanceCallback> waiting;
+  };
+  std::map<WarmPoolKey, WarmPool> warm_pools_;
+
+  // Times all work on the platform thread: method calls on every channel
+  // and WebView2 events.
+  util::TaskMonitor task_monitor_;
+  bool report_slow_calls_ = false;
+  std::unique_ptr<flutter::MethodChannel<flutter::EncodableValue>> channel_;
+
+  // Set while the traffic of all channels is recorded.
+  std::unique_ptr<util::ChannelRecorder> channel_recorder_;
+  // Incremented whenever the recorder is replaced, so that results of calls
+  // from an earlier recording are dropped.
+  uint64_t channel_recording_id_ = 0;
+
+  // The state of an ongoing replayChannelLog call.
+  struct ChannelReplay {
+    std::unique_ptr<util::ChannelReplayer> replayer;
+    // Recorded texture ids mapped to the ids of the instances created by
+    // the replay.
+    std::unordered_map<int64_t, int64_t> texture_ids;
+    // The texture ids returned by calls creating instances, by the index of
+    // the call's record, while the other side isn't known yet.
+    std::unordered_map<size_t, std::vector<std::optional<int64_t>>>
+        recorded_results;
+    std::unordered_map<size_t, std::vector<std::optional<int64_t>>>
+        replayed_results;
+    // Recorded instances disposed of before the replay created them.
+    std::unordered_set<int64_t> pending_disposals;
+    size_t results = 0;
+    size_t skipped = 0;
+    std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result;
+  };
+  std::shared_ptr<ChannelReplay> channel_replay_;
 
   WNDCLASS window_class_ = {};
   flutter::TextureRegistrar* textures_;
   flutter::BinaryMessenger* messenger_;
 
+  typedef std::function<void(WebviewBridge* bridge,
+                             std::unique_ptr<WebviewCreationError> error)>
+      InstanceCreatedCallback;
+
+  // The state of an ongoing restoreSession call.
+  struct SessionRestore {
+    util::SessionSnapshot snapshot;
+    util::RestoreScheduler scheduler;
+    // The texture ids of the restored instances in snapshot order (null
+    // for instances which failed to be created).
+    flutter::EncodableList texture_ids;
+    std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result;
+  };
+
   bool InitPlatform();
+  // Creates the default environment unless one has been initialized. Errors
+  // are reported on |result|.
+  bool InitWebviewHost(flutter::MethodResult<flutter::EncodableValue>* result);
+  void RebalanceGraphicsContexts();
+  // Returns the graphics context of the least loaded shard whose context
+  // could be created. Shards failing to create one are disabled.
+  GraphicsContext* PickGraphicsContext(size_t* shard);
 
-  void CreateWebviewInstance(
-      std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>>);
+  void CreateWebviewInstance(WebviewHost* host,
+                             const WebviewProfileOptions& profile,
+                             InstanceCreatedCallback callback);
+  void SnapshotSession(
+      const flutter::EncodableList& instances,
+      std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result);
+  void RestoreSession(
+      util::SessionSnapshot snapshot, size_t max_parallel,
+      std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result);
+  void RestoreInstance(std::shared_ptr<SessionRestore> restore, size_t index);
+  // Returns the name |host| was initialized with, or std::nullopt for the
+  // default environment.
+  std::optional<std::string> GetEnvironmentName(const WebviewHost* host) const;
+  void AddRegisteredScript(int64_t texture_id, WebviewBridge* bridge,
+                           const util::ScriptRegistry::Script& script);
+  void FillWarmPool(WebviewHost* host, const WebviewProfileOptions& profile);
+  void SetChannelRecorder(std::unique_ptr<util::ChannelRecorder> recorder);
+  // Wraps |result| to record the value it succeeds with.
+  std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>>
+  RecordResult(
+      size_t call, const std::string& method_name,
+      std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result);
+  void ReplayChannelLog(
+      std::vector<util::ChannelRecord> records, double speed,
+      std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result);
+  void RunChannelReplay(std::shared_ptr<ChannelReplay> replay);
+  void DispatchReplayedRecord(ChannelReplay* replay, size_t index,
+                              const util::ChannelRecord& record);
+  // Maps the instances created by the call at |call| once both its
+  // recorded and its replayed result are known.
+  void MapReplayedInstances(ChannelReplay* replay, size_t call);
+  void TakeWarmInstance(WebviewHost* host, const WebviewProfileOptions& profile,
+                        WebviewBridge::PopupInstanceCallback callback);
   // Called when a method is called on this plugin's channel from Dart.
   void HandleMethodCall(
       const flutter::MethodCall<flutter::EncodableValue>& method_call,
@@ -88,6 +353,8 @@ void WebviewWindowsPlugin::RegisterWithRegistrar(
       [plugin_pointer = plugin.get()](const auto& call, auto result) {
         plugin_pointer->HandleMethodCall(call, std::move(result));
       });
+  // Kept for reporting slow calls.
+  plugin->channel_ = std::move(channel);
 
   registrar->AddPlugin(std::move(plugin));
 }
@@ -98,6 +365,20 @@ WebviewWindowsPlugin::WebviewWindowsPlugin(flutter::TextureRegistrar* textures,
   window_class_.lpszClassName = L"FlutterWebviewMessage";
   window_class_.lpfnWndProc = &DefWindowProc;
   RegisterClass(&window_class_);
+
+  task_monitor_.SetOnLongTask([this](const util::TaskMonitor::LongTask& task) {
+    if (!report_slow_calls_ || !channel_) {
+      return;
+    }
+    channel_->InvokeMethod(
+        kMethodSlowCall,
+        std::make_unique<flutter::EncodableValue>(flutter::EncodableMap{
+            {flutter::EncodableValue("name"),
+             flutter::EncodableValue(task.name)},
+            {flutter::EncodableValue("durationUs"),
+             flutter::EncodableValue(ToMicroseconds(task.duration))},
+        }));
+  });
 }
 
 WebviewWindowsPlugin::~WebviewWindowsPlugin() {
@@ -108,8 +389,23 @@ WebviewWindowsPlugin::~WebviewWindowsPlugin() {
 void WebviewWindowsPlugin::HandleMethodCall(
     const flutter::MethodCall<flutter::EncodableValue>& method_call,
     std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result) {
+  const util::TaskMonitor::Scope scope(&task_monitor_,
+                                       "plugin." + method_call.method_name());
+  if (channel_recorder_) {
+    const auto call = channel_recorder_->Record(
+        util::ChannelRecord::Kind::kMethodCall, util::kPluginChannel,
+        method_call.method_name(), EncodePayload(method_call.arguments()));
+    if (CreatesInstances(method_call.method_name())) {
+      result = RecordResult(call, method_call.method_name(), std::move(result));
+    }
+  }
+
   if (method_call.method_name().compare(kMethodInitializeEnvironment) == 0) {
-    if (webview_host_) {
+    const auto& map = std::get<flutter::EncodableMap>(*method_call.arguments());
+
+    // Named environments are created in addition to the default one.
+    const auto name = GetOptionalValue<std::string>(map, "name");
+    if (name ? environments_.count(*name) > 0 : webview_host_ != nullptr) {
       return result->Error(kErrorCodeEnvironmentAlreadyInitialized,
                            "The webview environment is already initialized");
     }
@@ -119,8 +415,6 @@ void WebviewWindowsPlugin::HandleMethodCall(
                            "The platform is not supported");
     }
 
-    const auto& map = std::get<flutter::EncodableMap>(*method_call.arguments());
-
     std::optional<std::wstring> browser_exe_wpath = std::nullopt;
     std::optional<std::string> browser_exe_path =
         GetOptionalValue<std::string>(map, "browserExePath");
@@ -140,11 +434,47 @@ void WebviewWindowsPlugin::HandleMethodCall(
     std::optional<std::string> additional_args =
         GetOptionalValue<std::string>(map, "additionalArguments");
 
-    webview_host_ = std::move(WebviewHost::Create(
-        platform_.get(), user_data_wpath, browser_exe_wpath, additional_args));
-    if (!webview_host_) {
+    // Without a performance profile, the arguments are passed on as they
+    // are. Otherwise, they take precedence over the profile's ones, which
+    // requires parsing them.
+    const auto performance_profile =
+        GetOptionalValue<int32_t>(map, "performanceProfile");
+    if (performance_profile) {
+      if (*performance_profile < 0 ||
+          *performance_profile >
+              static_cast<int32_t>(util::PerformanceProfile::kMaxThroughput)) {
+        return result->Error(kErrorCodeInvalidArgs,
+                             "Unknown performance profile");
+      }
+      const auto user_args = util::BrowserArguments::Parse(
+          additional_args.value_or(std::string()));
+      if (!user_args) {
+        return result->Error(kErrorCodeInvalidArgs,
+                             "Malformed additional arguments");
+      }
+      auto args = util::BrowserArguments::ForProfile(
+          static_cast<util::PerformanceProfile>(*performance_profile));
+      args.Merge(*user_args);
+      additional_args = args.ToString();
+    }
+
+    auto host = WebviewHost::Create(platform_.get(), user_data_wpath,
+                                    browser_exe_wpath, additional_args);
+    if (!host) {
       return result->Error(kErrorCodeEnvironmentCreationFailed);
     }
+    if (name) {
+      environments_[*name] = std::move(host);
+    } else {
+      webview_host_ = std::move(host);
+    }
+
+    std::optional<int32_t> shards =
+        GetOptionalValue<int32_t>(map, "graphicsContextShards");
+    if (shards && *shards > 0 &&
+        shard_balancer_.SetShardCount(static_cast<size_t>(*shards))) {
+      platform_->SetGraphicsContextShardCount(static_cast<size_t>(*shards));
+    }
 
     return result->Success();
   }
@@ -159,8 +489,233 @@ void WebviewWindowsPlugin::HandleMethodCall(
     }
   }
 
+  // Map: {environment: String?, profile: String?, inPrivate: bool?,
+  //       initialUrl: String?}
   if (method_call.method_name().compare(kMethodInitialize) == 0) {
-    return CreateWebviewInstance(std::move(result));
+    WebviewHost* host = nullptr;
+    WebviewProfileOptions profile;
+    const auto map =
+        std::get_if<flutter::EncodableMap>(method_call.arguments());
+    const auto environment =
+        map ? GetOptionalValue<std::string>(*map, "environment") : std::nullopt;
+    const auto initial_url =
+        map ? GetOptionalValue<std::string>(*map, "initialUrl") : std::nullopt;
+    if (map) {
+      profile.name = GetOptionalValue<std::string>(*map, "profile");
+      profile.in_private =
+          GetOptionalValue<bool>(*map, "inPrivate").value_or(false);
+      if (profile.name && !util::IsValidProfileName(*profile.name)) {
+        return result->Error(kErrorCodeInvalidArgs, "Invalid profile name");
+      }
+    }
+
+    if (environment) {
+      const auto it = environments_.find(*environment);
+      if (it == environments_.end()) {
+        return result->Error(kErrorCodeUnknownEnvironment,
+                             "The environment has not been initialized");
+      }
+      host = it->second.get();
+    } else if (InitWebviewHost(result.get())) {
+      host = webview_host_.get();
+    } else {
+      return;
+    }
+
+    std::shared_ptr<flutter::MethodResult<flutter::EncodableValue>>
+        shared_result = std::move(result);
+    return CreateWebviewInstance(
+        host, profile,
+        [shared_result, initial_url](
+            WebviewBridge* bridge,
+            std::unique_ptr<WebviewCreationError> error) {
+          if (!bridge) {
+            return shared_result->Error(kErrorCodeWebviewCreationFailed,
+                                        GetCreationErrorMessage(error.get()));
+          }
+
+          // Saves a round trip; the bridge keeps the resulting events
+          // until Dart listens.
+          if (initial_url) {
+            bridge->webview()->LoadUrl(*initial_url);
+          }
+
+          auto response = flutter::EncodableValue(flutter::EncodableMap{
+              {flutter::EncodableValue("textureId"),
+               flutter::EncodableValue(bridge->texture_id())},
+          });
+
+          shared_result->Success(response);
+        });
+  }
+
+  // List: [[textureId, priority], ...]
+  if (method_call.method_name().compare(kMethodSnapshotSession) == 0) {
+    if (const auto instances =
+            std::get_if<flutter::EncodableList>(method_call.arguments())) {
+      return SnapshotSession(*instances, std::move(result));
+    }
+    return result->Error(kErrorCodeInvalidArgs);
+  }
+
+  // List: [Uint8List snapshot, int maxParallel]
+  if (method_call.method_name().compare(kMethodRestoreSession) == 0) {
+    const auto list =
+        std::get_if<flutter::EncodableList>(method_call.arguments());
+    if (list && list->size() == 2) {
+      const auto data = std::get_if<std::vector<uint8_t>>(&list->at(0));
+      const auto max_parallel = std::get_if<int32_t>(&list->at(1));
+      util::SessionSnapshot snapshot;
+      if (data &&
+          util::DeserializeSessionSnapshot(data->data(), data->size(),
+                                           &snapshot)) {
+        return RestoreSession(
+            std::move(snapshot),
+            max_parallel && *max_parallel > 0 ? *max_parallel
+                                              : kDefaultRestoreParallelism,
+            std::move(result));
+      }
+    }
+    return result->Error(kErrorCodeInvalidArgs);
+  }
+
+  // String: script
+  if (method_call.method_name().compare(kMethodAddGlobalScript) == 0) {
+    if (const auto script =
+            std::get_if<std::string>(method_call.arguments())) {
+      const auto id = script_registry_.Add(util::Utf16FromUtf8(*script));
+      const auto& registered = script_registry_.scripts().back();
+      for (const auto& [texture_id, bridge] : instances_) {
+        AddRegisteredScript(texture_id, bridge.get(), registered);
+      }
+      return result->Success(flutter::EncodableValue(id));
+    }
+    return result->Error(kErrorCodeInvalidArgs);
+  }
+
+  // int: id returned by addGlobalScript
+  if (method_call.method_name().compare(kMethodRemoveGlobalScript) == 0) {
+    const auto arguments = method_call.arguments();
+    if (const auto id = arguments ? GetInt64(*arguments) : std::nullopt) {
+      const auto instance_ids = script_registry_.Remove(*id);
+      if (instance_ids) {
+        for (const auto& [texture_id, script_id] : *instance_ids) {
+          const auto it = instances_.find(texture_id);
+          if (it != instances_.end()) {
+            it->second->webview()->RemoveScriptToExecuteOnDocumentCreated(
+                script_id);
+          }
+        }
+      }
+      return result->Success(
+          flutter::EncodableValue(instance_ids.has_value()));
+    }
+    return result->Error(kErrorCodeInvalidArgs);
+  }
+
+  if (method_call.method_name().compare(kMethodGetTaskStats) == 0) {
+    return result->Success(EncodeTaskStats(task_monitor_));
+  }
+
+  // configureTaskMonitor: [int budgetUs | null, bool reportSlowCalls]
+  if (method_call.method_name().compare(kMethodConfigureTaskMonitor) == 0) {
+    const auto list =
+        std::get_if<flutter::EncodableList>(method_call.arguments());
+    if (!list || list->size() != 2) {
+      return result->Error(kErrorCodeInvalidArgs);
+    }
+
+    const auto budget = GetInt64((*list)[0]);
+    const auto report_slow_calls = std::get_if<bool>(&(*list)[1]);
+    if ((!budget && !(*list)[0].IsNull()) || (budget && *budget <= 0) ||
+        !report_slow_calls) {
+      return result->Error(kErrorCodeInvalidArgs);
+    }
+
+    if (budget) {
+      task_monitor_.set_budget(std::chrono::microseconds(*budget));
+    }
+    report_slow_calls_ = *report_slow_calls;
+    return result->Success();
+  }
+
+  if (method_call.method_name().compare(kMethodResetTaskStats) == 0) {
+    task_monitor_.Reset();
+    return result->Success();
+  }
+
+  // startChannelRecording: [String path, bool redact]
+  if (method_call.method_name().compare(kMethodStartChannelRecording) == 0) {
+    const auto list =
+        std::get_if<flutter::EncodableList>(method_call.arguments());
+    const auto path =
+        list && list->size() == 2 ? std::get_if<std::string>(&(*list)[0])
+                                  : nullptr;
+    const auto redact =
+        list && list->size() == 2 ? std::get_if<bool>(&(*list)[1]) : nullptr;
+    if (!path || !redact) {
+      return result->Error(kErrorCodeInvalidArgs);
+    }
+
+    auto out = std::make_unique<std::ofstream>(
+        std::filesystem::path(util::Utf16FromUtf8(*path)),
+        std::ios::binary | std::ios::trunc);
+    if (!*out) {
+      return result->Error(kErrorCodeRecordingFailed,
+                           "The log file could not be opened");
+    }
+    SetChannelRecorder(
+        std::make_unique<util::ChannelRecorder>(std::move(out), *redact));
+    return result->Success();
+  }
+
+  if (method_call.method_name().compare(kMethodStopChannelRecording) == 0) {
+    if (!channel_recorder_) {
+      return result->Success();
+    }
+    const auto count = channel_recorder_->record_count();
+    const auto written = channel_recorder_->Flush();
+    SetChannelRecorder(nullptr);
+    if (!written) {
+      return result->Error(kErrorCodeRecordingFailed,
+                           "Writing the log file failed");
+    }
+    return result->Success(
+        flutter::EncodableValue(static_cast<int64_t>(count)));
+  }
+
+  // replayChannelLog: [String path, double speed]
+  if (method_call.method_name().compare(kMethodReplayChannelLog) == 0) {
+    const auto list =
+        std::get_if<flutter::EncodableList>(method_call.arguments());
+    const auto path =
+        list && list->size() == 2 ? std::get_if<std::string>(&(*list)[0])
+                                  : nullptr;
+    const auto speed =
+        list && list->size() == 2 ? std::get_if<double>(&(*list)[1]) : nullptr;
+    if (!path || !speed || *speed < 0) {
+      return result->Error(kErrorCodeInvalidArgs);
+    }
+    if (channel_replay_) {
+      return result->Error(kErrorCodeReplayFailed,
+                           "Another log is being replayed");
+    }
+
+    std::ifstream in(std::filesystem::path(util::Utf16FromUtf8(*path)),
+                     std::ios::binary);
+    const std::vector<uint8_t> data((std::istreambuf_iterator<char>(in)),
+                                    std::istreambuf_iterator<char>());
+    std::vector<util::ChannelRecord> records;
+    if (!in.is_open() ||
+        !util::ReadChannelLog(data.data(), data.size(), &records)) {
+      return result->Error(kErrorCodeReplayFailed,
+                           "The log file could not be read");
+    }
+    if (!InitPlatform()) {
+      return result->Error(kErrorUnsupportedPlatform,
+                           "The platform is not supported");
+    }
+    return ReplayChannelLog(std::move(records), *speed, std::move(result));
   }
 
   if (method_call.method_name().compare(kMethodDispose) == 0) {
@@ -168,6 +723,10 @@ void WebviewWindowsPlugin::HandleMethodCall(
       const auto it = instances_.find(*texture_id);
       if (it != instances_.end()) {
         instances_.erase(it);
+        instance_origins_.erase(*texture_id);
+        script_registry_.RemoveInstance(*texture_id);
+        shard_balancer_.Remove(*texture_id);
+        RebalanceGraphicsContexts();
         return result->Success();
       }
     }
@@ -177,56 +736,544 @@ void WebviewWindowsPlugin::HandleMethodCall(
   }
 }
 
-void WebviewWindowsPlugin::CreateWebviewInstance(
-    std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result) {
+bool WebviewWindowsPlugin::InitWebviewHost(
+    flutter::MethodResult<flutter::EncodableValue>* result) {
   if (!InitPlatform()) {
-    return result->Error(kErrorUnsupportedPlatform,
-                         "The platform is not supported");
+    result->Error(kErrorUnsupportedPlatform, "The platform is not supported");
+    return false;
   }
 
   if (!webview_host_) {
     webview_host_ = std::move(WebviewHost::Create(
         platform_.get(), platform_->GetDefaultDataDirectory()));
     if (!webview_host_) {
-      return result->Error(kErrorCodeEnvironmentCreationFailed);
+      result->Error(kErrorCodeEnvironmentCreationFailed);
+      return false;
     }
   }
+  return true;
+}
 
+void WebviewWindowsPlugin::CreateWebviewInstance(
+    WebviewHost* host, const WebviewProfileOptions& profile,
+    InstanceCreatedCallback callback) {
   auto hwnd = CreateWindowEx(0, window_class_.lpszClassName, L"", 0, CW_DEFAULT,
                              CW_DEFAULT, 0, 0, HWND_MESSAGE, nullptr,
                              window_class_.hInstance, nullptr);
 
-  std::shared_ptr<flutter::MethodResult<flutter::EncodableValue>>
-      shared_result = std::move(result);
-  webview_host_->CreateWebview(
+  host->CreateWebview(
       hwnd, true, true,
-      [shared_result, this](std::unique_ptr<Webview> webview,
-                            std::unique_ptr<WebviewCreationError> error) {
+      [callback = std::move(callback), this, host, profile](
+          std::unique_ptr<Webview> webview,
+          std::unique_ptr<WebviewCreationError> error) {
         if (!webview) {
-          if (error) {
-            return shared_result->Error(
-                kErrorCodeWebviewCreationFailed,
-                std::format(
-                    "Creating the webview failed: {} (HRESULT: {:#010x})",
-                    error->message, error->hr));
-          }
-          return shared_result->Error(kErrorCodeWebviewCreationFailed,
-                                      "Creating the webview failed.");
+          return callback(nullptr, std::move(error));
         }
 
+        size_t shard = 0;
+        const auto graphics_context = PickGraphicsContext(&shard);
         auto bridge = std::make_unique<WebviewBridge>(
-            messenger_, textures_, platform_->graphics_context(),
-            std::move(webview));
+            messenger_, textures_, graphics_context, std::move(webview),
+            platform_->capture_supported());
         auto texture_id = bridge->texture_id();
+
+        shard_balancer_.Add(texture_id, shard, kDefaultSurfaceWeight);
+        bridge->OnSurfaceSizeChanged(
+            [this, texture_id](size_t width, size_t height) {
+              shard_balancer_.UpdateWeight(texture_id, width * height);
+            });
+
+        bridge->SetTaskMonitor(&task_monitor_);
+        bridge->SetChannelRecorder(channel_recorder_.get());
+        bridge->SetPopupProvider(
+            {[this, host, profile]() { FillWarmPool(host, profile); },
+             [this, host, profile](
+                 WebviewBridge::PopupInstanceCallback callback) {
+               TakeWarmInstance(host, profile, std::move(callback));
+             }});
+
+        auto bridge_pointer = bridge.get();
         instances_[texture_id] = std::move(bridge);
+        instance_origins_[texture_id] = {host, profile};
+        // Added before the callback gets the chance to navigate.
+        for (const auto& script : script_registry_.scripts()) {
+          AddRegisteredScript(texture_id, bridge_pointer, script);
+        }
+        callback(bridge_pointer, nullptr);
+      },
+      profile);
+}
+
+void WebviewWindowsPlugin::SnapshotSession(
+    const flutter::EncodableList& instances,
+    std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result) {
+  struct SnapshotInstance {
+    Webview* webview;
+    int32_t priority;
+    std::optional<std::string> environment;
+    WebviewProfileOptions profile;
+  };
+  std::vector<SnapshotInstance> webviews;
+  for (const auto& instance : instances) {
+    const auto pair = std::get_if<flutter::EncodableList>(&instance);
+    if (!pair || pair->size() != 2) {
+      return result->Error(kErrorCodeInvalidArgs);
+    }
+    const auto texture_id = GetInt64(pair->at(0));
+    const auto priority = std::get_if<int32_t>(&pair->at(1));
+    const auto it =
+        texture_id ? instances_.find(*texture_id) : instances_.end();
+    if (it == instances_.end() || !priority) {
+      return result->Error(kErrorCodeInvalidId);
+    }
+    const auto& origin = instance_origins_[*texture_id];
+    webviews.push_back({it->second->webview(), *priority,
+                        GetEnvironmentName(origin.host), origin.profile});
+  }
+
+  struct PendingSnapshot {
+    util::SessionSnapshot snapshot;
+    size_t remaining;
+    std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result;
+  };
+
+  auto pending = std::make_shared<PendingSnapshot>();
+  pending->snapshot.instances.resize(webviews.size());
+  pending->remaining = webviews.size() + 1;
+  pending->result = std::move(result);
+  auto complete = [pending]() {
+    if (--pending->remaining == 0) {
+      pending->result->Success(flutter::EncodableValue(
+          util::SerializeSessionSnapshot(pending->snapshot)));
+    }
+  };
+
+  // All instances are queried concurrently.
+  for (size_t i = 0; i < webviews.size(); i++) {
+    webviews[i].webview->CaptureState(
+        [pending, complete, i, instance = webviews[i]](
+            util::InstanceState state) {
+          state.priority = instance.priority;
+          state.environment = instance.environment;
+          state.profile = instance.profile.name;
+          state.in_private = instance.profile.in_private;
+          pending->snapshot.instances[i] = std::move(state);
+          complete();
+        });
+  }
+  complete();
+}
+
+void WebviewWindowsPlugin::RestoreSession(
+    util::SessionSnapshot snapshot, size_t max_parallel,
+    std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result) {
+  if (!InitWebviewHost(result.get())) {
+    return;
+  }
+
+  std::vector<int32_t> priorities;
+  for (const auto& instance : snapshot.instances) {
+    priorities.push_back(instance.priority);
+  }
+
+  const auto count = snapshot.instances.size();
+  auto restore = std::make_shared<SessionRestore>(SessionRestore{
+      std::move(snapshot), util::RestoreScheduler(priorities, max_parallel),
+      flutter::EncodableList(count), std::move(result)});
+  if (restore->scheduler.done()) {
+    return restore->result->Success(
+        flutter::EncodableValue(restore->texture_ids));
+  }
+
+  for (const auto index : restore->scheduler.Start()) {
+    RestoreInstance(restore, index);
+  }
+}
+
+void WebviewWindowsPlugin::RestoreInstance(
+    std::shared_ptr<SessionRestore> restore, size_t index) {
+  auto on_created = [this, restore, index](
+                        WebviewBridge* bridge,
+                        std::unique_ptr<WebviewCreationError> error) {
+    if (bridge) {
+      bridge->webview()->RestoreState(restore->snapshot.instances[index]);
+      restore->texture_ids[index] =
+          flutter::EncodableValue(bridge->texture_id());
+    } else {
+      std::cerr << GetCreationErrorMessage(error.get()) << std::endl;
+    }
+
+    // The controller is up, so the next instance can be started while
+    // this one is still loading.
+    for (const auto next : restore->scheduler.Complete(index)) {
+      RestoreInstance(restore, next);
+    }
+    if (restore->scheduler.done()) {
+      restore->result->Success(flutter::EncodableValue(restore->texture_ids));
+    }
+  };
+
+  const auto& state = restore->snapshot.instances[index];
+  WebviewHost* host = webview_host_.get();
+  if (state.environment) {
+    const auto it = environments_.find(*state.environment);
+    if (it == environments_.end()) {
+      return on_created(nullptr,
+                        WebviewCreationError::create(
+                            E_INVALIDARG, "The environment \"" +
+                                              *state.environment +
+                                              "\" has not been initialized."));
+    }
+    host = it->second.get();
+  }
+
+  WebviewProfileOptions profile;
+  profile.name = state.profile;
+  profile.in_private = state.in_private;
+  if (profile.name && !util::IsValidProfileName(*profile.name)) {
+    return on_created(nullptr, WebviewCreationError::create(
+                                   E_INVALIDARG, "Invalid profile name."));
+  }
+  CreateWebviewInstance(host, profile, std::move(on_created));
+}
+
+std::optional<std::string> WebviewWindowsPlugin::GetEnvironmentName(
+    const WebviewHost* host) const {
+  for (const auto& [name, environment] : environments_) {
+    if (environment.get() == host) {
+      return name;
+    }
+  }
+  return std::nullopt;
+}
+
+void WebviewWindowsPlugin::AddRegisteredScript(
+    int64_t texture_id, WebviewBridge* bridge,
+    const util::ScriptRegistry::Script& script) {
+  bridge->webview()->AddRegisteredScript(
+      script.source, [this, texture_id, script_id = script.id](
+                         bool success, const std::string& instance_script_id) {
+        if (!success) {
+          std::cerr << "Adding a global script failed." << std::endl;
+          return;
+        }
+
+        // The instance may have been disposed of in the meantime.
+        const auto it = instances_.find(texture_id);
+        if (it == instances_.end()) {
+          return;
+        }
+        if (!script_registry_.SetInstanceScriptId(script_id, texture_id,
+                                                  instance_script_id)) {
+          // Removed while being added.
+          it->second->webview()->RemoveScriptToExecuteOnDocumentCreated(
+              instance_script_id);
+        }
+      });
+}
+
+void WebviewWindowsPlugin::FillWarmPool(WebviewHost* host,
+                                        const WebviewProfileOptions& profile) {
+  const auto key =
+      WarmPoolKey(host, profile.name.value_or(""), profile.in_private);
+  auto& pool = warm_pools_[key];
+  // Callers waiting for an instance get the next one created.
+  const auto target = kWarmPoolSize + pool.waiting.size();
+  const auto available = pool.texture_ids.size() + pool.creating;
+  for (auto i = available; i < target; i++) {
+    pool.creating++;
+    CreateWebviewInstance(
+        host, profile,
+        [this, key](WebviewBridge* bridge,
+                    std::unique_ptr<WebviewCreationError> error) {
+          auto& pool = warm_pools_[key];
+          pool.creating--;
+          if (!bridge) {
+            std::cerr << GetCreationErrorMessage(error.get()) << std::endl;
+            if (!pool.waiting.empty()) {
+              auto callback = std::move(pool.waiting.front());
+              pool.waiting.pop_front();
+              callback(nullptr);
+            }
+            return;
+          }
 
-        auto response = flutter::EncodableValue(flutter::EncodableMap{
-            {flutter::EncodableValue("textureId"),
-             flutter::EncodableValue(texture_id)},
+          if (!pool.waiting.empty()) {
+            auto callback = std::move(pool.waiting.front());
+            pool.waiting.pop_front();
+            callback(bridge);
+          } else {
+            pool.texture_ids.push_back(bridge->texture_id());
+          }
         });
+  }
+}
+
+void WebviewWindowsPlugin::TakeWarmInstance(
+    WebviewHost* host, const WebviewProfileOptions& profile,
+    WebviewBridge::PopupInstanceCallback callback) {
+  auto& pool = warm_pools_[WarmPoolKey(host, profile.name.value_or(""),
+                                       profile.in_private)];
+  WebviewBridge* bridge = nullptr;
+  while (!bridge && !pool.texture_ids.empty()) {
+    const auto it = instances_.find(pool.texture_ids.front());
+    pool.texture_ids.pop_front();
+    if (it != instances_.end()) {
+      bridge = it->second.get();
+    }
+  }
+
+  if (bridge) {
+    callback(bridge);
+  } else {
+    pool.waiting.push_back(std::move(callback));
+  }
+  // Refills the pool, or creates the instance being waited for.
+  FillWarmPool(host, profile);
+}
+
+void WebviewWindowsPlugin::RebalanceGraphicsContexts() {
+  for (const auto& move : shard_balancer_.Rebalance()) {
+    const auto graphics_context = platform_->graphics_context(move.to);
+    if (!graphics_context) {
+      // Keep the instance where it is.
+      shard_balancer_.DisableShard(move.to);
+      shard_balancer_.Reassign(move.instance, move.from);
+      continue;
+    }
+    const auto it = instances_.find(move.instance);
+    if (it != instances_.end()) {
+      it->second->SetGraphicsContext(graphics_context);
+    }
+  }
+}
 
-        shared_result->Success(response);
+GraphicsContext* WebviewWindowsPlugin::PickGraphicsContext(size_t* shard) {
+  // Every failure disables a shard, so this ends up on the primary context
+  // at the latest.
+  for (size_t i = 0; i < shard_balancer_.shard_count(); i++) {
+    *shard = shard_balancer_.PickShard();
+    if (const auto graphics_context = platform_->graphics_context(*shard)) {
+      return graphics_context;
+    }
+    shard_balancer_.DisableShard(*shard);
+  }
+  *shard = 0;
+  return platform_->graphics_context();
+}
+
+void WebviewWindowsPlugin::SetChannelRecorder(
+    std::unique_ptr<util::ChannelRecorder> recorder) {
+  for (const auto& [texture_id, bridge] : instances_) {
+    bridge->SetChannelRecorder(recorder.get());
+  }
+  // Replacing a recorder flushes it.
+  channel_recorder_ = std::move(recorder);
+  channel_recording_id_++;
+}
+
+std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>>
+WebviewWindowsPlugin::RecordResult(
+    size_t call, const std::string& method_name,
+    std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result) {
+  std::shared_ptr<flutter::MethodResult<flutter::EncodableValue>>
+      shared_result = std::move(result);
+  return std::make_unique<
+      flutter::MethodResultFunctions<flutter::EncodableValue>>(
+      [this, shared_result, call, method_name,
+       recording_id = channel_recording_id_](
+          const flutter::EncodableValue* value) {
+        // The recording may have been stopped or replaced in the meantime.
+        if (channel_recorder_ && channel_recording_id_ == recording_id) {
+          channel_recorder_->RecordResult(call, method_name,
+                                          EncodePayload(value));
+        }
+        if (value) {
+          shared_result->Success(*value);
+        } else {
+          shared_result->Success();
+        }
+      },
+      [shared_result](const std::string& code, const std::string& message,
+                      const flutter::EncodableValue* details) {
+        if (details) {
+          shared_result->Error(code, message, *details);
+        } else {
+          shared_result->Error(code, message);
+        }
+      },
+      [shared_result]() { shared_result->NotImplemented(); });
+}
+
+void WebviewWindowsPlugin::ReplayChannelLog(
+    std::vector<util::ChannelRecord> records, double speed,
+    std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result) {
+  auto replay = std::make_shared<ChannelReplay>();
+  replay->replayer = std::make_unique<util::ChannelReplayer>(
+      std::move(records), speed,
+      [this, replay_pointer = replay.get()](
+          size_t index, const util::ChannelRecord& record) {
+        DispatchReplayedRecord(replay_pointer, index, record);
       });
+  replay->result = std::move(result);
+  replay->replayer->Start();
+  channel_replay_ = replay;
+  RunChannelReplay(std::move(replay));
+}
+
+void WebviewWindowsPlugin::RunChannelReplay(
+    std::shared_ptr<ChannelReplay> replay) {
+  const auto next = replay->replayer->Run();
+  if (next) {
+    const auto delay = std::max(
+        std::chrono::ceil<std::chrono::milliseconds>(
+            *next - util::ChannelReplayer::Clock::now()),
+        std::chrono::milliseconds::zero());
+    platform_->task_runner()->PostDelayedTask(
+        [this, weak_replay = std::weak_ptr<ChannelReplay>(replay)]() {
+          if (const auto replay = weak_replay.lock()) {
+            RunChannelReplay(replay);
+          }
+        },
+        delay);
+    return;
+  }
+
+  // The timings of the dispatched calls are reported by getTaskStats.
+  channel_replay_ = nullptr;
+  replay->result->Success(flutter::EncodableValue(flutter::EncodableMap{
+      {flutter::EncodableValue("records"),
+       flutter::EncodableValue(
+           static_cast<int64_t>(replay->replayer->record_count()))},
+      {flutter::EncodableValue("dispatched"),
+       flutter::EncodableValue(static_cast<int64_t>(
+           replay->replayer->dispatched() - replay->results -
+           replay->skipped))},
+      {flutter::EncodableValue("skipped"),
+       flutter::EncodableValue(static_cast<int64_t>(replay->skipped))},
+      {flutter::EncodableValue("maxLagUs"),
+       flutter::EncodableValue(ToMicroseconds(replay->replayer->max_lag()))},
+  }));
+}
+
+void WebviewWindowsPlugin::DispatchReplayedRecord(
+    ChannelReplay* replay, size_t index, const util::ChannelRecord& record) {
+  typedef flutter::MethodResultFunctions<flutter::EncodableValue>
+      ReplayedResult;
+
+  // Events are emitted by the replayed instances themselves.
+  if (record.kind == util::ChannelRecord::Kind::kEvent ||
+      record.payload_state == util::ChannelRecord::Payload::kDropped) {
+    replay->skipped++;
+    return;
+  }
+
+  auto arguments =
+      record.payload.empty()
+          ? std::make_unique<flutter::EncodableValue>()
+          : flutter::StandardMessageCodec::GetInstance().DecodeMessage(
+                record.payload);
+  if (!arguments) {
+    replay->skipped++;
+    return;
+  }
+
+  if (record.kind == util::ChannelRecord::Kind::kResult) {
+    replay->results++;
+    replay->recorded_results[record.call] = GetCreatedTextureIds(*arguments);
+    MapReplayedInstances(replay, record.call);
+    return;
+  }
+
+  if (record.texture_id == util::kPluginChannel) {
+    if (record.name == kMethodDispose) {
+      const auto texture_id = GetInt64(*arguments);
+      if (!texture_id) {
+        replay->skipped++;
+        return;
+      }
+      const auto it = replay->texture_ids.find(*texture_id);
+      if (it == replay->texture_ids.end()) {
+        // The instance may still be being created by the replay.
+        bool pending = false;
+        for (const auto& [call, texture_ids] : replay->recorded_results) {
+          pending = pending ||
+                    std::find(texture_ids.begin(), texture_ids.end(),
+                              texture_id) != texture_ids.end();
+        }
+        if (pending) {
+          replay->pending_disposals.insert(*texture_id);
+        } else {
+          replay->skipped++;
+        }
+        return;
+      }
+      *arguments = flutter::EncodableValue(it->second);
+    }
+
+    const bool creates_instances = CreatesInstances(record.name);
+    HandleMethodCall(
+        flutter::MethodCall<flutter::EncodableValue>(record.name,
+                                                     std::move(arguments)),
+        std::make_unique<ReplayedResult>(
+            [this, weak_replay = std::weak_ptr<ChannelReplay>(channel_replay_),
+             creates_instances, index](const flutter::EncodableValue* value) {
+              const auto replay = weak_replay.lock();
+              if (!replay || !creates_instances || !value) {
+                return;
+              }
+              replay->replayed_results[index] = GetCreatedTextureIds(*value);
+              MapReplayedInstances(replay.get(), index);
+            },
+            nullptr, nullptr));
+    return;
+  }
+
+  const auto it = replay->texture_ids.find(record.texture_id);
+  const auto instance = it != replay->texture_ids.end()
+                            ? instances_.find(it->second)
+                            : instances_.end();
+  if (instance == instances_.end()) {
+    // Created before the recording started, or not yet by the replay.
+    replay->skipped++;
+    return;
+  }
+  instance->second->ReplayMethodCall(
+      flutter::MethodCall<flutter::EncodableValue>(record.name,
+                                                   std::move(arguments)),
+      std::make_unique<ReplayedResult>(nullptr, nullptr, nullptr));
+}
+
+void WebviewWindowsPlugin::MapReplayedInstances(ChannelReplay* replay,
+                                                size_t call) {
+  const auto recorded = replay->recorded_results.find(call);
+  const auto replayed = replay->replayed_results.find(call);
+  if (recorded == replay->recorded_results.end() ||
+      replayed == replay->replayed_results.end()) {
+    return;
+  }
+
+  const auto recorded_ids = std::move(recorded->second);
+  const auto replayed_ids = std::move(replayed->second);
+  replay->recorded_results.erase(recorded);
+  replay->replayed_results.erase(replayed);
+
+  for (size_t i = 0; i < std::min(recorded_ids.size(), replayed_ids.size());
+       i++) {
+    if (!recorded_ids[i] || !replayed_ids[i]) {
+      continue;
+    }
+    replay->texture_ids[*recorded_ids[i]] = *replayed_ids[i];
+    if (replay->pending_disposals.erase(*recorded_ids[i]) > 0) {
+      HandleMethodCall(
+          flutter::MethodCall<flutter::EncodableValue>(
+              kMethodDispose,
+              std::make_unique<flutter::EncodableValue>(*replayed_ids[i])),
+          std::make_unique<
+              flutter::MethodResultFunctions<flutter::EncodableValue>>(
+              nullptr, nullptr, nullptr));
+    }
+  }
 }
 
 bool WebviewWindowsPlugin::InitPlatform() {